@@ -60,9 +60,12 @@ static void CheckForHangup() {
 
 static void GiveupTimeSlices() {
   yield();
-  if (inst_msg_waiting() && (!a()->sess().in_chatroom() || !a()->sess().chatline())) {
+  if (!inst_msg_waiting()) {
+    wait_for_inst_msg(std::chrono::milliseconds(100));
+  } else if (!a()->sess().in_chatroom() || !a()->sess().chatline()) {
     process_inst_msgs();
   } else {
+    // Messages wait until we leave the chatline, so don't spin on them.
     sleep_for(std::chrono::milliseconds(100));
   }
   yield();
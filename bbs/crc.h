@@ -18,11 +18,8 @@
 #ifndef __INCLUDED_BBS_CRC_H__
 #define __INCLUDED_BBS_CRC_H__
 
-#include <cstddef>
-
-unsigned long int crc32buf(const char *buffer, std::size_t nLength);
-
-// used by old sr.cpp and friends.
+// The XModem CRC-16, used by old sr.cpp and friends.  It is computed with
+// wwiv::core::crc16_byte from core/crc32.h.
 extern unsigned short crc;
 
 #endif  // __INCLUDED_BBS_CRC_H__
@@ -180,9 +180,16 @@ std::unique_ptr<File> OpenEmailFile(bool bAllowWrite) {
   return file;
 }
 
+wwiv::sdk::msgapi::EmailIndex OpenEmailIndex(File& f) {
+  wwiv::sdk::msgapi::EmailIndex index(FilePath(a()->config()->datadir(), EMAIL_DAT));
+  if (f.IsOpen()) {
+    index.Load(f);
+  }
+  return index;
+}
+
 void sendout_email(EmailData& data) {
   mailrec m{};
-  mailrec messageRecord{};
   net_header_rec nh{};
 
   to_char_array(m.title, data.title);
@@ -211,24 +218,10 @@ void sendout_email(EmailData& data) {
     if (!file_email->IsOpen()) {
       return;
     }
-    auto nEmailFileLen = file_email->length() / sizeof(mailrec);
-    File::size_type i = 0;
-    if (nEmailFileLen != 0) {
-      i = nEmailFileLen - 1;
-      file_email->Seek(i * sizeof(mailrec), File::Whence::begin);
-      file_email->Read(&messageRecord, sizeof(mailrec));
-      while (i > 0 && messageRecord.tosys == 0 && messageRecord.touser == 0) {
-        --i;
-        file_email->Seek(i * sizeof(mailrec), File::Whence::begin);
-        auto i1 = file_email->Read(&messageRecord, sizeof(mailrec));
-        if (i1 == -1) {
-          bout << "|#6DIDN'T READ WRITE!\r\n";
-        }
-      }
-      if (messageRecord.tosys || messageRecord.touser) {
-        ++i;
-      }
-    }
+    auto index = OpenEmailIndex(*file_email);
+    const File::size_type i = index.next_slot();
+    index.Update(static_cast<int>(i), m);
+    index.Save();
 
     file_email->Seek(i * sizeof(mailrec), File::Whence::begin);
     auto bytes_written = file_email->Write(&m, sizeof(mailrec));
@@ -764,6 +757,9 @@ void delmail(File& f, size_t loc) {
       a()->users()->writeuser(&user, m.touser);
     }
   }
+  auto index = OpenEmailIndex(f);
+  index.Remove(static_cast<int>(loc));
+  index.Save();
   f.Seek(loc * sizeof(mailrec), File::Whence::begin);
   m.touser = 0;
   m.tosys = 0;
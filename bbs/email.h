@@ -22,6 +22,7 @@
 #include <string>
 #include "common/message_editor_data.h"
 #include "core/file.h"
+#include "sdk/msgapi/email_index.h"
 #include "sdk/vardec.h"
 
 class EmailData {
@@ -51,6 +52,8 @@ public:
 
 bool ForwardMessage(uint16_t* user_number, uint16_t* system_number);
 [[nodiscard]] std::unique_ptr<wwiv::core::File> OpenEmailFile(bool allow_write);
+/** Loads the mailbox index for f, which must be EMAIL.DAT opened by OpenEmailFile. */
+[[nodiscard]] wwiv::sdk::msgapi::EmailIndex OpenEmailIndex(wwiv::core::File& f);
 void sendout_email(::EmailData& data);
 [[nodiscard]] bool ok_to_mail(uint16_t user_number, uint16_t system_number, bool force_it);
 void email(const std::string& title, uint16_t user_number, uint16_t system_number, bool force_it,
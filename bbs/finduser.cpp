@@ -87,12 +87,7 @@ int finduser1(const string& searchString) {
     return un;
   }
 
-  const auto name_part = ToStringUpperCase(searchString);
-  for (const auto& n : a()->names()->names_vector()) {
-    if (strstr(reinterpret_cast<const char*>(n.name), name_part.c_str()) == nullptr) {
-      continue;
-    }
-
+  for (const auto& n : a()->names()->FindUsersContaining(searchString)) {
     bout << "|#5Do you mean " << a()->names()->UserName(n.number) << " (Y/N/Q)? ";
     const auto ch = bin.ynq();
     if (ch == 'Y') {
@@ -31,8 +31,11 @@
 #include "sdk/config.h"
 #include "sdk/filenames.h"
 #include "sdk/instance.h"
+#include "sdk/instance_message_bus.h"
 #include "sdk/names.h"
 #include <chrono>
+#include <cstring>
+#include <memory>
 #include <string>
 
 using std::string;
@@ -54,14 +57,35 @@ bool is_chat_invis() {
   return chat_invis; 
 }
 
+static std::unique_ptr<InstanceMessageBus> inst_bus_;
+
+// Opened the first time it's needed, since the instance number isn't
+// known at startup.
+static InstanceMessageBus& inst_bus() {
+  if (!inst_bus_) {
+    inst_bus_ =
+        std::make_unique<InstanceMessageBus>(a()->config()->datadir(), a()->instance_number());
+  }
+  return *inst_bus_;
+}
+
 static void send_inst_msg(inst_msg_header *ih, const std::string& msg) {
+  if (ih->msg_size > 0 && msg.empty()) {
+    ih->msg_size = 0;
+  }
+  std::string packet(reinterpret_cast<const char*>(ih), sizeof(inst_msg_header));
+  if (ih->msg_size > 0) {
+    packet.append(msg.c_str(), ih->msg_size);
+  }
+  if (inst_bus().Send(ih->dest_inst, packet)) {
+    return;
+  }
+
+  // The other instance isn't listening, so leave a message file for it.
   const auto fn = fmt::sprintf("tmsg%3.3u.%3.3d", a()->instance_number(), ih->dest_inst);
   File file(FilePath(a()->config()->datadir(), fn));
   if (file.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile, File::shareDenyReadWrite)) {
     file.Seek(0L, File::Whence::end);
-    if (ih->msg_size > 0 && msg.empty()) {
-      ih->msg_size = 0;
-    }
     file.Write(ih, sizeof(inst_msg_header));
     if (ih->msg_size > 0) {
       file.Write(msg.c_str(), ih->msg_size);
@@ -157,6 +181,19 @@ void process_inst_msgs() {
   last_iia = steady_clock::now();
   const auto oiia = setiia(std::chrono::milliseconds(0));
 
+  for (const auto& packet : inst_bus().Receive()) {
+    if (packet.size() < sizeof(inst_msg_header)) {
+      continue;
+    }
+    inst_msg_header ih{};
+    memcpy(&ih, packet.data(), sizeof(inst_msg_header));
+    string m;
+    if (ih.msg_size > 0) {
+      m = packet.substr(sizeof(inst_msg_header), ih.msg_size);
+    }
+    handle_inst_msg(&ih, m);
+  }
+
   const auto fndspec = fmt::sprintf("%smsg*.%3.3u", a()->config()->datadir(), a()->instance_number());
   FindFiles ff(fndspec, FindFiles::FindFilesType::files);
   for (const auto& f : ff) {
@@ -327,6 +364,10 @@ void write_inst(int loc, int subloc, int flags) {
 bool inst_msg_waiting() {
   if (iia.count() == 0) return false;
 
+  if (inst_bus().waiting()) {
+    return true;
+  }
+
   const auto l = steady_clock::now();
   if ((l - last_iia) < iia) {
     return false;
@@ -341,6 +382,14 @@ bool inst_msg_waiting() {
   return true;
 }
 
+void wait_for_inst_msg(std::chrono::milliseconds timeout) {
+  if (iia.count() == 0 || !inst_bus().ok()) {
+    sleep_for(timeout);
+    return;
+  }
+  inst_bus().Wait(timeout);
+}
+
 // Sets inter-instance availability on/off, for inter-instance messaging.
 // returns the old iia value.
 std::chrono::milliseconds setiia(std::chrono::milliseconds poll_time) {
@@ -139,6 +139,8 @@ int  num_instances();
 bool user_online(int user_number, int *wi);
 void write_inst(int loc, int subloc = 0, int flags = INST_FLAGS_NONE);
 bool inst_msg_waiting();
+// Sleeps for up to timeout, waking early when an inter-instance message arrives.
+void wait_for_inst_msg(std::chrono::milliseconds timeout);
 std::chrono::milliseconds setiia(std::chrono::milliseconds poll_time);
 void toggle_invis();
 void toggle_avail();
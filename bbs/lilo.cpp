@@ -965,12 +965,15 @@ void logoff() {
     if (pFileEmail->IsOpen()) {
       a()->user()->email_waiting(0);
       const auto num_records = static_cast<int>(pFileEmail->length() / sizeof(mailrec));
+      // Compacting moves records, so the index is rebuilt from where they end up.
+      wwiv::sdk::msgapi::EmailIndex index(FilePath(a()->config()->datadir(), EMAIL_DAT));
       auto r = 0;
       auto w = 0;
       while (r < num_records) {
         pFileEmail->Seek(static_cast<long>(sizeof(mailrec)) * static_cast<long>(r), File::Whence::begin);
         pFileEmail->Read(&m, sizeof(mailrec));
         if (m.tosys != 0 || m.touser != 0) {
+          index.Update(w, m);
           if (m.tosys == 0 && m.touser == a()->sess().user_num()) {
             if (a()->user()->email_waiting() != 255) {
               a()->user()->email_waiting(a()->user()->email_waiting() + 1);
@@ -993,6 +996,8 @@ void logoff() {
         }
       }
       pFileEmail->set_length(static_cast<long>(sizeof(mailrec)) * static_cast<long>(w));
+      index.Truncate(w);
+      index.Save();
       a()->status_manager()->Run([](Status& s) {
         s.increment_filechanged(Status::file_change_email);
       });
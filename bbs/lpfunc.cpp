@@ -31,6 +31,7 @@
 #include "fmt/printf.h"
 #include "local_io/keycodes.h"
 #include "sdk/filenames.h"
+#include "sdk/files/file_catalog.h"
 #include "sdk/files/files.h"
 #include <string>
 #include <vector>
@@ -43,10 +44,6 @@ using namespace wwiv::strings;
 
 // Local function prototypes
 int  compare_criteria(search_record * sr, uploadsrec * ur);
-bool lp_compare_strings(const char *raw, const char *formula);
-bool lp_compare_strings_wh(const char *raw, const char *formula, unsigned *pos, int size);
-int  lp_get_token(const char *formula, unsigned *pos);
-int  lp_get_value(const char *raw, const char *formula, unsigned *pos);
 
 // These are defined in listplus.cpp
 extern int bulk_move;
@@ -126,6 +123,16 @@ int listfiles_plus_function(int type) {
   auto max_lines = calc_max_lines();
   auto all_done = false;
 
+  // Only bother with the catalog when looking through more than one directory.
+  std::unique_ptr<wwiv::sdk::files::FileCatalog> catalog;
+  wwiv::sdk::files::file_catalog_query_t q{};
+  if (search_rec.alldirs != THIS_DIR) {
+    catalog = load_file_catalog();
+    q.filemask = search_rec.filemask;
+    q.newer_than = search_rec.nscandate;
+    q.keywords = search_rec.search;
+  }
+
   for (uint16_t this_dir = 0; this_dir < a()->udir.size() && !a()->sess().hangup() && !all_done;
        this_dir++) {
     int also_this_dir = a()->udir[this_dir].subnum;
@@ -144,6 +151,9 @@ int listfiles_plus_function(int type) {
       if (search_rec.alldirs == ALL_DIRS && (type != LP_NSCAN_NSCAN)) {
         scan_dir = true;
       }
+      if (scan_dir && !dir_may_match(catalog.get(), this_dir, q)) {
+        scan_dir = false;
+      }
     }
 
     int save_first_file = 0;
@@ -552,13 +562,6 @@ TOGGLE_EXTENDED:
   return all_done ? 1 : 0;
 }
 
-static constexpr char STR_AND = '&';
-static constexpr char STR_SPC = ' ';
-static constexpr char STR_OR = '|';
-static constexpr char STR_NOT = '!';
-static constexpr char STR_OPEN_PAREN = '(';
-static constexpr char STR_CLOSE_PAREN = ')';
-
 int compare_criteria(search_record * sr, uploadsrec * ur) {
   // "        .   "
   if (sr->filemask != "        .   ") {
@@ -600,7 +603,8 @@ int compare_criteria(search_record * sr, uploadsrec * ur) {
   // description (if there is one)
   buff += StrCat(" ", ur->filename, " ", ur->description);
 
-  if (lp_compare_strings(buff.c_str(), sr->search.c_str())) {
+  if (wwiv::sdk::files::keyword_formula_match(
+          sr->search, [&buff](const std::string& term) { return ifind_first(buff, term); })) {
     return 1;
   }
 
@@ -608,132 +612,5 @@ int compare_criteria(search_record * sr, uploadsrec * ur) {
   return 0;
 }
 
-bool lp_compare_strings(const char *raw, const char *formula) {
-  unsigned i = 0;
-
-  return lp_compare_strings_wh(raw, formula, &i, ssize(formula));
-}
-
-bool lp_compare_strings_wh(const char *raw, const  char *formula, unsigned *pos, int size) {
-  bool rvalue;
-
-  auto lvalue = lp_get_value(raw, formula, pos) ? true : false;
-  while (*pos < static_cast<unsigned>(size)) {
-    const auto token = lp_get_token(formula, pos);
-
-    switch (token) {
-    case STR_SPC:                         // Added
-    case STR_AND:
-      rvalue = lp_compare_strings_wh(raw, formula, pos, size);
-      lvalue = lvalue && rvalue;
-      break;
-
-    case STR_OR:
-      rvalue = lp_compare_strings_wh(raw, formula, pos, size);
-      lvalue = lvalue || rvalue;
-      break;
-
-    case STR_CLOSE_PAREN:
-    case 0:
-      return lvalue;
-
-    default:
-      return lvalue;
-    }
-  }
-  return lvalue;
-}
-
-int lp_get_token(const char *formula, unsigned *pos) {
-  auto tpos = 0;
-
-  while (formula[*pos] && isspace(formula[*pos])) {
-    ++* pos;
-  }
-
-  if (isalpha(formula[*pos])) {
-    // remove isspace to split by word basis
-    while (isalnum(formula[*pos]) || isspace(formula[*pos])) {
-      ++tpos;
-      ++*pos;
-    }
-  }
-  ++*pos;
-  return formula[*pos - 1];
-}
-
-int lp_get_value(const char *raw, const char *formula, unsigned *pos) {
-  char szBuffer[255];
-  int tpos = 0;
-  int sign = 1, started_number = 0;
-
-  while (formula[*pos] && isspace(formula[*pos])) {
-    ++* pos;
-  }
-  int x = formula[*pos];
-
-OPERATOR_CHECK_1:
-  switch (x) {
-  case STR_NOT:
-    sign = !sign;
-    ++*pos;
-    if (formula[*pos]) {
-      x = formula[*pos];
-      goto OPERATOR_CHECK_1;
-    }
-    return 0;
-
-  case STR_AND:
-  case STR_SPC:
-  case STR_OR:
-    return 0;
-  }
-
-  switch (x) {
-  case STR_OPEN_PAREN:
-    ++*pos;
-    if (lp_compare_strings_wh(raw, formula, pos, ssize(formula))) {
-      return (sign) ? 1 : 0;
-    } else {
-      return (sign) ? 0 : 1;
-    }
-  }
-
-  bool done = false;
-  while (!done && formula[*pos]) {
-    x = formula[*pos];
-    switch (x) {
-    case STR_NOT:
-      if (started_number) {
-        done = true;
-        break;
-      }
-      sign = !sign;
-      ++*pos;
-      continue;
-    case STR_AND:
-    case STR_SPC:
-    case STR_OR:
-    case STR_OPEN_PAREN:
-    case STR_CLOSE_PAREN: {
-      done = true;
-      break;
-    }
-    default:
-      started_number = 1;
-      szBuffer[tpos] = static_cast<char>(x);
-      ++tpos;
-      ++*pos;
-      break;
-    }
-  }
-  szBuffer[tpos] = 0;
-  StringTrim(szBuffer);
-
-  if (ifind_first(raw, szBuffer)) {
-    return (sign ? 1 : 0);
-  }
-  return (sign ? 0 : 1);
-}
 
 
@@ -24,8 +24,18 @@
 #include "common/com.h"
 #include "common/full_screen.h"
 #include "common/input.h"
+#include "core/file.h"
 #include "core/strings.h"
+#include "sdk/filenames.h"
+#include "sdk/msgapi/message_search_index.h"
 #include "sdk/subxtr.h"
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace wwiv::bbs {
 
@@ -33,14 +43,53 @@ static std::string last_search_string;
 static bool last_search_forward{true};
 
 using namespace wwiv::core;
+using namespace wwiv::sdk::msgapi;
 using namespace wwiv::strings;
 
+// The search index of the last sub searched, kept until the index or its
+// journal change.
+static std::unique_ptr<MessageSearchIndex> search_index;
+static std::pair<time_t, File::size_type> search_index_stamp;
+
+/**
+ * Returns the search index for the current sub, or nullptr if it doesn't
+ * have one.
+ */
+static const MessageSearchIndex* current_search_index() {
+  const auto sub_fn =
+      FilePath(a()->config()->datadir(), StrCat(a()->current_sub().filename, ".sub"));
+  MessageSearchIndex index(sub_fn);
+  if (!index.exists()) {
+    return nullptr;
+  }
+  const auto journal_size =
+      File::Exists(index.journal_path()) ? File(index.journal_path()).length() : 0;
+  const auto stamp = std::make_pair(File::last_write_time(index.path()), journal_size);
+  if (search_index && search_index->path() == index.path() && search_index_stamp == stamp) {
+    return search_index.get();
+  }
+  search_index.reset();
+  if (!index.Load()) {
+    return nullptr;
+  }
+  search_index = std::make_unique<MessageSearchIndex>(std::move(index));
+  search_index_stamp = stamp;
+  return search_index.get();
+}
+
 
 find_message_result_t FindNextMessageAgain(int msgno) {
   const auto search_string = last_search_string;
   const auto msgnum_limit = last_search_forward ? a()->GetNumMessagesInCurrentMessageArea() : 1;
   auto tmp_msgnum = msgno;
   auto fnd = false;
+  // Only messages the index says might match, or that aren't in it, need
+  // their text read.
+  const auto* index = current_search_index();
+  std::optional<std::vector<uint32_t>> candidates;
+  if (index) {
+    candidates = index->candidates(search_string);
+  }
   while (tmp_msgnum != msgnum_limit && !fnd) {
     if (last_search_forward) {
       tmp_msgnum++;
@@ -60,9 +109,18 @@ find_message_result_t FindNextMessageAgain(int msgno) {
         a()->CheckForHangup();
       }
     }
-    if (auto o = readfile(&(get_post(tmp_msgnum)->msg), a()->current_sub().filename)) {
+    const auto* p = get_post(tmp_msgnum);
+    if (!p) {
+      continue;
+    }
+    if (candidates && index->indexed(*p) &&
+        !std::binary_search(std::begin(*candidates), std::end(*candidates), p->qscan)) {
+      continue;
+    }
+    const auto post = *p;
+    if (auto o = readfile(&post.msg, a()->current_sub().filename)) {
       auto b = ToStringUpperCase(o.value());
-      const std::string title = stripcolors(get_post(tmp_msgnum)->title);
+      const std::string title = stripcolors(post.title);
       const auto ft = title.find(search_string) != std::string::npos;
       const auto fb = b.find(search_string) != std::string::npos;
       fnd = ft || fb;
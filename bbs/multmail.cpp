@@ -52,7 +52,7 @@ using namespace wwiv::sdk;
 using namespace wwiv::strings;
 
 void multimail(int *pnUserNumber, int numu) {
-  mailrec m, m1;
+  mailrec m;
   char s[255];
   User user;
   memset(&m, 0, sizeof(mailrec));
@@ -157,24 +157,16 @@ void multimail(int *pnUserNumber, int numu) {
   m.daten = daten_t_now();
 
   auto pFileEmail(OpenEmailFile(true));
-  auto len = pFileEmail->length() / sizeof(mailrec);
-  File::size_type i = 0;
-  if (len != 0) {
-    i = len - 1;
-    pFileEmail->Seek(static_cast<long>(i) * sizeof(mailrec), File::Whence::begin);
-    pFileEmail->Read(&m1, sizeof(mailrec));
-    while ((i > 0) && (m1.tosys == 0) && (m1.touser == 0)) {
-      --i;
-      pFileEmail->Seek(static_cast<long>(i) * sizeof(mailrec), File::Whence::begin);
-      auto i1 = pFileEmail->Read(&m1, sizeof(mailrec));
-      if (i1 == -1) {
-        bout << "|#6DIDN'T READ WRITE!\r\n";
-      }
-    }
-    if ((m1.tosys) || (m1.touser)) {
-      ++i;
+  auto index = OpenEmailIndex(*pFileEmail);
+  const File::size_type i = index.next_slot();
+  auto slot = static_cast<int>(i);
+  for (auto cv = 0; cv < numu; cv++) {
+    if (pnUserNumber[cv] > 0) {
+      m.touser = static_cast<uint16_t>(pnUserNumber[cv]);
+      index.Update(slot++, m);
     }
   }
+  index.Save();
   pFileEmail->Seek(static_cast<long>(i) * sizeof(mailrec), File::Whence::begin);
   for (auto cv = 0; cv < numu; cv++) {
     if (pnUserNumber[cv] > 0) {
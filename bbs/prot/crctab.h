@@ -1,13 +1,17 @@
 /*	@(#)crctab.h 1.2 96/09/13	*/
 
 /*
- *  Crc calculation stuff.  See crctab.c
+ *  Crc calculation stuff.  The tables are shared with the rest of WWIV
+ *  in core/crc32.h.
  */
 
-extern unsigned short crctab[256];
+#include "core/crc32.h"
 
-#define updcrc(cp, crc) (crctab[((crc >> 8) & 255)] ^ (crc << 8) ^ cp)
-
-extern unsigned long cr3tab[];
+/*
+ * updcrc macro derived from article Copyright (C) 1986 Stephen Satchell.
+ *  NOTE: First argument must be in range 0 to 255.
+ *        Second argument is referenced twice.
+ */
+#define updcrc(cp, crc) (wwiv::core::kCrc16Table[((crc >> 8) & 255)] ^ (crc << 8) ^ cp)
 
-#define UPDC32(b, c) (cr3tab[((int)c ^ b) & 0xff] ^ ((c >> 8) & 0x00FFFFFF))
+#define UPDC32(b, c) (wwiv::core::kCrc32Table[((int)c ^ b) & 0xff] ^ ((c >> 8) & 0x00FFFFFF))
@@ -50,12 +50,14 @@ void qwk_remove_email() {
     return;
   }
 
-  const auto mfl = f->length() / sizeof(mailrec);
   uint8_t mw = 0;
 
   mailrec m{};
-  for (unsigned long i = 0; (i < mfl) && (mw < MAXMAIL); i++) {
-    f->Seek(i * sizeof(mailrec), File::Whence::begin);
+  for (const auto i : OpenEmailIndex(*f).slots(a()->sess().user_num())) {
+    if (mw >= MAXMAIL) {
+      break;
+    }
+    f->Seek(static_cast<File::size_type>(i) * sizeof(mailrec), File::Whence::begin);
     f->Read(&m, sizeof(mailrec));
     if (m.tosys == 0 && m.touser == a()->sess().user_num()) {
       tmpmailrec r{};
@@ -101,9 +103,11 @@ void qwk_gather_email(qwk_state* qwk_info) {
     bout.nl();
     return;
   }
-  const auto mfl = static_cast<int>(f->length() / sizeof(mailrec));
   uint8_t mw = 0;
-  for (auto i = 0; i < mfl && mw < MAXMAIL; i++) {
+  for (const auto i : OpenEmailIndex(*f).slots(a()->sess().user_num())) {
+    if (mw >= MAXMAIL) {
+      break;
+    }
     f->Seek(static_cast<File::size_type>(i) * sizeof(mailrec), File::Whence::begin);
     f->Read(&m, sizeof(mailrec));
     if (m.tosys == 0 && m.touser == a()->sess().user_num()) {
@@ -133,16 +137,6 @@ void qwk_gather_email(qwk_state* qwk_info) {
   auto curmail = 0;
   auto done = false;
   qwk_info->in_email = true;
-  const auto index_filemode = File::modeReadWrite | File::modeAppend | File::modeBinary | File::modeCreateFile;
-
-  const auto personal_filename = FilePath(a()->sess().dirs().qwk_directory(), "PERSONAL.NDX");
-  qwk_info->personal =
-      std::make_unique<DataFile<qwk_index>>(personal_filename, index_filemode);
-
-
-  const auto zero_filename = FilePath(a()->sess().dirs().qwk_directory(), "000.NDX");
-  qwk_info->zero = 
-      std::make_unique<DataFile<qwk_index>>(zero_filename, index_filemode);
 
   do {
     read_same_email(mloc, mw, curmail, m, 0, 0);
@@ -51,7 +51,13 @@
 #include "sdk/qwk_config.h"
 #include "sdk/subxtr.h"
 #include "sdk/vardec.h"
-#include "sdk/ansi/makeansi.h"
+#include "sdk/msgapi/type2_text.h"
+#include <algorithm>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace wwiv::core;
 using namespace wwiv::stl;
@@ -59,10 +65,6 @@ using namespace wwiv::strings;
 
 namespace wwiv::bbs::qwk {
 
-
-// Also used in qwk1.cpp
-const char *QWKFrom = "\x04""0QWKFrom:";
-
 static uint16_t max_msgs;
 
 // from xfer.cpp
@@ -94,7 +96,7 @@ bool build_control_dat(const sdk::qwk_config& qwk_cfg, Clock* clock, qwk_state *
   fp.WriteLine(a()->user()->name());
   fp.WriteLine("");
   fp.WriteLine("0");
-  fp.WriteLine(qwk_info->qwk_rec_num);
+  fp.WriteLine(qwk_info->writer ? qwk_info->writer->num_messages() : 0);
   
   const auto max_size = a()->subs().subs().size();
   const sdk::qscan_bitset qb(a()->sess().qsc_q, max_size);
@@ -155,25 +157,16 @@ void build_qwk_packet() {
   write_inst(INST_LOC_QWK, a()->current_user_sub().subnum, INST_FLAGS_ONLINE);
 
   const auto filename = FilePath(a()->sess().dirs().batch_directory(), MESSAGES_DAT);
-  const auto filemode = File::modeReadWrite | File::modeBinary | File::modeCreateFile;
   qwk_state qwk_info{};
-  qwk_info.file = std::make_unique<DataFile<qwk_record>>(filename, filemode);
+  qwk_info.writer =
+      std::make_unique<QwkPacketWriter>(filename, a()->sess().dirs().qwk_directory());
 
-  if (!qwk_info.file->ok()) {
+  if (!qwk_info.writer->ok()) {
     bout.bputs("Open error");
     sysoplog() << "Couldn't open MESSAGES.DAT";
     return;
   }
 
-  // Required header at the start of MESSAGES.DAT
-  qwk_record header{};
-  memcpy(&header, "Produced by Qmail...Copyright (c) 1987 by Sparkware.  All Rights Reserved (For Compatibility with Qmail)                        ", 128);
-  qwk_info.file->Write(&header);
-
-  // Logical record number
-  qwk_info.qwk_rec_num = 1;
-  qwk_info.qwk_rec_pos = 2;
-
   qwk_info.abort = false;
 
   if (!a()->user()->data.qwk_dont_scan_mail && !qwk_info.abort) {
@@ -207,7 +200,7 @@ void build_qwk_packet() {
 
   bool msgs_ok = true;
   for (uint16_t i = 0; i < a()->usub.size() && !a()->sess().hangup() && !qwk_info.abort && msgs_ok; i++) {
-    msgs_ok = max_msgs ? qwk_info.qwk_rec_num <= max_msgs : true;
+    msgs_ok = max_msgs ? qwk_info.writer->num_messages() < max_msgs : true;
     if (a()->sess().qsc_q[a()->usub[i].subnum / 32] & (1L << (a()->usub[i].subnum % 32))) {
       qwk_gather_sub(i, &qwk_info);
     }
@@ -227,10 +220,11 @@ void build_qwk_packet() {
     }
   }
 
-  qwk_info.file.reset(nullptr);
-  qwk_info.index.reset(nullptr);
-  qwk_info.personal.reset(nullptr);
-  qwk_info.zero.reset(nullptr);
+  if (!qwk_info.writer->Close() && !qwk_info.abort) {
+    qwk_info.abort = true; // Must be out of disk space
+    bout.bputs("Write error");
+    bout.pausescr();
+  }
 
   if (!qwk_info.abort) {
     SystemClock clock{};
@@ -328,6 +322,56 @@ void qwk_gather_sub(uint16_t bn, qwk_state* qwk_info) {
   bout.Color(0);
 }
 
+// Number of messages read from the message base at a time.  Each batch is
+// converted on the worker threads while the next one is read, and then
+// written in order.
+static constexpr int kQwkBatchSize = 256;
+
+static int qwk_num_threads() {
+  const auto n = static_cast<int>(std::thread::hardware_concurrency());
+  return std::clamp(n, 1, 8);
+}
+
+static qwk_convert_options_t qwk_convert_options() {
+  qwk_convert_options_t opts{};
+  opts.remove_color = a()->user()->data.qwk_remove_color;
+  opts.convert_color = a()->user()->data.qwk_convert_color;
+  opts.keep_routing = a()->user()->data.qwk_keep_routing;
+  return opts;
+}
+
+static qwk_source_message_t qwk_read_message(sdk::msgapi::Type2Text& text, const postrec& p,
+                                             int msgnum) {
+  qwk_source_message_t m{};
+  if (p.msg.storage_type == sdk::msgapi::STORAGE_TYPE) {
+    if (auto o = text.readfile(p.msg)) {
+      m.text = std::move(o.value());
+    }
+  }
+  if (m.text.empty()) {
+    bout << "File not found.";
+    bout.nl();
+  }
+  m.title = p.title;
+  m.anony = p.anony;
+  m.ownersys = p.ownersys;
+  m.daten = p.daten;
+  m.msgnum = msgnum;
+  return m;
+}
+
+static sdk::msgapi::Type2Text qwk_message_text(const std::string& filename) {
+  return sdk::msgapi::Type2Text(
+      FilePath(a()->config()->msgsdir(), StrCat(filename, FILENAME_DAT_EXTENSION)));
+}
+
+namespace {
+struct qwk_batch_t {
+  std::vector<qwk_source_message_t> messages;
+  std::vector<uint32_t> qscan;
+};
+}
+
 void qwk_start_read(int msgnum, qwk_state *qwk_info) {
   a()->sess().clear_irt();
 
@@ -341,155 +385,101 @@ void qwk_start_read(int msgnum, qwk_state *qwk_info) {
     set_net_num(0);
   }
 
-  auto amount = 1;
-  auto done = false;
   const auto total = a()->GetNumMessagesInCurrentMessageArea();
-  do {
-    if (msgnum > 0 && msgnum <= a()->GetNumMessagesInCurrentMessageArea()) {
-      make_pre_qwk(msgnum, qwk_info);
-    }
-    ++msgnum;
-    if (msgnum > total) {
-      done = true;
-    }
-    if (a()->user()->data.qwk_max_msgs_per_sub ? amount >
-        a()->user()->data.qwk_max_msgs_per_sub : 0) {
-      done = true;
+  const int max_per_sub = a()->user()->data.qwk_max_msgs_per_sub;
+  const auto conf_num = static_cast<uint16_t>(a()->current_user_sub().subnum + 1);
+  const auto opts = qwk_convert_options();
+  const auto num_threads = qwk_num_threads();
+  auto text = qwk_message_text(a()->current_sub().filename);
+  auto& qscan_ptr = a()->sess().qsc_p[a()->sess().GetCurrentReadMessageArea()];
+
+  // Number of messages read so far, and how many of them are yet to be written.
+  auto amount = 0;
+  auto pending = 0;
+  // Checked for every message, so an abort or hangup stops packing right away
+  // rather than at the end of a batch.
+  auto stopped = [&]() {
+    bin.checka(&qwk_info->abort);
+    return a()->sess().hangup() || qwk_info->abort;
+  };
+  auto next_batch = [&]() {
+    qwk_batch_t batch;
+    for (; msgnum > 0 && msgnum <= total && ssize(batch.messages) < kQwkBatchSize; msgnum++) {
+      if (stopped()) {
+        break;
+      }
+      if (max_per_sub && amount >= max_per_sub) {
+        break;
+      }
+      if (max_msgs && qwk_info->writer->num_messages() + pending >= max_msgs) {
+        break;
+      }
+      const auto* p = get_post(msgnum);
+      if ((p->status & (status_unvalidated | status_delete)) && !lcs()) {
+        continue;
+      }
+      auto m = qwk_read_message(text, *p, msgnum);
+      m.conf_num = conf_num;
+      batch.messages.emplace_back(std::move(m));
+      batch.qscan.push_back(p->qscan);
+      ++amount;
+      ++pending;
     }
-    if (max_msgs ? qwk_info->qwk_rec_num > max_msgs : 0) {
-      done = true;
+    return batch;
+  };
+
+  // The batch on the worker threads.
+  qwk_batch_t converting;
+  std::future<std::vector<std::optional<std::string>>> results;
+  for (;;) {
+    auto batch = next_batch();
+    if (!results.valid() && batch.messages.empty()) {
+      break;
     }
-    ++amount;
-    bin.checka(&qwk_info->abort);
-    if ((amount % 100) == 0) {
-      bout.format("\r|#9Packing Message(|#2{} |#9/ |#1{}|#9)|#0", amount, total);
+    auto done = results.valid() ? results.get() : std::vector<std::optional<std::string>>{};
+    auto written = std::move(converting);
+    converting = std::move(batch);
+    if (!converting.messages.empty()) {
+      results = std::async(std::launch::async, [&converting, opts, num_threads] {
+        return qwk_convert_messages(converting.messages, opts, num_threads);
+      });
     }
-  } while (!done && !a()->sess().hangup() && !qwk_info->abort);
-  bout.clear_whole_line();
-}
-
-void make_pre_qwk(int msgnum, qwk_state *qwk_info) {
-  auto* p = get_post(msgnum);
-  if ((p->status & (status_unvalidated | status_delete)) && !lcs()) {
-    return;
-  }
-
-  const auto nn = a()->net_num();
-  if (p->status & status_post_new_net) {
-    set_net_num(p->network.network_msg.net_number);
-  }
-
-  put_in_qwk(p, a()->current_sub().filename.c_str(), msgnum, qwk_info);
-  if (nn != a()->net_num()) {
-    set_net_num(nn);
-  }
-
-  a()->user()->messages_read(a()->user()->messages_read() + 1);
-  a()->SetNumMessagesReadThisLogon(a()->GetNumMessagesReadThisLogon() + 1);
 
-  if (p->qscan >
-      a()->sess()
-          .qsc_p[a()->sess().GetCurrentReadMessageArea()]) { // Update qscan pointer right here
-    a()->sess().qsc_p[a()->sess().GetCurrentReadMessageArea()] = p->qscan; // And here
-  }
-}
-
-
-static void insert_after_routing(std::string& text, const std::string& text2insert) {
-  const auto text_to_insert_nc = StrCat(stripcolors(text2insert), "\xE3\xE3");
-
-  size_t pos = 0;
-  const auto len = text.size();
-  while (pos < len && text[pos] != 0) {
-    if (text[pos] == 4 && text[pos + 1] == '0') {
-      while (pos < len && text[pos] != '\xE3') {
-        ++pos;
+    for (size_t i = 0; i < done.size(); i++) {
+      if (stopped()) {
+        break;
       }
-
-      if (text[pos] == '\xE3') {
-        ++pos;
+      --pending;
+      if (!done[i]) {
+        // Not in the packet, so it hasn't been read.
+        continue;
+      }
+      if (!qwk_info->writer->Write(done[i].value())) {
+        qwk_info->abort = true; // Must be out of disk space
+        bout.bputs("Write error");
+        bout.pausescr();
+        break;
+      }
+      a()->user()->messages_read(a()->user()->messages_read() + 1);
+      a()->SetNumMessagesReadThisLogon(a()->GetNumMessagesReadThisLogon() + 1);
+      // Update qscan pointer right here
+      if (written.qscan[i] > qscan_ptr) {
+        qscan_ptr = written.qscan[i];
       }
-    } else if (pos < len) {
-      text.insert(pos, text_to_insert_nc);
-      return;
     }
-  }
-}
-
-// Give us 3000 extra bytes to play with in the message text
-static constexpr int PAD_SPACE = 3000;
 
-// Takes text, deletes all ascii '10' and converts '13' to '227' ()
-// And does other conversions as specified
-// TODO(rushfan): This whole thing needs to be redone.
-static std::string make_qwk_ready(const std::string& text, const std::string& address) {
-  std::string::size_type pos = 0;
-
-  std::string temp;
-  temp.reserve(text.size() + PAD_SPACE + 1);
-
-  while (pos < text.size()) {
-    const auto x = static_cast<unsigned char>(text[pos]);
-    const auto xo = text[pos];
-    if (x == 0) {
+    if (a()->sess().hangup() || qwk_info->abort) {
       break;
     }
-    if (x == 13) {
-      temp.push_back('\xE3');
-      ++pos;
-    } else if (x == 10 || x < 3) {
-      // Strip out Newlines, NULLS, 1's and 2's
-      ++pos;
-    } else if (a()->user()->data.qwk_remove_color && x == 3) {
-      pos += 2;
-    } else if (a()->user()->data.qwk_convert_color && x == 3) {
-      const auto save_curatr = bout.curatr();
-      bout.curatr(255);
-
-      const auto ansi_string = wwiv::sdk::ansi::makeansi(text[pos + 1] - '0', bout.curatr());
-      temp.append(ansi_string);
-
-      pos += 2;
-      bout.SystemColor(save_curatr);
-    } else if (a()->user()->data.qwk_keep_routing == false && x == 4 && text[pos + 1] == '0') {
-      if (text[pos + 1] == 0) {
-        ++pos;
-      } else { 
-        while (text[pos] != '\xE3' && text[pos] != '\r' && pos < text.size() && text[pos] != 0) {
-          ++pos;
-        }
-      }
-      ++pos;
-      if (pos < text.size() && text[pos] == '\n') {
-        ++pos;
-      }
-    } else if (x == 4 && text[pos + 1] != '0') {
-      pos += 2;
-    } else {
-      temp.push_back(xo);
-      ++pos;
+    if (!done.empty()) {
+      bout.format("\r|#9Packing Message(|#2{} |#9/ |#1{}|#9)|#0", amount - pending, total);
     }
   }
-
-  // Only add address if it does not yet exist
-  if (temp.find("QWKFrom:") != std::string::npos) {
-    // Don't search for diamond or number, just text after that
-    insert_after_routing(temp, address);
-  }
-
-  temp.shrink_to_fit();
-  return temp;
-}
-
-static void qwk_remove_null(char *memory, int size) {
-  auto pos = 0;
-
-  while (pos < size) {
-    if (memory[pos] == 0) {
-      memory[pos] = ' ';
-    }
-    ++pos;
+  if (results.valid()) {
+    // Aborted, throw away the batch in progress.
+    results.wait();
   }
+  bout.clear_whole_line();
 }
 
 void put_in_qwk(postrec *m1, const char *fn, int msgnum, qwk_state *qwk_info) {
@@ -498,128 +488,30 @@ void put_in_qwk(postrec *m1, const char *fn, int msgnum, qwk_state *qwk_info) {
       return;
     }
   }
-  memset(&qwk_info->qwk_rec, ' ', sizeof(qwk_info->qwk_rec));
-
-  auto m = read_type2_message(&m1->msg, static_cast<char>(m1->anony & 0x0f), true,
-                              fn, m1->ownersys, m1->owneruser);
-
-  int cur = 0;
-  if (m.message_text.empty() && m.title.empty()) {
-    // TODO(rushfan): Really read_type2_message should return an std::optional<Type2MessageData>
-    bout << "File not found.";
-    bout.nl();
-    return;
-  }
 
-  auto len = m.message_text.length();
-  if (len <= 0) {
-    std::cout << "we have no text for this message." << std::endl;
+  auto text = qwk_message_text(fn);
+  auto m = qwk_read_message(text, *m1, msgnum);
+  if (m.text.empty()) {
     return;
   }
-  auto ss = m.message_text;
-  auto n = m.from_user_name;
-  auto d = m.date;
-
-  auto qwk_address = StrCat(QWKFrom, n);  // Copy wwivnet address to qwk_address
-  if (qwk_address.find('@') != std::string::npos) {
-    qwk_address.append(fmt::format("@{}", m1->ownersys));
-  }
-
-  // Took the annonomouse stuff out right here
-  if (!qwk_info->in_email) {
-    // Maybe m.to_user_name is valid here?
-    if (!m.to_user_name.empty()) {
-    strncpy(qwk_info->qwk_rec.to, m.to_user_name.c_str(), 25);
-    } else {
-      memcpy(qwk_info->qwk_rec.to, "ALL", 3);
-    }
-  } else {
-    auto temp = ToStringUpperCase(a()->user()->name());
-    strncpy(qwk_info->qwk_rec.to, temp.c_str(), 25);
-  }
-  auto temp_from = ToStringUpperCase(stripcolors(n));
-  strncpy(qwk_info->qwk_rec.from, temp_from.c_str(), 25);
-
-  auto dt = DateTime::from_daten(m1->daten);
-  auto date = dt.to_string("%m-%d-%y");
-  // to_char_array uses strncpy_safe which expects buffer to be big enough for
-  // a trailing 0.  Use memcpy instead.
-  memcpy(qwk_info->qwk_rec.date, date.c_str(), sizeof(qwk_info->qwk_rec.date));
-
-  ss = make_qwk_ready(ss, qwk_address);
-  // Update length since we don't do it in make_qwk_ready anymore.
-  len = ss.length();
-  auto amount_blocks = static_cast<int>(len / sizeof(qwk_info->qwk_rec) + 2);
-
-  // Save Qwk Record
-  sprintf(qwk_info->qwk_rec.amount_blocks, "%d", amount_blocks);
-  sprintf(qwk_info->qwk_rec.msgnum, "%d", msgnum);
-
-  if (!qwk_info->in_email) {
-    strncpy(qwk_info->qwk_rec.subject, stripcolors(m1->title), 25);
-  } else {
-    strncpy(qwk_info->qwk_rec.subject,qwk_info->email_title, 25);
-  }
-
-  qwk_remove_null(reinterpret_cast<char*>(&qwk_info->qwk_rec), 123);
   if (qwk_info->in_email) {
+    m.to = ToStringUpperCase(a()->user()->name());
+    m.title.assign(qwk_info->email_title, strnlen(qwk_info->email_title, sizeof(qwk_info->email_title)));
     // email conference is always zero.
-    qwk_info->qwk_rec.conf_num = 0;
+    m.conf_num = 0;
   } else {
-    qwk_info->qwk_rec.conf_num = a()->current_user_sub().subnum + 1;
+    m.conf_num = static_cast<uint16_t>(a()->current_user_sub().subnum + 1);
   }
-  qwk_info->qwk_rec.logical_num = qwk_info->qwk_rec_num;
 
-  if (!qwk_info->file->Write(&qwk_info->qwk_rec)) {
+  const auto o = qwk_convert_message(m, qwk_convert_options());
+  if (!o) {
+    return;
+  }
+  if (!qwk_info->writer->Write(o.value(), qwk_info->in_email)) {
     qwk_info->abort = true; // Must be out of disk space
     bout.bputs("Write error");
     bout.pausescr();
   }
-
-  // Save Qwk NDX
-  qwk_info->qwk_ndx.pos = static_cast<float>(qwk_info->qwk_rec_pos);
-  float msbin = 0.0f;
-  _fieeetomsbin(&qwk_info->qwk_ndx.pos, &msbin);
-  qwk_info->qwk_ndx.pos = msbin;
-  qwk_info->qwk_ndx.nouse = 0;
-
-  if (!qwk_info->in_email) { // Only if currently doing messages...
-    // Create new index if it hasn't been already
-    if (a()->current_user_sub_num() != static_cast<uint16_t>(qwk_info->cursub) || !qwk_info->index) {
-      qwk_info->cursub = a()->current_user_sub_num();
-      const auto filename =
-          fmt::sprintf("%s%03d.NDX", a()->sess().dirs().qwk_directory().string(), a()->current_user_sub().subnum + 1);
-      const auto index_filemode = File::modeReadWrite | File::modeAppend | File::modeBinary | File::modeCreateFile;
-      qwk_info->index = std::make_unique<DataFile<qwk_index>>(filename, index_filemode);
-    }
-
-    qwk_info->index->Write(&qwk_info->qwk_ndx);
-  } else { // Write to email indexes
-    qwk_info->zero->Write(&qwk_info->qwk_ndx);
-    qwk_info->personal->Write(&qwk_info->qwk_ndx);
-  }
-
-  // Setup next NDX position
-  qwk_info->qwk_rec_pos += static_cast<uint16_t>(amount_blocks);
-
-  int cur_block = 2;
-  while (cur_block <= amount_blocks && !a()->sess().hangup()) {
-    size_t this_pos;
-    memset(&qwk_info->qwk_rec, ' ', sizeof(qwk_info->qwk_rec));
-    this_pos = (cur_block - 2) * sizeof(qwk_info->qwk_rec);
-
-    if (this_pos < len) {
-      size_t size = (this_pos + sizeof(qwk_info->qwk_rec) > static_cast<size_t>(len)) ? (len - this_pos - 1) : sizeof(qwk_info->qwk_rec);
-      memmove(&qwk_info->qwk_rec, ss.data() + cur + this_pos, size);
-    }
-    // Save this block
-    qwk_info->file->Write(&qwk_info->qwk_rec);
-
-    this_pos += sizeof(qwk_info->qwk_rec);
-    ++cur_block;
-  }
-  // Global variable on total amount of records saved
-  ++qwk_info->qwk_rec_num;
 }
 
 static void qwk_send_file(const std::string& fn, bool *sent, bool *abort) {
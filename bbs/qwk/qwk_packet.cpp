@@ -0,0 +1,355 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "bbs/qwk/qwk_packet.h"
+
+#include "bbs/qwk/qwk_struct.h"
+#include "bbs/qwk/qwk_util.h"
+#include "core/log.h"
+#include "core/stl.h"
+#include "core/strings.h"
+#include "fmt/format.h"
+#include "local_io/keycodes.h"
+#include "sdk/vardec.h"
+#include "sdk/ansi/makeansi.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <utility>
+
+using namespace wwiv::core;
+using namespace wwiv::stl;
+using namespace wwiv::strings;
+
+namespace wwiv::bbs::qwk {
+
+// Also used in qwk_text.cpp
+const char *QWKFrom = "\x04""0QWKFrom:";
+
+static constexpr auto QWK_BLOCK_SIZE = sizeof(qwk_record);
+
+static void insert_after_routing(std::string& text, const std::string& text2insert) {
+  const auto text_to_insert_nc = StrCat(stripcolors(text2insert), "\xE3\xE3");
+
+  size_t pos = 0;
+  const auto len = text.size();
+  while (pos < len && text[pos] != 0) {
+    if (text[pos] == 4 && text[pos + 1] == '0') {
+      while (pos < len && text[pos] != '\xE3') {
+        ++pos;
+      }
+
+      if (text[pos] == '\xE3') {
+        ++pos;
+      }
+    } else if (pos < len) {
+      text.insert(pos, text_to_insert_nc);
+      return;
+    }
+  }
+}
+
+// Give us 3000 extra bytes to play with in the message text
+static constexpr int PAD_SPACE = 3000;
+
+// TODO(rushfan): This whole thing needs to be redone.
+std::string make_qwk_ready(const std::string& text, const std::string& address,
+                           const qwk_convert_options_t& opts) {
+  std::string::size_type pos = 0;
+
+  std::string temp;
+  temp.reserve(text.size() + PAD_SPACE + 1);
+
+  while (pos < text.size()) {
+    const auto x = static_cast<unsigned char>(text[pos]);
+    const auto xo = text[pos];
+    if (x == 0) {
+      break;
+    }
+    if (x == 13) {
+      temp.push_back('\xE3');
+      ++pos;
+    } else if (x == 10 || x < 3) {
+      // Strip out Newlines, NULLS, 1's and 2's
+      ++pos;
+    } else if (opts.remove_color && x == 3) {
+      pos += 2;
+    } else if (opts.convert_color && x == 3) {
+      temp.append(sdk::ansi::makeansi(text[pos + 1] - '0', 255));
+      pos += 2;
+    } else if (!opts.keep_routing && x == 4 && text[pos + 1] == '0') {
+      if (text[pos + 1] == 0) {
+        ++pos;
+      } else { 
+        while (text[pos] != '\xE3' && text[pos] != '\r' && pos < text.size() && text[pos] != 0) {
+          ++pos;
+        }
+      }
+      ++pos;
+      if (pos < text.size() && text[pos] == '\n') {
+        ++pos;
+      }
+    } else if (x == 4 && text[pos + 1] != '0') {
+      pos += 2;
+    } else {
+      temp.push_back(xo);
+      ++pos;
+    }
+  }
+
+  // Only add address if it does not yet exist
+  if (temp.find("QWKFrom:") != std::string::npos) {
+    // Don't search for diamond or number, just text after that
+    insert_after_routing(temp, address);
+  }
+
+  return temp;
+}
+
+static void qwk_remove_null(char *memory, int size) {
+  for (auto pos = 0; pos < size; pos++) {
+    if (memory[pos] == 0) {
+      memory[pos] = ' ';
+    }
+  }
+}
+
+// Splits the name and date lines off the front of the message the same way
+// read_type2_message does.
+static std::string parse_message_text(const std::string& raw, std::string& from,
+                                      std::string& fido_to) {
+  size_t ptr;
+  for (ptr = 0; ptr < raw.size() && raw[ptr] != RETURN && ptr <= 200; ptr++) {
+    from.push_back(raw[ptr]);
+  }
+  if (ptr < raw.size() && raw[++ptr] == SOFTRETURN) {
+    ++ptr;
+  }
+  for (const auto start = ptr; ptr < raw.size() && raw[ptr] != RETURN && ptr - start <= 60;
+       ptr++) {
+  }
+  auto text = raw;
+  if (ptr + 1 < raw.size()) {
+    // skip trailing \r\n
+    while (ptr + 1 < raw.size() && (raw[ptr] == '\r' || raw[ptr] == '\n')) {
+      ptr++;
+    }
+    text = raw.substr(ptr);
+  }
+
+  for (auto line : SplitString(text, "\r")) {
+    StringTrim(&line);
+    if (starts_with(line, "\004" "0FidoAddr: ") && line.size() > 12) {
+      fido_to = line.substr(12);
+      break;
+    }
+  }
+
+  if (!text.empty() && text.back() == CZ) {
+    text.pop_back();
+  }
+  return text;
+}
+
+std::optional<std::string> qwk_convert_message(const qwk_source_message_t& m,
+                                               const qwk_convert_options_t& opts) {
+  std::string from;
+  std::string fido_to;
+  const auto text = parse_message_text(m.text, from, fido_to);
+  if (text.empty()) {
+    return std::nullopt;
+  }
+  switch (m.anony & 0x0f) {
+  case anony_sender:
+  case anony_sender_da:
+  case anony_sender_pp:
+    from = StrCat("<<< ", from, " >>>");
+    break;
+  default:
+    break;
+  }
+
+  auto qwk_address = StrCat(QWKFrom, from);
+  if (qwk_address.find('@') != std::string::npos) {
+    qwk_address.append(fmt::format("@{}", m.ownersys));
+  }
+  const auto ss = make_qwk_ready(text, qwk_address, opts);
+  const auto len = ss.size();
+  const auto amount_blocks = static_cast<int>(len / QWK_BLOCK_SIZE + 2);
+
+  std::string out(amount_blocks * QWK_BLOCK_SIZE, ' ');
+  qwk_record rec{};
+  memset(&rec, ' ', sizeof(qwk_record));
+  const auto& to = !m.to.empty() ? m.to : fido_to;
+  if (!to.empty()) {
+    strncpy(rec.to, to.c_str(), sizeof(rec.to));
+  } else {
+    memcpy(rec.to, "ALL", 3);
+  }
+  strncpy(rec.from, ToStringUpperCase(stripcolors(from)).c_str(), sizeof(rec.from));
+  const auto date = DateTime::from_daten(m.daten).to_string("%m-%d-%y");
+  memcpy(rec.date, date.c_str(), std::min(date.size(), sizeof(rec.date)));
+
+  // These are written with a trailing NUL, which qwk_remove_null turns into
+  // a space.
+  char num[16];
+  snprintf(num, sizeof(num), "%d", amount_blocks);
+  memcpy(rec.amount_blocks, num, std::min(strlen(num) + 1, sizeof(rec.amount_blocks)));
+  snprintf(num, sizeof(num), "%d", m.msgnum);
+  memcpy(rec.msgnum, num, std::min(strlen(num) + 1, sizeof(rec.msgnum)));
+  strncpy(rec.subject, stripcolors(m.title).c_str(), sizeof(rec.subject));
+
+  qwk_remove_null(reinterpret_cast<char*>(&rec), offsetof(qwk_record, conf_num));
+  rec.conf_num = m.conf_num;
+  rec.logical_num = 0;
+  memcpy(out.data(), &rec, sizeof(qwk_record));
+
+  // The last character of the text has never been included in the packet, so
+  // keep doing that to produce the same packets as before.
+  for (size_t this_pos = 0; this_pos < len; this_pos += QWK_BLOCK_SIZE) {
+    const auto size = this_pos + QWK_BLOCK_SIZE > len ? len - this_pos - 1 : QWK_BLOCK_SIZE;
+    memcpy(&out[QWK_BLOCK_SIZE + this_pos], ss.data() + this_pos, size);
+  }
+  return {out};
+}
+
+std::vector<std::optional<std::string>>
+qwk_convert_messages(const std::vector<qwk_source_message_t>& messages,
+                     const qwk_convert_options_t& opts, int num_threads) {
+  // Not worth starting a thread for fewer than this many messages.
+  static constexpr int kMinMessagesPerThread = 16;
+
+  std::vector<std::optional<std::string>> out(messages.size());
+  const auto total = ssize(messages);
+  const auto threads =
+      std::max(1, std::min(num_threads, static_cast<int>(total / kMinMessagesPerThread)));
+  const auto per_thread = (total + threads - 1) / threads;
+
+  auto convert = [&](int64_t start, int64_t end) {
+    for (auto i = start; i < end; i++) {
+      out[i] = qwk_convert_message(messages[i], opts);
+    }
+  };
+  std::vector<std::future<void>> workers;
+  for (auto t = 1; t < threads; t++) {
+    workers.emplace_back(std::async(std::launch::async, convert, t * per_thread,
+                                    std::min(total, (t + 1) * per_thread)));
+  }
+  // Use this thread for the first slice.
+  convert(0, std::min(total, per_thread));
+  for (auto& w : workers) {
+    w.get();
+  }
+  return out;
+}
+
+QwkPacketWriter::QwkPacketWriter(const std::filesystem::path& messages_dat,
+                                 std::filesystem::path index_dir, int buffer_size)
+    : file_(messages_dat), index_dir_(std::move(index_dir)),
+      buffer_size_(static_cast<std::size_t>(std::max<int>(QWK_BLOCK_SIZE, buffer_size))) {
+  if (!file_.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile |
+                  File::modeTruncate)) {
+    LOG(ERROR) << "Unable to create: " << messages_dat.string();
+    return;
+  }
+  buffer_.reserve(buffer_size_ + QWK_BLOCK_SIZE);
+  // Required header at the start of MESSAGES.DAT
+  buffer_.append("Produced by Qmail...Copyright (c) 1987 by Sparkware.  All Rights Reserved "
+                 "(For Compatibility with Qmail)");
+  buffer_.resize(QWK_BLOCK_SIZE, ' ');
+  ok_ = true;
+}
+
+QwkPacketWriter::~QwkPacketWriter() { Close(); }
+
+bool QwkPacketWriter::WriteBuffer() {
+  if (buffer_.empty()) {
+    return true;
+  }
+  const auto num = file_.Write(buffer_);
+  if (num != static_cast<File::size_type>(buffer_.size())) {
+    // Must be out of disk space
+    LOG(ERROR) << "Error writing: " << file_ << " num written (" << num
+               << ") != " << buffer_.size();
+    ok_ = false;
+  }
+  buffer_.clear();
+  return ok_;
+}
+
+bool QwkPacketWriter::Write(const std::string& message, bool personal) {
+  if (!ok_ || !file_.IsOpen()) {
+    return false;
+  }
+  if (message.size() < QWK_BLOCK_SIZE || message.size() % QWK_BLOCK_SIZE != 0) {
+    LOG(ERROR) << "Invalid QWK message of size: " << message.size();
+    return false;
+  }
+  qwk_record header{};
+  memcpy(&header, message.data(), sizeof(qwk_record));
+  header.logical_num = static_cast<uint16_t>(++num_messages_);
+  buffer_.append(reinterpret_cast<const char*>(&header), sizeof(qwk_record));
+  buffer_.append(message, QWK_BLOCK_SIZE, std::string::npos);
+
+  qwk_index ndx{};
+  auto pos = static_cast<float>(next_block_);
+  _fieeetomsbin(&pos, &ndx.pos);
+  ndx.nouse = 0;
+  const auto* ndx_data = reinterpret_cast<const char*>(&ndx);
+  index_[header.conf_num].append(ndx_data, sizeof(qwk_index));
+  if (personal) {
+    personal_.append(ndx_data, sizeof(qwk_index));
+  }
+  next_block_ += static_cast<uint32_t>(message.size() / QWK_BLOCK_SIZE);
+
+  if (buffer_.size() >= buffer_size_) {
+    return WriteBuffer();
+  }
+  return true;
+}
+
+static bool append_index(const std::filesystem::path& path, const std::string& data) {
+  File f(path);
+  if (!f.Open(File::modeReadWrite | File::modeAppend | File::modeBinary | File::modeCreateFile)) {
+    LOG(ERROR) << "Unable to open: " << path.string();
+    return false;
+  }
+  return f.Write(data) == static_cast<File::size_type>(data.size());
+}
+
+bool QwkPacketWriter::Close() {
+  if (!file_.IsOpen()) {
+    return ok_;
+  }
+  WriteBuffer();
+  file_.Close();
+  for (const auto& [conf, data] : index_) {
+    if (!append_index(FilePath(index_dir_, fmt::format("{:03}.NDX", conf)), data)) {
+      ok_ = false;
+    }
+  }
+  if (!personal_.empty() && !append_index(FilePath(index_dir_, "PERSONAL.NDX"), personal_)) {
+    ok_ = false;
+  }
+  index_.clear();
+  personal_.clear();
+  return ok_;
+}
+
+}
@@ -0,0 +1,124 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_BBS_QWK_QWK_PACKET_H
+#define INCLUDED_BBS_QWK_QWK_PACKET_H
+
+#include "core/file.h"
+#include "core/datetime.h"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wwiv::bbs::qwk {
+
+// The user's QWK text conversion settings.
+struct qwk_convert_options_t {
+  bool remove_color{false};
+  bool convert_color{false};
+  bool keep_routing{false};
+};
+
+// A message as it was read from the message base, along with the bits of
+// its header that end up in the QWK packet.
+struct qwk_source_message_t {
+  // Raw message text, including the name and date lines.
+  std::string text;
+  std::string title;
+  // If empty, the FidoAddr control line or "ALL" is used.
+  std::string to;
+  uint8_t anony{0};
+  uint16_t ownersys{0};
+  daten_t daten{0};
+  int msgnum{0};
+  uint16_t conf_num{0};
+};
+
+// Takes text, deletes all ascii '10' and converts '13' to '227'
+// And does other conversions as specified
+std::string make_qwk_ready(const std::string& text, const std::string& address,
+                           const qwk_convert_options_t& opts);
+
+/**
+ * Converts a message into the MESSAGES.DAT header record and text blocks.
+ * The logical message number is left for QwkPacketWriter to fill in.  Returns
+ * nullopt if the message has no text.
+ *
+ * This only depends on its arguments, so it may be called from any thread.
+ */
+std::optional<std::string> qwk_convert_message(const qwk_source_message_t& m,
+                                               const qwk_convert_options_t& opts);
+
+/**
+ * Converts messages using up to num_threads threads.  The results are in the
+ * same order as messages.
+ */
+std::vector<std::optional<std::string>>
+qwk_convert_messages(const std::vector<qwk_source_message_t>& messages,
+                     const qwk_convert_options_t& opts, int num_threads);
+
+/**
+ * Writes MESSAGES.DAT and the NDX files for a QWK packet in one pass.
+ * Messages are numbered in the order they are written, and output is
+ * buffered so that each write is large regardless of the message sizes.
+ */
+class QwkPacketWriter final {
+public:
+  QwkPacketWriter(const std::filesystem::path& messages_dat,
+                  std::filesystem::path index_dir, int buffer_size = 1024 * 1024);
+  ~QwkPacketWriter();
+  QwkPacketWriter(const QwkPacketWriter&) = delete;
+  QwkPacketWriter& operator=(const QwkPacketWriter&) = delete;
+
+  [[nodiscard]] bool ok() const noexcept { return ok_; }
+
+  /**
+   * Appends a message returned by qwk_convert_message and adds it to the
+   * NDX for its conference.  Personal messages are also added to
+   * PERSONAL.NDX.
+   */
+  bool Write(const std::string& message, bool personal = false);
+
+  /** Writes out the buffered messages and indexes and closes the files. */
+  bool Close();
+
+  /** Number of messages written so far. */
+  [[nodiscard]] int num_messages() const noexcept { return num_messages_; }
+
+private:
+  bool WriteBuffer();
+
+  core::File file_;
+  const std::filesystem::path index_dir_;
+  const std::size_t buffer_size_;
+  std::string buffer_;
+  // NDX file contents by conference number.
+  std::map<uint16_t, std::string> index_;
+  std::string personal_;
+  // Record number (1 based) where the next message goes.
+  uint32_t next_block_{2};
+  int num_messages_{0};
+  bool ok_{false};
+};
+
+}
+
+#endif
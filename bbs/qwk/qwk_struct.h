@@ -19,9 +19,11 @@
 #ifndef INCLUDED_BBS_QWK_QWK_STRUCT_H
 #define INCLUDED_BBS_QWK_QWK_STRUCT_H
 
+#include "bbs/qwk/qwk_packet.h"
 #include "core/file.h"
 #include "core/datafile.h"
 #include <cstdint>
+#include <memory>
 
 
 namespace wwiv::bbs::qwk {
@@ -53,20 +55,8 @@ struct qwk_index {
 };
 
 struct qwk_state {
-  uint16_t qwk_rec_num;
-  uint16_t qwk_rec_pos;
-
-  // File number for the MESSAGES.DAT file
-  std::unique_ptr<wwiv::core::DataFile<qwk_record>>  file;
-
-  // File number for the *.NDX files
-  std::unique_ptr<wwiv::core::DataFile<qwk_index>> index;
-  int cursub;
-  std::unique_ptr<wwiv::core::DataFile<qwk_index>> personal;  // personal.ndx
-  std::unique_ptr<wwiv::core::DataFile<qwk_index>> zero;      // 000.ndx for email
-
-  qwk_record qwk_rec;
-  qwk_index qwk_ndx;
+  // Writes MESSAGES.DAT and the *.NDX files
+  std::unique_ptr<QwkPacketWriter> writer;
 
   bool abort{false};
   bool in_email{false};
@@ -176,6 +176,9 @@ static void resynch_email(vector<tmpmailrec>& mloc, int mw, int rec, mailrec* m,
     }
     if (del && (mloc[rec].index >= 0)) {
       if (del == 2) {
+        auto index = OpenEmailIndex(*pFileEmail);
+        index.Remove(mloc[rec].index);
+        index.Save();
         m->touser = 0;
         m->tosys = 0;
         m->daten = 0xffffffff;
@@ -225,6 +228,9 @@ bool read_same_email(std::vector<tmpmailrec>& mloc, int mw, int rec, mailrec& m,
     }
     if (del) {
       if (del == 2) {
+        auto index = OpenEmailIndex(*file);
+        index.Remove(mloc[rec].index);
+        index.Save();
         m.touser = 0;
         m.tosys = 0;
         m.daten = 0xffffffff;
@@ -354,10 +360,14 @@ void readmail(int mode) {
       bout << "\r\n\nNo mail file exists!\r\n\n";
       return;
     }
-    auto mfl = static_cast<File::size_type>(pFileEmail->length() / sizeof(mailrec));
-    for (i = 0; i < mfl && mw < MAXMAIL; i++) {
+    for (const auto slot : OpenEmailIndex(*pFileEmail).slots(a()->sess().user_num())) {
+      if (mw >= MAXMAIL) {
+        break;
+      }
+      i = slot;
       pFileEmail->Seek(i * sizeof(mailrec), File::Whence::begin);
       pFileEmail->Read(&m, sizeof(mailrec));
+      // The index may be behind EMAIL.DAT, so make sure it's still ours.
       if (m.tosys == 0 && m.touser == a()->sess().user_num()) {
         tmpmailrec r = {};
         r.index = static_cast<int16_t>(i);
@@ -995,6 +1005,9 @@ void readmail(int mode) {
                     delete_attachment(m.daten, 0);
                   }
                   delme = 1;
+                  auto index = OpenEmailIndex(*file);
+                  index.Remove(mloc[curmail].index);
+                  index.Save();
                   m1.touser = 0;
                   m1.tosys = 0;
                   m1.daten = 0xffffffff;
@@ -1219,10 +1232,9 @@ int check_new_mail(int user_number) {
 
   auto pFileEmail(OpenEmailFile(false));
   if (pFileEmail->Exists() && pFileEmail->IsOpen()) {
-    const auto mfLength = static_cast<int>(pFileEmail->length() / sizeof(mailrec));
-    for (auto i = 0; i < mfLength; i++) {
+    for (const auto i : OpenEmailIndex(*pFileEmail).slots(user_number)) {
       mailrec m{};
-      pFileEmail->Seek(i * sizeof(mailrec), File::Whence::begin);
+      pFileEmail->Seek(static_cast<File::size_type>(i) * sizeof(mailrec), File::Whence::begin);
       pFileEmail->Read(&m, sizeof(mailrec));
       if (m.tosys == 0 && m.touser == user_number) {
         if (!(m.status & status_seen)) {
@@ -30,6 +30,7 @@
 #include "common/com.h"
 #include "common/datetime.h"
 #include "common/input.h"
+#include "core/crc32.h"
 #include "core/numbers.h"
 #include "core/scope_exit.h"
 #include "core/stl.h"
@@ -56,15 +57,7 @@ unsigned char checksum = 0;
 void calc_CRC(unsigned char b) {
   checksum = checksum + b;
 
-  crc ^= (static_cast<unsigned short>(b) << 8);
-  for (auto i = 0; i < 8; i++) {
-    if (crc & 0x8000) {
-      crc = crc << 1;
-      crc ^= 0x1021;
-    } else {
-      crc = crc << 1;
-    }
-  }
+  crc = crc16_byte(crc, b);
 }
 
 
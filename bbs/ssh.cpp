@@ -459,6 +459,11 @@ bool IOSSH::incoming() {
   return io_->incoming();
 }
 
+void IOSSH::flush() {
+  if (!initialized_) return;
+  io_->flush();
+}
+
 unsigned int IOSSH::GetHandle() const { 
   if (!initialized_) return false;
   return io_->GetHandle();
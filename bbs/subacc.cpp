@@ -31,6 +31,7 @@
 #include "core/version.h"
 #include "core/wwivport.h"
 #include "sdk/config.h"
+#include "sdk/msgapi/message_search_index.h"
 #include "sdk/status.h"
 #include "sdk/subxtr.h"
 #include "sdk/vardec.h"
@@ -40,6 +41,7 @@
 using std::string;
 using namespace wwiv::core;
 using namespace wwiv::sdk;
+using namespace wwiv::sdk::msgapi;
 using namespace wwiv::strings;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -243,6 +245,13 @@ void add_post(postrec* pp) {
   fileSub->Seek(a()->GetNumMessagesInCurrentMessageArea() * sizeof(postrec), File::Whence::begin);
   fileSub->Write(pp, sizeof(postrec));
 
+  // Keep the search index up to date, if this sub has one.
+  if (const MessageSearchIndex index(subdat_fn); index.exists()) {
+    if (auto o = readfile(&pp->msg, a()->current_sub().filename)) {
+      index.JournalAdd(*pp, o.value());
+    }
+  }
+
   // we've modified the sub
   a()->subchg = 0;
 
@@ -269,6 +278,7 @@ void delete_message(int mn) {
       if (auto* buffer = static_cast<char*>(malloc(BUFSIZE))) {
         const auto* p1 = get_post(mn);
         remove_link(&(p1->msg), a()->current_sub().filename);
+        MessageSearchIndex(subdat_fn).JournalRemove(p1->qscan);
 
         auto cp = static_cast<long>(mn + 1) * sizeof(postrec);
         const auto len = static_cast<long>(a()->GetNumMessagesInCurrentMessageArea() + 1) * sizeof(postrec);
@@ -40,6 +40,7 @@
 #include "local_io/wconstants.h"
 #include "sdk/config.h"
 #include "sdk/files/arc.h"
+#include "sdk/files/file_catalog.h"
 #include "sdk/files/files.h"
 #include <string>
 #include <vector>
@@ -225,6 +226,24 @@ void dliscan() {
   dliscan1(a()->dirs()[a()->current_user_dir().subnum]);
 }
 
+std::unique_ptr<wwiv::sdk::files::FileCatalog> load_file_catalog() {
+  auto catalog = std::make_unique<wwiv::sdk::files::FileCatalog>(a()->config()->datadir());
+  if (!catalog->Load()) {
+    return {};
+  }
+  return catalog;
+}
+
+bool dir_may_match(const wwiv::sdk::files::FileCatalog* catalog, int udir_num,
+                   const wwiv::sdk::files::file_catalog_query_t& q) {
+  if (!catalog) {
+    return true;
+  }
+  const auto& dir = a()->dirs()[a()->udir[udir_num].subnum];
+  const auto c = catalog->candidates(dir.filename, q);
+  return !c || !c->empty();
+}
+
 std::string aligns(const std::string& file_name) {
   return wwiv::sdk::files::align(file_name);
 }
@@ -429,6 +448,9 @@ void nscanall() {
   bool abort = false;
   int count = 0;
   int color = 3;
+  const auto catalog = load_file_catalog();
+  wwiv::sdk::files::file_catalog_query_t q{};
+  q.newer_than = a()->sess().nscandate();
   bout << "\r|#2Searching ";
   for (uint16_t i = 0; i < size_int(a()->udir) && !abort; i++) {
     count++;
@@ -446,7 +468,8 @@ void nscanall() {
       }
     }
     int nSubNum = a()->udir[i].subnum;
-    if (a()->sess().qsc_n[nSubNum / 32] & (1L << (nSubNum % 32))) {
+    if ((a()->sess().qsc_n[nSubNum / 32] & (1L << (nSubNum % 32))) &&
+        dir_may_match(catalog.get(), i, q)) {
       bool need_title = true;
       nscandir(i, need_title, &abort);
     }
@@ -478,6 +501,9 @@ void searchall() {
   bout.nl(2);
   bout << "Search all directories.\r\n";
   const auto filemask = file_mask();
+  const auto catalog = load_file_catalog();
+  wwiv::sdk::files::file_catalog_query_t q{};
+  q.filemask = filemask;
   bout.nl();
   bout << "|#2Searching ";
   bout.clear_lines_listed();
@@ -504,6 +530,9 @@ void searchall() {
           color = 0;
         }
       }
+      if (!dir_may_match(catalog.get(), i, q)) {
+        continue;
+      }
       a()->set_current_user_dir_num(i);
       dliscan();
       bool need_title = true;
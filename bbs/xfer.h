@@ -20,12 +20,15 @@
 
 #include "core/file.h"
 #include "sdk/vardec.h"
+#include <memory>
 #include <string>
 
 namespace wwiv {
 namespace sdk {
 namespace files {
 struct directory_t;
+struct file_catalog_query_t;
+class FileCatalog;
 }
 }
 }
@@ -40,6 +43,14 @@ bool dcs();
 void dliscan1(int directory_num);
 void dliscan1(const wwiv::sdk::files::directory_t& dir);
 void dliscan();
+/** Loads the file catalog, or returns nullptr if it hasn't been built. */
+std::unique_ptr<wwiv::sdk::files::FileCatalog> load_file_catalog();
+/**
+ * False if the catalog shows nothing in user directory udir_num can match q,
+ * so it doesn't need to be scanned.  True if catalog is nullptr.
+ */
+bool dir_may_match(const wwiv::sdk::files::FileCatalog* catalog, int udir_num,
+                   const wwiv::sdk::files::file_catalog_query_t& q);
 std::string aligns(const std::string& file_name);
 void printinfo(uploadsrec* upload_record, bool* abort);
 void printtitle(bool* abort);
@@ -0,0 +1,244 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "bbs/qwk/qwk_packet.h"
+#include "bbs/qwk/qwk_struct.h"
+#include "bbs/qwk/qwk_util.h"
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/vardec.h"
+#include "sdk/msgapi/type2_text.h"
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::bbs::qwk;
+using namespace wwiv::core;
+using namespace wwiv::sdk::msgapi;
+using namespace wwiv::strings;
+
+static qwk_source_message_t CreateMessage(const std::string& from, const std::string& body,
+                                          int msgnum = 1) {
+  qwk_source_message_t m{};
+  m.text = StrCat(from, "\r\n", "Sat Jan 02 12:34:56 2021\r\n", body);
+  m.title = "Title";
+  m.msgnum = msgnum;
+  m.conf_num = 2;
+  return m;
+}
+
+static qwk_record Header(const std::string& message) {
+  qwk_record r{};
+  memcpy(&r, message.data(), sizeof(qwk_record));
+  return r;
+}
+
+static std::string Field(const char* f, size_t len) { return StringTrim(std::string(f, len)); }
+
+static std::string msbin(uint32_t pos) {
+  auto f = static_cast<float>(pos);
+  float out{};
+  _fieeetomsbin(&f, &out);
+  return std::string(reinterpret_cast<const char*>(&out), sizeof(float));
+}
+
+TEST(QwkPacketTest, ConvertMessage) {
+  const auto o = qwk_convert_message(CreateMessage("Rushfan #1", "Hello\r\nWorld\r\n", 12), {});
+  ASSERT_TRUE(o.has_value());
+  const auto& s = o.value();
+  ASSERT_EQ(2 * sizeof(qwk_record), s.size());
+
+  const auto h = Header(s);
+  EXPECT_EQ("ALL", Field(h.to, sizeof(h.to)));
+  EXPECT_EQ("RUSHFAN #1", Field(h.from, sizeof(h.from)));
+  EXPECT_EQ("Title", Field(h.subject, sizeof(h.subject)));
+  EXPECT_EQ("12", Field(h.msgnum, sizeof(h.msgnum)));
+  EXPECT_EQ("2", Field(h.amount_blocks, sizeof(h.amount_blocks)));
+  EXPECT_EQ(2, h.conf_num);
+  EXPECT_EQ(0, h.logical_num);
+  // Nothing in the header is left as a NUL.
+  EXPECT_EQ(nullptr, memchr(&h, 0, offsetof(qwk_record, conf_num)));
+
+  // The last character of the text is dropped.
+  EXPECT_EQ("Hello\xE3World", StringTrim(s.substr(sizeof(qwk_record))));
+}
+
+TEST(QwkPacketTest, ConvertMessage_Empty) {
+  auto m = CreateMessage("Rushfan #1", "");
+  m.text.clear();
+  EXPECT_FALSE(qwk_convert_message(m, {}).has_value());
+}
+
+TEST(QwkPacketTest, ConvertMessage_To) {
+  auto m = CreateMessage("Rushfan #1", "\x04" "0FidoAddr: Sysop\r\nHello\r\n");
+  const auto fido = Header(qwk_convert_message(m, {}).value());
+  EXPECT_EQ("Sysop", Field(fido.to, sizeof(fido.to)));
+
+  m.to = "SOMEONE";
+  const auto h = Header(qwk_convert_message(m, {}).value());
+  EXPECT_EQ("SOMEONE", Field(h.to, sizeof(h.to)));
+}
+
+TEST(QwkPacketTest, ConvertMessage_Anonymous) {
+  auto m = CreateMessage("Rushfan #1", "Hello\r\n");
+  m.anony = anony_sender;
+  const auto h = Header(qwk_convert_message(m, {}).value());
+  EXPECT_EQ("<<< RUSHFAN #1 >>>", Field(h.from, sizeof(h.from)));
+}
+
+TEST(QwkPacketTest, ConvertMessage_ManyBlocks) {
+  const std::string body(1000, 'x');
+  const auto o = qwk_convert_message(CreateMessage("Rushfan #1", body), {});
+  ASSERT_TRUE(o.has_value());
+  // 1000 characters of text take 8 blocks after the header.
+  EXPECT_EQ(9 * sizeof(qwk_record), o->size());
+  EXPECT_EQ("9", Field(Header(o.value()).amount_blocks, 6));
+  EXPECT_EQ(body.substr(0, 999), StringTrim(o->substr(sizeof(qwk_record))));
+}
+
+TEST(QwkPacketTest, MakeQwkReady) {
+  const std::string text = "\x03" "1Hi\r\n\x04" "0Route\r\nThere\r\n";
+  EXPECT_EQ("\x03" "1Hi\xE3There\xE3", make_qwk_ready(text, "", {}));
+
+  qwk_convert_options_t opts{};
+  opts.remove_color = true;
+  opts.keep_routing = true;
+  EXPECT_EQ("Hi\xE3\x04" "0Route\xE3There\xE3", make_qwk_ready(text, "", opts));
+}
+
+TEST(QwkPacketTest, ConvertMessages_SameAsOneAtATime) {
+  std::vector<qwk_source_message_t> messages;
+  for (auto i = 1; i <= 1000; i++) {
+    messages.emplace_back(CreateMessage(StrCat("User #", i), std::string(i % 300, 'a'), i));
+  }
+  const auto out = qwk_convert_messages(messages, {}, 4);
+  ASSERT_EQ(messages.size(), out.size());
+  for (size_t i = 0; i < messages.size(); i++) {
+    EXPECT_EQ(qwk_convert_message(messages[i], {}), out[i]) << i;
+  }
+}
+
+TEST(QwkPacketTest, Writer) {
+  FileHelper helper;
+  const auto dat = FilePath(helper.TempDir(), "MESSAGES.DAT");
+  const auto first = qwk_convert_message(CreateMessage("A #1", std::string(200, 'a')), {}).value();
+  auto email = CreateMessage("B #2", "Hi\r\n");
+  email.conf_num = 0;
+  const auto second = qwk_convert_message(email, {}).value();
+  const auto third = qwk_convert_message(CreateMessage("C #3", "Bye\r\n"), {}).value();
+  {
+    QwkPacketWriter w(dat, helper.TempDir(), 256);
+    ASSERT_TRUE(w.ok());
+    EXPECT_TRUE(w.Write(first));
+    EXPECT_TRUE(w.Write(second, true));
+    EXPECT_TRUE(w.Write(third));
+    EXPECT_EQ(3, w.num_messages());
+    EXPECT_TRUE(w.Close());
+  }
+
+  const auto contents = helper.ReadFile(dat);
+  ASSERT_EQ(sizeof(qwk_record) + first.size() + second.size() + third.size(), contents.size());
+  EXPECT_TRUE(starts_with(contents, "Produced by Qmail..."));
+  auto pos = sizeof(qwk_record);
+  auto h = Header(contents.substr(pos));
+  EXPECT_EQ(1, h.logical_num);
+  EXPECT_EQ("A #1", Field(h.from, sizeof(h.from)));
+  pos += first.size();
+  EXPECT_EQ(2, Header(contents.substr(pos)).logical_num);
+  pos += second.size();
+  EXPECT_EQ(3, Header(contents.substr(pos)).logical_num);
+  EXPECT_EQ(third.substr(sizeof(qwk_record)), contents.substr(pos + sizeof(qwk_record)));
+
+  // Index entries are the record number of each message's header.
+  const auto first_blocks = static_cast<uint32_t>(first.size() / sizeof(qwk_record));
+  const auto second_blocks = static_cast<uint32_t>(second.size() / sizeof(qwk_record));
+  const std::string nouse(1, '\0');
+  EXPECT_EQ(StrCat(msbin(2), nouse, msbin(2 + first_blocks + second_blocks), nouse),
+            helper.ReadFile(FilePath(helper.TempDir(), "002.NDX")));
+  const auto email_ndx = StrCat(msbin(2 + first_blocks), nouse);
+  EXPECT_EQ(email_ndx, helper.ReadFile(FilePath(helper.TempDir(), "000.NDX")));
+  EXPECT_EQ(email_ndx, helper.ReadFile(FilePath(helper.TempDir(), "PERSONAL.NDX")));
+}
+
+TEST(QwkPacketTest, Writer_RejectsPartialBlocks) {
+  FileHelper helper;
+  QwkPacketWriter w(FilePath(helper.TempDir(), "MESSAGES.DAT"), helper.TempDir());
+  EXPECT_FALSE(w.Write("short"));
+  EXPECT_EQ(0, w.num_messages());
+}
+
+// Benchmark of building MESSAGES.DAT from a synthetic message base.
+TEST(QwkPacketTest, DISABLED_Benchmark_BuildPacket) {
+  constexpr auto kNumMessages = 20000;
+  FileHelper helper;
+  const auto msgs = helper.CreateTempFilePath("general.dat");
+  {
+    File f(msgs);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeCreateFile | File::modeReadWrite));
+    f.set_length(GAT_SECTION_SIZE + (75L * 1024L));
+  }
+  Type2Text text(msgs);
+  std::vector<messagerec> recs;
+  for (auto i = 0; i < kNumMessages; i++) {
+    std::string body;
+    for (auto line = 0; line < 20 + i % 40; line++) {
+      body.append(StrCat("\x03", line % 8, "Line ", line, " of a synthetic message.\r\n"));
+    }
+    auto m = text.savefile(StrCat("User #", i, "\r\nSat Jan 02 12:34:56 2021\r\n", body, "\x1a"));
+    ASSERT_TRUE(m.has_value());
+    recs.push_back(m.value());
+  }
+
+  qwk_convert_options_t opts{};
+  opts.convert_color = true;
+  auto build = [&](int num_threads) {
+    QwkPacketWriter w(helper.CreateTempFilePath("MESSAGES.DAT"), helper.TempDir());
+    for (size_t start = 0; start < recs.size(); start += 256) {
+      std::vector<qwk_source_message_t> batch;
+      for (auto i = start; i < std::min(recs.size(), start + 256); i++) {
+        qwk_source_message_t m{};
+        m.text = text.readfile(recs[i]).value_or("");
+        m.msgnum = static_cast<int>(i + 1);
+        m.conf_num = 1;
+        batch.emplace_back(std::move(m));
+      }
+      for (const auto& o : qwk_convert_messages(batch, opts, num_threads)) {
+        if (o) {
+          w.Write(o.value());
+        }
+      }
+    }
+    w.Close();
+    return w.num_messages();
+  };
+
+  for (const auto n : {1, 2, 4, 8}) {
+    const auto start = steady_clock::now();
+    const auto num = build(n);
+    const auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    LOG(INFO) << n << " thread(s): " << num << " messages in " << ms << "ms; "
+              << num * 1000 / std::max<int64_t>(1, ms) << " messages/sec";
+  }
+}
@@ -24,7 +24,6 @@
 #include "binkp/net_log.h"
 #include "binkp/transfer_file.h"
 #include "core/connection.h"
-#include "core/crc32.h"
 #include "core/datetime.h"
 #include "core/file.h"
 #include "core/log.h"
@@ -88,7 +87,8 @@ string expected_password_for(const net_call_out_rec* con) {
 BinkP::BinkP(Connection* conn, BinkConfig* config, BinkSide side,
              const std::string& expected_remote_node,
              received_transfer_file_factory_t& received_transfer_file_factory)
-    : config_(config), conn_(conn), side_(side), expected_remote_node_(expected_remote_node),
+    : config_(config), conn_(conn), sender_(conn), side_(side),
+      expected_remote_node_(expected_remote_node),
       received_transfer_file_factory_(received_transfer_file_factory),
       remote_(config, side_ == BinkSide::ANSWERING, expected_remote_node) {
   if (side_ == BinkSide::ORIGINATING) {
@@ -96,7 +96,7 @@ BinkP::BinkP(Connection* conn, BinkConfig* config, BinkSide side,
   }
 }
 
-BinkP::~BinkP() { files_to_send_.clear(); }
+BinkP::~BinkP() = default;
 
 bool BinkP::process_opt(const std::string& opt) {
   VLOG(1) << "OPT line: '" << opt << "'";
@@ -188,6 +188,9 @@ bool BinkP::process_command(int16_t length, duration<double> d) {
   case BinkpCommands::M_GOT: {
     HandleFileGotRequest(s);
   } break;
+  case BinkpCommands::M_SKIP: {
+    HandleFileSkipRequest(s);
+  } break;
   case BinkpCommands::M_EOB: {
     eob_received_ = true;
   } break;
@@ -245,19 +248,12 @@ bool BinkP::process_data(int16_t length, duration<double> d) {
 
     // If we have a crc; check it.
     if (crc_ && crc != 0) {
-      const auto rdir = config_->receive_dir(remote_.network_name());
-      const auto dir = File::absolute(config_->config().root_directory(), rdir);
-      const File received_file(FilePath(dir, current_receive_file_->filename()));
-      const auto file_crc = crc32file(received_file.path());
-      if (file_crc == 0) {
-        LOG(ERROR) << "Error calculating CRC32 of: " << current_receive_file_->filename();
-      } else {
-        if (file_crc != current_receive_file_->crc()) {
-          // TODO(rushfan): Once we're sure this works, make it mark the file bad.
-          LOG(ERROR) << "Wrong CRC32 of: " << current_receive_file_->filename()
-                     << "; expected: " << std::hex << current_receive_file_->crc()
-                     << "; actual: " << std::hex << file_crc;
-        }
+      const auto file_crc = current_receive_file_->received_crc();
+      if (file_crc != current_receive_file_->crc()) {
+        // TODO(rushfan): Once we're sure this works, make it mark the file bad.
+        LOG(ERROR) << "Wrong CRC32 of: " << current_receive_file_->filename()
+                   << "; expected: " << std::hex << current_receive_file_->crc()
+                   << "; actual: " << std::hex << file_crc;
       }
     }
 
@@ -338,25 +334,6 @@ bool BinkP::send_command_packet(uint8_t command_id, const string& data) {
   return true;
 }
 
-bool BinkP::send_data_packet(const char* data, int packet_length) {
-  if (!conn_->is_open()) {
-    return false;
-  }
-  // for now assume everything fits within a single frame.
-  const unique_ptr<char[]> packet(new char[packet_length + 2]);
-  packet_length &= 0x7fff;
-  uint8_t b0 = ((packet_length & 0xff00) >> 8);
-  uint8_t b1 = packet_length & 0x00ff;
-  auto* p = packet.get();
-  *p++ = b0;
-  *p++ = b1;
-  memcpy(p, data, packet_length);
-
-  conn_->send(packet.get(), packet_length + 2, seconds(10));
-  VLOG(3) << "SEND:  data packet: packet_length: " << packet_length;
-  return true;
-}
-
 BinkState BinkP::ConnInit() {
   VLOG(1) << "STATE: ConnInit";
   process_frames(seconds(2));
@@ -639,17 +616,13 @@ BinkState BinkP::TransferFiles() {
   process_frames(milliseconds(500));
   const auto list = file_manager_->CreateTransferFileList(remote_);
   for (auto* file : list) {
-    SendFilePacket(file);
-  }
-
-  VLOG(1) << "STATE: After SendFilePacket for all files.";
-  // Quickly let the inbound event loop percolate.
-  for (auto i = 0; i < 5; i++) {
-    process_frames(milliseconds(500));
+    sender_.Queue(unique_ptr<TransferFile>(file));
   }
+  SendFiles();
+  VLOG(1) << "STATE: After SendFiles for all files.";
 
   // TODO(rushfan): Should this be in a new state?
-  if (files_to_send_.empty()) {
+  if (sender_.empty()) {
     // All files are sent, let's let the remote know we are done.
     VLOG(1) << "       Sending EOB";
     // Kinda a hack, but trying to send a 3 byte packet was stalling on Windows.  Making it larger
@@ -657,10 +630,10 @@ BinkState BinkP::TransferFiles() {
     send_command_packet(BinkpCommands::M_EOB, "All files to send have been sent. Thank you.");
     process_frames(seconds(1));
   } else {
-    VLOG(1) << "       files_to_send_ is not empty, Not sending EOB";
+    VLOG(1) << "       files to send is not empty, Not sending EOB";
     std::ostringstream files;
-    for (const auto& f : files_to_send_) {
-      files << f.first << " ";
+    for (const auto& f : sender_.pending_files()) {
+      files << f << " ";
     }
     VLOG(2) << "Files: " << files.str();
   }
@@ -696,7 +669,13 @@ BinkState BinkP::WaitEob() {
   for (auto count = 1; count < eob_retries; count++) {
     // Loop for up to one minute waiting for an EOB before exiting.
     try {
-      process_frames([&]() -> bool { return eob_received_; }, seconds(eob_wait_seconds));
+      process_frames([&]() -> bool { return eob_received_ || sender_.can_send(); },
+                     seconds(eob_wait_seconds));
+      if (sender_.can_send()) {
+        // The remote asked for a file again with M_GET.
+        SendFiles();
+        continue;
+      }
       if (eob_received_) {
         return BinkState::DONE;
       }
@@ -709,37 +688,13 @@ BinkState BinkP::WaitEob() {
   return BinkState::DONE;
 }
 
-bool BinkP::SendFilePacket(TransferFile* file) {
-  const auto filename(file->filename());
-  VLOG(1) << "       SendFilePacket: " << filename;
-  files_to_send_[filename] = unique_ptr<TransferFile>(file);
-  send_command_packet(BinkpCommands::M_FILE, file->as_packet_data(0));
-  process_frames(seconds(2));
-
-  // file* may not be viable anymore if it was already send.
-  if (contains(files_to_send_, filename)) {
-    // We have the file still to send.
-    SendFileData(file);
-  }
-  return true;
-}
-
-bool BinkP::SendFileData(TransferFile* file) {
-  VLOG(1) << "       SendFileData: " << file->filename();
-  const auto file_length = file->file_size();
-  const auto chunk_size = 16384; // This is 1<<14.  The max per spec is (1 << 15) - 1
-  const auto chunk = std::make_unique<char[]>(chunk_size);
-  for (long start = 0; start < file_length; start += chunk_size) {
-    const auto size = min<int>(chunk_size, file_length - start);
-    if (!file->GetChunk(chunk.get(), start, size)) {
-      // Bad chunk. Abort
-    }
-    send_data_packet(chunk.get(), size);
-    // sending multi-chunk files was not reliable.  check after each frame if we have
-    // an inbound command.
-    process_frames(seconds(1));
-  }
-  return true;
+bool BinkP::SendFiles() {
+  const auto process = [this](const function<bool()>& predicate, duration<double> d) {
+    return process_frames(predicate, d);
+  };
+  // Once the window is full, give the remote up to 30 seconds to acknowledge
+  // a file before giving up.
+  return sender_.Run(process, seconds(30));
 }
 
 bool BinkP::HandlePassword(const string& password_line) {
@@ -794,21 +749,13 @@ bool BinkP::HandleFileGetRequest(const string& request_line) {
   const auto& filename = s.at(0);
   //const auto length = to_number<long>(s.at(1));
   //const auto timestamp = to_number<time_t>(s.at(2));
-  long offset = 0;
+  auto offset = 0;
   if (s.size() >= 4) {
-    offset = to_number<long>(s.at(3));
-  }
-  if (offset != 0) {
-    LOG(WARNING) << "offset specified in FileGetRequest.  We don't support offset != 0";
+    offset = to_number<int>(s.at(3));
   }
-
-  const auto iter = files_to_send_.find(filename);
-  if (iter == end(files_to_send_)) {
-    LOG(ERROR) << "File not found: " << filename;
-    return false;
-  }
-  return SendFileData(iter->second.get());
-  // File was sent but wait until we receive M_GOT before we remove it from the list.
+  // The file is sent again (M_FILE with the offset followed by the data) by
+  // the sender, we still wait until we receive M_GOT before we remove it.
+  return sender_.Get(filename, offset);
 }
 
 bool BinkP::HandleFileGotRequest(const string& request_line) {
@@ -817,30 +764,28 @@ bool BinkP::HandleFileGotRequest(const string& request_line) {
   const auto& filename = s.at(0);
   const auto length = to_number<int>(s.at(1));
 
-  const auto iter = files_to_send_.find(filename);
-  if (iter == end(files_to_send_)) {
-    LOG(ERROR) << "File not found: " << filename;
+  const auto file_size = sender_.Got(filename);
+  if (!file_size) {
     return false;
   }
-
-  auto* file = iter->second.get();
   // Increment the number of bytes sent.
   // Also don't increment with -1 if there's an error with the file.
-  bytes_sent_ += max(0, file->file_size());
+  bytes_sent_ += max(0, file_size.value());
 
-  if (length != file->file_size()) {
+  if (length != file_size.value()) {
     LOG(ERROR) << "NON-FATAL ERROR: Size didn't match M_GOT. Please log a bug. M_GOT: " << length
-               << "; file_size: " << file->file_size();
+               << "; file_size: " << file_size.value();
   }
-
-  // This is a file that we sent.
-  if (!file->Delete()) {
-    LOG(ERROR) << "       *** UNABLE TO DELETE FILE: " << file->filename();
-  }
-  files_to_send_.erase(iter);
   return true;
 }
 
+bool BinkP::HandleFileSkipRequest(const string& request_line) {
+  LOG(INFO) << "       HandleFileSkipRequest: request_line: [" << request_line << "]";
+  const auto s = SplitString(request_line, " ");
+  // Leave the file alone so that we'll send it in a later session.
+  return sender_.Skip(s.at(0));
+}
+
 void BinkP::Run(const wwiv::core::CommandLine& cmdline) {
   const auto now = DateTime::now();
   config_->session_identifier(fmt::format("in-{}", now.to_time_t()));
@@ -22,6 +22,7 @@
 #include "core/connection.h"
 #include "binkp/cram.h"
 #include "binkp/file_manager.h"
+#include "binkp/file_sender.h"
 #include "binkp/receive_file.h"
 #include "binkp/remote.h"
 #include "sdk/net/callout.h"
@@ -89,7 +90,6 @@ private:
   bool process_data(int16_t length, std::chrono::duration<double> d);
 
   bool send_command_packet(uint8_t command_id, const std::string& data);
-  bool send_data_packet(const char* data, int size);
 
   void process_network_files(const wwiv::core::CommandLine& cmdline) const;
 
@@ -106,10 +106,11 @@ private:
   BinkState WaitEob();
   BinkState Unknown();
   BinkState FatalError();
-  bool SendFilePacket(TransferFile* file);
-  bool SendFileData(TransferFile* file);
   bool HandleFileGetRequest(const std::string& request_line);
   bool HandleFileGotRequest(const std::string& request_line);
+  bool HandleFileSkipRequest(const std::string& request_line);
+  // Sends any files queued in sender_, handling inbound frames as they arrive.
+  bool SendFiles();
   bool HandlePassword(const std::string& password_line);
   bool HandleFileRequest(const std::string& request_line);
 
@@ -117,7 +118,8 @@ private:
   wwiv::core::Connection* conn_ = nullptr;
   bool ok_received_ = false;
   bool eob_received_ = false;
-  std::map<std::string, std::unique_ptr<TransferFile>> files_to_send_;
+  // Outbound files, pipelined up to a window of unacknowledged files.
+  FileSender sender_;
   BinkSide side_;
   const std::string expected_remote_node_;
   std::string remote_password_;
@@ -0,0 +1,250 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "binkp/file_sender.h"
+
+#include "binkp/binkp_commands.h"
+#include "core/log.h"
+#include "core/stl.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::stl;
+
+namespace wwiv::net {
+
+FileSender::FileSender(Connection* conn, int window_files, int window_bytes, int frame_size)
+    : conn_(conn), window_files_(std::max(1, window_files)),
+      window_bytes_(std::max(1, window_bytes)),
+      frame_size_(std::clamp(frame_size, 1, kMaxFrameSize)) {
+  frame_.resize(2 + frame_size_);
+}
+
+FileSender::~FileSender() = default;
+
+void FileSender::Queue(std::unique_ptr<TransferFile> file) {
+  auto* f = file.get();
+  const auto filename = f->filename();
+  if (contains(files_, filename)) {
+    LOG(WARNING) << "Ignoring duplicate file in send queue: " << filename;
+    return;
+  }
+  files_.emplace(filename, std::move(file));
+  queue_.push_back(f);
+}
+
+bool FileSender::can_send() const {
+  return current_.has_value() || !gets_.empty() || (!queue_.empty() && !window_full());
+}
+
+bool FileSender::window_full() const {
+  if (in_flight_.empty()) {
+    // Always allow one file, even if it's larger than the window.
+    return false;
+  }
+  return size_int(in_flight_) >= window_files_ || in_flight_bytes_ >= window_bytes_;
+}
+
+bool FileSender::empty() const { return files_.empty(); }
+
+std::vector<std::string> FileSender::pending_files() const {
+  std::vector<std::string> files;
+  for (const auto& [name, _] : files_) {
+    files.push_back(name);
+  }
+  return files;
+}
+
+bool FileSender::SendCommand(uint8_t command_id, const std::string& data) {
+  const auto size = 3 + size_int(data);
+  if (size_int(frame_) < size) {
+    frame_.resize(size);
+  }
+  // The frame size includes the command id, but not the 2 byte header.
+  const auto packet_length = static_cast<uint16_t>(data.size() + 1) | 0x8000;
+  auto* p = frame_.data();
+  *p++ = static_cast<char>((packet_length & 0xff00) >> 8);
+  *p++ = static_cast<char>(packet_length & 0x00ff);
+  *p++ = static_cast<char>(command_id);
+  memcpy(p, data.data(), data.size());
+  conn_->send(frame_.data(), size, seconds(3));
+  LOG(INFO) << "SEND:  " << BinkpCommands::command_id_to_name(command_id) << ": " << data;
+  return true;
+}
+
+bool FileSender::SendData(TransferFile* file, int offset, int size) {
+  // Read the chunk straight into the frame after the header.
+  if (!file->GetChunk(frame_.data() + 2, offset, size)) {
+    return false;
+  }
+  frame_[0] = static_cast<char>((size & 0x7f00) >> 8);
+  frame_[1] = static_cast<char>(size & 0x00ff);
+  conn_->send(frame_.data(), size + 2, seconds(10));
+  VLOG(3) << "SEND:  data packet: packet_length: " << size;
+  return true;
+}
+
+bool FileSender::StartFile(TransferFile* file, int offset) {
+  const auto size = file->file_size();
+  if (size < 0) {
+    LOG(ERROR) << "Unable to determine the size of: " << file->filename() << "; not sending it.";
+    Forget(file->filename());
+    return true;
+  }
+  offset = std::clamp(offset, 0, size);
+  VLOG(1) << "       SendFile: " << file->filename() << " offset: " << offset;
+  if (const auto it = in_flight_.find(file->filename()); it != std::end(in_flight_)) {
+    in_flight_bytes_ -= it->second;
+  }
+  in_flight_[file->filename()] = size;
+  in_flight_bytes_ += size;
+  if (!SendCommand(BinkpCommands::M_FILE, file->as_packet_data(offset))) {
+    return false;
+  }
+  if (offset < size) {
+    current_ = current_file_t{file, offset, size};
+  }
+  return true;
+}
+
+bool FileSender::SendNextFrame() {
+  if (!conn_->is_open()) {
+    return false;
+  }
+  if (current_) {
+    auto& c = current_.value();
+    const auto size = std::min(frame_size_, c.size - c.offset);
+    if (!SendData(c.file, c.offset, size)) {
+      LOG(ERROR) << "Error reading: " << c.file->filename() << " at offset: " << c.offset
+                 << "; not sending the rest of it.";
+      Forget(c.file->filename());
+      return true;
+    }
+    c.offset += size;
+    if (c.offset >= c.size) {
+      current_.reset();
+    }
+    return true;
+  }
+  if (!gets_.empty()) {
+    const auto [file, offset] = gets_.front();
+    gets_.pop_front();
+    return StartFile(file, offset);
+  }
+  if (!queue_.empty() && !window_full()) {
+    auto* file = queue_.front();
+    queue_.pop_front();
+    return StartFile(file, 0);
+  }
+  return false;
+}
+
+bool FileSender::Run(const process_frames_fn& process, duration<double> ack_timeout) {
+  while (!empty()) {
+    if (!conn_->is_open()) {
+      return false;
+    }
+    if (can_send()) {
+      if (!SendNextFrame()) {
+        return false;
+      }
+      // Handle anything the remote has sent us, but don't wait for it.
+      if (!process([this]() { return !conn_->wait_for_data(seconds(0)); }, seconds(10))) {
+        return false;
+      }
+      continue;
+    }
+    // The window is full, or everything is sent. Wait for the remote to
+    // acknowledge (or ask for) a file.
+    if (!process([this]() { return empty() || can_send(); }, ack_timeout)) {
+      return false;
+    }
+    if (!empty() && !can_send()) {
+      LOG(INFO) << "       Timed out waiting for M_GOT for " << in_flight_.size() << " files.";
+      return false;
+    }
+  }
+  return true;
+}
+
+void FileSender::Forget(const std::string& filename) {
+  if (const auto it = in_flight_.find(filename); it != std::end(in_flight_)) {
+    in_flight_bytes_ -= it->second;
+    in_flight_.erase(it);
+  }
+  if (current_ && current_->file->filename() == filename) {
+    current_.reset();
+  }
+  queue_.erase(std::remove_if(std::begin(queue_), std::end(queue_),
+                              [&](const auto* f) { return f->filename() == filename; }),
+               std::end(queue_));
+  gets_.erase(std::remove_if(std::begin(gets_), std::end(gets_),
+                             [&](const auto& g) { return g.first->filename() == filename; }),
+              std::end(gets_));
+  files_.erase(filename);
+}
+
+std::optional<int> FileSender::Got(const std::string& filename) {
+  const auto it = files_.find(filename);
+  if (it == std::end(files_)) {
+    LOG(ERROR) << "File not found: " << filename;
+    return std::nullopt;
+  }
+  auto* file = it->second.get();
+  const auto size = file->file_size();
+  // This is a file that we sent.
+  if (!file->Delete()) {
+    LOG(ERROR) << "       *** UNABLE TO DELETE FILE: " << filename;
+  }
+  Forget(filename);
+  return {size};
+}
+
+bool FileSender::Get(const std::string& filename, int offset) {
+  const auto it = files_.find(filename);
+  if (it == std::end(files_)) {
+    LOG(ERROR) << "File not found: " << filename;
+    return false;
+  }
+  auto* file = it->second.get();
+  if (current_ && current_->file == file) {
+    // Stop sending it, we'll start over from where the remote asked.
+    current_.reset();
+  }
+  queue_.erase(std::remove(std::begin(queue_), std::end(queue_), file), std::end(queue_));
+  gets_.erase(std::remove_if(std::begin(gets_), std::end(gets_),
+                             [&](const auto& g) { return g.first == file; }),
+              std::end(gets_));
+  gets_.emplace_back(file, offset);
+  return true;
+}
+
+bool FileSender::Skip(const std::string& filename) {
+  if (!contains(files_, filename)) {
+    LOG(ERROR) << "File not found: " << filename;
+    return false;
+  }
+  Forget(filename);
+  return true;
+}
+
+} // namespace wwiv::net
@@ -0,0 +1,133 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_BINKP_FILE_SENDER_H
+#define INCLUDED_BINKP_FILE_SENDER_H
+
+#include "core/connection.h"
+#include "binkp/transfer_file.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wwiv::net {
+
+/**
+ * Sends the outbound files for a BinkP session.
+ *
+ * Files are sent back to back (M_FILE followed by its data frames) without
+ * waiting for the remote to acknowledge each one, up to a window of files and
+ * bytes that have been sent but not yet acknowledged by a M_GOT.  Inbound
+ * frames are checked for between frames without blocking so that a M_GOT
+ * (skip) or M_GET (resend from offset) is acted on promptly.
+ *
+ * Data frames are read by the TransferFile straight into a single reusable
+ * frame buffer, so no per-frame allocations or copies are made.
+ */
+class FileSender final {
+public:
+  // Processes inbound frames until the predicate is true or no frame arrives
+  // within the duration.  This is BinkP::process_frames.
+  typedef std::function<bool(const std::function<bool()>&, std::chrono::duration<double>)>
+      process_frames_fn;
+
+  // The largest data frame allowed by the spec is (1 << 15) - 1 bytes.
+  static constexpr int kMaxFrameSize = 0x7fff;
+
+  FileSender(wwiv::core::Connection* conn, int window_files = 32,
+             int window_bytes = 2 * 1024 * 1024, int frame_size = kMaxFrameSize);
+  ~FileSender();
+  FileSender(const FileSender&) = delete;
+  FileSender& operator=(const FileSender&) = delete;
+
+  // Adds file to the end of the send queue.
+  void Queue(std::unique_ptr<TransferFile> file);
+
+  /**
+   * Sends everything queued and waits for the remote to acknowledge it,
+   * calling process to handle inbound frames.  Returns false if the
+   * connection is lost or the remote stops acknowledging files for longer
+   * than ack_timeout.
+   */
+  bool Run(const process_frames_fn& process, std::chrono::duration<double> ack_timeout);
+
+  // Sends the next frame.  Returns false if there is nothing that may be sent
+  // now, or on error.
+  bool SendNextFrame();
+
+  // M_GOT received.  Deletes the file and returns it's size, or std::nullopt
+  // if we were not sending filename.
+  std::optional<int> Got(const std::string& filename);
+  // M_GET received.  Resends filename starting at offset.
+  bool Get(const std::string& filename, int offset);
+  // M_SKIP received.  Stops sending filename without deleting it, so that it
+  // will be sent again in a later session.
+  bool Skip(const std::string& filename);
+
+  // True if there is a frame that may be sent now.
+  [[nodiscard]] bool can_send() const;
+  // True if the send window is full and we must wait for a M_GOT before
+  // starting another file.
+  [[nodiscard]] bool window_full() const;
+  // True when every file has been sent and acknowledged (or skipped).
+  [[nodiscard]] bool empty() const;
+  // Files which have been queued but not yet acknowledged.
+  [[nodiscard]] std::vector<std::string> pending_files() const;
+  // Files sent (M_FILE sent) but not yet acknowledged.
+  [[nodiscard]] int in_flight() const { return static_cast<int>(in_flight_.size()); }
+  [[nodiscard]] int64_t in_flight_bytes() const { return in_flight_bytes_; }
+
+private:
+  struct current_file_t {
+    TransferFile* file{nullptr};
+    int offset{0};
+    int size{0};
+  };
+  bool StartFile(TransferFile* file, int offset);
+  bool SendCommand(uint8_t command_id, const std::string& data);
+  bool SendData(TransferFile* file, int offset, int size);
+  void Forget(const std::string& filename);
+
+  wwiv::core::Connection* conn_;
+  const int window_files_;
+  const int64_t window_bytes_;
+  const int frame_size_;
+  // Every file we own until it is acknowledged or skipped.
+  std::map<std::string, std::unique_ptr<TransferFile>> files_;
+  // Files waiting for their M_FILE to be sent.
+  std::deque<TransferFile*> queue_;
+  // M_GET requests waiting to be served, as the file and offset.
+  std::deque<std::pair<TransferFile*, int>> gets_;
+  // The file whose data frames are being sent.
+  std::optional<current_file_t> current_;
+  // Size of each file whose M_FILE has been sent, keyed by filename.
+  std::map<std::string, int> in_flight_;
+  int64_t in_flight_bytes_{0};
+  // Reused for every frame sent.
+  std::vector<char> frame_;
+};
+
+} // namespace wwiv::net
+
+#endif
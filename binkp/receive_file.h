@@ -18,6 +18,7 @@
 #ifndef INCLUDED_NETORKB_RECEIVE_FILE_H
 #define INCLUDED_NETORKB_RECEIVE_FILE_H
 
+#include "core/crc32.h"
 #include "core/log.h"
 #include "core/strings.h"
 #include "binkp/transfer_file.h"
@@ -43,17 +44,13 @@ public:
     const auto ok = file_->WriteChunk(chunk, size);
     if (ok) {
       length_ += size;
+      received_crc_.update(chunk, size);
     }
     return ok;
   }
 
   bool WriteChunk(const std::string& chunk) {
-    const auto cs = wwiv::strings::ssize(chunk);
-    if (!file_->WriteChunk(chunk.data(), cs)) {
-      return false;
-    }
-    length_ += cs;
-    return true;
+    return WriteChunk(chunk.data(), wwiv::strings::ssize(chunk));
   }
 
   [[nodiscard]] std::string filename() const { return filename_; }
@@ -62,6 +59,9 @@ public:
   [[nodiscard]] time_t timestamp() const { return timestamp_; }
   [[nodiscard]] bool Close() { return file_->Close(); }
   [[nodiscard]] uint32_t crc() const { return crc_; }
+  // The CRC-32 of the data written so far, computed as it arrives so we
+  // don't need to read the file back once it is complete.
+  [[nodiscard]] uint32_t received_crc() const { return received_crc_.value(); }
 
   std::unique_ptr<TransferFile> file_;
   std::string filename_;
@@ -69,6 +69,7 @@ public:
   time_t timestamp_{0};
   long length_{0};
   uint32_t crc_{0};
+  wwiv::core::Crc32 received_crc_;
 };
 
 } // namespace
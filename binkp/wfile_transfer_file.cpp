@@ -60,6 +60,7 @@ bool WFileTransferFile::Delete() {
   // that it is closed so File::Remove will work.
   if (file_->IsOpen()) {
     file_->Close();
+    position_ = -1;
   }
   if (!File::Remove(file_->full_pathname())) {
     return false;
@@ -90,11 +91,14 @@ bool WFileTransferFile::GetChunk(char* chunk, int start, int size) {
     return false;
   }
 
-  // TODO(rushfan): Cache the current file pointer and only re-seek
-  // if needed (realistically we should ever have to seek after the
-  // first time.
-  file_->Seek(start, File::Whence::begin);
-  return file_->Read(chunk, size) == size;
+  // Chunks are almost always read in order, so only seek when asked for
+  // something other than what follows the last chunk (i.e. for a M_GET).
+  if (start != position_) {
+    file_->Seek(start, File::Whence::begin);
+  }
+  const auto ok = file_->Read(chunk, size) == size;
+  position_ = ok ? start + size : -1;
+  return ok;
 }
 
 bool WFileTransferFile::WriteChunk(const char* chunk, int size) {
@@ -116,6 +120,7 @@ bool WFileTransferFile::WriteChunk(const char* chunk, int size) {
 bool WFileTransferFile::Close() {
   VLOG(1) << "WFileTransferFile::Close " << file_->path().string();
   file_->Close();
+  position_ = -1;
   return true;
 }
 
@@ -43,6 +43,8 @@ public:
  private:
   std::unique_ptr<wwiv::core::File> file_; 
   std::unique_ptr<wwiv::sdk::fido::FloFile> flo_file_;
+  // Offset of the file pointer after the last GetChunk, or -1 if unknown.
+  int position_{-1};
 };
 
 }  // namespace net
@@ -38,17 +38,17 @@ using namespace wwiv::strings;
 using namespace wwiv::net;
 
 FakeBinkpPacket::FakeBinkpPacket(const void* data, int size) {
-  auto p = static_cast<const char*>(data);
-  header_ = (*p++) << 8;
+  auto p = static_cast<const uint8_t*>(data);
+  header_ = static_cast<uint16_t>(*p++ << 8);
   header_ = header_ | *p++;
-  is_command_ = (header_ | 0x8000) != 0;
+  is_command_ = (header_ & 0x8000) != 0;
   header_ &= 0x7fff;
 
   if (is_command_) {
     command_ = *p;
   }
   // size doesn't include the uint16_t header.
-  data_ = string(p, size - 2);  
+  data_ = string(reinterpret_cast<const char*>(p), size - 2);
 }
 
 FakeBinkpPacket::~FakeBinkpPacket() = default;
@@ -106,6 +106,14 @@ uint8_t FakeConnection::read_uint8(std::chrono::duration<double> d) {
   return front.command();
 }
 
+bool FakeConnection::wait_for_data(std::chrono::duration<double> d) {
+  auto predicate = [&]() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return !receive_queue_.empty();
+  };
+  return wait_for(predicate, d);
+}
+
 int FakeConnection::receive(void* data, int size, duration<double> d) {
   string s = receive(size, d);
   memcpy(data, s.data(), size);
@@ -59,9 +59,12 @@ public:
 
   uint16_t read_uint16(std::chrono::duration<double> d) override;
   uint8_t read_uint8(std::chrono::duration<double> d) override;
+  bool wait_for_data(std::chrono::duration<double> d) override;
   bool is_open() const override;
   bool close() override;
 
+  // Connections start out closed.
+  void open() { open_ = true; }
   bool has_sent_packets() const;
   FakeBinkpPacket GetNextPacket();
   void ReplyCommand(int8_t command_id, const std::string& data);
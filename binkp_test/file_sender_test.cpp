@@ -0,0 +1,303 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "binkp/binkp_commands.h"
+#include "binkp/file_sender.h"
+#include "binkp/transfer_file.h"
+#include "binkp_test/fake_connection.h"
+#include "core/log.h"
+#include "core/stl.h"
+#include "core/strings.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::net;
+using namespace wwiv::stl;
+using namespace wwiv::strings;
+
+// Records that it was deleted.
+class DeleteTrackingTransferFile : public InMemoryTransferFile {
+public:
+  DeleteTrackingTransferFile(const string& filename, const string& contents, bool* deleted)
+      : InMemoryTransferFile(filename, contents, 0), deleted_(deleted) {}
+  bool Delete() override {
+    *deleted_ = true;
+    return InMemoryTransferFile::Delete();
+  }
+
+private:
+  bool* deleted_;
+};
+
+class FileSenderTest : public testing::Test {
+public:
+  FileSenderTest() { conn_.open(); }
+
+  std::unique_ptr<TransferFile> CreateFile(const string& filename, const string& contents) {
+    return std::make_unique<DeleteTrackingTransferFile>(filename, contents, &deleted_[filename]);
+  }
+
+  // Sends frames until nothing more may be sent, returning the number sent.
+  int SendAll(FileSender& sender) {
+    auto count = 0;
+    while (sender.SendNextFrame()) {
+      ++count;
+    }
+    return count;
+  }
+
+  // Returns the sent frames as "M_FILE name offset" or the data.
+  std::vector<string> SentFrames() {
+    std::vector<string> frames;
+    while (conn_.has_sent_packets()) {
+      const auto p = conn_.GetNextPacket();
+      if (p.is_command()) {
+        EXPECT_EQ(BinkpCommands::M_FILE, p.command());
+        const auto parts = SplitString(p.data().substr(1), " ");
+        frames.push_back(StrCat("M_FILE ", parts.at(0), " ", parts.at(3)));
+      } else {
+        EXPECT_EQ(p.header(), size_int(p.data()));
+        frames.push_back(p.data());
+      }
+    }
+    return frames;
+  }
+
+  FakeConnection conn_;
+  std::map<string, bool> deleted_;
+};
+
+TEST_F(FileSenderTest, SendsFilesBackToBack) {
+  FileSender sender(&conn_);
+  sender.Queue(CreateFile("a", "Hello"));
+  sender.Queue(CreateFile("b", "World"));
+  sender.Queue(CreateFile("c", ""));
+
+  EXPECT_EQ(5, SendAll(sender));
+  EXPECT_EQ((std::vector<string>{"M_FILE a 0", "Hello", "M_FILE b 0", "World", "M_FILE c 0"}),
+            SentFrames());
+  EXPECT_EQ(3, sender.in_flight());
+  EXPECT_EQ(10, sender.in_flight_bytes());
+  EXPECT_FALSE(sender.empty());
+
+  EXPECT_EQ(5, sender.Got("a").value_or(-1));
+  EXPECT_EQ(5, sender.Got("b").value_or(-1));
+  EXPECT_EQ(0, sender.Got("c").value_or(-1));
+  EXPECT_TRUE(sender.empty());
+  EXPECT_EQ(0, sender.in_flight_bytes());
+  EXPECT_TRUE(deleted_["a"]);
+  EXPECT_TRUE(deleted_["b"]);
+  EXPECT_TRUE(deleted_["c"]);
+}
+
+TEST_F(FileSenderTest, SplitsIntoFrames) {
+  FileSender sender(&conn_, 32, 1024, 4);
+  sender.Queue(CreateFile("a", "Hello World"));
+  SendAll(sender);
+  EXPECT_EQ((std::vector<string>{"M_FILE a 0", "Hell", "o Wo", "rld"}), SentFrames());
+}
+
+TEST_F(FileSenderTest, Window_Files) {
+  FileSender sender(&conn_, 2);
+  sender.Queue(CreateFile("a", "1"));
+  sender.Queue(CreateFile("b", "2"));
+  sender.Queue(CreateFile("c", "3"));
+
+  EXPECT_EQ(4, SendAll(sender));
+  EXPECT_TRUE(sender.window_full());
+  EXPECT_FALSE(sender.can_send());
+  EXPECT_EQ(2, sender.in_flight());
+
+  ASSERT_TRUE(sender.Got("a"));
+  EXPECT_FALSE(sender.window_full());
+  EXPECT_EQ(2, SendAll(sender));
+  EXPECT_EQ((std::vector<string>{"M_FILE a 0", "1", "M_FILE b 0", "2", "M_FILE c 0", "3"}),
+            SentFrames());
+}
+
+TEST_F(FileSenderTest, Window_Bytes) {
+  FileSender sender(&conn_, 32, 4);
+  sender.Queue(CreateFile("a", "Hello"));
+  sender.Queue(CreateFile("b", "World"));
+
+  // One file is always allowed, even if it's larger than the window.
+  EXPECT_EQ(2, SendAll(sender));
+  EXPECT_TRUE(sender.window_full());
+  ASSERT_TRUE(sender.Got("a"));
+  EXPECT_EQ(2, SendAll(sender));
+}
+
+TEST_F(FileSenderTest, Got_StopsSendingData) {
+  FileSender sender(&conn_, 32, 1024, 2);
+  sender.Queue(CreateFile("a", "Hello"));
+  ASSERT_TRUE(sender.SendNextFrame());
+  ASSERT_TRUE(sender.SendNextFrame());
+  // The remote already has it.
+  ASSERT_TRUE(sender.Got("a"));
+  EXPECT_FALSE(sender.SendNextFrame());
+  EXPECT_EQ((std::vector<string>{"M_FILE a 0", "He"}), SentFrames());
+  EXPECT_TRUE(sender.empty());
+}
+
+TEST_F(FileSenderTest, Get_ResendsFromOffset) {
+  FileSender sender(&conn_);
+  sender.Queue(CreateFile("a", "Hello World"));
+  sender.Queue(CreateFile("b", "1"));
+  ASSERT_TRUE(sender.SendNextFrame());
+  ASSERT_TRUE(sender.Get("a", 6));
+  SendAll(sender);
+  EXPECT_EQ((std::vector<string>{"M_FILE a 0", "M_FILE a 6", "World", "M_FILE b 0", "1"}),
+            SentFrames());
+  EXPECT_EQ(2, sender.in_flight());
+  EXPECT_EQ(12, sender.in_flight_bytes());
+}
+
+TEST_F(FileSenderTest, Get_UnknownFile) {
+  FileSender sender(&conn_);
+  EXPECT_FALSE(sender.Get("a", 0));
+  EXPECT_FALSE(sender.Got("a"));
+}
+
+TEST_F(FileSenderTest, Skip_DoesNotDelete) {
+  FileSender sender(&conn_);
+  sender.Queue(CreateFile("a", "Hello"));
+  sender.Queue(CreateFile("b", "World"));
+  ASSERT_TRUE(sender.SendNextFrame());
+  ASSERT_TRUE(sender.Skip("a"));
+  ASSERT_TRUE(sender.Skip("b"));
+  EXPECT_FALSE(sender.SendNextFrame());
+  EXPECT_TRUE(sender.empty());
+  EXPECT_FALSE(deleted_["a"]);
+  EXPECT_FALSE(deleted_["b"]);
+  EXPECT_EQ(0, sender.in_flight_bytes());
+}
+
+TEST_F(FileSenderTest, Run) {
+  FileSender sender(&conn_, 2);
+  for (const auto* name : {"a", "b", "c", "d", "e"}) {
+    sender.Queue(CreateFile(name, name));
+  }
+  std::vector<string> acked;
+  auto process = [&](const std::function<bool()>& predicate, duration<double>) {
+    // Acknowledge the oldest file each time we are asked to wait.
+    while (!predicate()) {
+      const auto pending = sender.pending_files();
+      acked.push_back(pending.front());
+      sender.Got(pending.front());
+    }
+    return true;
+  };
+  EXPECT_TRUE(sender.Run(process, seconds(1)));
+  EXPECT_TRUE(sender.empty());
+  EXPECT_EQ((std::vector<string>{"a", "b", "c", "d", "e"}), acked);
+  EXPECT_EQ(10u, SentFrames().size());
+}
+
+TEST_F(FileSenderTest, Run_TimesOut) {
+  FileSender sender(&conn_);
+  sender.Queue(CreateFile("a", "Hello"));
+  auto process = [](const std::function<bool()>&, duration<double>) { return true; };
+  EXPECT_FALSE(sender.Run(process, seconds(1)));
+  EXPECT_EQ(std::vector<string>{"a"}, sender.pending_files());
+  EXPECT_FALSE(deleted_["a"]);
+}
+
+// The remote end of a link with a round trip time of rtt and unlimited
+// bandwidth.  Files are acknowledged with M_GOT one rtt after their last
+// frame was sent.
+class SimulatedRemote {
+public:
+  SimulatedRemote(FakeConnection& conn, FileSender& sender, duration<double> rtt)
+      : conn_(conn), sender_(sender), rtt_(duration_cast<steady_clock::duration>(rtt)) {}
+
+  bool process_frames(const std::function<bool()>& predicate, duration<double> d) {
+    const auto end = steady_clock::now() + duration_cast<steady_clock::duration>(d);
+    for (;;) {
+      Receive();
+      while (!acks_.empty() && acks_.front().first <= steady_clock::now()) {
+        sender_.Got(acks_.front().second);
+        acks_.erase(acks_.begin());
+      }
+      if (predicate()) {
+        return true;
+      }
+      if (acks_.empty() || acks_.front().first > end) {
+        return true;
+      }
+      std::this_thread::sleep_until(acks_.front().first);
+    }
+  }
+
+private:
+  void Receive() {
+    while (conn_.has_sent_packets()) {
+      const auto p = conn_.GetNextPacket();
+      if (p.is_command()) {
+        const auto parts = SplitString(p.data().substr(1), " ");
+        filename_ = parts.at(0);
+        remaining_ = to_number<int>(parts.at(1)) - to_number<int>(parts.at(3));
+      } else {
+        remaining_ -= size_int(p.data());
+      }
+      if (remaining_ == 0) {
+        acks_.emplace_back(steady_clock::now() + rtt_, filename_);
+        remaining_ = -1;
+      }
+    }
+  }
+
+  FakeConnection& conn_;
+  FileSender& sender_;
+  const steady_clock::duration rtt_;
+  string filename_;
+  int remaining_{-1};
+  std::vector<std::pair<steady_clock::time_point, string>> acks_;
+};
+
+// Sends 50 8k files over a simulated link with a 200ms round trip time, one
+// file at a time and then with the default window.
+TEST_F(FileSenderTest, DISABLED_Benchmark_200msRtt) {
+  constexpr auto kNumFiles = 50;
+  const string contents(8192, 'x');
+  for (const auto window : {1, 32}) {
+    FileSender sender(&conn_, window);
+    for (auto i = 0; i < kNumFiles; i++) {
+      sender.Queue(CreateFile(StrCat("file", i), contents));
+    }
+    SimulatedRemote remote(conn_, sender, milliseconds(200));
+    auto process = [&](const std::function<bool()>& predicate, duration<double> d) {
+      return remote.process_frames(predicate, d);
+    };
+    const auto start = steady_clock::now();
+    EXPECT_TRUE(sender.Run(process, seconds(10)));
+    const auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    LOG(INFO) << "window: " << window << " files: " << ms << "ms; "
+              << static_cast<int64_t>(contents.size()) * kNumFiles * 1000 / std::max<int64_t>(1, ms)
+              << " bytes/sec";
+  }
+}
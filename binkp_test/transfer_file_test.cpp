@@ -21,6 +21,7 @@
 #include "core/strings.h"
 #include "core_test/file_helper.h"
 #include "fmt/printf.h"
+#include "binkp/receive_file.h"
 #include "binkp/transfer_file.h"
 #include "binkp/wfile_transfer_file.h"
 #include <chrono>
@@ -126,6 +127,19 @@ TEST_F(TransferFileTest, WFileTest_Read) {
   wfile_file.Close();
 }
 
+TEST_F(TransferFileTest, WFileTest_Read_Sequential_ThenSeek) {
+  WFileTransferFile wfile_file(filename, std::make_unique<File>(full_filename));
+  char chunk[100];
+  ASSERT_TRUE(wfile_file.GetChunk(chunk, 0, 2));
+  EXPECT_EQ("AS", string(chunk, 2));
+  ASSERT_TRUE(wfile_file.GetChunk(chunk, 2, 2));
+  EXPECT_EQ("DF", string(chunk, 2));
+  // Back up like we would for a M_GET.
+  ASSERT_TRUE(wfile_file.GetChunk(chunk, 1, 3));
+  EXPECT_EQ("SDF", string(chunk, 3));
+  wfile_file.Close();
+}
+
 TEST_F(TransferFileTest, WFileTest_Write) {
   const string empty_filename = StrCat(filename, "_empty");
   const auto empty_file_fullpath = file_helper_.CreateTempFilePath(empty_filename);
@@ -141,3 +155,11 @@ TEST_F(TransferFileTest, WFileTest_Write) {
   // Needed wfile_file to go out of scope before the file can be read.
   EXPECT_EQ(contents, file_helper_.ReadFile(empty_file_fullpath));
 }
+
+TEST_F(TransferFileTest, ReceiveFile_Crc) {
+  ReceiveFile r(new InMemoryTransferFile("received", ""), "received", 8, 0, 0x67BC1E09);
+  EXPECT_TRUE(r.WriteChunk("AS"));
+  EXPECT_TRUE(r.WriteChunk(string("DF")));
+  EXPECT_EQ(4, r.length());
+  EXPECT_EQ(r.crc(), r.received_crc());
+}
@@ -100,6 +100,8 @@ char Input::getkey(bool allow_extended_input) {
 
   // Since were waiting for a key, reset the # of lines we've displayed since a pause.
   bout.clear_lines_listed();
+  // Make sure the user can see everything before we wait on them.
+  bout.flush();
   while (!sess().hangup()) {
     bus().invoke<CheckForHangupEvent>();
     while (!bkbhit() && !sess().hangup()) {
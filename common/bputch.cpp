@@ -116,10 +116,14 @@ void Output::rputs(const std::string& text) {
 }
 
 void Output::flush() {
+  if (remoteIO() == nullptr) {
+    return;
+  }
   if (!bputch_buffer_.empty()) {
     remoteIO()->write(bputch_buffer_.c_str(), stl::size_int(bputch_buffer_));
     bputch_buffer_.clear();
   }
+  remoteIO()->flush();
 }
 
 void Output::rputch(char ch, bool use_buffer_) {
@@ -54,6 +54,7 @@ TempDisablePause::TempDisablePause(Output& out)
 }
 
 char Output::GetKeyForPause() {
+  flush();
   char ch = 0;
   while (ch == 0 && !sess().hangup()) {
     ch = bin.bgetch();
@@ -111,6 +112,7 @@ void Output::pausescr() {
     const auto tstart = time_t_now();
 
     clear_lines_listed();
+    flush();
     auto warned = 0;
     char ch;
     do {
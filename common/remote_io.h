@@ -65,6 +65,12 @@ class RemoteIO {
   virtual bool connected() = 0;
   virtual bool incoming() = 0;
 
+  /**
+   * Sends any output that has been buffered by put or write.  Implementations
+   * that do not buffer output need not override this.
+   */
+  virtual void flush() {}
+
   [[nodiscard]] virtual unsigned int GetHandle() const = 0;
   [[nodiscard]] virtual unsigned int GetDoorHandle() const { return GetHandle(); }
 
@@ -26,8 +26,10 @@ typedef int socklen_t;
 #else
 
 #include <arpa/inet.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #endif  // _WIN32
@@ -39,6 +41,8 @@ typedef int socklen_t;
 #include "core/scope_exit.h"
 #include "core/strings.h"
 #include "fmt/printf.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <system_error>
@@ -51,6 +55,7 @@ using std::string;
 using std::thread;
 using std::unique_ptr;
 using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 using wwiv::core::ScopeExit;
 using wwiv::os::sleep_for;
 using namespace wwiv::core;
@@ -78,8 +83,39 @@ static bool socket_avail(SOCKET sock, int seconds) {
   return result == 1;
 }
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif  // MSG_NOSIGNAL 
+
+// Size of the ring of pending output.  Large enough to hold most ANSI
+// screens so they go out in a couple of packets.
+static constexpr std::size_t OUTPUT_RING_SIZE = 16 * 1024;
+
+static bool would_block() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR;
+#endif
+}
+
+/** Waits up to a second for sock to be writable. */
+static void wait_writable(SOCKET sock) {
+#ifdef _WIN32
+  WSAPOLLFD fds{};
+  fds.fd = sock;
+  fds.events = POLLWRNORM;
+  WSAPoll(&fds, 1, 1000);
+#else
+  pollfd fds{};
+  fds.fd = sock;
+  fds.events = POLLOUT;
+  poll(&fds, 1, 1000);
+#endif
+}
+
 RemoteSocketIO::RemoteSocketIO(unsigned int socket_handle, bool telnet)
-    : socket_(static_cast<SOCKET>(socket_handle)), telnet_(telnet) {
+    : socket_(static_cast<SOCKET>(socket_handle)), out_(OUTPUT_RING_SIZE), telnet_(telnet) {
   // assigning the value to a static causes this only to be initialized once.
   [[maybe_unused]] static auto once = Initialize();
 
@@ -102,6 +138,11 @@ bool RemoteSocketIO::open() {
   }
   StartThreads();
 
+  // We do our own coalescing of output, so don't let Nagle's algorithm hold
+  // our flushes waiting on ACKs from the remote side.
+  int one = 1;
+  setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&one), sizeof(one));
+
   GetRemotePeerAddress(socket_, remote_info().address);
   GetRemotePeerHostname(socket_, remote_info().address_name);
   if (telnet_) {
@@ -135,6 +176,9 @@ void RemoteSocketIO::close(bool temporary) {
     // Early return on invalid sockets.
     return;
   }
+  // Anything pending must go out before the socket is closed or handed to
+  // another process.
+  flush();
   if (!temporary) {
     // this will stop the threads
     closesocket(socket_);
@@ -148,16 +192,8 @@ unsigned int RemoteSocketIO::put(unsigned char ch) {
     return 0;
   }
 
-  unsigned char szBuffer[3] = {ch, 0, 0};
-  if (ch == TELNET_OPTION_IAC) {
-    szBuffer[1] = ch;
-  }
-
-  const auto num_sent = send(socket_, reinterpret_cast<char*>(szBuffer), ssize(szBuffer), 0);
-  if (num_sent == SOCKET_ERROR) {
-    return 0;
-  }
-  return num_sent;
+  const auto c = static_cast<char>(ch);
+  return write(&c, 1);
 }
 
 unsigned char RemoteSocketIO::getW() {
@@ -218,40 +254,162 @@ unsigned int RemoteSocketIO::read(char* buffer, unsigned int count) {
 
 static const char CHAR_TELNET_OPTION_IAC = '\xFF';
 
+void RemoteSocketIO::AppendToRing(const char* buffer, std::size_t count) {
+  const auto tail = (out_head_ + out_size_) % out_.size();
+  const auto first = std::min(count, out_.size() - tail);
+  memcpy(&out_[tail], buffer, first);
+  if (first < count) {
+    memcpy(&out_[0], buffer + first, count - first);
+  }
+  if (out_size_ == 0) {
+    out_oldest_ = steady_clock::now();
+  }
+  out_size_ += count;
+}
+
+void RemoteSocketIO::EnqueueOutput(const char* buffer, unsigned int count, bool no_translation) {
+  const auto* p = buffer;
+  const auto* end = buffer + count;
+  while (p < end) {
+    // Copy everything up to (and including) the next IAC, which is then
+    // doubled to escape it.
+    const auto* iac =
+        no_translation ? nullptr : static_cast<const char*>(memchr(p, CHAR_TELNET_OPTION_IAC, end - p));
+    const auto* run_end = iac ? iac + 1 : end;
+    while (p < run_end) {
+      if (out_size_ == out_.size()) {
+        SendPending();
+        if (out_size_ == out_.size()) {
+          // The send failed, drop the rest.
+          return;
+        }
+      }
+      const auto n = std::min<std::size_t>(run_end - p, out_.size() - out_size_);
+      AppendToRing(p, n);
+      p += n;
+    }
+    if (iac) {
+      if (out_size_ == out_.size()) {
+        SendPending();
+      }
+      if (out_size_ < out_.size()) {
+        AppendToRing(&CHAR_TELNET_OPTION_IAC, 1);
+      }
+    }
+  }
+}
+
+bool RemoteSocketIO::SendPending(const char* extra, unsigned int extra_count) {
+  if (out_size_ == 0 && extra_count == 0) {
+    return true;
+  }
+  ++stats_.flushes;
+  // Up to 2 pieces for the ring (if it has wrapped) and the extra data.
+  struct piece_t {
+    const char* data;
+    std::size_t size;
+  };
+  piece_t pieces[3]{};
+  auto num_pieces = 0;
+  if (out_size_ > 0) {
+    const auto first = std::min(out_size_, out_.size() - out_head_);
+    pieces[num_pieces++] = {&out_[out_head_], first};
+    if (first < out_size_) {
+      pieces[num_pieces++] = {&out_[0], out_size_ - first};
+    }
+  }
+  if (extra_count > 0) {
+    pieces[num_pieces++] = {extra, extra_count};
+  }
+
+  auto current = 0;
+  while (current < num_pieces) {
+    if (!valid_socket()) {
+      out_head_ = out_size_ = 0;
+      return false;
+    }
+    ++stats_.send_calls;
+#ifdef _WIN32
+    WSABUF bufs[3];
+    for (auto i = current; i < num_pieces; i++) {
+      bufs[i - current].buf = const_cast<char*>(pieces[i].data);
+      bufs[i - current].len = static_cast<ULONG>(pieces[i].size);
+    }
+    DWORD num_sent = 0;
+    const auto result = WSASend(socket_, bufs, static_cast<DWORD>(num_pieces - current), &num_sent,
+                                0, nullptr, nullptr);
+    auto sent = result == SOCKET_ERROR ? -1 : static_cast<long>(num_sent);
+#else
+    iovec iov[3];
+    for (auto i = current; i < num_pieces; i++) {
+      iov[i - current].iov_base = const_cast<char*>(pieces[i].data);
+      iov[i - current].iov_len = pieces[i].size;
+    }
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = num_pieces - current;
+    auto sent = sendmsg(socket_, &msg, MSG_NOSIGNAL);
+#endif
+    if (sent == SOCKET_ERROR) {
+      if (would_block()) {
+        wait_writable(socket_);
+        continue;
+      }
+      // Nothing more can be sent on this socket, the reader will notice
+      // and close it.
+      out_head_ = out_size_ = 0;
+      return false;
+    }
+    stats_.bytes_sent += sent;
+    // Consume the sent bytes from the pieces.
+    while (current < num_pieces && sent >= static_cast<decltype(sent)>(pieces[current].size)) {
+      sent -= static_cast<decltype(sent)>(pieces[current].size);
+      ++current;
+    }
+    if (current < num_pieces) {
+      pieces[current].data += sent;
+      pieces[current].size -= sent;
+    }
+  }
+  out_head_ = out_size_ = 0;
+  return true;
+}
+
 unsigned int RemoteSocketIO::write(const char* buffer, unsigned int count, bool no_translation) {
   // Early return on invalid sockets.
   if (!valid_socket()) {
     return 0;
   }
 
-  const auto tmp_buffer = make_unique<char[]>(count * 2 + 100);
-  memset(tmp_buffer.get(), 0, count * 2 + 100);
-  int nCount = count;
-
-  if (no_translation || !memchr(buffer, CHAR_TELNET_OPTION_IAC, count)) {
-    memcpy(tmp_buffer.get(), buffer, count);
-  } else {
-    // If there is a #255 then escape the #255's
-    const auto* p = buffer;
-    auto* p2 = tmp_buffer.get();
-    for (unsigned int i = 0; i < count; i++) {
-      if (*p == CHAR_TELNET_OPTION_IAC && !no_translation) {
-        *p2++ = CHAR_TELNET_OPTION_IAC;
-        *p2++ = CHAR_TELNET_OPTION_IAC;
-        nCount++;
-      } else {
-        *p2++ = *p;
-      }
-      p++;
-    }
-    *p2 = '\0';
+  std::unique_lock<std::mutex> lock(out_mu_);
+  stats_.bytes_in += count;
+  if (count >= out_.size() &&
+      (no_translation || !memchr(buffer, CHAR_TELNET_OPTION_IAC, count))) {
+    // Large writes that need no escaping are sent straight from the
+    // caller's buffer behind whatever is pending.
+    return SendPending(buffer, count) ? count : 0;
   }
 
-  const auto num_sent = send(socket_, tmp_buffer.get(), nCount, 0);
-  if (num_sent == SOCKET_ERROR) {
-    return 0;
+  const auto was_empty = out_size_ == 0;
+  EnqueueOutput(buffer, count, no_translation);
+  if (!writer_running_.load()) {
+    // Nothing will come along later to flush the output.
+    SendPending();
+  } else if (was_empty) {
+    lock.unlock();
+    out_cv_.notify_one();
   }
-  return num_sent;
+  return count;
+}
+
+void RemoteSocketIO::flush() {
+  std::lock_guard<std::mutex> lock(out_mu_);
+  SendPending();
+}
+
+remote_socket_io_stats_t RemoteSocketIO::stats() const {
+  std::lock_guard<std::mutex> lock(out_mu_);
+  return stats_;
 }
 
 bool RemoteSocketIO::connected() {
@@ -281,8 +439,22 @@ void RemoteSocketIO::StopThreads() {
     stop_.store(true);
     threads_started_ = false;
   }
+  {
+    // Take the lock so the writer can't miss the stop notification.
+    std::lock_guard<std::mutex> lock(out_mu_);
+    writer_running_.store(false);
+  }
+  out_cv_.notify_all();
   os::yield();
 
+  try {
+    if (write_thread_.joinable()) {
+      write_thread_.join();
+    }
+  } catch (const std::system_error& e) {
+    LOG(ERROR) << "Caught system_error with code: " << e.code() << "; meaning: " << e.what();
+  }
+
   // Wait for read thread to exit.
   if (!read_thread_.joinable()) {
     LOG(ERROR) << "read_thread_ is not JOINABLE.  Should not happen.";
@@ -307,6 +479,8 @@ void RemoteSocketIO::StartThreads() {
 
   stop_.store(false);
   read_thread_ = thread(&RemoteSocketIO::InboundTelnetProc, this);
+  writer_running_.store(true);
+  write_thread_ = thread(&RemoteSocketIO::OutboundTelnetProc, this);
 }
 
 RemoteSocketIO::~RemoteSocketIO() {
@@ -389,6 +563,25 @@ void RemoteSocketIO::InboundTelnetProc() {
   }
 }
 
+void RemoteSocketIO::OutboundTelnetProc() {
+  std::unique_lock<std::mutex> lock(out_mu_);
+  while (!stop_.load()) {
+    if (out_size_ == 0) {
+      out_cv_.wait(lock, [this] { return out_size_ > 0 || stop_.load(); });
+      continue;
+    }
+    // Give the caller a chance to add more output so that it goes out
+    // together, but don't hold onto it for longer than kCoalesceWindow.
+    const auto deadline = out_oldest_ + kCoalesceWindow;
+    if (steady_clock::now() < deadline) {
+      out_cv_.wait_until(lock, deadline, [this] { return out_size_ == 0 || stop_.load(); });
+      continue;
+    }
+    SendPending();
+  }
+  SendPending();
+}
+
 void RemoteSocketIO::set_binary_mode(bool b) {
   binary_mode_ = b;
   skip_next_ = false;
@@ -23,10 +23,13 @@
 #include "core/net.h" // INVALID_SOCKET
 #include "common/remote_io.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 #if defined( _WIN32 )
 #define NOCRYPT // Disable include of wincrypt.h
@@ -39,6 +42,18 @@ typedef int SOCKET;
 
 namespace wwiv::common {
 
+/** Counters for the output side of a RemoteSocketIO session. */
+struct remote_socket_io_stats_t {
+  // Bytes handed to put or write by the caller.
+  uint64_t bytes_in{0};
+  // Bytes sent to the socket (after escaping any IACs).
+  uint64_t bytes_sent{0};
+  // Number of send/writev calls made.
+  uint64_t send_calls{0};
+  // Number of times pending output has been flushed.
+  uint64_t flushes{0};
+};
+
 class RemoteSocketIO final : public RemoteIO {
  public:
   static const uint8_t TELNET_OPTION_IAC = 255;
@@ -77,6 +92,7 @@ class RemoteSocketIO final : public RemoteIO {
   unsigned int write(const char *buffer, unsigned int count, bool no_translation = false) override;
   bool connected() override;
   bool incoming() override;
+  void flush() override;
   void StopThreads();
   void StartThreads();
   unsigned int GetHandle() const override;
@@ -88,16 +104,55 @@ class RemoteSocketIO final : public RemoteIO {
 
   void set_binary_mode(bool b) override;
 
+  /** Returns a copy of the output counters for this session. */
+  [[nodiscard]] remote_socket_io_stats_t stats() const;
+
+  /**
+   * Output is held for at most this long waiting for more output to
+   * coalesce with before it is sent.
+   */
+  static constexpr auto kCoalesceWindow = std::chrono::milliseconds(20);
+
 private:
   void HandleTelnetIAC(unsigned char nCmd, unsigned char nParam);
   void InboundTelnetProc();
+  void OutboundTelnetProc();
+
+  /**
+   * Adds count bytes from buffer to the pending output, escaping IAC
+   * characters unless no_translation is true. Requires out_mu_ to be held.
+   */
+  void EnqueueOutput(const char* buffer, unsigned int count, bool no_translation);
+
+  /**
+   * Sends all pending output followed by count bytes from extra (which are
+   * sent as is) using as few calls as possible. Requires out_mu_ to be held.
+   */
+  bool SendPending(const char* extra = nullptr, unsigned int extra_count = 0);
+
+  /** Writes buffer into the output ring at the tail. Requires out_mu_ to be held. */
+  void AppendToRing(const char* buffer, std::size_t count);
 
   std::queue<char> queue_;
   mutable std::mutex mu_;
   mutable std::mutex threads_started_mu_;
   SOCKET socket_{INVALID_SOCKET};
   std::thread read_thread_;
+  std::thread write_thread_;
   std::atomic<bool> stop_;
+
+  // Output ring of bytes waiting to be sent, already escaped.
+  mutable std::mutex out_mu_;
+  std::condition_variable out_cv_;
+  std::vector<char> out_;
+  std::size_t out_head_{0};
+  std::size_t out_size_{0};
+  // When the oldest byte in the output ring was added.
+  std::chrono::steady_clock::time_point out_oldest_{};
+  remote_socket_io_stats_t stats_;
+  // True while the output thread is around to flush coalesced output.
+  std::atomic<bool> writer_running_{false};
+
   bool threads_started_{false};
   bool telnet_{true};
   bool skip_next_{false};
@@ -21,7 +21,9 @@
 #include "gtest/gtest.h"
 #include "common/remote_socket_io.h"
 
+#include <memory>
 #include <string>
+#include <thread>
 
 using namespace wwiv::common;
 using namespace testing;
@@ -80,3 +82,99 @@ TEST(RemoteSocketIOTest, TwoFFAtEnd) {
   EXPECT_EQ(io.queue().size(), 4u) << DumpQueue(io.queue());
 }
 
+
+#ifndef _WIN32
+#include <sys/socket.h>
+
+class RemoteSocketIOOutputTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    io_ = std::make_unique<RemoteSocketIO>(fds[0], false);
+    remote_ = fds[1];
+  }
+
+  void TearDown() override {
+    io_.reset();
+    closesocket(remote_);
+  }
+
+  std::string ReadRemote() {
+    std::string s;
+    char buf[1024];
+    while (true) {
+      const auto num = recv(remote_, buf, sizeof(buf), MSG_DONTWAIT);
+      if (num <= 0) {
+        return s;
+      }
+      s.append(buf, num);
+    }
+  }
+
+  std::unique_ptr<RemoteSocketIO> io_;
+  SOCKET remote_{INVALID_SOCKET};
+};
+
+TEST_F(RemoteSocketIOOutputTest, Unbuffered_WithoutThreads) {
+  io_->put('a');
+  io_->write("bc", 2);
+  EXPECT_EQ("abc", ReadRemote());
+}
+
+TEST_F(RemoteSocketIOOutputTest, EscapesIAC) {
+  io_->write("a\xff" "b", 3);
+  io_->put(0xff);
+  EXPECT_EQ("a\xff\xff" "b\xff\xff", ReadRemote());
+}
+
+TEST_F(RemoteSocketIOOutputTest, NoTranslation) {
+  io_->write("a\xff" "b", 3, true);
+  EXPECT_EQ("a\xff" "b", ReadRemote());
+}
+
+TEST_F(RemoteSocketIOOutputTest, CoalescesUntilFlush) {
+  io_->StartThreads();
+  for (const auto c : std::string("Hello World")) {
+    io_->put(c);
+  }
+  io_->flush();
+  EXPECT_EQ("Hello World", ReadRemote());
+  const auto stats = io_->stats();
+  EXPECT_EQ(11u, stats.bytes_in);
+  EXPECT_EQ(11u, stats.bytes_sent);
+  // Should be one send unless the coalesce window expired mid way.
+  EXPECT_LE(stats.send_calls, 2u);
+  io_->StopThreads();
+}
+
+TEST_F(RemoteSocketIOOutputTest, FlushesAfterCoalesceWindow) {
+  io_->StartThreads();
+  io_->write("abc", 3);
+  std::this_thread::sleep_for(RemoteSocketIO::kCoalesceWindow * 5);
+  EXPECT_EQ("abc", ReadRemote());
+  io_->StopThreads();
+}
+
+TEST_F(RemoteSocketIOOutputTest, LargeWriteAndWrappedRing) {
+  io_->StartThreads();
+  std::string expected;
+  // Larger than the ring so that it has to flush and wrap around.
+  for (auto i = 0; i < 5000; i++) {
+    const auto s = fmt::format("line {} \xff\r\n", i);
+    io_->write(s.c_str(), static_cast<unsigned int>(s.size()));
+    expected.append(fmt::format("line {} \xff\xff\r\n", i));
+  }
+  std::string received;
+  std::thread reader([&] {
+    while (received.size() < expected.size()) {
+      received.append(ReadRemote());
+      std::this_thread::yield();
+    }
+  });
+  io_->flush();
+  reader.join();
+  EXPECT_EQ(expected, received);
+  io_->StopThreads();
+}
+#endif // _WIN32
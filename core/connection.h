@@ -36,6 +36,13 @@ public:
 
   virtual uint16_t read_uint16(std::chrono::duration<double> d) = 0;
   virtual uint8_t read_uint8(std::chrono::duration<double> d) = 0;
+
+  /**
+   * Waits up to duration d for data to become available to read, returning
+   * true as soon as there is data pending (or the remote side has closed the
+   * connection) and false on timeout. A zero duration does not block.
+   */
+  virtual bool wait_for_data(std::chrono::duration<double> d) = 0;
   [[nodiscard]] virtual bool is_open() const = 0;
   virtual bool close() = 0;
 };
@@ -1,133 +1,392 @@
-/*
-*  Crc - 32 BIT ANSI X3.66 CRC checksum files
-*/
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*            Copyright (C)2016-2021, WWIV Software Services              */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/**************************************************************************/
+#include "core/crc32.h"
+
 #include "core/file.h"
+#include <cstring>
 #include <memory>
 #include <string>
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WWIV_CRC32_PCLMUL
+#define WWIV_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define WWIV_CRC32_PCLMUL
+#define WWIV_PCLMUL_TARGET
+#include <intrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__) && (defined(__linux__) || defined(__APPLE__))
+#define WWIV_CRC32_ARMV8
+#if defined(__clang__)
+#define WWIV_ARMV8_CRC_TARGET __attribute__((target("crc")))
+#else
+#define WWIV_ARMV8_CRC_TARGET __attribute__((target("+crc")))
+#endif
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+#endif
+
 namespace wwiv::core {
 
-/**********************************************************************\
-|*                                                                    *|
-|* Demonstration program to compute the 32-bit CRC used as the frame  *|
-|* check sequence in ADCCP (ANSI X3.66, also known as FIPS PUB 71     *|
-|* and FED-STD-1003, the U.S. versions of CCITT's X.25 link-level     *|
-|* protocol).  The 32-bit FCS was added via the Federal Register,     *|
-|* 1 June 1982, p.23798.  I presume but don't know for certain that   *|
-|* this polynomial is or will be included in CCITT V.41, which        *|
-|* defines the 16-bit CRC (often called CRC-CCITT) polynomial.  FIPS  *|
-|* PUB 78 says that the 32-bit FCS reduces otherwise undetected       *|
-|* errors by a factor of 10^-5 over 16-bit FCS.                       *|
-|*                                                                    *|
-\**********************************************************************/
+/*
+ * The CRC-32 polynomial is
+ * X^32+X^26+X^23+X^22+X^16+X^12+X^11+X^10+X^8+X^7+X^5+X^4+X^2+X^1+X^0
+ * taken "backwards" (0xedb88320) as in Gary S. Brown's original table, so
+ * that the highest-order term is in the lowest-order bit.  The CRC-16 is
+ * the CCITT polynomial 0x1021 used forwards as XModem does.
+ *
+ * Slicing-by-N uses N tables, where table k holds the CRC of a byte followed
+ * by k zero bytes, so that N bytes can be folded in with N independent
+ * lookups rather than N dependent ones.
+ */
+static constexpr uint32_t kPolynomial = 0xedb88320;
+static constexpr int kNumSlices = 16;
+
+typedef std::array<std::array<uint32_t, 256>, kNumSlices> slice_tables_t;
+
+static constexpr slice_tables_t make_slice_tables() {
+  slice_tables_t t{};
+  for (uint32_t i = 0; i < 256; i++) {
+    auto c = i;
+    for (auto j = 0; j < 8; j++) {
+      c = (c & 1) ? (c >> 1) ^ kPolynomial : c >> 1;
+    }
+    t[0][i] = c;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (auto k = 1; k < kNumSlices; k++) {
+      t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+    }
+  }
+  return t;
+}
+
+static constexpr std::array<uint16_t, 256> make_crc16_table() {
+  std::array<uint16_t, 256> t{};
+  for (uint32_t i = 0; i < 256; i++) {
+    auto c = i << 8;
+    for (auto j = 0; j < 8; j++) {
+      c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+    }
+    t[i] = static_cast<uint16_t>(c);
+  }
+  return t;
+}
+
+static constexpr slice_tables_t kSlices = make_slice_tables();
+const std::array<uint32_t, 256> kCrc32Table = kSlices[0];
+const std::array<uint16_t, 256> kCrc16Table = make_crc16_table();
+
+// Loads 4 bytes as a little endian value, which is the order the reflected
+// CRC consumes them in, regardless of the byte order of this CPU.
+static inline uint32_t load_le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+// The functions below work on the CRC register, the inverse of the CRC.
+
+static uint32_t crc32_bytewise(uint32_t reg, const uint8_t* p, std::size_t len) {
+  while (len--) {
+    reg = crc32_byte(reg, *p++);
+  }
+  return reg;
+}
+
+static uint32_t crc32_slice_by_8(uint32_t reg, const uint8_t* p, std::size_t len) {
+  const auto& t = kSlices;
+  while (len >= 8) {
+    const auto one = load_le32(p) ^ reg;
+    const auto two = load_le32(p + 4);
+    reg = t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff] ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24] ^
+          t[3][two & 0xff] ^ t[2][(two >> 8) & 0xff] ^ t[1][(two >> 16) & 0xff] ^ t[0][two >> 24];
+    p += 8;
+    len -= 8;
+  }
+  return crc32_bytewise(reg, p, len);
+}
+
+static uint32_t crc32_slice_by_16(uint32_t reg, const uint8_t* p, std::size_t len) {
+  const auto& t = kSlices;
+  while (len >= 16) {
+    const auto one = load_le32(p) ^ reg;
+    const auto two = load_le32(p + 4);
+    const auto three = load_le32(p + 8);
+    const auto four = load_le32(p + 12);
+    reg = t[15][one & 0xff] ^ t[14][(one >> 8) & 0xff] ^ t[13][(one >> 16) & 0xff] ^
+          t[12][one >> 24] ^ t[11][two & 0xff] ^ t[10][(two >> 8) & 0xff] ^
+          t[9][(two >> 16) & 0xff] ^ t[8][two >> 24] ^ t[7][three & 0xff] ^
+          t[6][(three >> 8) & 0xff] ^ t[5][(three >> 16) & 0xff] ^ t[4][three >> 24] ^
+          t[3][four & 0xff] ^ t[2][(four >> 8) & 0xff] ^ t[1][(four >> 16) & 0xff] ^
+          t[0][four >> 24];
+    p += 16;
+    len -= 16;
+  }
+  return crc32_bytewise(reg, p, len);
+}
+
+#ifdef WWIV_CRC32_PCLMUL
+
+static bool cpu_has_pclmul() {
+#if defined(_MSC_VER)
+  int info[4]{};
+  __cpuid(info, 1);
+  // ECX bit 1 is PCLMULQDQ, bit 19 is SSE4.1
+  return (info[2] & (1 << 1)) && (info[2] & (1 << 19));
+#else
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
 
 /*
-* Copyright (C) 1986 Gary S. Brown.  You may use this program, or
-* code or tables extracted from it, as desired without restriction.
-*/
-/* First, the polynomial itself and its table of feedback terms.  The  */
-/* polynomial is                                                       */
-/* X^32+X^26+X^23+X^22+X^16+X^12+X^11+X^10+X^8+X^7+X^5+X^4+X^2+X^1+X^0 */
-/* Note that we take it "backwards" and put the highest-order term in  */
-/* the lowest-order bit.  The X^32 term is "implied"; the LSB is the   */
-/* X^31 term, etc.  The X^0 term (usually shown as "+1") results in    */
-/* the MSB being 1.                                                    */
-
-/* Note that the usual hardware shift register implementation, which   */
-/* is what we're using (we're merely optimizing it by doing eight-bit  */
-/* chunks at a time) shifts bits into the lowest-order term.  In our   */
-/* implementation, that means shifting towards the right.  Why do we   */
-/* do it this way?  Because the calculated CRC must be transmitted in  */
-/* order from highest-order term to lowest-order term.  UARTs transmit */
-/* characters in order from LSB to MSB.  By storing the CRC this way,  */
-/* we hand it to the UART in the order low-byte to high-byte; the UART */
-/* sends each low-bit to hight-bit; and the result is transmission bit */
-/* by bit from highest- to lowest-order term without requiring any bit */
-/* shuffling on our part.  Reception works similarly.                  */
-
-/* The feedback terms table consists of 256, 32-bit entries.  Notes:   */
-/*                                                                     */
-/*  1. The table can be generated at runtime if desired; code to do so */
-/*     is shown later.  It might not be obvious, but the feedback      */
-/*     terms simply represent the results of eight shift/xor opera-    */
-/*     tions for all combinations of data and CRC register values.     */
-/*                                                                     */
-/*  2. The CRC accumulation logic is the same for all CRC polynomials, */
-/*     be they sixteen or thirty-two bits wide.  You simply choose the */
-/*     appropriate table.  Alternatively, because the table can be     */
-/*     generated at runtime, you can start by generating the table for */
-/*     the polynomial in question and use exactly the same "updcrc",   */
-/*     if your application needn't simultaneously handle two CRC       */
-/*     polynomials.  (Note, however, that XMODEM is strange.)          */
-/*                                                                     */
-/*  3. For 16-bit CRCs, the table entries need be only 16 bits wide;   */
-/*     of course, 32-bit entries work OK if the high 16 bits are zero. */
-/*                                                                     */
-/*  4. The values must be right-shifted by eight bits by the "updcrc"  */
-/*     logic; the shift must be unsigned (bring in zeroes).  On some   */
-/*     hardware you could probably optimize the shift in assembler by  */
-/*     using byte-swap instructions.                                   */
-
-static uint32_t crc_32_tab[] = { /* CRC polynomial 0xedb88320 */
-    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
-    0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
-    0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5,
-    0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
-    0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599, 0xb8bda50f,
-    0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924, 0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,
-    0x76dc4190, 0x01db7106, 0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
-    0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
-    0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb,
-    0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9,
-    0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad,
-    0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a, 0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683,
-    0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7,
-    0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
-    0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
-    0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236, 0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f,
-    0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
-    0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21,
-    0x86d3d2d4, 0xf1d4e242, 0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45,
-    0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db,
-    0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
-    0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-};
-
-#define UPDC32(octet, crc) (crc_32_tab[((crc) ^ (octet)) & 0xff] ^ ((crc) >> 8))
+ * Folds 64 bytes at a time using carry-less multiplication, then reduces
+ * the result to 32 bits with a Barrett reduction.  The constants are the
+ * bit-reflected ones from Intel's "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction" paper.  len must be at least 64
+ * and a multiple of 16.
+ */
+WWIV_PCLMUL_TARGET
+static uint32_t crc32_pclmul_blocks(uint32_t reg, const uint8_t* p, std::size_t len) {
+  alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+  alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+  alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+  alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+  auto x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+  auto x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+  auto x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+  auto x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(reg)));
+  auto x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+  p += 64;
+  len -= 64;
+
+  // Fold 4 blocks of 16 bytes in parallel.
+  while (len >= 64) {
+    const auto x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    const auto x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    const auto x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    const auto x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30)));
+    p += 64;
+    len -= 64;
+  }
+
+  // Fold the 4 blocks into 1.
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+  for (const auto& next : {x2, x3, x4}) {
+    const auto x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, next), x5);
+  }
+
+  // Fold in any remaining blocks of 16.
+  while (len >= 16) {
+    const auto x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                       x5);
+    p += 16;
+    len -= 16;
+  }
+
+  // Fold 128 bits down to 64.
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction down to 32 bits.
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+static uint32_t crc32_pclmul(uint32_t reg, const uint8_t* p, std::size_t len) {
+  if (len < 64) {
+    return crc32_slice_by_16(reg, p, len);
+  }
+  const auto blocks = len & ~static_cast<std::size_t>(15);
+  reg = crc32_pclmul_blocks(reg, p, blocks);
+  return crc32_bytewise(reg, p + blocks, len - blocks);
+}
+
+#endif // WWIV_CRC32_PCLMUL
+
+#ifdef WWIV_CRC32_ARMV8
+
+static bool cpu_has_armv8_crc() {
+#if defined(__APPLE__)
+  // Every Apple ARM CPU has them.
+  return true;
+#else
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+}
+
+WWIV_ARMV8_CRC_TARGET
+static uint32_t crc32_armv8(uint32_t reg, const uint8_t* p, std::size_t len) {
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    reg = __crc32d(reg, v);
+    p += 8;
+    len -= 8;
+  }
+  while (len--) {
+    reg = __crc32b(reg, *p++);
+  }
+  return reg;
+}
+
+#endif // WWIV_CRC32_ARMV8
+
+std::string to_string(crc32_impl_t impl) {
+  switch (impl) {
+  case crc32_impl_t::bytewise:
+    return "bytewise";
+  case crc32_impl_t::slice_by_8:
+    return "slice_by_8";
+  case crc32_impl_t::slice_by_16:
+    return "slice_by_16";
+  case crc32_impl_t::pclmul:
+    return "pclmul";
+  case crc32_impl_t::armv8:
+    return "armv8";
+  }
+  return "unknown";
+}
+
+bool crc32_impl_supported(crc32_impl_t impl) {
+  switch (impl) {
+  case crc32_impl_t::bytewise:
+  case crc32_impl_t::slice_by_8:
+  case crc32_impl_t::slice_by_16:
+    return true;
+  case crc32_impl_t::pclmul:
+#ifdef WWIV_CRC32_PCLMUL
+    return cpu_has_pclmul();
+#else
+    return false;
+#endif
+  case crc32_impl_t::armv8:
+#ifdef WWIV_CRC32_ARMV8
+    return cpu_has_armv8_crc();
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+crc32_impl_t crc32_default_impl() {
+  static const auto impl = [] {
+    for (const auto i : {crc32_impl_t::armv8, crc32_impl_t::pclmul}) {
+      if (crc32_impl_supported(i)) {
+        return i;
+      }
+    }
+    return crc32_impl_t::slice_by_16;
+  }();
+  return impl;
+}
+
+uint32_t crc32(uint32_t crc, const void* data, std::size_t len, crc32_impl_t impl) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  const auto reg = ~crc;
+  switch (impl) {
+  case crc32_impl_t::bytewise:
+    return ~crc32_bytewise(reg, p, len);
+  case crc32_impl_t::slice_by_8:
+    return ~crc32_slice_by_8(reg, p, len);
+#ifdef WWIV_CRC32_PCLMUL
+  case crc32_impl_t::pclmul:
+    return ~crc32_pclmul(reg, p, len);
+#endif
+#ifdef WWIV_CRC32_ARMV8
+  case crc32_impl_t::armv8:
+    return ~crc32_armv8(reg, p, len);
+#endif
+  default:
+    return ~crc32_slice_by_16(reg, p, len);
+  }
+}
+
+uint32_t crc32(uint32_t crc, const void* data, std::size_t len) {
+  static const auto impl = crc32_default_impl();
+  return crc32(crc, data, len, impl);
+}
 
 uint32_t crc32file(const std::filesystem::path& path) {
-  uint32_t crc = 0xFFFFFFFF;
   File file(path);
   if (!file.Open(File::modeReadOnly | File::modeBinary, File::shareDenyWrite)) {
-    return false;
+    return 0;
   }
-  const auto size = file.length();
-  const auto buffer = std::make_unique<uint8_t[]>(size);
-  if (!file.Read(buffer.get(), size)) {
-    return false;
-  }
-  for (auto i = 0; i < size; i++) {
-    crc = UPDC32(buffer[i], crc);
+  constexpr auto kBufferSize = 64 * 1024;
+  const auto buffer = std::make_unique<uint8_t[]>(kBufferSize);
+  Crc32 crc;
+  for (;;) {
+    const auto num = file.Read(buffer.get(), kBufferSize);
+    if (num <= 0) {
+      break;
+    }
+    crc.update(buffer.get(), static_cast<std::size_t>(num));
   }
-  return ~crc;
+  return crc.value();
 }
 
 uint32_t crc32string(const std::string& contents) {
-  uint32_t crc = 0xFFFFFFFF;
-  for (const auto& c : contents) {
-    crc = UPDC32(c, crc);
+  return crc32(0, contents.data(), contents.size());
+}
+
+uint16_t crc16(uint16_t crc, const void* data, std::size_t len) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  while (len--) {
+    crc = crc16_byte(crc, *p++);
   }
-  return ~crc;
+  return crc;
 }
 
 }
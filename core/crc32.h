@@ -18,14 +18,91 @@
 #ifndef INCLUDED_CORE_CRC32_H
 #define INCLUDED_CORE_CRC32_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <string_view>
 
 namespace wwiv::core {
 
+/**
+ * The ways we know how to compute a CRC-32.  crc32() uses the fastest one
+ * this CPU supports; the others exist for testing and benchmarking.
+ */
+enum class crc32_impl_t {
+  // One table lookup per byte.
+  bytewise,
+  // Slicing-by-8 and slicing-by-16 tables, portable to any CPU.
+  slice_by_8,
+  slice_by_16,
+  // Carry-less multiply folding on x86 CPUs with PCLMULQDQ and SSE4.1.
+  pclmul,
+  // The CRC32 instructions on ARMv8 CPUs.
+  armv8
+};
+
+[[nodiscard]] std::string to_string(crc32_impl_t impl);
+
+/** Returns true if impl may be used on this CPU. */
+[[nodiscard]] bool crc32_impl_supported(crc32_impl_t impl);
+
+/** Returns the implementation used by crc32(). */
+[[nodiscard]] crc32_impl_t crc32_default_impl();
+
+/**
+ * Returns the CRC-32 (the zip, BinkP and TIC file one) of len bytes at data,
+ * continuing on from crc, which is either 0 or the result of a previous call
+ * for the data preceding this one.
+ */
+[[nodiscard]] uint32_t crc32(uint32_t crc, const void* data, std::size_t len);
+[[nodiscard]] uint32_t crc32(uint32_t crc, const void* data, std::size_t len, crc32_impl_t impl);
+
+/**
+ * Computes a CRC-32 of data as it is fed in a piece at a time, for example
+ * as the chunks of a file are received.
+ */
+class Crc32 {
+public:
+  void update(const void* data, std::size_t len) noexcept { crc_ = crc32(crc_, data, len); }
+  void update(std::string_view s) noexcept { update(s.data(), s.size()); }
+  void reset() noexcept { crc_ = 0; }
+  [[nodiscard]] uint32_t value() const noexcept { return crc_; }
+
+private:
+  uint32_t crc_{0};
+};
+
+/** Returns the CRC-32 of the file at path, or 0 if it can not be read. */
 [[nodiscard]] uint32_t crc32file(const std::filesystem::path& path);
 [[nodiscard]] uint32_t crc32string(const std::string& contents);
 
+/**
+ * Returns the CRC-16 used by XModem, YModem and ZModem (CCITT polynomial,
+ * not reflected, starting at 0) of len bytes at data, continuing on from crc.
+ */
+[[nodiscard]] uint16_t crc16(uint16_t crc, const void* data, std::size_t len);
+
+// Byte at a time tables for the protocol code that updates its CRC as it
+// escapes or unescapes each byte.
+extern const std::array<uint32_t, 256> kCrc32Table;
+extern const std::array<uint16_t, 256> kCrc16Table;
+
+/**
+ * Updates the running CRC-32 register with b.  The register is the inverse
+ * of the CRC-32; it starts at 0xffffffff and is inverted once all of the
+ * data has been added.
+ */
+inline uint32_t crc32_byte(uint32_t reg, uint8_t b) noexcept {
+  return kCrc32Table[(reg ^ b) & 0xff] ^ (reg >> 8);
+}
+
+/** Updates crc, as returned by crc16(), with b. */
+inline uint16_t crc16_byte(uint16_t crc, uint8_t b) noexcept {
+  return static_cast<uint16_t>((crc << 8) ^ kCrc16Table[((crc >> 8) ^ b) & 0xff]);
+}
+
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -280,8 +280,12 @@ struct tm DateTime::to_tm() const noexcept {
 }
 
 void DateTime::update_tm() noexcept {
-  const auto* tm = localtime(&t_);
-  tm_ = *tm;
+  // Use the reentrant versions so DateTime may be used from worker threads.
+#ifdef _WIN32
+  localtime_s(&tm_, &t_);
+#else
+  localtime_r(&t_, &tm_);
+#endif
 }
 
 system_clock::time_point DateTime::to_system_clock() const noexcept {
@@ -23,6 +23,7 @@
 #include "core/os.h"
 #include "core/strings.h"
 #include "core/wfndfile.h"
+#include <atomic>
 #include <cerrno>
 #include <cstring>
 #include <string>
@@ -300,6 +301,18 @@ bool File::Exists() const noexcept {
 
 // ReSharper disable once CppMemberFunctionMayBeConst
 bool File::set_length(size_type l) {
+  if (IsOpen()) {
+    // Go through the handle so this works while we hold the file locked.
+#ifdef _WIN32
+    const auto ok = _chsize_s(handle_, l) == 0;
+#else
+    const auto ok = ftruncate(handle_, l) == 0;
+#endif // _WIN32
+    if (!ok) {
+      LOG(WARNING) << "Error truncating: " << full_path_name_ << "; " << strerror(errno);
+    }
+    return ok;
+  }
   std::error_code ec;
   resize_file(full_path_name_, l, ec);
   if (ec.value() != 0) {
@@ -309,6 +322,15 @@ bool File::set_length(size_type l) {
   return true;
 }
 
+// ReSharper disable once CppMemberFunctionMayBeConst
+bool File::fsync() {
+#ifdef _WIN32
+  return _commit(handle_) == 0;
+#else
+  return ::fsync(handle_) == 0;
+#endif
+}
+
 // static
 bool File::is_directory(const std::string& path) noexcept {
   std::error_code ec;
@@ -348,6 +370,30 @@ bool File::Rename(const std::filesystem::path& o, const std::filesystem::path& n
   return ec.value() == 0;
 }
 
+bool File::ReplaceContents(const std::filesystem::path& path, const std::string& data) {
+  static std::atomic<int> num{0};
+  const auto tmp_path = path.parent_path() / wwiv::strings::StrCat(path.filename().string(), ".",
+                                                                   wwiv::os::get_pid(), ".",
+                                                                   num++, ".tmp");
+  {
+    File f(tmp_path);
+    if (!f.Open(modeBinary | modeReadWrite | modeCreateFile | modeTruncate) ||
+        f.Write(data) != static_cast<size_type>(data.size())) {
+      f.Close();
+      Remove(tmp_path);
+      return false;
+    }
+  }
+  if (Rename(tmp_path, path)) {
+    return true;
+  }
+  Remove(tmp_path);
+  VLOG(1) << "Unable to rename over: " << path << "; rewriting it in place.";
+  File f(path);
+  return f.Open(modeBinary | modeReadWrite | modeCreateFile | modeTruncate) &&
+         f.Write(data) == static_cast<size_type>(data.size());
+}
+
 bool File::Remove(const std::filesystem::path& path, bool force) {
   if (!Exists(path)) {
     // Don't try to delete a file that doesn't exist.
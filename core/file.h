@@ -123,6 +123,8 @@ public:
   [[nodiscard]] size_type length() const noexcept;
   size_type Seek(size_type offset, Whence whence);
   bool set_length(size_type l);
+  /** Flushes anything written to this file out to disk. */
+  bool fsync();
   [[nodiscard]] size_type current_position() const;
 
   [[nodiscard]] bool Exists() const noexcept;
@@ -161,6 +163,14 @@ public:
                    const std::filesystem::path& to);
   static bool Move(const std::filesystem::path& from,
                    const std::filesystem::path& to);
+  /**
+   * Replaces the contents of path with data.  It is written to a temporary
+   * file named for this process and renamed over path, so nobody reads a
+   * partial file and concurrent writers don't clobber each other's data.
+   * If path can't be replaced (some platforms won't while another process
+   * has it open) it is rewritten in place.
+   */
+  static bool ReplaceContents(const std::filesystem::path& path, const std::string& data);
 
   static bool SetFilePermissions(const std::filesystem::path& path, int perm);
 
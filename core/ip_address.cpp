@@ -76,17 +76,25 @@ bool ip_address::empty() const {
   return true;
 }
 
+bool ip_address::is_v4() const noexcept {
+  static constexpr uint8_t v4_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+  return memcmp(data_, v4_prefix, sizeof(v4_prefix)) == 0;
+}
+
 std::optional<ip_address> ip_address::from_string(const std::string& s) { 
-  char d[16];
-  auto addr{s};
+  char d[16]{};
   if (s.length() < 2) {
     return std::nullopt;
   }
   if (s.find(':') == std::string::npos) {
-    //make this into a ipv6 address for an ipv4 address
-    addr = wwiv::strings::StrCat("0:0:0:0:0:FFFF:", s);
+    // Store IPv4 addresses as an IPv4-mapped IPv6 address (::ffff:a.b.c.d)
+    d[10] = d[11] = static_cast<char>(0xff);
+    if (inet_pton(AF_INET, s.c_str(), &d[12]) != 1) {
+      return std::nullopt;
+    }
+    return {ip_address(d)};
   }
-  const auto ret = inet_pton(AF_INET6, addr.c_str(), &d);
+  const auto ret = inet_pton(AF_INET6, s.c_str(), &d);
   if (ret != 1) {
     LOG(INFO) << "result code: " << ret;
     return std::nullopt;
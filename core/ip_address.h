@@ -19,6 +19,7 @@
 #ifndef INCLUDED_CORE_IP_ADDRESS_H
 #define INCLUDED_CORE_IP_ADDRESS_H
 
+#include <cstdint>
 #include <cstring>
 #include <optional>
 #include <string>
@@ -36,6 +37,12 @@ public:
 
   /** True if this IP Address is an empty address (i.e. 0.0.0.0 or ::) */
   [[nodiscard]] bool empty() const;
+  /** True if this is an IPv4 address (stored as an IPv4-mapped IPv6 address) */
+  [[nodiscard]] bool is_v4() const noexcept;
+  /** The 16 bytes of the IPv6 address in network byte order. */
+  [[nodiscard]] const uint8_t* bytes() const noexcept {
+    return reinterpret_cast<const uint8_t*>(data_);
+  }
   [[nodiscard]] static std::optional<ip_address> from_string(const std::string&);
   friend inline bool operator==(const ip_address& lhs, const ip_address& rhs);
   friend inline bool operator!=(const ip_address& lhs, const ip_address& rhs);
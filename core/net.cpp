@@ -30,6 +30,7 @@
 #else
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
 #endif // _WIN32
@@ -38,6 +39,7 @@
 #include "core/scope_exit.h"
 #include "core/socket_exceptions.h"
 #include "core/strings.h"
+#include <vector>
 
 using std::string;
 using namespace wwiv::strings;
@@ -222,61 +224,64 @@ bool SocketSet::Run(std::atomic<bool>& exit_signal) {
 }
 
 bool SocketSet::RunOnce() {
-  SOCKET max_fd = 0;
-  fd_set fds{};
-  FD_ZERO(&fds);
+  // poll has no FD_SETSIZE limit on the descriptor numbers, unlike select.
+#ifdef _WIN32
+  std::vector<WSAPOLLFD> fds;
+#else
+  std::vector<pollfd> fds;
+#endif
+  fds.reserve(socket_fn_map_.size());
   for (const auto& e : socket_fn_map_) {
-    if (e.first > max_fd) {
-      max_fd = e.first;
-    }
-    FD_SET(e.first, &fds);
+    fds.push_back({e.first, POLLIN, 0});
   }
 
-  if (max_fd == INVALID_SOCKET) {
+  if (fds.empty()) {
     LOG(ERROR) << "Nothing to do!";
     return false;
   }
 
-  VLOG(3) << "About to call select. (" << max_fd << ")";
-  int status;
-  if (timeout_seconds_ > 0) {
-    timeval timeout{};
-    timeout.tv_usec = 0;
-    timeout.tv_sec = timeout_seconds_;
-    status = select(max_fd + 1, &fds, nullptr, nullptr, &timeout);
-  } else {
-    status = select(max_fd + 1, &fds, nullptr, nullptr, nullptr);
-  }
-  VLOG(3) << "After select.";
+  VLOG(3) << "About to call poll. (" << fds.size() << ")";
+  const auto timeout_ms = timeout_seconds_ > 0 ? timeout_seconds_ * 1000 : -1;
+#ifdef _WIN32
+  const auto status = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+  const auto status = poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+#endif
+  VLOG(3) << "After poll.";
   if (status < 0 && errno == EINTR) {
-    LOG(ERROR) << "Caught signal calling select";
+    LOG(ERROR) << "Caught signal calling poll";
     // return true so we can check for exit signal.
     return true;
   }
   if (status < 0) {
-    LOG(ERROR) << "Error calling select; errno: " << errno;
+    LOG(ERROR) << "Error calling poll; errno: " << errno;
     // return false here since we know this wasn't a signal.
     return false;
   }
   if (status == 0) {
     // Timeout expired.  Keep on trucking.
-    VLOG(4) << "timeout expired on select";
+    VLOG(4) << "timeout expired on poll";
     return true;
   }
 
-  for (const auto& e : socket_fn_map_) {
-    if (FD_ISSET(e.first, &fds)) {
-      socklen_t addr_size = sizeof(sockaddr_in);
-      struct sockaddr_in saddr{};
-      const auto client_sock = accept(e.first, reinterpret_cast<sockaddr*>(&saddr), &addr_size);
+  for (const auto& pfd : fds) {
+    if ((pfd.revents & POLLIN) == 0) {
+      continue;
+    }
+    socklen_t addr_size = sizeof(sockaddr_in);
+    struct sockaddr_in saddr{};
+    const auto client_sock = accept(pfd.fd, reinterpret_cast<sockaddr*>(&saddr), &addr_size);
+    if (client_sock == INVALID_SOCKET) {
+      LOG(ERROR) << "Error calling accept; errno: " << errno;
+      continue;
+    }
 
 #ifdef _WIN32
-      auto newvalue = SO_SYNCHRONOUS_NONALERT;
-      setsockopt(client_sock, SOL_SOCKET, SO_OPENTYPE, reinterpret_cast<char*>(&newvalue),
-                 sizeof(newvalue));
+    auto newvalue = SO_SYNCHRONOUS_NONALERT;
+    setsockopt(client_sock, SOL_SOCKET, SO_OPENTYPE, reinterpret_cast<char*>(&newvalue),
+               sizeof(newvalue));
 #endif
-      e.second({client_sock, socket_port_map_.at(e.first)});
-    }
+    socket_fn_map_.at(pfd.fd)({client_sock, socket_port_map_.at(pfd.fd)});
   }
   return true;
 }
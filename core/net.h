@@ -82,7 +82,7 @@ struct accepted_socket_t {
 };
 
 /**
- * Handles select over a set of sockets.
+ * Handles polling over a set of listening sockets.
  */
 class SocketSet final {
 public:
@@ -101,13 +101,13 @@ public:
   bool add(int port, const socketset_accept_fn& fn, const std::string& description);
 
   /** 
-   * Runs the select/accept/execute loop until exit_signal is true.
+   * Runs the poll/accept/execute loop until exit_signal is true.
    * returning false on error or true of signaled to exit.
    */
   bool Run(std::atomic<bool>& exit_signal);
 
 private:
-  /** Runs the select/accept/execute loops once, returning false on error. */
+  /** Runs the poll/accept/execute loops once, returning false on error. */
   bool RunOnce();
 
   std::map<SOCKET, int> socket_port_map_;
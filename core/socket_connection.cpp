@@ -17,10 +17,11 @@
 /**************************************************************************/
 #include "core/socket_connection.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <iostream>
-#include <thread>
+#include <limits>
 #ifdef _WIN32
 #include <WS2tcpip.h>
 #include <WinSock2.h>
@@ -32,6 +33,7 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -53,16 +55,15 @@ using std::chrono::duration;
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
 using std::chrono::seconds;
-using std::chrono::system_clock;
-using std::chrono::time_point;
-using wwiv::os::sleep_for;
+using std::chrono::steady_clock;
 using namespace wwiv::strings;
 
 namespace wwiv::core {
 
 namespace {
 
-const auto SLEEP_MS = milliseconds(100);
+// Size of the receive buffer used when reading ahead of the caller.
+constexpr int READ_AHEAD_SIZE = 16 * 1024;
 
 bool SetBlockingMode(SOCKET sock, bool blocking_mode) {
   if (sock == INVALID_SOCKET) {
@@ -95,10 +96,42 @@ bool WouldSocketBlock() {
 #ifdef _WIN32
   return WSAGetLastError() == WSAEWOULDBLOCK;
 #else  // _WIN32
-  return errno == EWOULDBLOCK;
+  return errno == EWOULDBLOCK || errno == EAGAIN;
 #endif // _WIN32
 }
 
+bool WasInterrupted() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEINTR;
+#else  // _WIN32
+  return errno == EINTR;
+#endif // _WIN32
+}
+
+/**
+ * Returns the number of milliseconds remaining until end, rounded up so
+ * that we never wake up early and spin.
+ */
+int millis_until(steady_clock::time_point end) {
+  const auto now = steady_clock::now();
+  if (now >= end) {
+    return 0;
+  }
+  const auto remaining = std::chrono::ceil<milliseconds>(end - now).count();
+  return static_cast<int>(std::min<decltype(remaining)>(remaining, std::numeric_limits<int>::max()));
+}
+
+/**
+ * Returns the time_point d from now, clamping very long durations so
+ * that the addition can not overflow.
+ */
+steady_clock::time_point deadline(duration<double> d) {
+  if (d > std::chrono::hours(24 * 365)) {
+    return steady_clock::time_point::max();
+  }
+  return steady_clock::now() + duration_cast<steady_clock::duration>(d);
+}
+
 std::string GetLastErrorText() {
 #if defined ( _WIN32 )
   char* error_text{nullptr};
@@ -128,7 +161,8 @@ SocketConnection::SocketConnection(SOCKET sock)
 }
 
 SocketConnection::SocketConnection(SOCKET sock, ExitMode exit_mode)
-  : sock_(sock), open_(true), exit_mode_(exit_mode) {
+  : sock_(sock), open_(true), exit_mode_(exit_mode),
+    read_ahead_(exit_mode == ExitMode::CLOSE_SOCKET) {
   static auto initialized = InitializeSockets();
   if (!initialized) {
     throw socket_error("Unable to initialize sockets.");
@@ -146,6 +180,9 @@ SocketConnection::SocketConnection(SOCKET sock, ExitMode exit_mode)
     sock_ = INVALID_SOCKET;
     throw socket_error("SocketConnection: Unable to set nodelay mode on the socket.");
   }
+  if (read_ahead_) {
+    rbuf_.resize(READ_AHEAD_SIZE);
+  }
 }
 
 unique_ptr<SocketConnection> Connect(const string& host, int port) {
@@ -215,45 +252,99 @@ SocketConnection::~SocketConnection() {
   }
 }
 
-template <typename TYPE, std::size_t SIZE = sizeof(TYPE)>
-static int read_TYPE(const SOCKET sock, TYPE* data, const duration<double> d, bool throw_on_timeout,
-                     std::size_t size = SIZE) {
-  const auto end = system_clock::now() + d;
-  auto* p = reinterpret_cast<char*>(data);
-  auto total_read = 0;
-  auto remaining = static_cast<int>(size);
+bool SocketConnection::wait_readable(steady_clock::time_point end) {
   while (true) {
-    if (system_clock::now() > end) {
-      if (throw_on_timeout) {
-        throw timeout_error("timeout error reading from socket.");
-      }
-      return total_read;
+    ++stats_.poll_calls;
+#ifdef _WIN32
+    WSAPOLLFD fds{};
+    fds.fd = sock_;
+    fds.events = POLLRDNORM;
+    const auto result = WSAPoll(&fds, 1, millis_until(end));
+#else  // _WIN32
+    pollfd fds{};
+    fds.fd = sock_;
+    fds.events = POLLIN;
+    const auto result = poll(&fds, 1, millis_until(end));
+#endif // _WIN32
+    if (result > 0) {
+      // Readable, closed or in error, either way recv will tell us which.
+      return true;
+    }
+    if (result == SOCKET_ERROR && WasInterrupted()) {
+      continue;
     }
-    const auto result = recv(sock, p, remaining, 0);
     if (result == SOCKET_ERROR) {
-      const auto saved_errno = GetLastErrorText();
-      if (WouldSocketBlock()) {
-        sleep_for(SLEEP_MS);
-        continue;
-      }
-      LOG(ERROR) << "Got Socket Error on recv: " << saved_errno;
-      return total_read;
+      LOG(ERROR) << "Got Socket Error on poll: " << GetLastErrorText();
+      // Let recv report the error.
+      return true;
+    }
+    // Timed out, but poll only has millisecond resolution so make sure
+    // that we have really hit the deadline.
+    if (steady_clock::now() >= end) {
+      return false;
+    }
+  }
+}
+
+int SocketConnection::fill_buffer(steady_clock::time_point end, int want) {
+  // We only fill the buffer once it has been fully consumed, so rewind it.
+  rpos_ = rend_ = 0;
+  const auto capacity = read_ahead_ ? static_cast<int>(rbuf_.size()) : want;
+  if (static_cast<int>(rbuf_.size()) < capacity) {
+    rbuf_.resize(capacity);
+  }
+  while (true) {
+    ++stats_.recv_calls;
+    const auto result = recv(sock_, rbuf_.data(), capacity, 0);
+    if (result > 0) {
+      rend_ = static_cast<std::size_t>(result);
+      stats_.bytes_received += result;
+      return static_cast<int>(result);
     }
-    if (result <= 0) {
-      return total_read;
+    if (result == 0) {
+      // Remote side closed the socket.
+      return 0;
     }
-    total_read += result;
-    if (total_read < static_cast<int>(size)) {
-      p += result;
-      remaining -= result;
+    if (WasInterrupted()) {
       continue;
     }
-    return total_read;
+    if (!WouldSocketBlock()) {
+      LOG(ERROR) << "Got Socket Error on recv: " << GetLastErrorText();
+      return 0;
+    }
+    if (!wait_readable(end)) {
+      return -1;
+    }
   }
 }
 
+int SocketConnection::read_fully(void* data, int size, duration<double> d, bool throw_on_timeout) {
+  const auto end = deadline(d);
+  auto* p = static_cast<char*>(data);
+  auto total_read = 0;
+  while (total_read < size) {
+    if (buffered() == 0) {
+      const auto result = fill_buffer(end, size - total_read);
+      if (result < 0) {
+        if (throw_on_timeout) {
+          throw timeout_error("timeout error reading from socket.");
+        }
+        return total_read;
+      }
+      if (result == 0) {
+        return total_read;
+      }
+    }
+    const auto num = std::min(buffered(), size - total_read);
+    memcpy(p + total_read, rbuf_.data() + rpos_, num);
+    rpos_ += num;
+    total_read += num;
+  }
+  return total_read;
+}
+
 int SocketConnection::receive(void* data, const int size, duration<double> d) {
-  const auto num_read = read_TYPE<void, 0>(sock_, data, d, true, size);
+  const auto num_read = read_fully(data, size, d, true);
   if (open_ && num_read == 0) {
     throw socket_closed_error(fmt::sprintf("receive: got zero read from socket. expected: ", size));
   }
@@ -261,46 +352,56 @@ int SocketConnection::receive(void* data, const int size, duration<double> d) {
 }
 
 int SocketConnection::receive_upto(void* data, const int size, duration<double> d) {
-  return read_TYPE<void, 0>(sock_, data, d, false, size);
+  return read_fully(data, size, d, false);
 }
 
 string SocketConnection::receive(int size, duration<double> d) {
-  const auto data = std::make_unique<char[]>(size);
-  const auto num_read = receive(data.get(), size, d);
-  return string(data.get(), num_read);
+  string s(size, '\0');
+  const auto num_read = receive(s.data(), size, d);
+  s.resize(num_read);
+  return s;
 }
 
 string SocketConnection::receive_upto(int size, duration<double> d) {
-  const auto data = std::make_unique<char[]>(size);
-  const auto num_read = receive_upto(data.get(), size, d);
-  return string(data.get(), num_read);
+  string s(size, '\0');
+  const auto num_read = receive_upto(s.data(), size, d);
+  s.resize(num_read);
+  return s;
 }
 
 std::string SocketConnection::read_line(int max_size, duration<double> d) {
+  const auto end = deadline(d);
   string s;
-  auto size = 0;
-  try {
-    while (true) {
-      char data = 0;
-      const auto num_read = read_TYPE<char>(sock_, &data, d, true);
-      if (!open_) {
-        throw socket_closed_error("read_line: socket not open");
-      }
-      if (num_read == 0) {
-        break;
-      }
-      s.push_back(data);
-      size++;
-      if (data == '\n') {
-        break;
-      }
-      if (size > max_size) {
-        break;
+  while (true) {
+    if (!open_) {
+      throw socket_closed_error("read_line: socket not open");
+    }
+    if (buffered() == 0) {
+      // Without read ahead we must not read past the end of the line.
+      const auto want = read_ahead_ ? max_size : 1;
+      if (fill_buffer(end, std::max(1, want)) <= 0) {
+        // timeout, error or closed.
+        return s;
       }
     }
-  } catch (const timeout_error&) {
+    const auto* start = rbuf_.data() + rpos_;
+    const auto* last = start + buffered();
+    const auto* nl = std::find(start, last, '\n');
+    const auto* stop = nl == last ? last : nl + 1;
+    // Match the historical behavior of allowing max_size + 1 characters.
+    const auto room = static_cast<std::ptrdiff_t>(max_size + 1) - stl::ssize(s);
+    if (stop - start > room) {
+      stop = start + std::max<std::ptrdiff_t>(room, 0);
+    }
+    s.append(start, stop);
+    rpos_ += stop - start;
+    if (!s.empty() && s.back() == '\n') {
+      return s;
+    }
+    if (stl::ssize(s) > max_size) {
+      return s;
+    }
   }
-  return s;
 }
 
 #ifndef MSG_NOSIGNAL
@@ -308,7 +409,11 @@ std::string SocketConnection::read_line(int max_size, duration<double> d) {
 #endif  // MSG_NOSIGNAL 
 
 int SocketConnection::send(const void* data, int size, duration<double>) {
+  ++stats_.send_calls;
   const auto sent = ::send(sock_, static_cast<const char*>(data), size, MSG_NOSIGNAL);
+  if (sent > 0) {
+    stats_.bytes_sent += sent;
+  }
   if (open_ && sent != size) {
     if (sent == -1) {
       throw socket_closed_error(
@@ -329,7 +434,7 @@ int SocketConnection::send_line(const std::string& s, duration<double> d) {
 
 uint16_t SocketConnection::read_uint16(duration<double> d) {
   uint16_t data = 0;
-  const auto num_read = read_TYPE<uint16_t>(sock_, &data, d, true);
+  const auto num_read = read_fully(&data, sizeof(uint16_t), d, true);
   if (open_ && num_read == 0) {
     throw socket_closed_error(
         StrCat("read_uint16: got zero read from socket. expected: ", sizeof(uint16_t)));
@@ -339,7 +444,7 @@ uint16_t SocketConnection::read_uint16(duration<double> d) {
 
 uint8_t SocketConnection::read_uint8(duration<double> d) {
   uint8_t data = 0;
-  const auto num_read = read_TYPE<uint8_t>(sock_, &data, d, true);
+  const auto num_read = read_fully(&data, sizeof(uint8_t), d, true);
   if (open_ && num_read == 0) {
     throw socket_closed_error(
         StrCat("read_uint8: got zero read from socket. expected: ", sizeof(uint8_t)));
@@ -347,6 +452,16 @@ uint8_t SocketConnection::read_uint8(duration<double> d) {
   return data;
 }
 
+bool SocketConnection::wait_for_data(duration<double> d) {
+  if (buffered() > 0) {
+    return true;
+  }
+  if (!open_) {
+    return false;
+  }
+  return wait_readable(deadline(d));
+}
+
 bool SocketConnection::close() {
   if (open_) {
     open_ = false;
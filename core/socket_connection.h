@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <WinSock2.h>
@@ -35,6 +36,23 @@ namespace wwiv::core {
 
 class SocketConnection;
 
+/**
+ * Counters of the socket level work done by a SocketConnection.  Useful
+ * for seeing how many syscalls are being made per byte moved.
+ */
+struct socket_connection_stats_t {
+  // Number of calls to recv.
+  uint64_t recv_calls{0};
+  // Number of calls to poll (or WSAPoll) waiting for readable data.
+  uint64_t poll_calls{0};
+  // Number of calls to send.
+  uint64_t send_calls{0};
+  // Total bytes received from the socket (including any read ahead).
+  uint64_t bytes_received{0};
+  // Total bytes sent to the socket.
+  uint64_t bytes_sent{0};
+};
+
 std::unique_ptr<SocketConnection> Connect(const std::string& host, int port);
 
 class SocketConnection : public Connection {
@@ -65,14 +83,50 @@ public:
 
   uint16_t read_uint16(std::chrono::duration<double> d) override;
   uint8_t read_uint8(std::chrono::duration<double> d) override;
+  bool wait_for_data(std::chrono::duration<double> d) override;
 
   bool is_open() const override { return open_; }
   bool close() override;
 
+  [[nodiscard]] const socket_connection_stats_t& stats() const noexcept { return stats_; }
+
 private:
+  /**
+   * Reads size bytes into data, waiting up until duration d.  Returns
+   * the number of bytes read, which will only be less than size on
+   * timeout (when throw_on_timeout is false), error or when the remote
+   * side has closed the socket.
+   */
+  int read_fully(void* data, int size, std::chrono::duration<double> d, bool throw_on_timeout);
+
+  /**
+   * Waits until end for the socket to be readable, then reads as much
+   * as is available (up to the size of the buffer, or want when not
+   * reading ahead) into the receive buffer.  Returns the number of bytes
+   * read, 0 if the socket was closed or had an error, and -1 on timeout.
+   */
+  int fill_buffer(std::chrono::steady_clock::time_point end, int want);
+
+  /** Waits until end for the socket to become readable. */
+  bool wait_readable(std::chrono::steady_clock::time_point end);
+
+  /** Number of bytes in the receive buffer that have not been consumed. */
+  [[nodiscard]] int buffered() const noexcept { return static_cast<int>(rend_ - rpos_); }
+
   SOCKET sock_;
   bool open_;
   ExitMode exit_mode_ = ExitMode::LEAVE_SOCKET_OPEN;
+  /**
+   * When true bytes past what the caller has asked for will be read from the
+   * socket into the receive buffer.  This is only safe when we own the socket,
+   * sockets that are handed off to another process after we are done with
+   * them must never have bytes read from them that were not asked for.
+   */
+  bool read_ahead_{false};
+  std::vector<char> rbuf_;
+  std::size_t rpos_{0};
+  std::size_t rend_{0};
+  socket_connection_stats_t stats_;
 };
 
 
@@ -19,17 +19,34 @@
 #include "gtest/gtest.h"
 #include "core/crc32.h"
 #include "core/file.h"
+#include "core/log.h"
 #include "core_test/file_helper.h"
-#include <map>
+#include <chrono>
+#include <random>
 #include <string>
 #include <vector>
 
-using std::map;
 using std::string;
 using std::vector;
+using namespace std::chrono;
 
 using namespace wwiv::core;
 
+static const vector<crc32_impl_t> kAllImpls{crc32_impl_t::bytewise, crc32_impl_t::slice_by_8,
+                                            crc32_impl_t::slice_by_16, crc32_impl_t::pclmul,
+                                            crc32_impl_t::armv8};
+
+static string RandomData(std::size_t len) {
+  std::mt19937 gen(len);
+  std::uniform_int_distribution<int> dist(0, 255);
+  string s;
+  s.reserve(len);
+  for (std::size_t i = 0; i < len; i++) {
+    s.push_back(static_cast<char>(dist(gen)));
+  }
+  return s;
+}
+
 TEST(Crc32Test, Simple) {
   FileHelper file;
   const auto path = file.CreateTempFile("helloworld.txt", "Hello World");
@@ -42,3 +59,106 @@ TEST(Crc32Test, Simple) {
   // use wwiv/scripts/crc32.py to generate golden values as needed.
   EXPECT_EQ(expected, crc) << " was " << std::hex << crc;
 }
+
+TEST(Crc32Test, CheckValue) {
+  EXPECT_EQ(0u, crc32string(""));
+  EXPECT_EQ(0xcbf43926u, crc32string("123456789"));
+  EXPECT_EQ(0x4a17b156u, crc32string("Hello World"));
+}
+
+TEST(Crc32Test, AllImplsAgree) {
+  const auto data = RandomData(4096 + 64);
+  for (const auto impl : kAllImpls) {
+    if (!crc32_impl_supported(impl)) {
+      continue;
+    }
+    // Cover every length around the block sizes, from every alignment.
+    for (std::size_t offset = 0; offset < 16; offset++) {
+      for (std::size_t len = 0; len < 300; len++) {
+        const auto* p = data.data() + offset;
+        ASSERT_EQ(crc32(0, p, len, crc32_impl_t::bytewise), crc32(0, p, len, impl))
+            << to_string(impl) << " offset: " << offset << " len: " << len;
+      }
+    }
+    EXPECT_EQ(crc32(0, data.data(), data.size(), crc32_impl_t::bytewise),
+              crc32(0, data.data(), data.size(), impl))
+        << to_string(impl);
+  }
+}
+
+TEST(Crc32Test, DefaultImplSupported) {
+  EXPECT_TRUE(crc32_impl_supported(crc32_default_impl()));
+  EXPECT_TRUE(crc32_impl_supported(crc32_impl_t::slice_by_16));
+}
+
+TEST(Crc32Test, Streaming) {
+  const auto data = RandomData(10000);
+  const auto expected = crc32string(data);
+  for (const std::size_t chunk : {1, 7, 64, 100, 4096}) {
+    Crc32 crc;
+    for (std::size_t pos = 0; pos < data.size(); pos += chunk) {
+      crc.update(std::string_view(data).substr(pos, chunk));
+    }
+    EXPECT_EQ(expected, crc.value()) << "chunk: " << chunk;
+  }
+
+  Crc32 crc;
+  crc.update("junk");
+  crc.reset();
+  crc.update("123456789");
+  EXPECT_EQ(0xcbf43926u, crc.value());
+}
+
+TEST(Crc32Test, ByteAtATime) {
+  const string s = "123456789";
+  uint32_t reg = 0xffffffff;
+  for (const auto c : s) {
+    reg = crc32_byte(reg, static_cast<uint8_t>(c));
+  }
+  EXPECT_EQ(0xcbf43926u, ~reg);
+}
+
+TEST(Crc32Test, File_LargerThanBuffer) {
+  FileHelper file;
+  string data;
+  for (auto i = 0; data.size() < 200 * 1024 + 3; i++) {
+    data += std::to_string(i);
+  }
+  const auto path = file.CreateTempFile("big.bin", data);
+  EXPECT_EQ(crc32string(data), crc32file(path));
+}
+
+TEST(Crc32Test, File_Missing) {
+  FileHelper file;
+  EXPECT_EQ(0u, crc32file(FilePath(file.TempDir(), "missing.bin")));
+}
+
+TEST(Crc16Test, CheckValue) {
+  const string s = "123456789";
+  EXPECT_EQ(0x31c3, crc16(0, s.data(), s.size()));
+
+  uint16_t crc = 0;
+  for (const auto c : s) {
+    crc = crc16_byte(crc, static_cast<uint8_t>(c));
+  }
+  EXPECT_EQ(0x31c3, crc);
+}
+
+// Reports the throughput of each CRC-32 implementation.
+TEST(Crc32Test, DISABLED_Benchmark_Throughput) {
+  constexpr auto kRounds = 16;
+  const auto data = RandomData(16 * 1024 * 1024);
+  for (const auto impl : kAllImpls) {
+    if (!crc32_impl_supported(impl)) {
+      continue;
+    }
+    uint32_t crc = 0;
+    const auto start = steady_clock::now();
+    for (auto i = 0; i < kRounds; i++) {
+      crc = crc32(crc, data.data(), data.size(), impl);
+    }
+    const auto secs = duration<double>(steady_clock::now() - start).count();
+    const auto gbps = static_cast<double>(data.size()) * kRounds / secs / 1e9;
+    LOG(INFO) << to_string(impl) << ": " << gbps << " GB/s; crc: " << std::hex << crc;
+  }
+}
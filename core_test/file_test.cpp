@@ -423,6 +423,29 @@ TEST(FileTest, Remove_Path) {
   EXPECT_FALSE(File::Exists(path));
 }
 
+TEST(FileTest, ReplaceContents) {
+  FileHelper helper;
+  const auto path = helper.CreateTempFile(test_info_->name(), "Hello World");
+  ASSERT_TRUE(File::ReplaceContents(path, "Bye"));
+  EXPECT_EQ("Bye", helper.ReadFile(path));
+
+  // Nothing is left behind next to it.
+  auto num_files = 0;
+  for (const auto& e : std::filesystem::directory_iterator(path.parent_path())) {
+    if (e.path().filename().string().rfind(path.filename().string(), 0) == 0) {
+      ++num_files;
+    }
+  }
+  EXPECT_EQ(1, num_files);
+}
+
+TEST(FileTest, ReplaceContents_DoesNotExist) {
+  FileHelper helper;
+  const auto path = helper.CreateTempFilePath(test_info_->name());
+  ASSERT_TRUE(File::ReplaceContents(path, "Hello"));
+  EXPECT_EQ("Hello", helper.ReadFile(path));
+}
+
 TEST(FileTest, Free) {
   const FileHelper file;
   const auto& tmp = file.TempDir();
@@ -76,3 +76,10 @@ TEST_F(IpAddressTest, Equality) {
   EXPECT_NE(ip4, ip6);
   EXPECT_NE(ip4, ip4dif);
 }
+
+TEST_F(IpAddressTest, IsV4) {
+  EXPECT_TRUE(ip_address::from_string("127.0.0.1")->is_v4());
+  EXPECT_TRUE(ip_address::from_string("::ffff:10.0.0.1")->is_v4());
+  EXPECT_FALSE(ip_address::from_string("::1")->is_v4());
+  EXPECT_FALSE(ip_address::from_string("2001:db8::1")->is_v4());
+}
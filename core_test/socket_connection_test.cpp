@@ -0,0 +1,161 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef _WIN32
+
+#include "core/log.h"
+#include "core/socket_connection.h"
+#include "core/socket_exceptions.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+
+class SocketConnectionTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    local_ = std::make_unique<SocketConnection>(fds[0]);
+    remote_ = std::make_unique<SocketConnection>(fds[1]);
+  }
+
+  std::unique_ptr<SocketConnection> local_;
+  std::unique_ptr<SocketConnection> remote_;
+};
+
+TEST_F(SocketConnectionTest, ReadUint8AndUint16) {
+  const uint8_t data[] = {0x42, 0x80, 0x05};
+  remote_->send(data, 3, seconds(1));
+
+  EXPECT_EQ(0x42, local_->read_uint8(seconds(1)));
+  EXPECT_EQ(0x8005, local_->read_uint16(seconds(1)));
+}
+
+TEST_F(SocketConnectionTest, ReadAheadBuffersSmallReads) {
+  remote_->send(std::string(100, 'x'), seconds(1));
+
+  for (auto i = 0; i < 100; i++) {
+    EXPECT_EQ('x', local_->read_uint8(seconds(1)));
+  }
+  // All 100 bytes should have been satisfied from a single recv.
+  EXPECT_EQ(1u, local_->stats().recv_calls);
+  EXPECT_EQ(100u, local_->stats().bytes_received);
+}
+
+TEST_F(SocketConnectionTest, ReadLine) {
+  remote_->send("hello\r\nworld\n", seconds(1));
+
+  EXPECT_EQ("hello\r\n", local_->read_line(1024, seconds(1)));
+  EXPECT_EQ("world\n", local_->read_line(1024, seconds(1)));
+}
+
+TEST_F(SocketConnectionTest, ReadLine_NoNewLine_Timeout) {
+  remote_->send("partial", seconds(1));
+
+  EXPECT_EQ("partial", local_->read_line(1024, milliseconds(20)));
+}
+
+TEST_F(SocketConnectionTest, Receive_Timeout) {
+  remote_->send("ab", seconds(1));
+
+  EXPECT_THROW(local_->receive(3, milliseconds(20)), timeout_error);
+}
+
+TEST_F(SocketConnectionTest, ReceiveUpto_Partial) {
+  remote_->send("ab", seconds(1));
+
+  EXPECT_EQ("ab", local_->receive_upto(10, milliseconds(20)));
+}
+
+TEST_F(SocketConnectionTest, ReceiveWakesWhenDataArrives) {
+  std::thread t([this] {
+    std::this_thread::sleep_for(milliseconds(20));
+    remote_->send("x", seconds(1));
+  });
+  const auto start = steady_clock::now();
+  EXPECT_EQ('x', local_->read_uint8(seconds(10)));
+  t.join();
+  // We should wake up as soon as the byte arrives, well before the timeout.
+  EXPECT_LT(steady_clock::now() - start, seconds(5));
+}
+
+TEST_F(SocketConnectionTest, WaitForData) {
+  EXPECT_FALSE(local_->wait_for_data(milliseconds(0)));
+  remote_->send("ab", seconds(1));
+  EXPECT_TRUE(local_->wait_for_data(seconds(1)));
+  EXPECT_EQ('a', local_->read_uint8(seconds(1)));
+  // The 2nd byte is already buffered.
+  EXPECT_TRUE(local_->wait_for_data(milliseconds(0)));
+}
+
+TEST_F(SocketConnectionTest, NoReadAheadWhenSocketIsHandedOff) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  SocketConnection remote(fds[1]);
+  remote.send("abc", seconds(1));
+  {
+    SocketConnection conn(fds[0], SocketConnection::ExitMode::LEAVE_SOCKET_OPEN);
+    EXPECT_EQ('a', conn.read_uint8(seconds(1)));
+  }
+  // The remaining bytes must still be on the socket for the next owner.
+  SocketConnection next(fds[0]);
+  EXPECT_EQ("bc", next.receive(2, seconds(1)));
+}
+
+// Benchmark of frame round trips over a socket pair.
+TEST_F(SocketConnectionTest, DISABLED_Benchmark_FrameRoundTrip) {
+  constexpr auto kNumFrames = 10000;
+  constexpr auto kFrameSize = 512;
+  std::thread echo([this] {
+    for (auto i = 0; i < kNumFrames; i++) {
+      const auto len = remote_->read_uint16(seconds(10));
+      const auto body = remote_->receive(len, seconds(10));
+      const uint8_t hdr[] = {static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len & 0xff)};
+      remote_->send(hdr, 2, seconds(10));
+      remote_->send(body, seconds(10));
+    }
+  });
+
+  const std::string body(kFrameSize, 'x');
+  const uint8_t hdr[] = {kFrameSize >> 8, kFrameSize & 0xff};
+  const auto start = steady_clock::now();
+  for (auto i = 0; i < kNumFrames; i++) {
+    local_->send(hdr, 2, seconds(10));
+    local_->send(body, seconds(10));
+    const auto len = local_->read_uint16(seconds(10));
+    ASSERT_EQ(body, local_->receive(len, seconds(10)));
+  }
+  const auto elapsed = steady_clock::now() - start;
+  echo.join();
+
+  const auto& s = local_->stats();
+  const auto kb = static_cast<double>(s.bytes_received) / 1024.0;
+  LOG(INFO) << "frames: " << kNumFrames << "; avg round trip: "
+            << duration_cast<microseconds>(elapsed).count() / kNumFrames << "us";
+  LOG(INFO) << "recv calls/KB: " << s.recv_calls / kb << "; poll calls/KB: " << s.poll_calls / kb
+            << "; send calls/KB: " << s.send_calls / kb;
+}
+
+#endif // _WIN32
@@ -55,19 +55,10 @@ void AddStandardNetworkArgs(wwiv::core::CommandLine& cmdline) {
 
 NetworkCommandLine::NetworkCommandLine(wwiv::core::CommandLine& cmdline, char net_cmd)
     : cmdline_(cmdline), net_cmd_(net_cmd) {
-  cmdline.set_no_args_allowed(true);
-  cmdline.AddStandardArgs();
-  AddStandardNetworkArgs(cmdline);
-
-  if (!cmdline.Parse()) {
+  if (!ParseCommandLine()) {
     initialized_ = false;
   }
 
-  if (!LoadNetIni(net_cmd, cmdline.bbsdir())) {
-    LOG(ERROR) << "Error loading INI file for defaults";
-  }
-
-  network_number_ = cmdline.arg("net").as_int();
   // TODO(rushfan): Need to look to see if WWIV_CONFIG_FILE is set 1st.
   config_ = sdk::load_any_config(cmdline.bbsdir());
   if (!config_) {
@@ -75,8 +66,40 @@ NetworkCommandLine::NetworkCommandLine(wwiv::core::CommandLine& cmdline, char ne
     initialized_ = false;
     return;
   }
-  networks_.reset(new sdk::Networks(*config_));
+  networks_ = std::make_shared<sdk::Networks>(*config_);
+  InitializeNetwork();
+}
+
+NetworkCommandLine::NetworkCommandLine(wwiv::core::CommandLine& cmdline, char net_cmd,
+                                       const NetworkCommandLine& parent)
+    : config_(parent.config_), networks_(parent.networks_), cmdline_(cmdline),
+      net_cmd_(net_cmd) {
+  if (!ParseCommandLine()) {
+    initialized_ = false;
+  }
+  if (!config_ || !networks_) {
+    LOG(ERROR) << "Parent command line has no config loaded.";
+    initialized_ = false;
+    return;
+  }
+  InitializeNetwork();
+}
+
+bool NetworkCommandLine::ParseCommandLine() {
+  cmdline_.set_no_args_allowed(true);
+  cmdline_.AddStandardArgs();
+  AddStandardNetworkArgs(cmdline_);
+
+  const auto ok = cmdline_.Parse();
+  if (!LoadNetIni(net_cmd_, cmdline_.bbsdir())) {
+    LOG(ERROR) << "Error loading INI file for defaults";
+  }
+
+  network_number_ = cmdline_.arg("net").as_int();
+  return ok;
+}
 
+void NetworkCommandLine::InitializeNetwork() {
   if (!config_->IsInitialized()) {
     LOG(ERROR) << "Unable to load config.json.";
     initialized_ = false;
@@ -94,10 +117,10 @@ NetworkCommandLine::NetworkCommandLine(wwiv::core::CommandLine& cmdline, char ne
   }
   network_ = nws[network_number_];
   network_name_ = ToStringLowerCase(network_.name);
-  LOG(STARTUP) << cmdline.program_name() << " [" << full_version() << "]"
+  LOG(STARTUP) << cmdline_.program_name() << " [" << full_version() << "]"
                << " for network: " << network_name_;
   if (!quiet()) {
-    std::cerr << cmdline.program_name() << " [" << full_version() << "]"
+    std::cerr << cmdline_.program_name() << " [" << full_version() << "]"
               << " for network: " << network_name_ << std::endl;
   }
 }
@@ -37,6 +37,12 @@ void AddStandardNetworkArgs(core::CommandLine& cmdline);
 class NetworkCommandLine {
 public:
   NetworkCommandLine(core::CommandLine& cmdline, char net_cmd);
+  /**
+   * Creates the command line for a network command run in-process by another
+   * one (i.e. networkc), sharing the config and networks already loaded by
+   * parent instead of reading them from disk again.
+   */
+  NetworkCommandLine(core::CommandLine& cmdline, char net_cmd, const NetworkCommandLine& parent);
 
   [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
   [[nodiscard]] const sdk::Config& config() const noexcept { return *config_; }
@@ -58,8 +64,11 @@ public:
   [[nodiscard]] std::chrono::duration<double> semaphore_timeout() const noexcept;
 
 private:
-  std::unique_ptr<sdk::Config> config_;
-  std::unique_ptr<sdk::Networks> networks_;
+  bool ParseCommandLine();
+  void InitializeNetwork();
+
+  std::shared_ptr<sdk::Config> config_;
+  std::shared_ptr<sdk::Networks> networks_;
   std::string network_name_;
   int network_number_{0};
   bool initialized_{true};
@@ -0,0 +1,110 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "net_core/stage_context.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "sdk/filenames.h"
+#include <chrono>
+#include <memory>
+#include <system_error>
+
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::fido;
+using namespace wwiv::strings;
+
+namespace wwiv::net {
+
+// How long after being written a file's time can't be trusted to change on
+// the next write.
+static constexpr auto kRacyInterval = std::chrono::seconds(2);
+
+StageContext::file_stamp_t StageContext::file_stamp_t::of(const std::filesystem::path& path) {
+  std::error_code ec;
+  file_stamp_t s;
+  s.size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return {};
+  }
+  s.mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return {};
+  }
+  s.racy = s.mtime > std::filesystem::file_time_type::clock::now() - kRacyInterval;
+  return s;
+}
+
+bool StageContext::file_stamp_t::current(const std::filesystem::path& path) const {
+  if (racy) {
+    return false;
+  }
+  const auto now = of(path);
+  return !now.racy && now.size == size && now.mtime == mtime;
+}
+
+StageContext::StageContext(const Config& config, const net_networks_rec& net, bool hold_packets)
+    : config_(config), net_(net), spool_(net) {
+  if (hold_packets) {
+    spool_.Hold(LOCAL_NET);
+    if (net.type == network_type_t::ftn) {
+      spool_.Hold(StrCat("s", FTN_FAKE_OUTBOUND_NODE, ".net"));
+    }
+  }
+}
+
+StageContext::~StageContext() = default;
+
+UserManager& StageContext::user_manager() {
+  if (!user_manager_) {
+    user_manager_ = std::make_unique<UserManager>(config_);
+  }
+  return *user_manager_;
+}
+
+FtnMessageDupe& StageContext::dupe() {
+  if (!dupe_ || dupe_->stale()) {
+    VLOG(1) << (dupe_ ? "Reloading" : "Loading") << " message dupes.";
+    dupe_ = std::make_unique<FtnMessageDupe>(config_);
+  }
+  return *dupe_;
+}
+
+const BbsListNet& StageContext::bbslist() {
+  const auto path = FilePath(net_.dir, BBSDATA_NET);
+  if (!bbslist_ || !bbslist_stamp_.current(path)) {
+    VLOG(1) << (bbslist_ ? "Reloading: " : "Loading: ") << path;
+    bbslist_stamp_ = file_stamp_t::of(path);
+    bbslist_.emplace(BbsListNet::ReadBbsDataNet(net_.dir));
+  }
+  return bbslist_.value();
+}
+
+const Nodelist* StageContext::nodelist(const std::filesystem::path& path) {
+  if (!nodelist_ || path != nodelist_path_ || !nodelist_stamp_.current(path)) {
+    VLOG(1) << (nodelist_ ? "Reloading nodelist: " : "Loading nodelist: ") << path;
+    nodelist_path_ = path;
+    nodelist_stamp_ = file_stamp_t::of(path);
+    nodelist_ = std::make_unique<Nodelist>(path);
+  }
+  return nodelist_->initialized() ? nodelist_.get() : nullptr;
+}
+
+} // namespace wwiv::net
@@ -0,0 +1,91 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_NET_CORE_STAGE_CONTEXT_H
+#define INCLUDED_NET_CORE_STAGE_CONTEXT_H
+
+#include "sdk/bbslist.h"
+#include "sdk/config.h"
+#include "sdk/usermanager.h"
+#include "sdk/fido/nodelist.h"
+#include "sdk/net/ftn_msgdupe.h"
+#include "sdk/net/net.h"
+#include "sdk/net/packet_spool.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace wwiv::net {
+
+/**
+ * What the network stages (network1, network2, network3 and networkf) load
+ * that's worth sharing when networkc runs several of them in one process.
+ * Each is loaded the first time a stage asks for it, and reloaded if the
+ * file behind it was changed by someone else (the BBS, network3, the sysop)
+ * since.
+ *
+ * When hold_packets is set, local.net and the FTN outbound packet are held
+ * in spool() for the next stage rather than being written to the network
+ * directory.
+ */
+class StageContext final {
+public:
+  StageContext(const sdk::Config& config, const net_networks_rec& net, bool hold_packets = false);
+  ~StageContext();
+  StageContext(const StageContext&) = delete;
+  StageContext& operator=(const StageContext&) = delete;
+
+  /** UserManager already notices when USER.LST changes, so is never reloaded. */
+  [[nodiscard]] sdk::UserManager& user_manager();
+  [[nodiscard]] sdk::FtnMessageDupe& dupe();
+  /** bbsdata.net for the network, which is empty if it can't be read. */
+  [[nodiscard]] const sdk::BbsListNet& bbslist();
+  /** The nodelist at path, or nullptr if it can't be loaded. */
+  [[nodiscard]] const sdk::fido::Nodelist* nodelist(const std::filesystem::path& path);
+  [[nodiscard]] sdk::net::PacketSpool& spool() noexcept { return spool_; }
+
+private:
+  // The size and modification time of a file when it was loaded.
+  struct file_stamp_t {
+    std::uintmax_t size{0};
+    std::filesystem::file_time_type mtime{};
+    // A file written to just before it was loaded may be written to again
+    // without its time changing, so it is reloaded next time.
+    bool racy{true};
+
+    [[nodiscard]] static file_stamp_t of(const std::filesystem::path& path);
+    [[nodiscard]] bool current(const std::filesystem::path& path) const;
+  };
+
+  const sdk::Config& config_;
+  const net_networks_rec& net_;
+  std::unique_ptr<sdk::UserManager> user_manager_;
+  std::unique_ptr<sdk::FtnMessageDupe> dupe_;
+  std::optional<sdk::BbsListNet> bbslist_;
+  file_stamp_t bbslist_stamp_;
+  std::unique_ptr<sdk::fido::Nodelist> nodelist_;
+  std::filesystem::path nodelist_path_;
+  file_stamp_t nodelist_stamp_;
+  sdk::net::PacketSpool spool_;
+};
+
+} // namespace wwiv::net
+
+#endif
@@ -33,6 +33,7 @@
 #include "sdk/bbslist.h"
 #include "sdk/filenames.h"
 #include "sdk/net/contact.h"
+#include "sdk/net/packet_reader.h"
 #include "sdk/net/packets.h"
 #include <cstdlib>
 #include <iostream>
@@ -58,56 +59,56 @@ using namespace wwiv::sdk::net;
 using namespace wwiv::stl;
 using namespace wwiv::os;
 
-static void ShowHelp(const NetworkCommandLine& cmdline) {
-  cout << cmdline.GetHelp() << endl;
-  exit(1);
-}
-
 int NetworkStat::k() const {
   return bytes == 0 ? 0 : (bytes + 1023) / 1024;
 }
 
-Network1::Network1(const NetworkCommandLine& cmdline, const BbsListNet& bbslist,
-                   wwiv::core::Clock& clock)
-    : net_cmdline_(cmdline), bbslist_(bbslist), clock_(clock), net_(net_cmdline_.network()),
+Network1::Network1(const NetworkCommandLine& cmdline, StageContext& stage,
+                   const BbsListNet& bbslist, wwiv::core::Clock& clock)
+    : net_cmdline_(cmdline), stage_(stage), bbslist_(bbslist), clock_(clock),
+      net_(net_cmdline_.network()),
       netdat_(net_cmdline_.config().gfilesdir(),
         net_cmdline_.config().logdir(), 
-        net_, net_cmdline_.net_cmd(), clock_) {}
+        net_, net_cmdline_.net_cmd(), clock_), writer_(net_) {
+  writer_.set_spool(&stage_.spool());
+}
 
 
 /**
- * Determines the filename for each of the nodes in list to forward to
- * and writes packets (calling write_wwivnet_packet) to each of them.
+ * Determines the filename for each of the nodes in the packet's list to
+ * forward to and writes packets (using writer_) to each of them.
  */
-bool Network1::write_multiple_wwivnet_packets(const net_header_rec& nh,
-                                              const std::vector<uint16_t>& list,
-                                              const std::string& text) {
+bool Network1::write_multiple_wwivnet_packets(const PacketView& p) {
   std::map<uint16_t, std::set<uint16_t>> forsys_to_all;
-  for (const auto& node : list) {
+  for (auto i = 0; i < p.list_size(); i++) {
+    const auto node = p.list_at(i);
     auto forsys = get_forsys(bbslist_, node);
     forsys_to_all[forsys].insert(node);
   }
 
   auto result = true;
   for (const auto& fa : forsys_to_all) {
-    Packet np(nh, std::vector<uint16_t>(fa.second.begin(), fa.second.end()), text);
-    np.nh.list_len = static_cast<uint16_t>(np.list.size());
-    if (np.list.size() == 1) {
+    const std::vector<uint16_t> list(fa.second.begin(), fa.second.end());
+    PacketView np(p);
+    np.nh.list_len = static_cast<uint16_t>(list.size());
+    np.set_list(std::string_view(reinterpret_cast<const char*>(list.data()),
+                                 list.size() * sizeof(uint16_t)));
+    if (list.size() == 1) {
       // If we only have 1, move it out of list into tosys.
-      np.nh.tosys = *np.list.begin();
+      np.nh.tosys = list.front();
       np.nh.list_len = 0;
-      np.list.clear();
+      np.set_list({});
     }
     const auto forsys = fa.first;
-    netdat_.add_file_bytes(forsys, np.length());
-    if (!write_wwivnet_packet(Packet::wwivnet_packet_name(net_, forsys), net_, np)) {
+    netdat_.add_file_bytes(forsys, static_cast<int>(np.nh.length));
+    if (!writer_.Write(Packet::wwivnet_packet_name(net_, forsys), np)) {
       result = false;
     }
   }
   return result;
 }
 
-bool Network1::handle_packet(Packet& p) {
+bool Network1::handle_packet(PacketView& p) {
 
   // Update the routing information on this packet since
   // we're unpacking it.
@@ -115,36 +116,36 @@ bool Network1::handle_packet(Packet& p) {
 
   if (p.nh.tosys == net_.sysnum) {
     // Local Packet.
-    netdat_.add_file_bytes(net_.sysnum, p.length());
-    return write_wwivnet_packet(LOCAL_NET, net_, p);
+    netdat_.add_file_bytes(net_.sysnum, static_cast<int>(p.nh.length));
+    return writer_.Write(LOCAL_NET, p);
   }
-  if (p.list.empty()) {
+  if (p.list_size() == 0) {
     // Network packet, single destination
     const auto forsys = get_forsys(bbslist_, p.nh.tosys);
-    netdat_.add_file_bytes(forsys, p.length());
-    return write_wwivnet_packet(Packet::wwivnet_packet_name(net_, forsys), net_, p);
+    netdat_.add_file_bytes(forsys, static_cast<int>(p.nh.length));
+    return writer_.Write(Packet::wwivnet_packet_name(net_, forsys), p);
   }
   // Network packet, multiple destinations.
-  return write_multiple_wwivnet_packets(p.nh, p.list, p.text());
+  return write_multiple_wwivnet_packets(p);
 }
 
 bool Network1::handle_file(const string& name) {
-  File f(FilePath(net_.dir, name));
-  if (!f.Open(File::modeBinary | File::modeReadOnly)) {
+  PacketReader reader(FilePath(net_.dir, name), false);
+  if (!reader.IsOpen()) {
     LOG(INFO) << "Unable to open file: " << net_.dir << name;
     return false;
   }
 
   for (;;) {
-    auto [packet, response] = read_packet(f, false);
+    auto [view, response] = reader.Next();
     if (response == ReadPacketResponse::END_OF_FILE) {
       return true;
     }
     if (response == ReadPacketResponse::ERROR) {
       return false;
     }
-    if (!handle_packet(packet)) {
-      LOG(INFO) << "error handing packet: type: " << packet.nh.main_type;
+    if (!handle_packet(view)) {
+      LOG(INFO) << "error handing packet: type: " << view.nh.main_type;
     }
   }
 }
@@ -155,15 +156,27 @@ bool Network1::Run() {
     FindFiles ff(FilePath(net_.dir, "p*.net"), FindFiles::FindFilesType::files);
     for (const auto& f : ff) {
       LOG(INFO) << "Processing: " << net_.dir << f.name;
-      if (handle_file(f.name)) {
+      const auto handled = handle_file(f.name);
+      // Make sure everything from this file is on disk before deleting it.
+      if (!writer_.Flush()) {
+        LOG(ERROR) << "Error writing packets from: " << net_.dir << f.name << "; not deleting it.";
+        continue;
+      }
+      if (handled) {
         LOG(INFO) << "Deleting: " << net_.dir << f.name;
         if (net_cmdline_.skip_delete()) {
           backup_file(FilePath(net_.dir, f.name));
         }
-        File::Remove(FilePath(net_.dir, f.name));
+        // Kept aside until network2 has read anything of it still in memory.
+        stage_.spool().Remove(FilePath(net_.dir, f.name));
       }
     }
 
+    writer_.Close();
+    const auto& ws = writer_.stats();
+    VLOG(1) << "Wrote " << ws.packets << " packets; " << ws.bytes << " bytes; " << ws.opens
+            << " opens; " << ws.writes << " writes.";
+
     // Update contact record.
     LOG(INFO) << " * Updating " << net_.name << " contact.net...";
     Contact contact(net_, true);
@@ -180,13 +193,14 @@ bool Network1::Run() {
       // Should *never* happen since we checked above.
       DCHECK(c);
       VLOG(1) << "Updating contact entry for node: @" << sn;
-      const auto outbound_fn = FilePath(net_.dir, StrCat("s", it->second.systemnumber(), ".net"));
+      const auto outbound_name = StrCat("s", it->second.systemnumber(), ".net");
+      const auto outbound_fn = FilePath(net_.dir, outbound_name);
+      auto bytes_waiting = static_cast<int32_t>(stage_.spool().size(outbound_name));
       if (File::Exists(outbound_fn)) {
         File of(outbound_fn);
-        c->set_bytes_waiting(static_cast<int32_t>(of.length()));
-      } else {
-        c->set_bytes_waiting(0);
+        bytes_waiting += static_cast<int32_t>(of.length());
       }
+      c->set_bytes_waiting(bytes_waiting);
       ++it;
     }
 
@@ -204,36 +218,16 @@ bool Network1::Run() {
   return false;
 }
 
-int main(int argc, char** argv) { 
-  LoggerConfig config(LogDirFromConfig);
-  Logger::Init(argc, argv, config);
-
-  ScopeExit at_exit(Logger::ExitLogger);
-  CommandLine cmdline(argc, argv, "net");
-  const NetworkCommandLine net_cmdline(cmdline, '1');
-  if (!net_cmdline.IsInitialized() || net_cmdline.cmdline().help_requested()) {
-    ShowHelp(net_cmdline);
-    return 1;
-  }
-
-
+int network1_main(const NetworkCommandLine& net_cmdline, StageContext& stage) {
   VLOG(3) << "Reading bbsdata.net..";
-  const auto& net = net_cmdline.network();
-  const auto b = BbsListNet::ReadBbsDataNet(net.dir);
+  const auto& b = stage.bbslist();
   if (b.empty()) {
     LOG(ERROR) << "ERROR: Unable to read bbsdata.net.";
     LOG(ERROR) << "       You likely need to run network3?";
     return 1;
   }
 
-  try {
-    auto semaphore = SemaphoreFile::try_acquire(net_cmdline.semaphore_path(),
-                                                net_cmdline.semaphore_timeout());
-    SystemClock clock;
-    Network1 n1(net_cmdline, b, clock);
-    return n1.Run() ? 0 : 2;
-  } catch (const semaphore_not_acquired& e) {
-    LOG(ERROR) << "ERROR: [network" << net_cmdline.net_cmd()
-               << "]: Unable to Acquire Network Semaphore: " << e.what();
-  }
-}
\ No newline at end of file
+  SystemClock clock;
+  Network1 n1(net_cmdline, stage, b, clock);
+  return n1.Run() ? 0 : 2;
+}
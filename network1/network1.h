@@ -21,6 +21,9 @@
 #include "core/clock.h"
 #include "net_core/net_cmdline.h"
 #include "net_core/netdat.h"
+#include "net_core/stage_context.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_writer.h"
 #include "sdk/net/packets.h"
 #include <string>
 
@@ -32,23 +35,30 @@ class BbsListNet;
 
 class Network1 final {
 public:
-  Network1(const wwiv::net::NetworkCommandLine& cmdline, 
-           const wwiv::sdk::BbsListNet& bbslist,
-           wwiv::core::Clock& clock);
+  Network1(const wwiv::net::NetworkCommandLine& cmdline, wwiv::net::StageContext& stage,
+           const wwiv::sdk::BbsListNet& bbslist, wwiv::core::Clock& clock);
   ~Network1() = default;
 
   bool Run();
 
 private:
-  bool write_multiple_wwivnet_packets(const net_header_rec& nh, const std::vector<uint16_t>& list,
-                                      const std::string& text);
-  bool handle_packet(wwiv::sdk::net::Packet& p);
+  bool write_multiple_wwivnet_packets(const wwiv::sdk::net::PacketView& p);
+  bool handle_packet(wwiv::sdk::net::PacketView& p);
   bool handle_file(const std::string& name);
   const wwiv::net::NetworkCommandLine& net_cmdline_;
+  wwiv::net::StageContext& stage_;
   const wwiv::sdk::BbsListNet& bbslist_;
   wwiv::core::Clock& clock_;
   const net_networks_rec& net_;
   wwiv::net::NetDat netdat_;
+  wwiv::sdk::net::PacketWriter writer_;
 };
 
+/**
+ * Runs network1 for the network in net_cmdline, returning the exit code.
+ * The caller must hold the network1 semaphore.
+ */
+int network1_main(const wwiv::net::NetworkCommandLine& net_cmdline,
+                  wwiv::net::StageContext& stage);
+
 #endif // INCLUDED_NET_NETWORK1_H
\ No newline at end of file
@@ -59,15 +59,12 @@ namespace wwiv::net::network2 {
 
 // Gets the user number or 0 if it is not found.
 static int GetUserNumber(const std::string& name, UserManager& um) {
-  auto max = um.num_user_records();
+  auto user_number = 0;
   auto realname_pos = 0;
-  for (auto i = 0; i <= max; i++) {
-    User u;
-    if (!um.readuser_nocache(&u, i)) {
-      continue;
-    }
+  um.for_each_user([&](int i, const User& u) {
     if (iequals(name, u.name())) {
-      return i;
+      user_number = i;
+      return false;
     }
     // Try to fix emails not matching against real names
     // when coming from FTN systems.
@@ -77,6 +74,10 @@ static int GetUserNumber(const std::string& name, UserManager& um) {
     } else if (matches_realname && realname_pos != 0) {
       LOG(WARNING) << "Duplicate real names";
     }
+    return true;
+  });
+  if (user_number != 0) {
+    return user_number;
   }
   // If we didn't find a handle, use the first known position
   // of the real name.  These are not guaranteed to be unique
@@ -17,6 +17,8 @@
 /**************************************************************************/
 
 // WWIV5 Network2
+#include "network2/network2.h"
+
 #include "core/command_line.h"
 #include "core/datafile.h"
 #include "core/file.h"
@@ -32,6 +34,7 @@
 #include "network2/subs.h"
 #include "net_core/netdat.h"
 #include "net_core/net_cmdline.h"
+#include "net_core/stage_context.h"
 #include "sdk/config.h"
 #include "sdk/filenames.h"
 #include "sdk/ssm.h"
@@ -40,6 +43,8 @@
 #include "sdk/msgapi/message_api_wwiv.h"
 #include "sdk/msgapi/msgapi.h"
 #include "sdk/net/networks.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_spool.h"
 #include "sdk/net/packets.h"
 
 #include <cstdlib>
@@ -85,11 +90,6 @@ static void update_filechange_status_dat(const string& datadir, bool email, bool
   });
 }
 
-static void ShowHelp(const NetworkCommandLine& cmdline) {
-  cout << cmdline.GetHelp() << endl;
-  exit(1);
-}
-
 static bool handle_ssm(Context& context, Packet& p) {
   ScopeExit at_exit(
       [] { VLOG(1) << "=============================================================="; });
@@ -151,11 +151,13 @@ static bool handle_sub_list(Context& context, Packet& p) {
   return write_net_received_file(context, net, p, info);
 }
 
-static bool handle_packet(Context& context, Packet& p) {
-  LOG(INFO) << "Processing message with type: " << main_type_name(p.nh.main_type) << "/"
-            << p.nh.minor_type;
+// Handlers that keep, change or parse the packet get their own copy of it.
+// Anything else is forwarded from the reader's buffer as-is.
+static bool handle_packet(Context& context, PostTosser& tosser, const PacketView& view) {
+  LOG(INFO) << "Processing message with type: " << main_type_name(view.nh.main_type) << "/"
+            << view.nh.minor_type;
 
-  switch (p.nh.main_type) {
+  switch (view.nh.main_type) {
     /*
     These messages contain various network information
     files, encoded with method 1 (requiring DE1.EXE).
@@ -165,6 +167,7 @@ static bool handle_packet(Context& context, Packet& p) {
     minor_type (except minor_type 1).
     */
   case main_type_net_info: {
+    auto p = view.ToPacket();
     if (p.nh.minor_type == 0) {
       // Feedback to sysop from the NC.
       // This is sent to the #1 account as source verified email.
@@ -173,50 +176,67 @@ static bool handle_packet(Context& context, Packet& p) {
     }
     return handle_net_info_file(context, context.net, p);
   }
-  case main_type_email:
+  case main_type_email: {
     // This is regular email sent to a user number at this system.
     // Email has no minor type, so minor_type will always be zero.
     email_changed = true;
+    auto p = view.ToPacket();
     return handle_email(context, p.nh.touser, p);
-  case main_type_email_name:
+  }
+  case main_type_email_name: {
     // The other email type.  The "touser" field is zero, and the name is found at
     // the beginning of the message text, followed by a NUL character.
     // Minor_type will always be zero.
     email_changed = true;
+    auto p = view.ToPacket();
     return handle_email_byname(context, p);
+  }
   case main_type_new_post: {
     posts_changed = true;
-    if (!handle_inbound_post(context, p)) {
-      LOG(ERROR) << "Error on handle_inbound_post";
+    auto p = view.ToPacket();
+    if (!tosser.Toss(p)) {
+      LOG(ERROR) << "Error on PostTosser::Toss";
       return false;
     }
     return send_post_to_subscribers(context, p, {p.nh.fromsys});
   }
   case main_type_ssm: {
+    auto p = view.ToPacket();
     return handle_ssm(context, p);
   }
   // Subs add/drop support.
-  case main_type_sub_add_req:
+  case main_type_sub_add_req: {
+    auto p = view.ToPacket();
     return handle_sub_add_req(context, p);
-  case main_type_sub_drop_req:
+  }
+  case main_type_sub_drop_req: {
+    auto p = view.ToPacket();
     return handle_sub_drop_req(context, p);
-  case main_type_sub_add_resp:
+  }
+  case main_type_sub_add_resp: {
+    auto p = view.ToPacket();
     return handle_sub_add_drop_resp(context, p, "add");
-  case main_type_sub_drop_resp:
+  }
+  case main_type_sub_drop_resp: {
+    auto p = view.ToPacket();
     return handle_sub_add_drop_resp(context, p, "drop");
+  }
 
   // Sub ping.
   // In many WWIV networks, the subs list coordinator (SLC) occasionally sends
   // out "pings" to all network members.
   case main_type_sub_list_info: {
+    auto p = view.ToPacket();
     if (p.nh.minor_type == 0) {
       return handle_sub_list_info_request(context, p);
     }
     return handle_sub_list_info_response(context, p);
   }
 
-  case main_type_sub_list:
+  case main_type_sub_list: {
+    auto p = view.ToPacket();
     return handle_sub_list(context, p);
+  }
 
   // Legacy numeric only post types.
   case main_type_post:
@@ -236,37 +256,48 @@ static bool handle_packet(Context& context, Packet& p) {
     // Anything undefined or anything we missed.
   default:
     LOG(ERROR) << "    ! ERROR Writing message to dead.net for unhandled type: '"
-               << main_type_name(p.nh.main_type) << "'; writing to dead.net";
-    return write_wwivnet_packet(DEAD_NET, context.net, p);
+               << main_type_name(view.nh.main_type) << "'; writing to dead.net";
+    return write_wwivnet_packet(DEAD_NET, context.net, view);
   }
 }
 
-static bool handle_file(Context& context, const string& name) {
-  File f(FilePath(context.net.dir, name));
-  if (!f.Open(File::modeBinary | File::modeReadOnly)) {
-    LOG(ERROR) << "Unable to open file: " << context.net.dir << name;
-    return false;
-  }
-
+static bool handle_packets(Context& context, PacketReader& reader) {
+  // Posts are written to each sub once we've read them all.
+  PostTosser tosser(context);
   for (;;) {
-    auto [packet, response] = read_packet(f, true);
+    auto [view, response] = reader.Next();
     if (response == ReadPacketResponse::END_OF_FILE) {
-      return true;
+      return tosser.Flush();
     }
     if (response == ReadPacketResponse::ERROR) {
       return false;
     }
-
-    if (!handle_packet(context, packet)) {
-      LOG(ERROR) << "Error handing packet: type: " << packet.nh.main_type;
+    if (!handle_packet(context, tosser, view)) {
+      LOG(ERROR) << "Error handing packet: type: " << view.nh.main_type;
     }
   }
 }
 
-int network2_main(const NetworkCommandLine& net_cmdline) {
+static bool handle_file(Context& context, const string& name) {
+  PacketReader reader(FilePath(context.net.dir, name), true);
+  if (!reader.IsOpen()) {
+    LOG(ERROR) << "Unable to open file: " << context.net.dir << name;
+    return false;
+  }
+  return handle_packets(context, reader);
+}
+
+int network2_main(const NetworkCommandLine& net_cmdline, StageContext& stage) {
+  // networkc may run us more than once in the same process.
+  email_changed = false;
+  posts_changed = false;
   try {
     const auto& net = net_cmdline.network();
-    if (!File::Exists(FilePath(net.dir, LOCAL_NET))) {
+    // Anything already in local.net came first, so is handled before the
+    // packets network1 and networkf handed to us in memory.
+    auto held = stage.spool().Take(LOCAL_NET);
+    const auto have_file = File::Exists(FilePath(net.dir, LOCAL_NET));
+    if (!have_file && held.empty()) {
       LOG(INFO) << "No local.net exists. exiting.";
       return 0;
     }
@@ -279,19 +310,24 @@ int network2_main(const NetworkCommandLine& net_cmdline) {
     // By default, delete excess messages like net37 did.
     options.overflow_strategy = OverflowStrategy::delete_all;
 
-    const auto user_manager = make_unique<UserManager>(config);
     SystemClock clock{};
     NetDat netdat(config.gfilesdir(), config.logdir(), net, net_cmdline.net_cmd(), clock);
 
-    Context context(config, net, *user_manager, networks.networks(), netdat);
+    Context context(config, net, stage.user_manager(), networks.networks(), netdat);
     context.network_number = net_cmdline.network_number();
     context.set_email_api(
         make_unique<WWIVMessageApi>(options, config, networks.networks(), new NullLastReadImpl()));
     context.set_api(2, make_unique<WWIVMessageApi>(options, config, networks.networks(),
                                                    new NullLastReadImpl()));
 
-    LOG(INFO) << "Processing: " << net.dir << LOCAL_NET;
-    if (handle_file(context, LOCAL_NET)) {
+    if (have_file) {
+      LOG(INFO) << "Processing: " << net.dir << LOCAL_NET;
+      if (!handle_file(context, LOCAL_NET)) {
+        LOG(ERROR) << "ERROR: handle_file returned false";
+        // Leave what we were handed for after local.net.
+        stage.spool().PutBack(LOCAL_NET, std::move(held));
+        return 1;
+      }
       if (net_cmdline.skip_delete()) {
         backup_file(FilePath(net.dir, LOCAL_NET));
       }
@@ -299,35 +335,23 @@ int network2_main(const NetworkCommandLine& net_cmdline) {
       if (!File::Remove(FilePath(net.dir, LOCAL_NET))) {
         LOG(ERROR) << "ERROR: Unable to delete " << net.dir << LOCAL_NET;
       }
-      update_filechange_status_dat(context.config.datadir(), email_changed, posts_changed);
-      return 0;
     }
-    LOG(ERROR) << "ERROR: handle_file returned false";
-    return 1;
+    if (!held.empty()) {
+      LOG(INFO) << "Processing: " << held.size() << " bytes of packets for " << LOCAL_NET
+                << " held in memory";
+      // A copy, so that they can be written to local.net if this fails.
+      PacketReader reader(held, true);
+      if (!handle_packets(context, reader)) {
+        LOG(ERROR) << "ERROR: handle_packets returned false";
+        stage.spool().PutBack(LOCAL_NET, std::move(held));
+        return 1;
+      }
+    }
+    update_filechange_status_dat(context.config.datadir(), email_changed, posts_changed);
+    return 0;
   } catch (const std::exception& e) {
     LOG(ERROR) << "ERROR: [network]: " << e.what();
   }
 
   return 255;
 }
-
-int main(int argc, char** argv) {
-  LoggerConfig config(LogDirFromConfig);
-  Logger::Init(argc, argv, config);
-  ScopeExit at_exit(Logger::ExitLogger);
-  CommandLine cmdline(argc, argv, "net");
-  const NetworkCommandLine net_cmdline(cmdline, '2');
-  if (!net_cmdline.IsInitialized() || net_cmdline.cmdline().help_requested()) {
-    ShowHelp(net_cmdline);
-    return 1;
-  }
-
-  try {
-    auto semaphore =
-        SemaphoreFile::try_acquire(net_cmdline.semaphore_path(), net_cmdline.semaphore_timeout());
-    return network2_main(net_cmdline);
-  } catch (const semaphore_not_acquired& e) {
-    LOG(ERROR) << "ERROR: [network" << net_cmdline.net_cmd()
-               << "]: Unable to Acquire Network Semaphore: " << e.what();
-  }
-}
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include "net_core/net_cmdline.h"
 #include "sdk/filenames.h"
 #include "sdk/subxtr.h"
+#include "sdk/msgapi/message_area_wwiv.h"
 #include "sdk/msgapi/msgapi.h"
 #include "sdk/net/packets.h"
 #include <iostream>
@@ -75,13 +76,17 @@ static bool find_sub(const Subs& subs, int network_number, const string& netname
   return false;
 }
 
+PostTosser::PostTosser(Context& context) : context_(context) {}
+
+PostTosser::~PostTosser() { Flush(); }
+
 // Alpha subtypes are seven characters -- the first must be a letter, but the rest can be any
 // character allowed in a DOS filename.This main_type covers both subscriber - to - host and
 // host - to - subscriber messages. Minor type is always zero(since it's ignored), and the
 // subtype appears as the first part of the message text, followed by a NUL.Thus, the message
 // header info at the beginning of the message text is in the format
 // SUBTYPE<nul>TITLE<nul>SENDER_NAME<cr / lf>DATE_STRING<cr / lf>MESSAGE_TEXT.
-bool handle_inbound_post(Context& context, Packet& p) {
+bool PostTosser::Toss(Packet& p) {
 
   ScopeExit at_exit;
 
@@ -96,6 +101,7 @@ bool handle_inbound_post(Context& context, Packet& p) {
     VLOG(1) << "  Date:    " << ppt.date();
   }
 
+  auto& context = context_;
   subboard_t sub;
   if (!find_sub(context.subs, context.network_number, ppt.subtype(), sub)) {
     LOG(INFO) << "    ! ERROR: Unable to find message of subtype: " << ppt.subtype();
@@ -105,29 +111,39 @@ bool handle_inbound_post(Context& context, Packet& p) {
     return write_wwivnet_packet(DEAD_NET, context.net, p);
   }
 
-  if (!context.api(sub.storage_type).Exist(sub)) {
-    LOG(INFO) << "WARNING Message area: '" << sub.filename << "' does not exist.";
-    LOG(INFO) << "WARNING Attempting to create it.";
-    // Since the area does not exist, let's create it automatically
-    // like WWIV always does.
-    auto created = context.api(sub.storage_type).Create(sub, -1);
-    if (!created) {
-      const auto msg = fmt::format("Failed to create message area: '{}'; writing to dead.net", sub.filename);
+  auto it = areas_.find(sub.filename);
+  if (it == std::end(areas_)) {
+    if (!context.api(sub.storage_type).Exist(sub)) {
+      LOG(INFO) << "WARNING Message area: '" << sub.filename << "' does not exist.";
+      LOG(INFO) << "WARNING Attempting to create it.";
+      // Since the area does not exist, let's create it automatically
+      // like WWIV always does.
+      auto created = context.api(sub.storage_type).Create(sub, -1);
+      if (!created) {
+        const auto msg = fmt::format("Failed to create message area: '{}'; writing to dead.net", sub.filename);
+        context.netdat().add_message(NetDat::netdat_msgtype_t::error, msg);
+        LOG(INFO) << "    ! ERROR: Failed to create message area: '" << sub.filename
+                  << "'; writing to dead.net.";
+        return write_wwivnet_packet(DEAD_NET, context.net, p);
+      }
+    }
+
+    unique_ptr<MessageArea> area(context.api(sub.storage_type).Open(sub, -1));
+    if (!area) {
+      const auto msg = fmt::format("Failed to open message area: '{}'; writing to dead.net", sub.filename);
       context.netdat().add_message(NetDat::netdat_msgtype_t::error, msg);
-      LOG(INFO) << "    ! ERROR: Failed to create message area: '" << sub.filename
+      LOG(INFO) << "    ! ERROR Unable to open message area: '" << sub.filename
                 << "'; writing to dead.net.";
       return write_wwivnet_packet(DEAD_NET, context.net, p);
     }
+    if (auto* wwiv_area = dynamic_cast<WWIVMessageArea*>(area.get())) {
+      if (!wwiv_area->BeginBatch()) {
+        LOG(INFO) << "WARNING Unable to batch posts on: '" << sub.filename << "'.";
+      }
+    }
+    it = areas_.emplace(sub.filename, area_t{std::move(area), {}}).first;
   }
-
-  unique_ptr<MessageArea> area(context.api(sub.storage_type).Open(sub, -1));
-  if (!area) {
-    const auto msg = fmt::format("Failed to open message area: '{}'; writing to dead.net", sub.filename);
-    context.netdat().add_message(NetDat::netdat_msgtype_t::error, msg);
-    LOG(INFO) << "    ! ERROR Unable to open message area: '" << sub.filename
-              << "'; writing to dead.net.";
-    return write_wwivnet_packet(DEAD_NET, context.net, p);
-  }
+  auto& area = it->second.area;
 
   if (area->Exists(p.nh.daten, ppt.title(), p.nh.fromsys, p.nh.fromuser)) {
     const auto msg = fmt::format("Discarding Duplicate Message on sub: {}; daten: {}; title: {}", ppt.subtype(),  p.nh.daten, ppt.title());
@@ -157,6 +173,10 @@ bool handle_inbound_post(Context& context, Packet& p) {
     LOG(ERROR) << "    ! ERROR " << errmsg;
     return write_wwivnet_packet(DEAD_NET, context.net, p);
   }
+  if (const auto* wwiv_area = dynamic_cast<WWIVMessageArea*>(area.get());
+      wwiv_area && wwiv_area->in_batch()) {
+    it->second.packets.push_back(p);
+  }
   LOG(INFO) << "    + Posted  '" << ppt.title() << "' on sub: '" << ppt.subtype() << "'.";
     context.netdat().add_message(NetDat::netdat_msgtype_t::post, fmt::format("Posted  '{}' on sub: '{}'",
     ppt.title(), ppt.subtype()));
@@ -164,6 +184,31 @@ bool handle_inbound_post(Context& context, Packet& p) {
   return true;
 }
 
+bool PostTosser::Flush() {
+  auto result = true;
+  for (auto& [filename, a] : areas_) {
+    auto* wwiv_area = dynamic_cast<WWIVMessageArea*>(a.area.get());
+    if (!wwiv_area || !wwiv_area->in_batch()) {
+      continue;
+    }
+    VLOG(1) << "Writing " << a.packets.size() << " posts to sub: '" << filename << "'.";
+    if (wwiv_area->EndBatch()) {
+      continue;
+    }
+    const auto msg = fmt::format("Failed to write {} posts to message area: '{}'; writing to dead.net",
+                                 a.packets.size(), filename);
+    context_.netdat().add_message(NetDat::netdat_msgtype_t::error, msg);
+    LOG(ERROR) << "    ! ERROR " << msg;
+    for (const auto& p : a.packets) {
+      if (!write_wwivnet_packet(DEAD_NET, context_.net, p)) {
+        result = false;
+      }
+    }
+  }
+  areas_.clear();
+  return result;
+}
+
 static std::string set_to_string(const set<uint16_t>& lines) {
   std::ostringstream ss;
   for (const auto& line : lines) {
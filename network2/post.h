@@ -21,17 +21,50 @@
 #include "network2/context.h"
 #include "sdk/msgapi/message_api_wwiv.h"
 #include "sdk/net/packets.h"
+#include <map>
+#include <memory>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace wwiv {
 namespace net {
 namespace network2 {
 
 /**
- * Handles receiving a Packet with a post and writing it to the
- * local database.
+ * Handles receiving Packets with posts and writing them to the local
+ * database.  Posts are grouped by their destination sub: each sub is opened
+ * once, the first time a post for it is tossed, and kept in batch mode so
+ * checking for duplicates doesn't reread the sub.  The posts are written to
+ * each sub together by Flush.
  */
-bool handle_inbound_post(Context& context, wwiv::sdk::net::Packet& packet);
+class PostTosser final {
+public:
+  explicit PostTosser(Context& context);
+  ~PostTosser();
+  PostTosser(const PostTosser&) = delete;
+  PostTosser& operator=(const PostTosser&) = delete;
+
+  /** Handles receiving a Packet with a post. */
+  bool Toss(wwiv::sdk::net::Packet& packet);
+
+  /**
+   * Writes the posts tossed so far to their subs and closes them.  If a sub
+   * can't be written, its posts are written to dead.net.
+   */
+  bool Flush();
+
+private:
+  struct area_t {
+    std::unique_ptr<wwiv::sdk::msgapi::MessageArea> area;
+    // Packets of the posts waiting to be written, in case we can't.
+    std::vector<wwiv::sdk::net::Packet> packets;
+  };
+  Context& context_;
+  // Open subs by filename.
+  std::map<std::string, area_t> areas_;
+};
+
 /**
  * Send a network post out to the other subscribers when you are the host off
  * a sub or gating a sub.
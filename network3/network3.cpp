@@ -15,6 +15,8 @@
 /*    either  express  or implied.  See  the  License for  the specific   */
 /*    language governing permissions and limitations under the License.   */
 /**************************************************************************/
+#include "network3/network3.h"
+
 #include "binkp/binkp_config.h"
 #include "core/command_line.h"
 #include "core/datafile.h"
@@ -33,6 +35,7 @@
 #include "fmt/printf.h"
 #include "net_core/netdat.h"
 #include "net_core/net_cmdline.h"
+#include "net_core/stage_context.h"
 #include "sdk/bbslist.h"
 #include "sdk/config.h"
 #include "sdk/fido/fido_address.h"
@@ -72,11 +75,6 @@ using namespace wwiv::sdk::net;
 using namespace wwiv::stl;
 using namespace wwiv::os;
 
-static void ShowHelp(const NetworkCommandLine& cmdline) {
-  cout << cmdline.GetHelp() << endl;
-  exit(1);
-}
-
 static bool check_wwivnet_host_networks(
   const wwiv::sdk::Config& config, 
   const wwiv::sdk::Networks& network,
@@ -421,7 +419,7 @@ static bool need_to_send_feedback(const CommandLine& cmdline) {
   return false;
 }
 
-static int network3_fido(const NetworkCommandLine& net_cmdline) {
+static int network3_fido(const NetworkCommandLine& net_cmdline, StageContext& stage) {
   VLOG(2) << "network3_fido";
   const auto& net = net_cmdline.network();
   std::ostringstream text;
@@ -513,16 +511,16 @@ static int network3_fido(const NetworkCommandLine& net_cmdline) {
   } else {
     text << " [" << time_t_to_wwivnet_time(File::last_write_time(nl_file)) << "]\r\n";
     auto nl_path = File::absolute(dirs.net_dir(), nodelist);
-    Nodelist nl(nl_path);
-    if (!nl.initialized()) {
+    const auto* nl = stage.nodelist(nl_path);
+    if (!nl) {
       text << " ** Unable to parse nodelist.\r\n";
       text << " ** Please fix it.\r\n\n";
     } else {
-      if (!nl.contains(address)) {
+      if (!nl->contains(address)) {
         text << " ** Your address: '" << address << "' does not exist in the nodelist: '" << nodelist << ".\r\n";
       }
       for (const auto& ncs : callout.node_configs_map()) {
-        if (!nl.contains(ncs.first)) {
+        if (!nl->contains(ncs.first)) {
           text << " ** Callout address: '" << ncs.first.as_string() << "' does not exist in the nodelist.\r\n";
         }
       }
@@ -596,7 +594,11 @@ static int network3_wwivnet(const NetworkCommandLine& net_cmdline) {
   return 0;
 }
 
-int network3_main(const NetworkCommandLine& net_cmdline) {
+void AddNetwork3Args(CommandLine& cmdline) {
+  cmdline.add_argument(BooleanCommandLineArgument("feedback", 'y', "Sends feedback.", false));
+}
+
+int network3_main(const NetworkCommandLine& net_cmdline, StageContext& stage) {
   try {
     const auto& net = net_cmdline.network();
     update_net_ver_status_dat(net_cmdline.config().datadir());
@@ -609,7 +611,7 @@ int network3_main(const NetworkCommandLine& net_cmdline) {
 
     // Only run the net fido type network3 for 5.x
     if (net_cmdline.config().is_5xx_or_later() && net.type == network_type_t::ftn) {
-      return network3_fido(net_cmdline);
+      return network3_fido(net_cmdline, stage);
     }
     return network3_wwivnet(net_cmdline);
   } catch (const std::exception& e) {
@@ -617,27 +619,3 @@ int network3_main(const NetworkCommandLine& net_cmdline) {
   }
   return 2;
 }
-
-
-int main(int argc, char** argv) {
-  LoggerConfig config(LogDirFromConfig);
-  Logger::Init(argc, argv, config);
-
-  ScopeExit at_exit(Logger::ExitLogger);
-  CommandLine cmdline(argc, argv, "net");
-  cmdline.add_argument(BooleanCommandLineArgument("feedback", 'y', "Sends feedback.", false));
-  const NetworkCommandLine net_cmdline(cmdline, '3');
-  if (!net_cmdline.IsInitialized() || net_cmdline.cmdline().help_requested()) {
-    ShowHelp(net_cmdline);
-    return 1;
-  }
-
-  try {
-    auto semaphore = SemaphoreFile::try_acquire(net_cmdline.semaphore_path(),
-                                                net_cmdline.semaphore_timeout());
-    return network3_main(net_cmdline);
-  } catch (const semaphore_not_acquired& e) {
-    LOG(ERROR) << "ERROR: [network" << net_cmdline.net_cmd()
-               << "]: Unable to Acquire Network Semaphore: " << e.what();
-  }
-}
@@ -0,0 +1,36 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_NETWORK3_NETWORK3_H
+#define INCLUDED_NETWORK3_NETWORK3_H
+
+#include "core/command_line.h"
+#include "net_core/net_cmdline.h"
+#include "net_core/stage_context.h"
+
+/** Adds the arguments network3 accepts beyond the standard network ones. */
+void AddNetwork3Args(wwiv::core::CommandLine& cmdline);
+
+/**
+ * Runs network3 for the network in net_cmdline, returning the exit code.
+ * The caller must hold the network3 semaphore.
+ */
+int network3_main(const wwiv::net::NetworkCommandLine& net_cmdline,
+                  wwiv::net::StageContext& stage);
+
+#endif
@@ -29,11 +29,18 @@
 #include "core/version.h"
 #include "fmt/printf.h"
 #include "net_core/net_cmdline.h"
+#include "net_core/stage_context.h"
+#include "network1/network1.h"
+#include "network2/network2.h"
+#include "network3/network3.h"
+#include "networkf/networkf.h"
+#include "networkt/networkt.h"
 #include "sdk/config.h"
 #include "sdk/filenames.h"
 #include "sdk/status.h"
 #include "sdk/fido/fido_directories.h"
 #include "sdk/fido/fido_util.h"
+#include "sdk/net/packet_spool.h"
 #include "sdk/net/packets.h"
 #include <cstdlib>
 #include <ctime>
@@ -42,6 +49,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #ifndef _WIN32
 #include <signal.h>
@@ -78,27 +86,36 @@ static void rename_bbs_instance_files(const std::filesystem::path& dir, int inst
   }
 }
 
-string create_network_cmdline(const NetworkCommandLine& net_cmdline, char num, const string& cmd) {
-  const auto path = FilePath(net_cmdline.cmdline().bindir(), StrCat("network", num));
-
-  std::ostringstream ss;
-  ss << path;
+static std::vector<string> create_network_args(const NetworkCommandLine& net_cmdline, char num,
+                                               const string& cmd) {
+  auto path = FilePath(net_cmdline.cmdline().bindir(), StrCat("network", num)).string();
 #ifdef _WIN32
-  ss << ".exe";
+  path.append(".exe");
 #endif
-  ss << " --v=" << net_cmdline.cmdline().verbose();
+  std::vector<string> args{path, StrCat("--v=", net_cmdline.cmdline().verbose())};
   if (net_cmdline.quiet()) {
-    ss << " --quiet";
+    args.emplace_back("--quiet");
   }
-  ss << " --bbsdir=" << net_cmdline.cmdline().bbsdir();
-  ss << " --bindir=" << net_cmdline.cmdline().bindir();
-  ss << " --configdir=" << net_cmdline.cmdline().configdir();
-  ss << " ." << net_cmdline.network_number();
+  args.emplace_back(StrCat("--bbsdir=", net_cmdline.cmdline().bbsdir()));
+  args.emplace_back(StrCat("--bindir=", net_cmdline.cmdline().bindir()));
+  args.emplace_back(StrCat("--configdir=", net_cmdline.cmdline().configdir()));
+  args.emplace_back(StrCat(".", net_cmdline.network_number()));
   if (num == '3') {
-    ss << " Y";
+    args.emplace_back("Y");
   }
   if (!cmd.empty()) {
-    ss << " " << cmd;
+    args.emplace_back(cmd);
+  }
+  return args;
+}
+
+string create_network_cmdline(const NetworkCommandLine& net_cmdline, char num, const string& cmd) {
+  const auto args = create_network_args(net_cmdline, num, cmd);
+  std::ostringstream ss;
+  // Streaming the path quotes it.
+  ss << std::filesystem::path(args.front());
+  for (auto it = std::next(std::begin(args)); it != std::end(args); ++it) {
+    ss << " " << *it;
   }
   return ss.str();
 }
@@ -108,6 +125,63 @@ static int System(const string& cmd) {
   return system(cmd.c_str());
 }
 
+// Runs network command num inside of networkc, sharing the config, networks,
+// users, message dupes, bbslist and nodelist in stage, instead of starting
+// another process.  network3, the BBS and the sysop may change those between
+// stages, so stage reloads any whose file has changed since it was loaded.
+// local.net and the FTN outbound packet are handed to the next stage in
+// stage's spool rather than through the network directory.
+//
+// The callouts are still loaded by each stage.  The stage logs to networkc's
+// log, not its own; use --subprocess to get the separate logs back.
+static int run_network_cmd_in_process(const NetworkCommandLine& net_cmdline, StageContext& stage,
+                                      char num, const string& cmd) {
+  LOG(INFO) << "Running network" << num << " " << cmd;
+  CommandLine cmdline(create_network_args(net_cmdline, num, cmd), "net");
+  if (num == '3') {
+    AddNetwork3Args(cmdline);
+  } else if (num == 't') {
+    AddNetworkTArgs(cmdline);
+  }
+  const NetworkCommandLine cmd_cmdline(cmdline, num, net_cmdline);
+  if (!cmd_cmdline.IsInitialized()) {
+    LOG(ERROR) << "ERROR: [network" << num << "]: Unable to initialize.";
+    return 1;
+  }
+
+  try {
+    auto semaphore = SemaphoreFile::try_acquire(cmd_cmdline.semaphore_path(),
+                                                cmd_cmdline.semaphore_timeout());
+    switch (num) {
+    case '1':
+      return network1_main(cmd_cmdline, stage);
+    case '2':
+      return network2_main(cmd_cmdline, stage);
+    case '3':
+      return network3_main(cmd_cmdline, stage);
+    case 'f':
+      return wwiv::net::networkf::networkf_main(cmd_cmdline, stage);
+    case 't':
+      return networkt_main(cmd_cmdline);
+    default:
+      LOG(ERROR) << "Unknown network command: network" << num;
+      return 1;
+    }
+  } catch (const semaphore_not_acquired& e) {
+    LOG(ERROR) << "ERROR: [network" << num
+               << "]: Unable to Acquire Network Semaphore: " << e.what();
+  }
+  return 2;
+}
+
+static int run_network_cmd(const NetworkCommandLine& net_cmdline, StageContext& stage, char num,
+                           const string& cmd) {
+  if (net_cmdline.cmdline().barg("subprocess")) {
+    return System(create_network_cmdline(net_cmdline, num, cmd));
+  }
+  return run_network_cmd_in_process(net_cmdline, stage, num, cmd);
+}
+
 static bool checkup2(const time_t tFileTime, const std::filesystem::path& dir, const string& filename) {
   const auto fn = FilePath(dir, filename);
   File file(fn);
@@ -181,6 +255,11 @@ int networkc_main(const NetworkCommandLine& net_cmdline) {
     StatusMgr sm(net_cmdline.config().datadir(), [](int) {});
     const auto status = sm.get_status();
 
+    // Put back any inputs a previous run died holding the packets of.
+    PacketSpool::Recover(net.dir);
+    // Packets are only held in memory when the stages run in this process.
+    StageContext stage(net_cmdline.config(), net, !net_cmdline.cmdline().barg("subprocess"));
+
     auto num_tries = 0;
     auto found = false;
     do {
@@ -195,7 +274,7 @@ int networkc_main(const NetworkCommandLine& net_cmdline) {
       // Pending files, call network1 to put them into s* or local.net.
       if (File::ExistsWildcard(FilePath(net.dir, "p*.net"))) {
         VLOG(2) << "Found p*.net";
-        System(create_network_cmdline(net_cmdline, '1', ""));
+        run_network_cmd(net_cmdline, stage, '1', "");
         found = true;
       }
 
@@ -205,7 +284,7 @@ int networkc_main(const NetworkCommandLine& net_cmdline) {
         // Import everything into local.net
         if (File::ExistsWildcard(FilePath(dirs.inbound_dir(), "*.*"))) {
           VLOG(2) << "Trying to FTN import";
-          System(create_network_cmdline(net_cmdline, 'f', "import"));
+          run_network_cmd(net_cmdline, stage, 'f', "import");
         }
 
         // Check to see if TIC files exist.
@@ -213,33 +292,39 @@ int networkc_main(const NetworkCommandLine& net_cmdline) {
         const auto tic_file_exist = File::ExistsWildcard(FilePath(dirs.tic_dir(), "*.tic"));
         if (process_tic && tic_file_exist) {
           VLOG(2) << "Trying to process TIC files";
-          System(create_network_cmdline(net_cmdline, 't', ""));
+          run_network_cmd(net_cmdline, stage, 't', "");
         }
 
         if (exists_bundle(net_cmdline.config(), net)) {
           VLOG(2) << "Trying to FTN export";
-          System(create_network_cmdline(net_cmdline, 'f', "export"));
+          run_network_cmd(net_cmdline, stage, 'f', "export");
         }
 
         // Export everything to FTN bundles
         const auto fido_out = StrCat("s", FTN_FAKE_OUTBOUND_NODE, ".net");
-        if (File::Exists(FilePath(net.dir, fido_out))) {
+        if (File::Exists(FilePath(net.dir, fido_out)) || stage.spool().has_packets(fido_out)) {
           VLOG(2) << "Found s" << FTN_FAKE_OUTBOUND_NODE << ".net; trying to export";
-          System(create_network_cmdline(net_cmdline, 'f', "export"));
+          run_network_cmd(net_cmdline, stage, 'f', "export");
         }
       }
 
       // Process local mail with network2.
-      if (File::Exists(FilePath(net.dir, LOCAL_NET))) {
+      if (File::Exists(FilePath(net.dir, LOCAL_NET)) || stage.spool().has_packets(LOCAL_NET)) {
         VLOG(2) << "Found: " << LOCAL_NET;
-        System(create_network_cmdline(net_cmdline, '2', ""));
+        run_network_cmd(net_cmdline, stage, '2', "");
         found = true;
       }
 
+      // network3 renames the packet files, so anything still held (from a
+      // stage that failed) needs to be in them first.
+      if (!stage.spool().Commit()) {
+        LOG(ERROR) << "ERROR: Unable to write held packets to " << net.dir;
+      }
+
       // If our network files have changed, run network3 and send feedback.
       if (need_network3(net, status->status_net_version())) {
         VLOG(2) << "Need to run network3";
-        System(create_network_cmdline(net_cmdline, '3', ""));
+        run_network_cmd(net_cmdline, stage, '3', "");
         found = true;
       }
     } while (found && ++num_tries < 3);
@@ -258,6 +343,9 @@ int main(int argc, char** argv) {
   ScopeExit at_exit(Logger::ExitLogger);
   CommandLine cmdline(argc, argv, "net");
   cmdline.add_argument({"process_instance", "Also process pending files for BBS instance #", "0"});
+  cmdline.add_argument(BooleanCommandLineArgument(
+      "subprocess", "Run network1/2/3/f/t as separate processes instead of within networkc",
+      false));
 
   const NetworkCommandLine net_cmdline(cmdline, 'c');
   if (!net_cmdline.IsInitialized() || net_cmdline.cmdline().help_requested()) {
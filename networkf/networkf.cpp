@@ -32,16 +32,21 @@
 #include "core/version.h"
 #include "fmt/format.h"
 #include "net_core/net_cmdline.h"
+#include "net_core/stage_context.h"
 #include "sdk/bbslist.h"
 #include "sdk/config.h"
 #include "sdk/fido/fido_address.h"
 #include "sdk/fido/fido_callout.h"
 #include "sdk/fido/fido_directories.h"
+#include "sdk/fido/fido_packet_reader.h"
 #include "sdk/fido/fido_packets.h"
 #include "sdk/fido/fido_util.h"
 #include "sdk/filenames.h"
 #include "sdk/files/arc.h"
+#include "sdk/files/zip_writer.h"
 #include "sdk/net/ftn_msgdupe.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_spool.h"
 #include "sdk/net/packets.h"
 #include "sdk/net/subscribers.h"
 #include <cstdlib>
@@ -54,10 +59,6 @@
 #include <string>
 #include <vector>
 
-#ifndef _WIN32
-#include <signal.h>
-#endif // _WIN32
-
 using namespace wwiv::core;
 using namespace wwiv::net;
 using namespace wwiv::os;
@@ -75,6 +76,10 @@ using std::vector;
 
 namespace wwiv::net::networkf {
 
+// Packets are added to their bundle once they get this large, so that we
+// don't hold a whole export in memory.
+static constexpr std::size_t kMaxFtnPacketSize = 1024 * 1024;
+
 static vector<arcrec> read_arcs(const std::string& datadir) {
   vector<arcrec> arcs;
   if (auto file = DataFile<arcrec>(FilePath(datadir, ARCHIVER_DAT))) {
@@ -118,7 +123,7 @@ static std::string arc_stuff_in(const std::string& command_line, const std::stri
   return os.str();
 }
 
-static void ShowHelp(const NetworkCommandLine& cmdline) {
+void ShowHelp(const NetworkCommandLine& cmdline) {
   cout << cmdline.GetHelp() << endl
        << "commands: " << endl
        << endl
@@ -139,9 +144,10 @@ static std::string get_echomail_areaname(const std::string& text) {
   return "";
 }
 
-NetworkF::NetworkF(const wwiv::net::NetworkCommandLine& net_cmdline,
+NetworkF::NetworkF(const wwiv::net::NetworkCommandLine& net_cmdline, StageContext& stage,
                    const wwiv::sdk::BbsListNet& bbslist, wwiv::core::Clock& clock)
-    : net_cmdline_(net_cmdline), bbslist_(bbslist), clock_(clock), net_(net_cmdline_.network()),
+    : net_cmdline_(net_cmdline), stage_(stage), bbslist_(bbslist), clock_(clock),
+      net_(net_cmdline_.network()),
       fido_callout_(net_cmdline_.config(), net_),
       netdat_(net_cmdline_.config().gfilesdir(), net_cmdline_.config().logdir(), net_,
               net_cmdline_.net_cmd(), clock_) {
@@ -168,9 +174,9 @@ bool NetworkF::import_packet_file(const std::string& dir, const std::string& nam
   }
 
   auto done = false;
+  FidoPacketReader reader(f);
   packet_header_2p_t header{};
-  auto num_header_read = f.Read(&header, sizeof(packet_header_2p_t));
-  if (num_header_read < static_cast<int>(sizeof(packet_header_2p_t))) {
+  if (!reader.ReadHeader(header)) {
     LOG(ERROR) << "Read less than packet header";
     return false;
   }
@@ -200,7 +206,7 @@ bool NetworkF::import_packet_file(const std::string& dir, const std::string& nam
 
   while (!done) {
     FidoPackedMessage msg;
-    auto response = read_packed_message(f, msg);
+    auto response = reader.Next(msg);
     if (response == ReadPacketResponse::END_OF_FILE) {
       return true;
     }
@@ -393,94 +399,6 @@ int NetworkF::import_bundles(const std::string& dir, const std::string& mask) {
   return num_bundles_processed;
 }
 
-static std::string rename_fido_packet(const std::string& dir, const std::string& origname) {
-  if (!ends_with(origname, ".pkt") || origname.size() != 12) {
-    LOG(ERROR) << "rename_fido_packet: not allowed on name: '" << origname << "'";
-    return origname;
-  }
-  auto base = origname.substr(0, 8);
-  for (auto i = 0; i < 26; i++) {
-    base.pop_back();
-    base.push_back(static_cast<char>('a' + i));
-    auto newname = base + ".pkt";
-    if (!File::Exists(FilePath(dir, newname))) {
-      return newname;
-    }
-  }
-  return origname;
-}
-
-bool NetworkF::create_ftn_bundle(const FidoAddress& route_to, const std::string& fido_packet_name,
-                                 std::string& out_bundle_name) {
-  // were in the temp dir now.
-  auto arcs = read_arcs(net_cmdline_.config().datadir());
-  if (arcs.empty()) {
-    LOG(ERROR) << "No archivers defined!";
-    return false;
-  }
-  auto now = DateTime::now();
-  auto dow = now.dow();
-
-  const auto saved_dir = File::current_directory();
-  ScopeExit at_exit([=] { File::set_current_directory(saved_dir); });
-
-  FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
-  const auto ctype = fido_callout_.packet_config_for(route_to).compression_type;
-
-  if (ctype == "PKT") {
-    // No bundles, only packet files.
-    auto in = FilePath(dirs.temp_outbound_dir(), fido_packet_name);
-    auto out = FilePath(dirs.outbound_dir(), fido_packet_name);
-    if (File::Exists(out)) {
-      LOG(INFO) << "Outbound dir already has a packet named: " << fido_packet_name;
-      auto newname = rename_fido_packet(dirs.outbound_dir(), fido_packet_name);
-      LOG(INFO) << "Renamed to: " << newname;
-      out = FilePath(dirs.outbound_dir(), newname);
-    }
-    if (!File::Move(in, out)) {
-      LOG(ERROR) << "Unable to move packet file into outbound dir. file: " << fido_packet_name;
-      return false;
-    }
-    LOG(INFO) << "Created bundle(packet): " << FilePath(dirs.outbound_dir(), fido_packet_name);
-    out_bundle_name = fido_packet_name;
-    return true;
-  }
-
-  FidoAddress orig(net_.fido.fido_address);
-  for (auto i = 0; i < 35; i++) {
-    auto bname = bundle_name(orig, route_to, dow, i);
-    if (File::Exists(FilePath(dirs.outbound_dir(), bname))) {
-      VLOG(1) << "Skipping candidate bundle: " << FilePath(dirs.outbound_dir(), bname);
-      // Already exists.
-      continue;
-    }
-    // We should actually change to the temp outbound dir so that
-    // we won't add paths.
-    File::set_current_directory(dirs.temp_outbound_dir());
-    LOG(INFO) << "Changed directory to: " << dirs.temp_outbound_dir();
-    const auto& arc = find_arc(arcs, ctype);
-    const auto zip_cmd =
-        arc_stuff_in(arc.arca, FilePath(dirs.outbound_dir(), bname).string(), fido_packet_name);
-    LOG(INFO) << "Command: " << zip_cmd;
-    if (0 != system(zip_cmd.c_str())) {
-      LOG(ERROR) << "Failed executing: " << zip_cmd;
-      return false;
-    }
-    // Need to be back home.
-    LOG(INFO) << "Changed directory back to: " << saved_dir;
-    File::set_current_directory(saved_dir);
-    out_bundle_name = bname;
-
-    LOG(INFO) << "Created bundle: " << FilePath(dirs.outbound_dir(), bname);
-    if (!File::Remove(FilePath(dirs.temp_outbound_dir(), fido_packet_name))) {
-      LOG(ERROR) << "Error removing packet: "
-                 << FilePath(dirs.temp_outbound_dir(), fido_packet_name);
-    }
-    return true;
-  }
-  return false;
-}
-
 static bool CleanupWWIVName(std::string& sender_name) {
   // #NN, @NODE or (FIDO_ADDR)
   const auto idx = sender_name.find_first_of("#@(");
@@ -598,203 +516,382 @@ static std::string remove_fido_addr(string to_user) {
   return to_user_new;
 }
 
-bool NetworkF::create_ftn_packet(const FidoAddress& dest, const FidoAddress& route_to,
-                                 const Packet& wwivnet_packet, std::string& fido_packet_name) {
+bool NetworkF::create_ftn_message(const FidoAddress& dest, const Packet& wwivnet_packet,
+                                  FidoPackedMessage& out) {
+  VLOG(1) << "create_ftn_message: dest: " << dest;
 
-  VLOG(1) << "create_ftn_packet: dest: " << dest << "; route: " << route_to;
+  const FidoAddress from_address(net_.fido.fido_address);
+  auto is_email = wwivnet_packet.nh.main_type == main_type_email ||
+                  wwivnet_packet.nh.main_type == main_type_email_name;
+  const auto raw_text = wwivnet_packet.text();
+  auto iter = raw_text.cbegin();
 
-  FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
+  std::string subtype;
+  std::string to_user_name;
+  // or we can put code in for email here??
 
-  FidoAddress from_address(net_.fido.fido_address);
-  for (auto tries = 0; tries < 10; tries++) {
-    auto now = DateTime::now();
-    File file(FilePath(dirs.temp_outbound_dir(), packet_name(now)));
-    if (!file.Open(File::modeCreateFile | File::modeExclusive | File::modeReadWrite |
-                       File::modeBinary,
-                   File::shareDenyReadWrite)) {
-      LOG(INFO) << "Will try again: Unable to create packet file: " << file;
-      sleep_for(std::chrono::seconds(1));
-      continue;
-    }
+  if (is_email) {
+    to_user_name = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+    CleanupWWIVName(to_user_name);
+  } else {
+    subtype = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+  }
+  auto title = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+  auto sender_name = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+  auto date_string = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+
+  // TODO(rushfan: These next 2 here should be done differently. We should
+  // split the message here and look for these in all lines.  For the By:
+  // line we just want to remove it since it's useless.
+  if (!is_email) {
+    to_user_name = get_fido_addr(raw_text, iter, {'\0', '\r', '\n'}, 80);
+  }
 
-    auto pw = fido_callout_.packet_config_for(route_to).packet_password;
-    auto header = CreateType2PlusPacketHeader(from_address, route_to, now, pw);
+  if (!is_email && iter_starts_with(raw_text, iter, "BY: ")) {
+    // Skip BY line.
+    get_message_field(raw_text, iter, {'\r', '\n'}, 80);
+  }
 
-    if (!write_fido_packet_header(file, header)) {
-      LOG(ERROR) << "Error writing packet header.";
-      return false;
+  fido_variable_length_header_t vh{};
+  vh.date_time = daten_to_fido(wwivnet_packet.nh.daten);
+  // Clean up sender name.
+  CleanupWWIVName(sender_name);
+  vh.from_user_name = sender_name;
+  vh.subject = title;
+  if (!to_user_name.empty()) {
+    auto username_only = remove_fido_addr(to_user_name);
+    vh.to_user_name = properize(username_only);
+  } else {
+    vh.to_user_name = "All";
+  }
+
+  auto msgid = FtnMessageDupe::GetMessageIDFromWWIVText(raw_text);
+  auto needs_msgid = false;
+  if (msgid.empty()) {
+    // Create a new MSGID if the BBS didn't put one in there already.
+    // We'll do this for emails too since Mystic needs this for a proper
+    // reply to address. Otherwise we'd just do it for conference mail.
+    msgid = dupe().CreateMessageID(from_address);
+    needs_msgid = true;
+  }
+
+  // TODO(rushfan): need to add in INTL for netmails, and all that nonsense.
+  // We probably have other stuff we need to add for echomail too.
+  std::ostringstream text;
+  if (is_email) {
+    text << "\001"
+         << "INTL " << dest.as_string(false, false) << " "
+         << from_address.as_string(false, false) << "\r";
+    if (from_address.point()) {
+      // FMPT (FROM POINT) just has the point address
+      text << "\001" << "FMPT " << from_address.point() << "\r";
     }
+    if (dest.point()) {
+      // TOPT (TO POINT) just has the point address
+      text << "\001" << "TOPT " << dest.point() << "\r";
+    }
+  } else {
+    text << "AREA:" << subtype << "\r";
+  }
+  // As of 5.3, the PID is added by the BBS software.
+  // text << "\001PID: WWIV " << full_version() << "\r";
+  text << "\001TID: WWIV NET" << full_version() << "\r";
+  if (needs_msgid && !is_email) {
+    text << "\001MSGID: " << msgid << "\r";
+  }
+  // Implement FTS-5003. [http://ftsc.org/docs/fts-5003.001]
+  // All outbound WWIV messages are always CP437.
+  text << "\001CHRS: CP437 2\r";
+
+  // Implement FRL-1004. [http://ftsc.org/docs/frl-1004.002]
+  text << "\001TZUTC: " << tz_offset_from_utc(clock_.Now()) << "\r";
+
+  // TODO(rushfan): We should rip through the bbs_text here.
+  // and add in any special kludges like ^AREPLY here.
+  // Add the text from the message (as entered from the BBS).
+  wwiv_to_fido_options opts{};
+  opts.colors = colors_;
+  opts.wwiv_heart_color_codes = net_.fido.wwiv_heart_color_codes;
+  opts.wwiv_pipe_color_codes = net_.fido.wwiv_pipe_color_codes;
+  auto bbs_text = WWIVToFidoText(string(iter, raw_text.end()), opts);
+  text << bbs_text;
+
+  // Now we need tear + origin lines
+  auto origin_line = net_.fido.origin_line;
+  if (origin_line.empty()) {
+    // default origin line to system name if it doesn't exist.
+    origin_line = net_cmdline_.config().system_name();
+  }
 
-    auto is_email = wwivnet_packet.nh.main_type == main_type_email ||
-                    wwivnet_packet.nh.main_type == main_type_email_name;
-    const auto raw_text = wwivnet_packet.text();
-    auto iter = raw_text.cbegin();
+  if (from_address.point() == 0) {
+    text << "\r"
+         << "--- WWIV " << full_version() << "\r"
+         << " * Origin: " << origin_line << " (" << to_zone_net_node(from_address) << ")\r";
+  } else {
+    text << "\r"
+         << "--- WWIV " << full_version() << "\r"
+         << " * Origin: " << origin_line << " (" << to_zone_net_node_point(from_address) << ")\r";
+  }
+  // Finally we need SEEN-BY and PATH lines for routing.
+  if (!is_email) {
+    // TODO(rushfan): Add the nodes we are exporting this to.
+    text << "SEEN-BY: " << to_net_node(from_address) << "\r\r";
+    // Also we need to add a ^APATH: line here, starting with us.
+  }
 
-    std::string subtype;
-    std::string to_user_name;
-    // or we can put code in for email here??
+  vh.text = text.str();
 
-    if (is_email) {
-      to_user_name = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
-      CleanupWWIVName(to_user_name);
-    } else {
-      subtype = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
-    }
-    auto title = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
-    auto sender_name = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
-    auto date_string = get_message_field(raw_text, iter, {'\0', '\r', '\n'}, 80);
+  fido_packed_message_t nh{};
+  nh.message_type = 2;
+  nh.attribute = 0;
+  nh.cost = 0;
+  nh.orig_net = from_address.net();
+  nh.orig_node = from_address.node();
+  nh.dest_net = dest.net();
+  nh.dest_node = dest.node();
+  nh.attribute = MSGLOCAL;
 
-    // TODO(rushfan: These next 2 here should be done differently. We should
-    // split the message here and look for these in all lines.  For the By:
-    // line we just want to remove it since it's useless.
-    if (!is_email) {
-      to_user_name = get_fido_addr(raw_text, iter, {'\0', '\r', '\n'}, 80);
-    }
+  if (wwivnet_packet.nh.main_type == main_type_email_name) {
+    nh.attribute |= MSGPRIVATE;
+  }
 
-    if (!is_email && iter_starts_with(raw_text, iter, "BY: ")) {
-      // Skip BY line.
-      get_message_field(raw_text, iter, {'\r', '\n'}, 80);
-    }
+  out = FidoPackedMessage(nh, vh);
+  return true;
+}
 
-    fido_variable_length_header_t vh{};
-    vh.date_time = daten_to_fido(wwivnet_packet.nh.daten);
-    // Clean up sender name.
-    CleanupWWIVName(sender_name);
-    vh.from_user_name = sender_name;
-    vh.subject = title;
-    if (!to_user_name.empty()) {
-      auto username_only = remove_fido_addr(to_user_name);
-      vh.to_user_name = properize(username_only);
-    } else {
-      vh.to_user_name = "All";
-    }
+static bool write_packet_file(const std::filesystem::path& path, const std::string& data) {
+  File file(path);
+  if (!file.Open(File::modeCreateFile | File::modeExclusive | File::modeReadWrite |
+                     File::modeBinary,
+                 File::shareDenyReadWrite)) {
+    LOG(ERROR) << "Unable to create packet file: " << file;
+    return false;
+  }
+  const auto num_written = file.Write(data);
+  if (num_written != ssize(data)) {
+    LOG(ERROR) << "short write to packet, wrote " << num_written << "; expected: " << data.size();
+    return false;
+  }
+  return true;
+}
 
-    FtnMessageDupe dupe(net_cmdline_.config());
-    auto msgid = FtnMessageDupe::GetMessageIDFromWWIVText(raw_text);
-    auto needs_msgid = false;
-    if (msgid.empty()) {
-      // Create a new MSGID if the BBS didn't put one in there already.
-      // We'll do this for emails too since Mystic needs this for a proper
-      // reply to address. Otherwise we'd just do it for conference mail.
-      msgid = dupe.CreateMessageID(from_address);
-      needs_msgid = true;
+std::string NetworkF::next_packet_name(const std::filesystem::path& dir) {
+  auto dt = DateTime::now();
+  for (auto i = 0; i < 1000; i++) {
+    auto name = packet_name(dt);
+    if (!contains(packet_names_, name) && !File::Exists(FilePath(dir, name))) {
+      packet_names_.insert(name);
+      return name;
     }
+    dt += std::chrono::seconds(1);
+  }
+  LOG(ERROR) << "Unable to find an unused packet name in: " << dir;
+  return {};
+}
 
-    // TODO(rushfan): need to add in INTL for netmails, and all that nonsense.
-    // We probably have other stuff we need to add for echomail too.
-    std::ostringstream text;
-    if (is_email) {
-      text << "\001"
-           << "INTL " << dest.as_string(false, false) << " "
-           << from_address.as_string(false, false) << "\r";
-      if (from_address.point()) {
-        // FMPT (FROM POINT) just has the point address
-        text << "\001" << "FMPT " << from_address.point() << "\r";
-      }
-      if (dest.point()) {
-        // TOPT (TO POINT) just has the point address
-        text << "\001" << "TOPT " << dest.point() << "\r";
-      }
-    } else {
-      text << "AREA:" << subtype << "\r";
-    }
-    // As of 5.3, the PID is added by the BBS software.
-    // text << "\001PID: WWIV " << full_version() << "\r";
-    text << "\001TID: WWIV NET" << full_version() << "\r";
-    if (needs_msgid && !is_email) {
-      text << "\001MSGID: " << msgid << "\r";
-    }
-    // Implement FTS-5003. [http://ftsc.org/docs/fts-5003.001]
-    // All outbound WWIV messages are always CP437.
-    text << "\001CHRS: CP437 2\r";
-
-    // Implement FRL-1004. [http://ftsc.org/docs/frl-1004.002]
-    text << "\001TZUTC: " << tz_offset_from_utc(clock_.Now()) << "\r";
-
-    // TODO(rushfan): We should rip through the bbs_text here.
-    // and add in any special kludges like ^AREPLY here.
-    // Add the text from the message (as entered from the BBS).
-    wwiv_to_fido_options opts{};
-    opts.colors = colors_;
-    opts.wwiv_heart_color_codes = net_.fido.wwiv_heart_color_codes;
-    opts.wwiv_pipe_color_codes = net_.fido.wwiv_pipe_color_codes;
-    auto bbs_text = WWIVToFidoText(string(iter, raw_text.end()), opts);
-    text << bbs_text;
-
-    // Now we need tear + origin lines
-    auto origin_line = net_.fido.origin_line;
-    if (origin_line.empty()) {
-      // default origin line to system name if it doesn't exist.
-      origin_line = net_cmdline_.config().system_name();
-    }
+NetworkF::outbound_bundle_t& NetworkF::bundle_for(const FidoAddress& route_to) {
+  const auto key = route_to.as_string();
+  auto it = bundles_.find(key);
+  if (it == std::end(bundles_)) {
+    const auto& packet_config = fido_callout_.packet_config_for(route_to);
+    outbound_bundle_t b;
+    b.route_to = route_to;
+    b.compression_type = ToStringUpperCase(packet_config.compression_type);
+    b.packet_password = packet_config.packet_password;
+    it = bundles_.emplace(key, std::move(b)).first;
+  }
+  return it->second;
+}
 
-    if (from_address.point() == 0) {
-      text << "\r"
-           << "--- WWIV " << full_version() << "\r"
-           << " * Origin: " << origin_line << " (" << to_zone_net_node(from_address) << ")\r";
-    } else {
-      text << "\r"
-           << "--- WWIV " << full_version() << "\r"
-           << " * Origin: " << origin_line << " (" << to_zone_net_node_point(from_address) << ")\r";
+bool NetworkF::open_bundle(outbound_bundle_t& b) {
+  if (!b.bundlename.empty()) {
+    return true;
+  }
+  const FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
+  const FidoAddress orig(net_.fido.fido_address);
+  const auto dow = DateTime::now().dow();
+  for (auto i = 0; i < 35; i++) {
+    auto bname = bundle_name(orig, b.route_to, dow, i);
+    const auto path = FilePath(dirs.outbound_dir(), bname);
+    if (File::Exists(path)) {
+      VLOG(1) << "Skipping candidate bundle: " << path;
+      // Already exists.
+      continue;
     }
-    // Finally we need SEEN-BY and PATH lines for routing.
-    if (!is_email) {
-      // TODO(rushfan): Add the nodes we are exporting this to.
-      text << "SEEN-BY: " << to_net_node(from_address) << "\r\r";
-      // Also we need to add a ^APATH: line here, starting with us.
+    if (b.compression_type == "ZIP") {
+      auto zip = std::make_unique<files::ZipWriter>(path);
+      if (!zip->Create()) {
+        continue;
+      }
+      b.zip = std::move(zip);
     }
+    LOG(INFO) << "Created bundle: " << path;
+    b.bundlename = bname;
+    b.files.push_back(bname);
+    return true;
+  }
+  LOG(ERROR) << "Unable to find an unused bundle name for: " << b.route_to;
+  return false;
+}
 
-    vh.text = text.str();
-
-    fido_packed_message_t nh{};
-    nh.message_type = 2;
-    nh.attribute = 0;
-    nh.cost = 0;
-    nh.orig_net = from_address.net();
-    nh.orig_node = from_address.node();
-    nh.dest_net = dest.net();
-    nh.dest_node = dest.node();
-    nh.attribute = MSGLOCAL;
-
-    if (wwivnet_packet.nh.main_type == main_type_email_name) {
-      nh.attribute |= MSGPRIVATE;
-    }
+void NetworkF::fail_bundle(outbound_bundle_t& b) {
+  LOG(ERROR) << "    ! ERROR Failed to create FTN bundle for " << b.route_to << "; writing "
+             << b.sources.size() << " messages to dead.net";
+  for (const auto& p : b.sources) {
+    write_wwivnet_packet(DEAD_NET, net_, p);
+  }
+  b.sources.clear();
+  b.packet.clear();
+  if (b.zip) {
+    // Everything in the zip just went to dead.net, so start over in a new one.
+    const auto path = b.zip->path();
+    b.zip->Close();
+    b.zip.reset();
+    File::Remove(path);
+    b.files.erase(std::remove(std::begin(b.files), std::end(b.files), b.bundlename),
+                  std::end(b.files));
+    b.bundlename.clear();
+  }
+}
 
-    FidoPackedMessage p(nh, vh);
-    if (!write_packed_message(file, p)) {
-      LOG(ERROR) << "Error writing packed message.";
+bool NetworkF::write_ftn_packet(outbound_bundle_t& b) {
+  if (b.packet.empty()) {
+    return true;
+  }
+  const FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
+  const auto now = DateTime::now();
+  auto header = CreateType2PlusPacketHeader(FidoAddress(net_.fido.fido_address), b.route_to, now,
+                                            b.packet_password);
+  std::string data(reinterpret_cast<const char*>(&header), sizeof(packet_header_2p_t));
+  data.append(b.packet);
+  // End of packet.
+  data.append(2, '\0');
+  b.packet.clear();
+
+  if (b.compression_type == "PKT") {
+    // No bundles, only packet files.
+    const auto name = next_packet_name(dirs.outbound_dir());
+    if (name.empty() || !write_packet_file(FilePath(dirs.outbound_dir(), name), data)) {
+      fail_bundle(b);
       return false;
     }
+    LOG(INFO) << "Created bundle(packet): " << FilePath(dirs.outbound_dir(), name);
+    b.files.push_back(name);
+    b.sources.clear();
+    return true;
+  }
 
-    // Since we wrote the packed message, let's add it to the
-    // duplicate message database if it's a post.
-    if (!is_email) {
-      dupe.add(p);
+  const auto name = next_packet_name(dirs.temp_outbound_dir());
+  if (name.empty() || !open_bundle(b)) {
+    fail_bundle(b);
+    return false;
+  }
+  if (b.zip) {
+    if (!b.zip->Add(name, data, now)) {
+      fail_bundle(b);
+      return false;
     }
-    fido_packet_name = file.path().filename().string();
+    // The messages are only safe once the zip is closed, so keep b.sources.
+    LOG(INFO) << "Added packet: " << name << " to bundle: " << b.zip->path();
     return true;
   }
-  return false;
+
+  // Anything other than ZIP uses the archiver from archiver.dat.
+  const auto arcs = read_arcs(net_cmdline_.config().datadir());
+  if (arcs.empty()) {
+    LOG(ERROR) << "No archivers defined!";
+    fail_bundle(b);
+    return false;
+  }
+  const auto packet_path = FilePath(dirs.temp_outbound_dir(), name);
+  if (!write_packet_file(packet_path, data)) {
+    fail_bundle(b);
+    return false;
+  }
+  const auto saved_dir = File::current_directory();
+  ScopeExit at_exit([=] { File::set_current_directory(saved_dir); });
+  // We should actually change to the temp outbound dir so that
+  // we won't add paths.
+  File::set_current_directory(dirs.temp_outbound_dir());
+  LOG(INFO) << "Changed directory to: " << dirs.temp_outbound_dir();
+  const auto& arc = find_arc(arcs, b.compression_type);
+  const auto zip_cmd =
+      arc_stuff_in(arc.arca, FilePath(dirs.outbound_dir(), b.bundlename).string(), name);
+  LOG(INFO) << "Command: " << zip_cmd;
+  const auto result = system(zip_cmd.c_str());
+  // Need to be back home.
+  File::set_current_directory(saved_dir);
+  if (!File::Remove(packet_path)) {
+    LOG(ERROR) << "Error removing packet: " << packet_path;
+  }
+  if (result != 0) {
+    LOG(ERROR) << "Failed executing: " << zip_cmd;
+    fail_bundle(b);
+    return false;
+  }
+  b.sources.clear();
+  return true;
 }
 
-bool NetworkF::create_ftn_packet_and_bundle(const FidoAddress& dest, const FidoAddress& route_to,
-                                            const Packet& p, std::string& bundlename) {
+bool NetworkF::export_ftn_message(const FidoAddress& dest, const FidoAddress& route_to,
+                                  const Packet& p) {
   LOG(INFO) << "Creating packet for subscriber: " << dest << "; route_to: " << route_to;
-  const FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
-  std::string fido_packet_name;
-  if (!create_ftn_packet(dest, route_to, p, fido_packet_name)) {
+  FidoPackedMessage msg;
+  if (!create_ftn_message(dest, p, msg)) {
     LOG(ERROR) << "    ! ERROR Failed to create FTN packet; writing to dead.net";
     write_wwivnet_packet(DEAD_NET, net_, p);
     return false;
   }
-  LOG(INFO) << "Created packet: " << FilePath(dirs.temp_outbound_dir(), fido_packet_name);
 
-  if (!create_ftn_bundle(route_to, fido_packet_name, bundlename)) {
-    LOG(ERROR) << "    ! ERROR Failed to create FTN bundle; writing to dead.net";
-    write_wwivnet_packet(DEAD_NET, net_, p);
-    return false;
+  auto& b = bundle_for(route_to);
+  append_packed_message(b.packet, msg);
+  b.sources.push_back(p);
+  // Since we wrote the packed message, let's add it to the
+  // duplicate message database if it's a post.
+  if (p.nh.main_type != main_type_email && p.nh.main_type != main_type_email_name) {
+    dupe().add(msg);
   }
-  return true;
+  if (b.packet.size() < kMaxFtnPacketSize) {
+    return true;
+  }
+  return write_ftn_packet(b);
+}
+
+bool NetworkF::close_bundles() {
+  const FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
+  auto ok = true;
+  for (auto& [_, b] : bundles_) {
+    if (!write_ftn_packet(b)) {
+      ok = false;
+    }
+    if (b.zip) {
+      if (b.zip->Close()) {
+        b.sources.clear();
+      } else {
+        fail_bundle(b);
+        ok = false;
+      }
+      b.zip.reset();
+    }
+
+    // Skip bundles that the archiver never got to create.
+    std::vector<std::string> bundlenames;
+    for (const auto& f : b.files) {
+      if (File::Exists(FilePath(dirs.outbound_dir(), f))) {
+        bundlenames.push_back(f);
+      }
+    }
+    if (bundlenames.empty()) {
+      continue;
+    }
+    const auto route_packet_config = fido_callout_.packet_config_for(b.route_to);
+    if (!CreateNetmailAttachOrFloFile(b.route_to, bundlenames, route_packet_config)) {
+      ok = false;
+    }
+  }
+  bundles_.clear();
+  packet_names_.clear();
+  return ok;
 }
 
 static std::string NextNetmailFilePath(const std::string& dir) {
@@ -885,7 +982,7 @@ static bool CreateFidoNetAttachNetMail(const FidoAddress& orig, const FidoAddres
 }
 
 bool NetworkF::CreateFloFile(const wwiv::sdk::fido::FidoAddress& dest,
-                             const std::string& bundlename,
+                             const std::vector<std::string>& bundlenames,
                              const fido_packet_config_t& packet_config) {
   FidoAddress orig(net_.fido.fido_address);
   const FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
@@ -901,9 +998,14 @@ bool NetworkF::CreateFloFile(const wwiv::sdk::fido::FidoAddress& dest,
       LOG(ERROR) << "Unable to open FLO file: " << flo_file;
       return false;
     }
-    const auto num_written =
-        flo_file.WriteLine(StrCat("^", FilePath(dirs.outbound_dir(), bundlename).string()));
-    return num_written > 0;
+    for (const auto& bundlename : bundlenames) {
+      const auto num_written =
+          flo_file.WriteLine(StrCat("^", FilePath(dirs.outbound_dir(), bundlename).string()));
+      if (num_written <= 0) {
+        return false;
+      }
+    }
+    return true;
 
   } catch (const semaphore_not_acquired& e) {
     LOG(ERROR) << "Unable to create BSY file semaphore trying to create FLO file.";
@@ -932,13 +1034,20 @@ bool NetworkF::CreateNetmailAttach(const FidoAddress& dest, const std::string& b
   return true;
 }
 
-bool NetworkF::CreateNetmailAttachOrFloFile(const FidoAddress& dest, const std::string& bundlename,
+bool NetworkF::CreateNetmailAttachOrFloFile(const FidoAddress& dest,
+                                            const std::vector<std::string>& bundlenames,
                                             const fido_packet_config_t& packet_config) {
   if (net_.fido.mailer_type == fido_mailer_t::attach) {
-    return CreateNetmailAttach(dest, bundlename, packet_config);
+    auto ok = true;
+    for (const auto& bundlename : bundlenames) {
+      if (!CreateNetmailAttach(dest, bundlename, packet_config)) {
+        ok = false;
+      }
+    }
+    return ok;
   }
   if (net_.fido.mailer_type == fido_mailer_t::flo) {
-    return CreateFloFile(dest, bundlename, packet_config);
+    return CreateFloFile(dest, bundlenames, packet_config);
   }
   LOG(ERROR) << "Unknown mailer type: " << static_cast<int>(net_.fido.mailer_type);
   return false;
@@ -958,8 +1067,7 @@ static FidoAddress find_route_to(const FidoAddress& dest, const FidoCallout& cal
   return a;
 }
 
-bool NetworkF::export_main_type_new_post(std::set<std::string>& bundles, Packet& p) {
-  // Lame implementation that creates 1 file per message.
+bool NetworkF::export_main_type_new_post(Packet& p) {
   auto subtype = get_subtype_from_packet_text(p.text());
   LOG(INFO) << "Creating packet for subtype: " << subtype;
 
@@ -968,28 +1076,16 @@ bool NetworkF::export_main_type_new_post(std::set<std::string>& bundles, Packet&
     LOG(INFO) << "There are no subscribers on echo: '" << subtype << "'. Nothing to do!";
   }
   for (const auto& sub : subscribers) {
-    std::string bundlename;
     auto packet_config = fido_callout_.packet_config_for(sub);
     auto route_to = find_route_to(sub, fido_callout_, packet_config);
-    if (!create_ftn_packet_and_bundle(sub, route_to, p, bundlename)) {
-      continue;
-    }
-    if (!contains(bundles, bundlename)) {
-      // We only want to attach the bundle (or add it to the flo file)
-      // one time, so skip ones that have already been done.
-      bundles.insert(bundlename);
-      auto route_packet_config = fido_callout_.packet_config_for(route_to);
-      CreateNetmailAttachOrFloFile(route_to, bundlename, route_packet_config);
-    }
+    export_ftn_message(sub, route_to, p);
   }
   return true;
 }
 
-bool NetworkF::export_main_type_email_name(std::set<std::string>& bundles, Packet& p) {
-  // Lame implementation that creates 1 file per message.
+bool NetworkF::export_main_type_email_name(Packet& p) {
   LOG(INFO) << "Creating packet for netmail.";
 
-  std::string bundlename;
   auto it = p.text().begin();
   const auto to = get_message_field(p.text(), it, {0}, 80);
   const auto dest = get_address_from_single_line(to);
@@ -1002,22 +1098,45 @@ bool NetworkF::export_main_type_email_name(std::set<std::string>& bundles, Packe
   // right with net mail
   const auto packet_config = fido_callout_.packet_config_for(dest);
   const FidoAddress route_to = find_route_to(dest, fido_callout_, packet_config);
-  if (create_ftn_packet_and_bundle(dest, route_to, p, bundlename)) {
-    if (!contains(bundles, bundlename)) {
-      // We only want to attach the bundle (or add it to the flo file)
-      // one time, so skip ones that have already been done.
-      bundles.insert(bundlename);
-      CreateNetmailAttachOrFloFile(route_to, bundlename, packet_config);
-    }
-  }
+  export_ftn_message(dest, route_to, p);
   return true;
 }
 
 sdk::FtnMessageDupe& NetworkF::dupe() {
-  if (!dupe_) {
-    dupe_ = std::make_unique<wwiv::sdk::FtnMessageDupe>(net_cmdline_.config());
+  return stage_.dupe();
+}
+
+bool NetworkF::export_packets(PacketReader& reader, int& num_packets_processed) {
+  for (;;) {
+    auto [view, response] = reader.Next();
+    if (response == ReadPacketResponse::END_OF_FILE) {
+      return true;
+    }
+    if (response == ReadPacketResponse::ERROR) {
+      return false;
+    }
+    // If we got here, we had a packet to process.
+    ++num_packets_processed;
+
+    if (view.nh.main_type == main_type_new_post) {
+      auto p = view.ToPacket();
+      if (!export_main_type_new_post(p)) {
+        LOG(ERROR) << "Error exporting post.";
+      }
+    } else if (view.nh.main_type == main_type_email_name) {
+      auto p = view.ToPacket();
+      if (!export_main_type_email_name(p)) {
+        LOG(ERROR) << "Error exporting email.";
+      }
+    } else {
+      LOG(ERROR) << "    ! ERROR Unhandled type: '" << main_type_name(view.nh.main_type)
+                 << "'; writing to dead.net";
+      // Let's write it to dead.net_
+      if (!write_wwivnet_packet(DEAD_NET, net_, view)) {
+        LOG(ERROR) << "Error writing to dead.net";
+      }
+    }
   }
-  return *dupe_;
 }
 
 bool NetworkF::Run() {
@@ -1045,7 +1164,6 @@ bool NetworkF::Run() {
 
   FtnDirectories dirs(net_cmdline_.config().root_directory(), net_);
   if (cmd == "import") {
-    std::unique_ptr<FtnMessageDupe> dupe;
     const std::vector<std::string> extensions{"su?", "mo?", "tu?", "we?",
                                               "th?", "fr?", "sa?", "pkt"};
     for (const auto& ext : extensions) {
@@ -1057,53 +1175,53 @@ bool NetworkF::Run() {
     }
   } else if (cmd == "export") {
     const auto sfilename = StrCat("s", FTN_FAKE_OUTBOUND_NODE, ".net");
-    if (!File::Exists(FilePath(net_.dir, sfilename))) {
-      LOG(INFO) << "No file '" << sfilename << "' exists to be exported to a FTN packet.";
-      return false;
-    }
-
     // Packet file is created by us for sure.
-    File f(FilePath(net_.dir, sfilename));
-    if (!f.Open(File::modeBinary | File::modeReadOnly)) {
-      LOG(ERROR) << "Unable to open file: " << net_.dir << sfilename;
+    const auto path = FilePath(net_.dir, sfilename);
+    // Anything already in the file came first, so is exported before the
+    // packets network1 handed to us in memory.
+    auto held = stage_.spool().Take(sfilename);
+    const auto have_file = File::Exists(path);
+    if (!have_file && held.empty()) {
+      LOG(INFO) << "No file '" << sfilename << "' exists to be exported to a FTN packet.";
       return false;
     }
 
-    auto done = false;
-    std::set<std::string> bundles;
-    while (!done) {
-      auto [p, response] = read_packet(f, true);
-      if (response == ReadPacketResponse::END_OF_FILE) {
-        // Delete the packet.
-        f.Close();
-        if (net_cmdline_.skip_delete()) {
-          backup_file(f.full_pathname());
-        }
-        File::Remove(f.path());
-        break;
+    // Messages are written into one bundle per route_to address, which are
+    // only closed and added to the FLO files once we've read them all.
+    if (have_file) {
+      PacketReader reader(path, true);
+      if (!reader.IsOpen()) {
+        LOG(ERROR) << "Unable to open file: " << net_.dir << sfilename;
+        stage_.spool().PutBack(sfilename, std::move(held));
+        return false;
       }
-      if (response == ReadPacketResponse::ERROR) {
+      if (!export_packets(reader, num_packets_processed)) {
+        close_bundles();
+        stage_.spool().PutBack(sfilename, std::move(held));
         return false;
       }
-      // If we got here, we had a packet to process.
-      ++num_packets_processed;
+    }
+    auto held_ok = true;
+    if (!held.empty()) {
+      // A copy, so that they can be written to the file if this fails.
+      PacketReader reader(held, true);
+      held_ok = export_packets(reader, num_packets_processed);
+    }
 
-      if (p.nh.main_type == main_type_new_post) {
-        if (!export_main_type_new_post(bundles, p)) {
-          LOG(ERROR) << "Error exporting post.";
-        }
-      } else if (p.nh.main_type == main_type_email_name) {
-        if (!export_main_type_email_name(bundles, p)) {
-          LOG(ERROR) << "Error exporting email.";
-        }
-      } else {
-        LOG(ERROR) << "    ! ERROR Unhandled type: '" << main_type_name(p.nh.main_type)
-                   << "'; writing to dead.net";
-        // Let's write it to dead.net_
-        if (!write_wwivnet_packet(DEAD_NET, net_, p)) {
-          LOG(ERROR) << "Error writing to dead.net";
-        }
+    // Anything that didn't make it into a bundle went to dead.net, so the
+    // packet may be deleted either way.
+    if (!close_bundles()) {
+      LOG(ERROR) << "Error closing FTN bundles.";
+    }
+    if (have_file) {
+      if (net_cmdline_.skip_delete()) {
+        backup_file(path);
       }
+      File::Remove(path);
+    }
+    if (!held_ok) {
+      stage_.spool().PutBack(sfilename, std::move(held));
+      return false;
     }
 
   } else {
@@ -1114,38 +1232,16 @@ bool NetworkF::Run() {
   return num_packets_processed > 0;
 }
 
-} // namespace wwiv::net::networkf
-
-using namespace wwiv::net::networkf;
-
-int main(int argc, char** argv) {
-
-#ifndef _WIN32
-  // Set this to the default handling, since when wwivd invokes
-  // this (and wwivd ignores SIGCHLD).
-  signal(SIGCHLD, SIG_DFL);
-#endif // !_WIN32
-
-  LoggerConfig config(LogDirFromConfig);
-  Logger::Init(argc, argv, config);
-
-  CommandLine cmdline(argc, argv, "net");
-  const NetworkCommandLine net_cmdline_(cmdline, 'f');
+int networkf_main(const NetworkCommandLine& net_cmdline, StageContext& stage) {
   try {
-    ScopeExit at_exit(Logger::ExitLogger);
-    if (!net_cmdline_.IsInitialized() || net_cmdline_.cmdline().help_requested()) {
-      ShowHelp(net_cmdline_);
-      return 1;
-    }
-    const auto& net = net_cmdline_.network();
+    const auto& net = net_cmdline.network();
     if (net.type != network_type_t::ftn) {
       LOG(ERROR) << "NETWORKF is only for use on FTN type networks.";
-      ShowHelp(net_cmdline_);
       return 1;
     }
 
     VLOG(3) << "Reading bbsdata.net_..";
-    auto b = BbsListNet::ReadBbsDataNet(net.dir);
+    const auto& b = stage.bbslist();
     if (b.empty()) {
       LOG(ERROR) << "ERROR: Unable to read bbsdata.net_.";
       LOG(ERROR) << "       Do you need to run network3?";
@@ -1159,16 +1255,14 @@ int main(int argc, char** argv) {
       return 2;
     }
 
-    auto semaphore =
-        SemaphoreFile::try_acquire(net_cmdline_.semaphore_path(), net_cmdline_.semaphore_timeout());
     SystemClock clock{};
-    NetworkF nf(net_cmdline_, b, clock);
+    NetworkF nf(net_cmdline, stage, b, clock);
     return nf.Run() ? 0 : 2;
-  } catch (const semaphore_not_acquired& e) {
-    LOG(ERROR) << "ERROR: [network" << net_cmdline_.net_cmd()
-               << "]: Unable to Acquire Network Semaphore: " << e.what();
   } catch (const std::exception& e) {
     LOG(ERROR) << "ERROR: [networkf]: " << e.what();
   }
   return 2;
 }
+
+} // namespace wwiv::net::networkf
+
@@ -21,18 +21,27 @@
 #include "core/clock.h"
 #include "net_core/net_cmdline.h"
 #include "net_core/netdat.h"
+#include "net_core/stage_context.h"
 #include "sdk/bbslist.h"
 #include "sdk/fido/fido_callout.h"
 #include "sdk/net/ftn_msgdupe.h"
+#include "sdk/fido/fido_packets.h"
+#include "sdk/files/zip_writer.h"
+#include "sdk/net/packet_reader.h"
 #include "sdk/net/packets.h"
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace wwiv::net::networkf {
 
 class NetworkF final {
 public:
-  NetworkF(const NetworkCommandLine& cmdline, const sdk::BbsListNet& bbslist,
-           core::Clock& clock);
+  NetworkF(const NetworkCommandLine& cmdline, StageContext& stage,
+           const sdk::BbsListNet& bbslist, core::Clock& clock);
   ~NetworkF();
 
   bool Run();
@@ -46,47 +55,84 @@ private:
 
   int import_bundles(const std::string& dir, const std::string& mask);
 
-  bool create_ftn_bundle(const sdk::fido::FidoAddress& route_to, 
-                         const std::string& fido_packet_name, std::string& out_bundle_name);
-
-  // ReSharper disable once CppMemberFunctionMayBeConst
-  bool create_ftn_packet(const sdk::fido::FidoAddress& dest, const sdk::fido::FidoAddress& route_to,
-                         const sdk::net::Packet& wwivnet_packet,
-                         std::string& fido_packet_name);
-
-  bool create_ftn_packet_and_bundle(const sdk::fido::FidoAddress& dest,
-                                    const sdk::fido::FidoAddress& route_to,
-                                    const sdk::net::Packet& p,
-                                    std::string& bundlename);
+  bool create_ftn_message(const sdk::fido::FidoAddress& dest,
+                          const sdk::net::Packet& wwivnet_packet,
+                          sdk::fido::FidoPackedMessage& out);
+
+  // The bundle for one route_to address that messages are being exported to.
+  // Messages are added to an FTN packet in memory which is written to the
+  // bundle when it gets large or the bundle is closed.
+  struct outbound_bundle_t {
+    sdk::fido::FidoAddress route_to;
+    std::string compression_type;
+    std::string packet_password;
+    // Packed messages for the packet being built.
+    std::string packet;
+    // WWIVnet packets not yet safely in a bundle, for dead.net on failure.
+    std::vector<sdk::net::Packet> sources;
+    // Bundle being written in process, only used for ZIP.
+    std::unique_ptr<sdk::files::ZipWriter> zip;
+    // Current bundle in the outbound dir, empty until one is created.
+    std::string bundlename;
+    // Bundles (or packets for PKT) to add to the FLO file or attach.
+    std::vector<std::string> files;
+  };
+
+  std::string next_packet_name(const std::filesystem::path& dir);
+  outbound_bundle_t& bundle_for(const sdk::fido::FidoAddress& route_to);
+  bool open_bundle(outbound_bundle_t& b);
+  void fail_bundle(outbound_bundle_t& b);
+  bool write_ftn_packet(outbound_bundle_t& b);
+  bool export_ftn_message(const sdk::fido::FidoAddress& dest,
+                          const sdk::fido::FidoAddress& route_to, const sdk::net::Packet& p);
+  bool close_bundles();
 
   bool CreateFloFile(const wwiv::sdk::fido::FidoAddress& dest,
-                     const std::string& bundlename, const fido_packet_config_t& packet_config);
+                     const std::vector<std::string>& bundlenames,
+                     const fido_packet_config_t& packet_config);
 
   bool CreateNetmailAttach(const sdk::fido::FidoAddress& dest,
                            const std::string& bundlename,
                            const fido_packet_config_t& packet_config);
 
   bool CreateNetmailAttachOrFloFile(const sdk::fido::FidoAddress& dest,
-                                    const std::string& bundlename,
+                                    const std::vector<std::string>& bundlenames,
                                     const fido_packet_config_t& packet_config);
 
-  bool export_main_type_new_post(std::set<std::string>& bundles, sdk::net::Packet& p);
+  bool export_main_type_new_post(sdk::net::Packet& p);
+
+  bool export_main_type_email_name(sdk::net::Packet& p);
 
-  bool export_main_type_email_name(std::set<std::string>& bundles, sdk::net::Packet& p);
+  // Exports every packet in reader, returning false on a read error.
+  bool export_packets(sdk::net::PacketReader& reader, int& num_packets_processed);
 
   sdk::FtnMessageDupe& dupe();
 
   const NetworkCommandLine& net_cmdline_;
+  StageContext& stage_;
   const sdk::BbsListNet& bbslist_;
   core::Clock& clock_;
   const net_networks_rec& net_;
   sdk::fido::FidoCallout fido_callout_;
   NetDat netdat_;
 
-  std::unique_ptr<sdk::FtnMessageDupe> dupe_;
+  // Keyed by the route_to address.
+  std::map<std::string, outbound_bundle_t> bundles_;
+  // Packet names used during this run.
+  std::set<std::string> packet_names_;
   std::vector<int> colors_{7, 11, 14, 5, 31, 2, 12, 9, 6, 3};
 };
 
+/** Shows the networkf usage and exits. */
+void ShowHelp(const NetworkCommandLine& cmdline);
+
+/**
+ * Runs networkf for the network in net_cmdline, returning the exit code.
+ * The command (import or export) comes from the remaining arguments, and the
+ * caller must hold the networkf semaphore.
+ */
+int networkf_main(const NetworkCommandLine& net_cmdline, StageContext& stage);
+
 } // namespace wwiv::net::networkf
 
 #endif
@@ -16,7 +16,9 @@
 /*    language governing permissions and limitations under the License.   */
 /**************************************************************************/
 
-// WWIV5 NetworkC
+// WWIV5 NetworkT
+#include "networkt/networkt.h"
+
 #include "core/command_line.h"
 #include "core/file.h"
 #include "core/findfiles.h"
@@ -58,11 +60,6 @@ using namespace wwiv::stl;
 using namespace wwiv::os;
 using namespace wwiv::sdk::fido;
 
-static void ShowHelp(const NetworkCommandLine& cmdline) {
-  cout << cmdline.GetHelp() << endl;
-  exit(1);
-}
-
 bool process_ftn_tic(const Config& config, const net_networks_rec& net, bool save_tic_files, bool skip_delete) {
   if (!net.fido.process_tic) {
     LOG(WARNING) << "TIC processing disabled for network: " << net.name;
@@ -170,6 +167,12 @@ bool process_ftn_tic(const Config& config, const net_networks_rec& net, bool sav
   return true;
 }
 
+void AddNetworkTArgs(CommandLine& cmdline) {
+  cmdline.add_argument({"process_instance", "Also process pending files for BBS instance #", "0"});
+  cmdline.add_argument(BooleanCommandLineArgument{
+      "save_tic_files", 'S', "Save TIC files, do not delete TIC and archives", false});
+}
+
 int networkt_main(const NetworkCommandLine& net_cmdline) {
   try {
     const auto& net = net_cmdline.network();
@@ -205,28 +208,3 @@ int networkt_main(const NetworkCommandLine& net_cmdline) {
   }
   return 2;
 }
-
-int main(int argc, char** argv) {
-  LoggerConfig config(LogDirFromConfig);
-  Logger::Init(argc, argv, config);
-
-  ScopeExit at_exit(Logger::ExitLogger);
-  CommandLine cmdline(argc, argv, "net");
-  cmdline.add_argument({"process_instance", "Also process pending files for BBS instance #", "0"});
-  cmdline.add_argument(BooleanCommandLineArgument{
-      "save_tic_files", 'S', "Save TIC files, do not delete TIC and archives", false});
-
-  const NetworkCommandLine net_cmdline(cmdline, 't');
-  if (!net_cmdline.IsInitialized() || net_cmdline.cmdline().help_requested()) {
-    ShowHelp(net_cmdline);
-    return 1;
-  }
-  try {
-    auto semaphore = SemaphoreFile::try_acquire(net_cmdline.semaphore_path(),
-                                                net_cmdline.semaphore_timeout());
-    return networkt_main(net_cmdline);
-  } catch (const semaphore_not_acquired& e) {
-    LOG(ERROR) << "ERROR: [network" << net_cmdline.net_cmd()
-               << "]: Unable to Acquire Network Semaphore: " << e.what();
-  }
-}
\ No newline at end of file
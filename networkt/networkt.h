@@ -0,0 +1,34 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_NETWORKT_NETWORKT_H
+#define INCLUDED_NETWORKT_NETWORKT_H
+
+#include "core/command_line.h"
+#include "net_core/net_cmdline.h"
+
+/** Adds the arguments networkt accepts beyond the standard network ones. */
+void AddNetworkTArgs(wwiv::core::CommandLine& cmdline);
+
+/**
+ * Runs networkt for the network in net_cmdline, returning the exit code.
+ * The caller must hold the networkt semaphore.
+ */
+int networkt_main(const wwiv::net::NetworkCommandLine& net_cmdline);
+
+#endif
@@ -19,6 +19,7 @@
 #include "sdk/acs/acs.h"
 
 #include "core/stl.h"
+#include "sdk/acs/compiled_acs.h"
 #include "sdk/acs/eval.h"
 #include "sdk/acs/eval_error.h"
 #include "sdk/acs/uservalueprovider.h"
@@ -54,6 +55,12 @@ std::tuple<bool, std::vector<std::string>> check_acs(const Config& config, const
     return std::make_tuple(true, debug_lines);
   }
 
+  if (debug == acs_debug_t::none) {
+    // Nobody will see the debug lines, so use the cached compiled expression.
+    const auto compiled = CompiledAcs::get(expression);
+    return std::make_tuple(compiled->eval(config, user, eff_sl), std::vector<std::string>{});
+  }
+
   auto eval = make_eval(config, user, eff_sl, expression);
   const auto result = eval->eval();
   return std::make_tuple(result, eval->debug_info());
@@ -0,0 +1,457 @@
+/**************************************************************************/
+/*                                                                        */
+/*                            WWIV Version 5                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/**************************************************************************/
+#include "sdk/acs/compiled_acs.h"
+
+#include "core/log.h"
+#include "core/strings.h"
+#include "core/parser/lexer.h"
+#include "fmt/printf.h"
+#include "sdk/acs/eval_error.h"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+using namespace wwiv::core;
+using namespace wwiv::core::parser;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::acs {
+
+// Expressions come from menus and the sub/dir configs so there are normally
+// only a few hundred of them.  This keeps a bad caller from growing the cache
+// forever.
+static constexpr int kMaxCacheSize = 4096;
+
+static std::mutex cache_mu;
+static std::unordered_map<std::string, std::shared_ptr<const CompiledAcs>> cache;
+
+static std::tuple<std::string, std::string> split_obj_name(const std::string& name) {
+  const auto last = name.rfind('.');
+  if (last == std::string::npos) {
+    return std::make_tuple("", name);
+  }
+  return std::make_tuple(name.substr(0, last), name.substr(last + 1));
+}
+
+CompiledAcs::CompiledAcs(const std::string& expression) {
+  try {
+    Lexer l(expression);
+    if (!l.ok()) {
+      throw eval_error(fmt::format("Failed to lex expression: '{}'", expression));
+    }
+    Ast ast{};
+    if (!ast.parse(l)) {
+      throw eval_error(fmt::format("Failed to parse expression: '{}'.", expression));
+    }
+    auto* root = ast.root();
+    if (!root) {
+      throw eval_error(fmt::format("Failed to parse expression: '{}'.", expression));
+    }
+    if (root->ast_type() == AstType::ERROR) {
+      const auto* error_node = dynamic_cast<ErrorNode*>(root);
+      throw eval_error(error_node->message);
+    }
+    auto* expr = dynamic_cast<Expression*>(root);
+    if (!expr) {
+      throw eval_error(fmt::format("Failed to parse expression: '{}'.", expression));
+    }
+    if (auto* f = dynamic_cast<Factor*>(expr); f && f->factor_type() != FactorType::variable) {
+      // Eval only gives a result for a lone factor when it's a variable.
+      throw eval_error(fmt::format("Unable to find expression id: '{}'.", f->id()));
+    }
+    root_ = compile(expr);
+  } catch (const eval_error& e) {
+    error_text_ = e.what();
+    VLOG(1) << "CompiledAcs Error: " << error_text_;
+    nodes_.clear();
+    root_ = -1;
+  }
+}
+
+int CompiledAcs::compile_factor(const Factor* f) {
+  node_t n{};
+  switch (f->factor_type()) {
+  case FactorType::int_value:
+    n.value = scalar_t::of(f->int_value());
+    break;
+  case FactorType::string_val:
+    // The view is pointed at str when the constant is evaluated, since
+    // nodes_ may still move.
+    n.value.type = ValueType::string;
+    n.str = f->value();
+    break;
+  case FactorType::variable: {
+    auto [prefix, member] = split_obj_name(f->value());
+    if (prefix.empty() && (member == "true" || member == "false")) {
+      n.value = scalar_t::of(member == "true");
+      break;
+    }
+    if (prefix != "user") {
+      throw eval_error(fmt::format("No object named '{}' exists.", f->value()));
+    }
+    static const std::vector<std::pair<std::string, attr_t>> attrs{
+        {"sl", attr_t::sl},         {"dsl", attr_t::dsl},       {"age", attr_t::age},
+        {"ar", attr_t::ar},         {"dar", attr_t::dar},       {"name", attr_t::name},
+        {"regnum", attr_t::regnum}, {"sysop", attr_t::sysop},   {"cosysop", attr_t::cosysop}};
+    auto found = false;
+    for (const auto& [name, a] : attrs) {
+      if (iequals(name, member)) {
+        n.type = node_type_t::attribute;
+        n.attr = a;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      throw eval_error(fmt::format("No user attribute named 'user.{}' exists.", member));
+    }
+  } break;
+  }
+  nodes_.emplace_back(std::move(n));
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+int CompiledAcs::compile(const Expression* e) {
+  if (!e) {
+    throw eval_error("Missing operand in expression.");
+  }
+  if (const auto* f = dynamic_cast<const Factor*>(e)) {
+    return compile_factor(f);
+  }
+  const auto left = compile(e->left());
+  auto right = compile(e->right());
+
+  // Value::eval converts a string on the right of an AR to an Ar each time it
+  // is called, so do that here once instead.
+  const auto& l = nodes_.at(left);
+  if (l.type == node_type_t::attribute && (l.attr == attr_t::ar || l.attr == attr_t::dar) &&
+      nodes_.at(right).type == node_type_t::constant) {
+    auto& r = nodes_.at(right);
+    if (r.value.type == ValueType::string) {
+      r.value.str = r.str;
+    }
+    r.value = scalar_t::of(r.value.as_ar());
+  }
+
+  node_t n{};
+  n.type = node_type_t::binop;
+  n.op = e->op();
+  n.left = left;
+  n.right = right;
+  nodes_.emplace_back(std::move(n));
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+// Value::as_string, formatting into buf only when v isn't already a string.
+static std::string_view as_string(ValueType type, std::string_view str, int number, const Ar& ar,
+                                  std::string& buf) {
+  switch (type) {
+  case ValueType::string:
+    return str;
+  case ValueType::number:
+    buf = std::to_string(number);
+    return buf;
+  case ValueType::boolean:
+    return number ? "true" : "false";
+  case ValueType::ar:
+    buf = ar.as_string();
+    return buf;
+  case ValueType::unknown:
+    break;
+  }
+  return {};
+}
+
+static bool iequals(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char c1, char c2) {
+           return std::tolower(c1) == std::tolower(c2);
+         });
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::scalar_t::of(bool b) {
+  scalar_t s;
+  s.type = ValueType::boolean;
+  s.number = b ? 1 : 0;
+  return s;
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::scalar_t::of(int n) {
+  scalar_t s;
+  s.type = ValueType::number;
+  s.number = n;
+  return s;
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::scalar_t::of(Ar a) {
+  scalar_t s;
+  s.type = ValueType::ar;
+  s.ar = a;
+  return s;
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::scalar_t::of(std::string_view v) {
+  scalar_t s;
+  s.type = ValueType::string;
+  s.str = v;
+  return s;
+}
+
+// The conversions below match the ones in Value.
+
+int CompiledAcs::scalar_t::as_number() const {
+  switch (type) {
+  case ValueType::number:
+  case ValueType::boolean:
+    return number;
+  case ValueType::string:
+    return to_number<int>(std::string(as_string_view()));
+  case ValueType::ar:
+    return ar.as_integer();
+  case ValueType::unknown:
+    return 0;
+  }
+  return 0;
+}
+
+bool CompiledAcs::scalar_t::as_boolean() const {
+  switch (type) {
+  case ValueType::string:
+    return iequals(as_string_view(), "true");
+  case ValueType::number:
+  case ValueType::boolean:
+    return number != 0;
+  case ValueType::ar:
+  case ValueType::unknown:
+    return false;
+  }
+  return false;
+}
+
+Ar CompiledAcs::scalar_t::as_ar() const {
+  switch (type) {
+  case ValueType::ar:
+    return ar;
+  case ValueType::boolean:
+  case ValueType::number:
+    return Ar(0, false);
+  case ValueType::string:
+    return Ar(std::string(as_string_view()));
+  case ValueType::unknown:
+    break;
+  }
+  throw eval_error(fmt::format("Unable to coerce valuetype: {} to Ar", static_cast<int>(type)));
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::attribute(attr_t a, const Config& config, const User* user,
+                                             int eff_sl) {
+  switch (a) {
+  case attr_t::sl:
+    return scalar_t::of(user->sl());
+  case attr_t::dsl:
+    return scalar_t::of(user->dsl());
+  case attr_t::age:
+    return scalar_t::of(user->age());
+  case attr_t::ar:
+    return scalar_t::of(Ar(user->ar_int(), true));
+  case attr_t::dar:
+    return scalar_t::of(Ar(user->dar_int(), true));
+  case attr_t::name:
+    return scalar_t::of(std::string_view(user->GetName()));
+  case attr_t::regnum:
+    return scalar_t::of(user->wwiv_regnum() != 0);
+  case attr_t::sysop:
+    return scalar_t::of(user->sl() == 255);
+  case attr_t::cosysop: {
+    const auto so = user->sl() == 255;
+    const auto cs = (config.sl(eff_sl).ability & ability_cosysop) != 0;
+    return scalar_t::of(so || cs);
+  }
+  }
+  return scalar_t::of(false);
+}
+
+// static
+CompiledAcs::scalar_t CompiledAcs::binop(const scalar_t& l, Operator op, const scalar_t& r) {
+  const auto vt = l.type;
+  auto text = [](const scalar_t& v, std::string& buf) {
+    return as_string(v.type, v.as_string_view(), v.number, v.ar, buf);
+  };
+  std::string lbuf;
+  std::string rbuf;
+  switch (op) {
+  case Operator::add:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() + r.as_number());
+    }
+    {
+      scalar_t s;
+      s.type = ValueType::string;
+      s.owned = StrCat(text(l, lbuf), text(r, rbuf));
+      return s;
+    }
+  case Operator::sub:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() - r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::mul:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() * r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::div:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() / r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::gt:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() > r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::ge:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() >= r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::lt:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() < r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::le:
+    if (vt == ValueType::number) {
+      return scalar_t::of(l.as_number() <= r.as_number());
+    }
+    LOG(ERROR) << to_string(op) << " is only allowed on numbers";
+    break;
+  case Operator::eq:
+  case Operator::ne: {
+    const auto ne = op == Operator::ne;
+    if (vt == ValueType::number) {
+      return scalar_t::of((l.as_number() == r.as_number()) != ne);
+    }
+    if (vt == ValueType::boolean) {
+      return scalar_t::of((l.as_boolean() == r.as_boolean()) != ne);
+    }
+    if (vt == ValueType::string) {
+      return scalar_t::of(iequals(text(l, lbuf), text(r, rbuf)) != ne);
+    }
+    if (vt == ValueType::ar) {
+      return scalar_t::of((l.as_ar() == r.as_ar()) != ne);
+    }
+  } break;
+  case Operator::logical_or:
+    return scalar_t::of(l.as_boolean() || r.as_boolean());
+  case Operator::logical_and:
+    return scalar_t::of(l.as_boolean() && r.as_boolean());
+  case Operator::UNKNOWN:
+    return scalar_t::of(false);
+  }
+  return scalar_t::of(false);
+}
+
+CompiledAcs::scalar_t CompiledAcs::eval_node(int idx, const Config& config, const User* user,
+                                             int eff_sl) const {
+  const auto& n = nodes_[idx];
+  switch (n.type) {
+  case node_type_t::constant:
+    if (n.value.type == ValueType::string) {
+      return scalar_t::of(std::string_view(n.str));
+    }
+    return n.value;
+  case node_type_t::attribute:
+    return attribute(n.attr, config, user, eff_sl);
+  case node_type_t::binop:
+    break;
+  }
+  if (n.op == Operator::logical_or) {
+    if (eval_node(n.left, config, user, eff_sl).as_boolean()) {
+      return scalar_t::of(true);
+    }
+    return scalar_t::of(eval_node(n.right, config, user, eff_sl).as_boolean());
+  }
+  if (n.op == Operator::logical_and) {
+    if (!eval_node(n.left, config, user, eff_sl).as_boolean()) {
+      return scalar_t::of(false);
+    }
+    return scalar_t::of(eval_node(n.right, config, user, eff_sl).as_boolean());
+  }
+  return binop(eval_node(n.left, config, user, eff_sl), n.op,
+               eval_node(n.right, config, user, eff_sl));
+}
+
+bool CompiledAcs::eval(const Config& config, const User* user, int eff_sl) const {
+  if (root_ < 0) {
+    return false;
+  }
+  try {
+    return eval_node(root_, config, user, eff_sl).as_boolean();
+  } catch (const eval_error& e) {
+    VLOG(1) << "CompiledAcs Eval Error: " << e.what();
+  }
+  return false;
+}
+
+// static
+std::shared_ptr<const CompiledAcs> CompiledAcs::get(const std::string& expression) {
+  {
+    std::lock_guard<std::mutex> lock(cache_mu);
+    if (const auto it = cache.find(expression); it != std::end(cache)) {
+      return it->second;
+    }
+  }
+  // Compile outside of the lock, if two threads race the 2nd one just wins.
+  auto c = std::make_shared<const CompiledAcs>(expression);
+  std::lock_guard<std::mutex> lock(cache_mu);
+  if (static_cast<int>(cache.size()) >= kMaxCacheSize) {
+    cache.clear();
+  }
+  cache[expression] = c;
+  return c;
+}
+
+// static
+void CompiledAcs::clear_cache() {
+  std::lock_guard<std::mutex> lock(cache_mu);
+  cache.clear();
+}
+
+// static
+int CompiledAcs::cache_size() {
+  std::lock_guard<std::mutex> lock(cache_mu);
+  return static_cast<int>(cache.size());
+}
+
+} // namespace wwiv::sdk::acs
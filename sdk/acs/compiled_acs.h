@@ -0,0 +1,125 @@
+/**************************************************************************/
+/*                                                                        */
+/*                            WWIV Version 5                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_ACS_COMPILED_ACS_H
+#define INCLUDED_SDK_ACS_COMPILED_ACS_H
+
+#include "core/parser/ast.h"
+#include "sdk/config.h"
+#include "sdk/user.h"
+#include "sdk/acs/value.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wwiv::sdk::acs {
+
+/**
+ * An ACS expression that has been lexed, parsed and had all of its variables
+ * resolved once, so that it may be evaluated many times without re-parsing.
+ *
+ * Evaluation results match Eval, except that && and || short-circuit.  Since
+ * every variable is resolved up front, an expression that Eval would fail on
+ * (unknown attribute, parse error) fails to compile and always evaluates to
+ * false.
+ */
+class CompiledAcs final {
+public:
+  explicit CompiledAcs(const std::string& expression);
+
+  /** True if the expression compiled cleanly. */
+  [[nodiscard]] bool ok() const noexcept { return error_text_.empty(); }
+  /** The reason the expression failed to compile, or empty if ok() */
+  [[nodiscard]] const std::string& error_text() const noexcept { return error_text_; }
+
+  /**
+   * Evaluates this expression for user at the effective SL eff_sl.  Returns
+   * false if the expression did not compile.
+   */
+  [[nodiscard]] bool eval(const Config& config, const User* user, int eff_sl) const;
+
+  /**
+   * Returns the compiled form of expression from the process wide cache,
+   * compiling it the first time it is seen.
+   */
+  [[nodiscard]] static std::shared_ptr<const CompiledAcs> get(const std::string& expression);
+
+  /** Drops everything in the process wide cache. */
+  static void clear_cache();
+
+  /** Number of expressions in the process wide cache. */
+  [[nodiscard]] static int cache_size();
+
+private:
+  enum class node_type_t { constant, attribute, binop };
+  enum class attr_t { sl, dsl, age, ar, dar, name, regnum, sysop, cosysop };
+
+  /**
+   * A value produced while evaluating, with the same conversions as Value.
+   * Unlike Value it doesn't allocate: strings point at the constant in the
+   * node or the user record, and only a computed string (from +) is owned.
+   */
+  struct scalar_t {
+    ValueType type{ValueType::unknown};
+    int number{0};
+    Ar ar{0, false};
+    std::string_view str;
+    std::string owned;
+
+    static scalar_t of(bool b);
+    static scalar_t of(int n);
+    static scalar_t of(Ar a);
+    static scalar_t of(std::string_view s);
+
+    [[nodiscard]] std::string_view as_string_view() const noexcept {
+      return owned.empty() ? str : std::string_view(owned);
+    }
+    [[nodiscard]] int as_number() const;
+    [[nodiscard]] bool as_boolean() const;
+    [[nodiscard]] Ar as_ar() const;
+  };
+
+  struct node_t {
+    node_type_t type{node_type_t::constant};
+    // For constants, str holds the text of a string constant.
+    scalar_t value;
+    std::string str;
+    attr_t attr{attr_t::sl};
+    core::parser::Operator op{core::parser::Operator::UNKNOWN};
+    int left{-1};
+    int right{-1};
+  };
+
+  /** Compiles e into nodes_, returning the node index. Throws eval_error. */
+  int compile(const core::parser::Expression* e);
+  int compile_factor(const core::parser::Factor* f);
+  [[nodiscard]] scalar_t eval_node(int idx, const Config& config, const User* user,
+                                   int eff_sl) const;
+  [[nodiscard]] static scalar_t attribute(attr_t a, const Config& config, const User* user,
+                                          int eff_sl);
+  [[nodiscard]] static scalar_t binop(const scalar_t& l, core::parser::Operator op,
+                                      const scalar_t& r);
+
+  std::vector<node_t> nodes_;
+  int root_{-1};
+  std::string error_text_;
+};
+
+} // namespace wwiv::sdk::acs
+
+#endif
@@ -0,0 +1,185 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/fido/fido_packet_reader.h"
+
+#include "core/log.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+
+using namespace wwiv::core;
+using namespace wwiv::sdk::net;
+
+namespace wwiv::sdk::fido {
+
+// Longest the variable length fields of a packed message may be.
+static constexpr std::size_t kMaxToUserName = 36;
+static constexpr std::size_t kMaxFromUserName = 36;
+static constexpr std::size_t kMaxSubject = 72;
+static constexpr std::size_t kMaxText = 256 * 1024;
+static constexpr std::size_t kDateTimeSize = 20;
+// How much to read at first when looking for the end of a message.
+static constexpr std::size_t kMinRead = 4096;
+
+namespace {
+
+// Parses the fields of a packed message the same way read_packed_message
+// always has, with the end of the data standing in for the end of the file.
+class PackedMessageParser {
+public:
+  PackedMessageParser(std::string_view data, bool eof) : data_(data), eof_(eof) {}
+
+  // Returns nullopt if more data is needed to get to the end of the message.
+  std::optional<ReadPacketResponse> Parse(FidoPackedMessage& packet) {
+    const auto avail = data_.size();
+    if (avail < sizeof(fido_packed_message_t) && !eof_) {
+      return std::nullopt;
+    }
+    const auto num_read = std::min(avail, sizeof(fido_packed_message_t));
+    std::memcpy(&packet.nh, data_.data(), num_read);
+    pos_ = num_read;
+    if (num_read == 0) {
+      // at the end of the packet.
+      return ReadPacketResponse::END_OF_FILE;
+    }
+    if (num_read == 2) {
+      // FIDO packets have 2 bytes of NULL at the end;
+      if (packet.nh.message_type == 0) {
+        return ReadPacketResponse::END_OF_FILE;
+      }
+    }
+    if (num_read != sizeof(fido_packed_message_t)) {
+      LOG(INFO) << "error reading header, got short read of size: " << num_read
+                << "; expected: " << sizeof(fido_packed_message_t);
+      return ReadPacketResponse::ERROR;
+    }
+    if (packet.nh.message_type != 2) {
+      LOG(INFO) << "invalid message_type: " << packet.nh.message_type << "; expected: 2";
+    }
+
+    auto& vh = packet.vh;
+    if (!FixedLengthField(kDateTimeSize, vh.date_time) ||
+        !VariableLengthField(kMaxToUserName, vh.to_user_name) ||
+        !VariableLengthField(kMaxFromUserName, vh.from_user_name) ||
+        !VariableLengthField(kMaxSubject, vh.subject) ||
+        !VariableLengthField(kMaxText, vh.text)) {
+      return std::nullopt;
+    }
+    return ReadPacketResponse::OK;
+  }
+
+  [[nodiscard]] std::size_t pos() const noexcept { return pos_; }
+
+private:
+  // Reads a field of length len, removing any trailing nulls.
+  bool FixedLengthField(std::size_t len, std::string& s) {
+    const auto avail = data_.size() - pos_;
+    if (avail < len && !eof_) {
+      return false;
+    }
+    len = std::min(len, avail);
+    s.assign(data_.data() + pos_, len);
+    pos_ += len;
+    while (!s.empty() && s.back() == '\0') {
+      s.pop_back();
+    }
+    return true;
+  }
+
+  // Reads up to max_len characters or through the first null, which isn't
+  // included.
+  bool VariableLengthField(std::size_t max_len, std::string& s) {
+    const auto avail = data_.size() - pos_;
+    const auto* start = data_.data() + pos_;
+    const auto len = std::min(max_len, avail);
+    if (const auto* nul = static_cast<const char*>(std::memchr(start, 0, len))) {
+      s.assign(start, nul - start);
+      pos_ += s.size() + 1;
+      return true;
+    }
+    if (len < max_len && !eof_) {
+      return false;
+    }
+    s.assign(start, len);
+    pos_ += len;
+    return true;
+  }
+
+  std::string_view data_;
+  const bool eof_;
+  std::size_t pos_{0};
+};
+
+} // namespace
+
+FidoPacketReader::FidoPacketReader(File& file, int buffer_size)
+    : file_(file), buffer_size_(std::max<std::size_t>(kMinRead, buffer_size)),
+      offset_(file.current_position()) {}
+
+File::size_type FidoPacketReader::position() const noexcept {
+  return offset_ + static_cast<File::size_type>(pos_);
+}
+
+std::size_t FidoPacketReader::Fill(std::size_t n) {
+  if (end_ - pos_ >= n || eof_) {
+    return end_ - pos_;
+  }
+  // Move what's left to the front, then read as much as fits.
+  if (pos_ > 0) {
+    std::memmove(&buf_[0], &buf_[pos_], end_ - pos_);
+    offset_ += static_cast<File::size_type>(pos_);
+    end_ -= pos_;
+    pos_ = 0;
+  }
+  if (const auto size = std::max(n, buffer_size_); size > buf_.size()) {
+    buf_.resize(size);
+  }
+  while (end_ < n) {
+    const auto num_read = file_.Read(&buf_[end_], static_cast<File::size_type>(buf_.size() - end_));
+    if (num_read <= 0) {
+      eof_ = true;
+      break;
+    }
+    end_ += static_cast<std::size_t>(num_read);
+  }
+  return end_ - pos_;
+}
+
+bool FidoPacketReader::ReadHeader(packet_header_2p_t& header) {
+  if (Fill(sizeof(packet_header_2p_t)) < sizeof(packet_header_2p_t)) {
+    return false;
+  }
+  std::memcpy(&header, &buf_[pos_], sizeof(packet_header_2p_t));
+  pos_ += sizeof(packet_header_2p_t);
+  return true;
+}
+
+ReadPacketResponse FidoPacketReader::Next(FidoPackedMessage& packet) {
+  for (auto want = kMinRead;; want *= 2) {
+    const auto avail = Fill(want);
+    PackedMessageParser parser(std::string_view(buf_.data() + pos_, avail), eof_);
+    if (const auto response = parser.Parse(packet)) {
+      pos_ += parser.pos();
+      return response.value();
+    }
+  }
+}
+
+} // namespace wwiv::sdk::fido
@@ -0,0 +1,71 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_FIDO_FIDO_PACKET_READER_H
+#define INCLUDED_SDK_FIDO_FIDO_PACKET_READER_H
+
+#include "core/file.h"
+#include "sdk/fido/fido_packets.h"
+#include "sdk/net/packets.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace wwiv::sdk::fido {
+
+/**
+ * Reads the messages in a FidoNet type 2+ packet using large reads into a
+ * reusable buffer and memchr to find the end of each field, instead of
+ * reading a byte at a time.
+ *
+ * Reading starts at the current position of the file, which the reader
+ * doesn't own.  The file position is left past what has been buffered, so
+ * use position() to find where the next unread message starts.
+ */
+class FidoPacketReader final {
+public:
+  explicit FidoPacketReader(core::File& file, int buffer_size = 256 * 1024);
+  ~FidoPacketReader() = default;
+  FidoPacketReader(const FidoPacketReader&) = delete;
+  FidoPacketReader& operator=(const FidoPacketReader&) = delete;
+
+  /** Reads the packet header.  Returns false on a short read. */
+  bool ReadHeader(packet_header_2p_t& header);
+  /** Reads the next message, like read_packed_message. */
+  net::ReadPacketResponse Next(FidoPackedMessage& packet);
+
+  /** Offset in the file of the first byte not yet read. */
+  [[nodiscard]] core::File::size_type position() const noexcept;
+
+private:
+  // Ensures at least n bytes are buffered past pos_, returns how many are.
+  std::size_t Fill(std::size_t n);
+
+  core::File& file_;
+  const std::size_t buffer_size_;
+  // Offset in the file of buf_[0].
+  core::File::size_type offset_;
+  std::string buf_;
+  std::size_t pos_{0};
+  std::size_t end_{0};
+  bool eof_{false};
+};
+
+} // namespace wwiv::sdk::fido
+
+#endif
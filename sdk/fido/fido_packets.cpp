@@ -20,8 +20,10 @@
 #include "core/file.h"
 #include "core/log.h"
 #include "core/strings.h"
+#include "sdk/fido/fido_packet_reader.h"
 #include "sdk/net/packets.h"
 #include <algorithm>
+#include <cstring>
 #include <string>
 
 using std::string;
@@ -31,58 +33,8 @@ using namespace wwiv::sdk::net;
 
 namespace wwiv::sdk::fido {
 
-static char ReadCharFromFile(File& f) {
-  char buf[1];
-  const auto num_read = f.Read(buf, 1);
-  if (num_read == 0) {
-    return 0;
-  }
-  return buf[0];
-}
-
-static std::string ReadRestOfFile(File& f, int max_size) {
-  auto current = f.current_position();
-  const auto size = f.length();
-  string s;
-
-  const auto to_read = std::min<decltype(current)>(max_size, size - current);
-  s.resize(to_read + 1);
-  const auto num_read = f.Read(&s[0], to_read);
-  s.resize(num_read);
-  return s;
-}
-
-/**
- * Reads a field of length {len}.  Will trim the field to  remove
- * any trailing nulls.
- */
-static std::string ReadFixedLengthField(File& f, int len) {
-  string s;
-  s.resize(len + 1);
-  const auto num_read = f.Read(&s[0], len);
-  s.resize(num_read);
-  while (!s.empty() && s.back() == '\0') {
-    // Remove trailing null characters.
-    s.pop_back();
-  }
-  return s;
-}
-
-/**
- * Reads a null-terminated field of up to length {len} or the first null
- * character.
- */
-static std::string ReadVariableLengthField(File& f, int max_len) {
-  string s;
-  for (auto i = 0; i < max_len; i++) {
-    const auto ch = ReadCharFromFile(f);
-    if (ch == 0) {
-      return s;
-    }
-    s.push_back(ch);
-  }
-  return s;
-}
+// Most of a stored message's text read_stored_message will read.
+static constexpr int kMaxStoredMessageText = 32 * 1024;
 
 FidoStoredMessage::~FidoStoredMessage()  = default;
 
@@ -96,36 +48,45 @@ bool write_fido_packet_header(File& f, packet_header_2p_t& header) {
   return true;
 }
 
+void append_packed_message(std::string& data, const FidoPackedMessage& packet) {
+  data.append(reinterpret_cast<const char*>(&packet.nh), sizeof(fido_packed_message_t));
+  // The date is always 19 characters and a null.
+  data.append(packet.vh.date_time, 0, 19);
+  data.append(19 - std::min<std::size_t>(19, packet.vh.date_time.size()), '\0');
+  data.push_back('\0');
+  data.append(packet.vh.to_user_name);
+  data.push_back('\0');
+  data.append(packet.vh.from_user_name);
+  data.push_back('\0');
+  data.append(packet.vh.subject);
+  data.push_back('\0');
+  data.append(packet.vh.text);
+  data.push_back('\0');
+}
+
 bool write_packed_message(File& f, FidoPackedMessage& packet) {
-  const auto num_written = f.Write(&packet.nh, sizeof(fido_packed_message_t));
-  if (num_written != sizeof(fido_packed_message_t)) {
-    LOG(ERROR) << "short write to packet, wrote " << num_written
-               << "; expected: " << sizeof(fido_packed_message_t);
+  std::string data;
+  append_packed_message(data, packet);
+  // End of packet.
+  data.append(2, '\0');
+  const auto num_written = f.Write(data);
+  if (num_written != ssize(data)) {
+    LOG(ERROR) << "short write to packet, wrote " << num_written << "; expected: " << data.size();
     return false;
   }
-  f.Write(packet.vh.date_time.c_str(), 19);
-  f.Write("\0", 1);
-  f.Write(packet.vh.to_user_name);
-  f.Write("\0", 1);
-  f.Write(packet.vh.from_user_name);
-  f.Write("\0", 1);
-  f.Write(packet.vh.subject);
-  f.Write("\0", 1);
-  f.Write(packet.vh.text);
-  f.Write("\0", 1);
-  // End of packet.
-  f.Write("\0\0", 2);
   return true;
 }
 
 bool write_stored_message(File& f, FidoStoredMessage& packet) {
-  const auto num = f.Write(&packet.nh, sizeof(fido_stored_message_t));
-  if (num != sizeof(fido_stored_message_t)) {
+  std::string data(reinterpret_cast<const char*>(&packet.nh), sizeof(fido_stored_message_t));
+  data.append(packet.text);
+  const auto num = f.Write(data);
+  if (num < static_cast<File::size_type>(sizeof(fido_stored_message_t))) {
     LOG(ERROR) << "Short write on write_stored_message. Wrote: " << num
                << "; expected: " << sizeof(fido_stored_message_t);
     return false;
   }
-  return f.Write(packet.text) == ssize(packet.text);
+  return num == ssize(data);
 }
 
 /**
@@ -133,43 +94,25 @@ bool write_stored_message(File& f, FidoStoredMessage& packet) {
  * See http://ftsc.org/docs/fts-0001.016
  */
 ReadPacketResponse read_packed_message(File& f, FidoPackedMessage& packet) {
-  const auto num_read = f.Read(&packet.nh, sizeof(fido_packed_message_t));
-  if (num_read == 0) {
-    // at the end of the packet.
-    return ReadPacketResponse::END_OF_FILE;
-  }
-  if (num_read == 2) {
-    // FIDO packets have 2 bytes of NULL at the end;
-    if (packet.nh.message_type == 0) {
-      return ReadPacketResponse::END_OF_FILE;
-    }
-  }
-
-  if (num_read != sizeof(fido_packed_message_t)) {
-    LOG(INFO) << "error reading header, got short read of size: " << num_read
-              << "; expected: " << sizeof(fido_packed_message_t);
-    return ReadPacketResponse::ERROR;
-  }
-
-  if (packet.nh.message_type != 2) {
-    LOG(INFO) << "invalid message_type: " << packet.nh.message_type << "; expected: 2";
-  }
-  packet.vh.date_time = ReadFixedLengthField(f, 20);
-  packet.vh.to_user_name = ReadVariableLengthField(f, 36);
-  packet.vh.from_user_name = ReadVariableLengthField(f, 36);
-  packet.vh.subject = ReadVariableLengthField(f, 72);
-  packet.vh.text = ReadVariableLengthField(f, 256 * 1024);
-  return ReadPacketResponse::OK;
+  // Read in blocks rather than a byte at a time, then leave the file where
+  // the message ended.  Use FidoPacketReader to read a whole packet.
+  FidoPacketReader reader(f, 0);
+  const auto response = reader.Next(packet);
+  f.Seek(reader.position(), File::Whence::begin);
+  return response;
 }
 
 ReadPacketResponse read_stored_message(File& f, FidoStoredMessage& packet) {
-  const auto num_read = f.Read(&packet.nh, sizeof(fido_stored_message_t));
+  // Read the header and text together.
+  std::string data(sizeof(fido_stored_message_t) + kMaxStoredMessageText, '\0');
+  const auto num_read = std::max<File::size_type>(0, f.Read(&data[0], ssize(data)));
   if (num_read == 0) {
     // at the end of the packet.
     return ReadPacketResponse::END_OF_FILE;
   }
-
-  packet.text = ReadRestOfFile(f, 32 * 1024);
+  const auto header_size = std::min<std::size_t>(num_read, sizeof(fido_stored_message_t));
+  std::memcpy(&packet.nh, data.data(), header_size);
+  packet.text = data.substr(header_size, num_read - header_size);
   return ReadPacketResponse::OK;
 }
 
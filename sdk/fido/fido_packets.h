@@ -265,6 +265,11 @@ public:
 bool write_fido_packet_header(wwiv::core::File& f, packet_header_2p_t& header);
 bool write_packed_message(wwiv::core::File& f, FidoPackedMessage& packet);
 bool write_stored_message(wwiv::core::File& f, FidoStoredMessage& packet);
+/**
+ * Appends packet to data as write_packed_message writes it, but without the
+ * end of packet marker, so more messages may follow it.
+ */
+void append_packed_message(std::string& data, const FidoPackedMessage& packet);
 
 
 wwiv::sdk::net::ReadPacketResponse read_packed_message(wwiv::core::File& file,
@@ -20,10 +20,14 @@
 #include "core/datetime.h"
 #include "core/file.h"
 #include "core/findfiles.h"
+#include "core/log.h"
 #include "core/stl.h"
 #include "core/strings.h"
 #include "core/textfile.h"
 #include "fmt/printf.h"
+#include "sdk/fido/nodelist_cache.h"
+#include <limits>
+#include <memory>
 #include <set>
 #include <string>
 
@@ -159,12 +163,14 @@ bool NodelistEntry::ParseDataLine(const std::string& data_line, NodelistEntry& e
   return true;
 }
 
-Nodelist::Nodelist(const std::filesystem::path& path) 
-  : initialized_(Load(path)) {}
+Nodelist::Nodelist(const std::filesystem::path& path, bool use_cache)
+  : initialized_(Load(path, use_cache)) {}
 
 Nodelist::Nodelist(const std::vector<std::string>& lines) 
   : initialized_(Load(lines)) {}
 
+Nodelist::~Nodelist() = default;
+
 bool Nodelist::HandleLine(const string& line, uint16_t& zone, uint16_t& region, uint16_t& net, uint16_t& hub) {
   if (line.empty()) return true;
   if (line.front() == ';') {
@@ -217,7 +223,14 @@ bool Nodelist::HandleLine(const string& line, uint16_t& zone, uint16_t& region,
   return true;
 }
 
-bool Nodelist::Load(const std::filesystem::path& path) {
+bool Nodelist::Load(const std::filesystem::path& path, bool use_cache) {
+  if (use_cache) {
+    if (auto c = NodelistCache::Open(path)) {
+      VLOG(1) << "Using nodelist cache for: " << path;
+      cache_ = std::make_unique<NodelistCache>(std::move(c.value()));
+      return true;
+    }
+  }
   TextFile f(path, "rt");
   if (!f) {
     return false;
@@ -228,6 +241,11 @@ bool Nodelist::Load(const std::filesystem::path& path) {
     StringTrim(&line);
     HandleLine(line, zone, region, net, hub);
   }
+  all_entries_ = true;
+  if (use_cache) {
+    f.Close();
+    NodelistCache::Write(path, entries_);
+  }
   return true;
 }
 
@@ -241,8 +259,48 @@ bool Nodelist::Load(const std::vector<std::string>& lines) {
   return true;
 }
 
+const NodelistEntry& Nodelist::entry(const FidoAddress& a) const {
+  if (cache_ && !all_entries_ && !stl::contains(entries_, a) && a.point() == 0 &&
+      a.domain().empty()) {
+    if (const auto i = cache_->find(a.zone(), a.net(), a.node()); i >= 0) {
+      return entries_.emplace(a, cache_->entry(i)).first->second;
+    }
+  }
+  return entries_.at(a);
+}
+
+bool Nodelist::contains(const FidoAddress& a) const {
+  if (!cache_) {
+    return stl::contains(entries_, a);
+  }
+  return a.point() == 0 && a.domain().empty() && cache_->find(a.zone(), a.net(), a.node()) >= 0;
+}
+
+const std::map<FidoAddress, NodelistEntry>& Nodelist::entries() const {
+  if (cache_ && !all_entries_) {
+    for (auto i = 0; i < cache_->size(); i++) {
+      const auto& r = cache_->at(i);
+      const FidoAddress a(r.zone, r.net, r.node, 0, "");
+      if (!stl::contains(entries_, a)) {
+        entries_.emplace(a, cache_->entry(i));
+      }
+    }
+    all_entries_ = true;
+  }
+  return entries_;
+}
+
 std::vector<NodelistEntry> Nodelist::entries(uint16_t zone, uint16_t net) const {
   std::vector<NodelistEntry> entries;
+  if (cache_) {
+    const auto z = static_cast<int16_t>(zone);
+    const auto n = static_cast<int16_t>(net);
+    for (auto i = cache_->lower_bound(z, n, std::numeric_limits<int16_t>::min());
+         i < cache_->size() && cache_->at(i).zone == z && cache_->at(i).net == n; i++) {
+      entries.push_back(cache_->entry(i));
+    }
+    return entries;
+  }
   for (const auto& e : entries_) {
     if (e.first.zone() == zone && e.first.net() == net) {
       entries.push_back(e.second);
@@ -253,6 +311,15 @@ std::vector<NodelistEntry> Nodelist::entries(uint16_t zone, uint16_t net) const
 
 std::vector<NodelistEntry> Nodelist::entries(uint16_t zone) const {
   std::vector<NodelistEntry> entries;
+  if (cache_) {
+    const auto z = static_cast<int16_t>(zone);
+    const auto min = std::numeric_limits<int16_t>::min();
+    for (auto i = cache_->lower_bound(z, min, min); i < cache_->size() && cache_->at(i).zone == z;
+         i++) {
+      entries.push_back(cache_->entry(i));
+    }
+    return entries;
+  }
   for (const auto& e : entries_) {
     if (e.first.zone() == zone) {
       entries.push_back(e.second);
@@ -263,6 +330,11 @@ std::vector<NodelistEntry> Nodelist::entries(uint16_t zone) const {
 
 std::vector<uint16_t> Nodelist::zones() const {
   std::set<uint16_t> s;
+  if (cache_) {
+    for (auto i = 0; i < cache_->size(); i++) {
+      s.emplace(cache_->at(i).zone);
+    }
+  }
   for (const auto& e : entries_) {
     s.emplace(e.first.zone());
   }
@@ -275,6 +347,14 @@ std::vector<uint16_t> Nodelist::zones() const {
 
 std::vector<uint16_t> Nodelist::nets(uint16_t zone) const {
   std::set<uint16_t> s;
+  if (cache_) {
+    const auto z = static_cast<int16_t>(zone);
+    const auto min = std::numeric_limits<int16_t>::min();
+    for (auto i = cache_->lower_bound(z, min, min); i < cache_->size() && cache_->at(i).zone == z;
+         i++) {
+      s.emplace(cache_->at(i).net);
+    }
+  }
   for (const auto& e : entries_) {
     if (e.first.zone() == zone) {
       s.emplace(e.first.net());
@@ -289,6 +369,15 @@ std::vector<uint16_t> Nodelist::nets(uint16_t zone) const {
 
 std::vector<uint16_t> Nodelist::nodes(uint16_t zone, uint16_t net) const {
   std::vector<uint16_t> nodes;
+  if (cache_) {
+    const auto z = static_cast<int16_t>(zone);
+    const auto n = static_cast<int16_t>(net);
+    for (auto i = cache_->lower_bound(z, n, std::numeric_limits<int16_t>::min());
+         i < cache_->size() && cache_->at(i).zone == z && cache_->at(i).net == n; i++) {
+      nodes.emplace_back(cache_->at(i).node);
+    }
+    return nodes;
+  }
   for (const auto& e : entries_) {
     if (e.first.zone() == zone && e.first.net() == net) {
       nodes.emplace_back(e.first.node());
@@ -299,10 +388,10 @@ std::vector<uint16_t> Nodelist::nodes(uint16_t zone, uint16_t net) const {
 
 const NodelistEntry* Nodelist::entry(uint16_t zone, uint16_t net, uint16_t node) {
   const FidoAddress a(zone, net, node, 0, "");
-  if (!stl::contains(entries_, a)) {
+  if (!contains(a)) {
     return nullptr;
   }
-  return &entries_.at(a);
+  return &entry(a);
 }
 
 static int year_of(time_t t) {
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -99,22 +100,30 @@ public:
   // IP, IFC, IFT, IVM, IN04
 };
 
+class NodelistCache;
+
 /**
  * Represents a FidoNet NodeList as defined in FRL-1003.
+ *
+ * When loaded from a file, a compiled NodelistCache is kept alongside it and
+ * used instead of parsing the text nodelist whenever it is still current.
+ * Entries are then only materialized as they are asked for.
  */
 class Nodelist final {
 public:
   /** Parses address.  If it fails, throws bad_fidonet_address. */
-  explicit Nodelist(const std::filesystem::path& path);
+  explicit Nodelist(const std::filesystem::path& path, bool use_cache = true);
   explicit Nodelist(const std::vector<std::string>& lines);
-  ~Nodelist() = default;
+  ~Nodelist();
 
   [[nodiscard]] bool initialized() const { return initialized_; }
   explicit operator bool() const { return initialized_; }
+  /** True if this nodelist is being served from its cache. */
+  [[nodiscard]] bool cached() const noexcept { return static_cast<bool>(cache_); }
 
-  [[nodiscard]] const NodelistEntry& entry(const FidoAddress& a) const { return entries_.at(a); }
-  [[nodiscard]] bool contains(const FidoAddress& a) const { return wwiv::stl::contains(entries_, a); }
-  [[nodiscard]] const std::map<FidoAddress, NodelistEntry>& entries() const { return entries_; }
+  [[nodiscard]] const NodelistEntry& entry(const FidoAddress& a) const;
+  [[nodiscard]] bool contains(const FidoAddress& a) const;
+  [[nodiscard]] const std::map<FidoAddress, NodelistEntry>& entries() const;
   [[nodiscard]] std::vector<NodelistEntry> entries(uint16_t zone, uint16_t net) const;
   [[nodiscard]] std::vector<NodelistEntry> entries(uint16_t zone) const;
   [[nodiscard]] std::vector<uint16_t> zones() const;
@@ -125,11 +134,14 @@ public:
   static std::string FindLatestNodelist(const std::filesystem::path& dir, const std::string& base);
 
 private:
-  bool Load(const std::filesystem::path& path);
+  bool Load(const std::filesystem::path& path, bool use_cache);
   bool Load(const std::vector<std::string>& lines);
 
   bool HandleLine(const std::string& line, uint16_t& zone, uint16_t& region, uint16_t& net, uint16_t& hub );
-  std::map<FidoAddress, NodelistEntry> entries_;
+  // When using the cache, this only holds the entries materialized so far.
+  mutable std::map<FidoAddress, NodelistEntry> entries_;
+  mutable bool all_entries_{false};
+  std::unique_ptr<NodelistCache> cache_;
   bool initialized_{false};
 };
 
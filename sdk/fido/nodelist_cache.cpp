@@ -0,0 +1,261 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/fido/nodelist_cache.h"
+
+#include "core/crc32.h"
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::fido {
+
+static constexpr char kMagic[4] = {'W', 'N', 'L', 'C'};
+static constexpr uint32_t kVersion = 1;
+
+enum nodelist_cache_flags_t : uint16_t {
+  flag_cm = 0x0001,
+  flag_icm = 0x0002,
+  flag_mo = 0x0004,
+  flag_lo = 0x0008,
+  flag_mn = 0x0010,
+  flag_bark_file = 0x0020,
+  flag_bark_update = 0x0040,
+  flag_wazoo_file = 0x0080,
+  flag_wazoo_update = 0x0100,
+  flag_binkp = 0x0200,
+  flag_telnet = 0x0400,
+  flag_vmodem = 0x0800,
+};
+
+static const std::map<uint16_t, bool NodelistEntry::*> kFlags = {
+    {flag_cm, &NodelistEntry::cm_},
+    {flag_icm, &NodelistEntry::icm_},
+    {flag_mo, &NodelistEntry::mo_},
+    {flag_lo, &NodelistEntry::lo_},
+    {flag_mn, &NodelistEntry::mn_},
+    {flag_bark_file, &NodelistEntry::bark_file_},
+    {flag_bark_update, &NodelistEntry::bark_update_},
+    {flag_wazoo_file, &NodelistEntry::wazoo_file_},
+    {flag_wazoo_update, &NodelistEntry::wazoo_update_},
+    {flag_binkp, &NodelistEntry::binkp_},
+    {flag_telnet, &NodelistEntry::telnet_},
+    {flag_vmodem, &NodelistEntry::vmodem_},
+};
+
+// static
+std::filesystem::path NodelistCache::CachePath(const std::filesystem::path& source) {
+  // NODELIST.123 becomes NODELIST_123.nlc, so that FindLatestNodelist
+  // never mistakes it for a nodelist.
+  auto ext = source.extension().string();
+  if (!ext.empty()) {
+    ext[0] = '_';
+  }
+  return FilePath(source.parent_path(), StrCat(source.stem().string(), ext, ".nlc"));
+}
+
+NodelistCache::NodelistCache(std::string data) : data_(std::move(data)) {
+  nodelist_cache_header_t h{};
+  memcpy(&h, data_.data(), sizeof(h));
+  size_ = static_cast<int>(h.num_entries);
+}
+
+const nodelist_cache_rec_t* NodelistCache::recs() const noexcept {
+  return reinterpret_cast<const nodelist_cache_rec_t*>(data_.data() +
+                                                       sizeof(nodelist_cache_header_t));
+}
+
+std::string NodelistCache::str(uint32_t offset) const {
+  // Offsets are validated against the string table, and the table to end
+  // with a NUL, when opened.
+  const auto start = sizeof(nodelist_cache_header_t) + size_ * sizeof(nodelist_cache_rec_t);
+  return std::string(data_.data() + start + offset);
+}
+
+int NodelistCache::lower_bound(int16_t zone, int16_t net, int16_t node) const noexcept {
+  const auto key = std::make_tuple(zone, net, node);
+  const auto* begin = recs();
+  const auto* it = std::lower_bound(begin, begin + size_, key, [](const auto& r, const auto& k) {
+    return std::make_tuple(r.zone, r.net, r.node) < k;
+  });
+  return static_cast<int>(it - begin);
+}
+
+int NodelistCache::find(int16_t zone, int16_t net, int16_t node) const noexcept {
+  const auto i = lower_bound(zone, net, node);
+  if (i == size_) {
+    return -1;
+  }
+  const auto& r = at(i);
+  return r.zone == zone && r.net == net && r.node == node ? i : -1;
+}
+
+NodelistEntry NodelistCache::entry(int i) const {
+  const auto& r = at(i);
+  NodelistEntry e{};
+  e.address_ = FidoAddress(r.zone, r.net, r.node, 0, "");
+  e.keyword_ = static_cast<NodelistKeyword>(r.keyword);
+  e.number_ = static_cast<uint16_t>(r.node);
+  e.name_ = str(r.name);
+  e.location_ = str(r.location);
+  e.sysop_name_ = str(r.sysop_name);
+  e.phone_number_ = str(r.phone_number);
+  e.baud_rate_ = r.baud_rate;
+  for (const auto& [flag, member] : kFlags) {
+    e.*member = (r.flags & flag) != 0;
+  }
+  e.hostname_ = str(r.hostname);
+  e.binkp_port_ = r.binkp_port;
+  e.binkp_hostname_ = str(r.binkp_hostname);
+  e.telnet_port_ = r.telnet_port;
+  e.telnet_hostname_ = str(r.telnet_hostname);
+  e.vmodem_port_ = r.vmodem_port;
+  e.vmodem_hostname_ = str(r.vmodem_hostname);
+  return e;
+}
+
+// static
+std::optional<NodelistCache> NodelistCache::Open(const std::filesystem::path& source) {
+  const auto path = CachePath(source);
+  if (!File::Exists(path) || !File::Exists(source)) {
+    return std::nullopt;
+  }
+  File f(path);
+  if (!f.Open(File::modeBinary | File::modeReadOnly, File::shareDenyNone)) {
+    return std::nullopt;
+  }
+  const auto len = f.length();
+  if (len < static_cast<File::size_type>(sizeof(nodelist_cache_header_t))) {
+    return std::nullopt;
+  }
+  std::string data(static_cast<std::size_t>(len), '\0');
+  if (f.Read(&data[0], len) != len) {
+    return std::nullopt;
+  }
+  f.Close();
+
+  nodelist_cache_header_t h{};
+  memcpy(&h, data.data(), sizeof(h));
+  const auto expected_size = sizeof(h) + static_cast<uint64_t>(h.num_entries) *
+                                             sizeof(nodelist_cache_rec_t) + h.strings_size;
+  if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+      expected_size != data.size() || h.strings_size == 0 || data.back() != '\0') {
+    LOG(WARNING) << "Ignoring invalid nodelist cache: " << path;
+    return std::nullopt;
+  }
+  const auto* recs = reinterpret_cast<const nodelist_cache_rec_t*>(data.data() + sizeof(h));
+  for (auto i = 0u; i < h.num_entries; i++) {
+    const auto& r = recs[i];
+    for (const auto offset : {r.name, r.location, r.sysop_name, r.phone_number, r.hostname,
+                              r.binkp_hostname, r.telnet_hostname, r.vmodem_hostname}) {
+      if (offset >= h.strings_size) {
+        LOG(WARNING) << "Ignoring invalid nodelist cache: " << path;
+        return std::nullopt;
+      }
+    }
+  }
+
+  const auto source_size = static_cast<uint64_t>(File(source).length());
+  const auto source_mtime = static_cast<int64_t>(File::last_write_time(source));
+  if (h.source_size != source_size || h.source_mtime != source_mtime) {
+    // Touched, but maybe not changed.
+    if (crc32file(source) != h.source_crc32) {
+      return std::nullopt;
+    }
+    h.source_size = source_size;
+    h.source_mtime = source_mtime;
+    memcpy(&data[0], &h, sizeof(h));
+    if (!File::ReplaceContents(path, data)) {
+      // Still usable, we'll just checksum the nodelist again next time.
+      LOG(WARNING) << "Unable to update nodelist cache: " << path;
+    }
+  }
+  return NodelistCache(std::move(data));
+}
+
+// static
+bool NodelistCache::Write(const std::filesystem::path& source,
+                          const std::map<FidoAddress, NodelistEntry>& entries) {
+  nodelist_cache_header_t h{};
+  memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.source_size = static_cast<uint64_t>(File(source).length());
+  h.source_mtime = static_cast<int64_t>(File::last_write_time(source));
+  h.source_crc32 = crc32file(source);
+  h.num_entries = static_cast<uint32_t>(entries.size());
+
+  // Offset zero is the empty string.
+  std::string strings(1, '\0');
+  std::unordered_map<std::string, uint32_t> interned{{"", 0}};
+  auto intern = [&](const std::string& s) -> uint32_t {
+    auto [it, inserted] = interned.emplace(s, static_cast<uint32_t>(strings.size()));
+    if (inserted) {
+      strings.append(s).push_back('\0');
+    }
+    return it->second;
+  };
+
+  std::string recs;
+  recs.reserve(entries.size() * sizeof(nodelist_cache_rec_t));
+  for (const auto& [a, e] : entries) {
+    nodelist_cache_rec_t r{};
+    r.zone = a.zone();
+    r.net = a.net();
+    r.node = a.node();
+    r.keyword = static_cast<uint8_t>(e.keyword_);
+    for (const auto& [flag, member] : kFlags) {
+      if (e.*member) {
+        r.flags |= flag;
+      }
+    }
+    r.binkp_port = e.binkp_port_;
+    r.telnet_port = e.telnet_port_;
+    r.vmodem_port = e.vmodem_port_;
+    r.baud_rate = e.baud_rate_;
+    r.name = intern(e.name_);
+    r.location = intern(e.location_);
+    r.sysop_name = intern(e.sysop_name_);
+    r.phone_number = intern(e.phone_number_);
+    r.hostname = intern(e.hostname_);
+    r.binkp_hostname = intern(e.binkp_hostname_);
+    r.telnet_hostname = intern(e.telnet_hostname_);
+    r.vmodem_hostname = intern(e.vmodem_hostname_);
+    recs.append(reinterpret_cast<const char*>(&r), sizeof(r));
+  }
+  h.strings_size = static_cast<uint32_t>(strings.size());
+
+  std::string data(reinterpret_cast<const char*>(&h), sizeof(h));
+  data.append(recs).append(strings);
+
+  if (const auto path = CachePath(source); !File::ReplaceContents(path, data)) {
+    LOG(WARNING) << "Unable to write nodelist cache: " << path;
+    return false;
+  }
+  return true;
+}
+
+} // namespace wwiv::sdk::fido
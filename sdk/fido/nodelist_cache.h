@@ -0,0 +1,110 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_FIDO_NODELIST_CACHE_H
+#define INCLUDED_SDK_FIDO_NODELIST_CACHE_H
+
+#include "sdk/fido/fido_address.h"
+#include "sdk/fido/nodelist.h"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace wwiv::sdk::fido {
+
+#pragma pack(push, 1)
+struct nodelist_cache_header_t {
+  char magic[4];
+  uint32_t version;
+  // Size, modification time and CRC32 of the text nodelist this was built from.
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint32_t source_crc32;
+  uint32_t num_entries;
+  uint32_t strings_size;
+};
+
+// Strings are offsets into the string table that follows the records.
+struct nodelist_cache_rec_t {
+  int16_t zone;
+  int16_t net;
+  int16_t node;
+  uint8_t keyword;
+  uint8_t reserved;
+  uint16_t flags;
+  uint16_t binkp_port;
+  uint16_t telnet_port;
+  uint16_t vmodem_port;
+  uint32_t baud_rate;
+  uint32_t name;
+  uint32_t location;
+  uint32_t sysop_name;
+  uint32_t phone_number;
+  uint32_t hostname;
+  uint32_t binkp_hostname;
+  uint32_t telnet_hostname;
+  uint32_t vmodem_hostname;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(nodelist_cache_header_t) == 36);
+static_assert(sizeof(nodelist_cache_rec_t) == 52);
+
+/**
+ * Compiled form of a text nodelist.  The cache file is a header, the entries
+ * sorted by address, and a table of the distinct strings used by them.  It is
+ * read with a single read and searched in place, so loading it doesn't need
+ * to parse or allocate anything per entry.
+ *
+ * The cache is used as long as the size and time of the text nodelist are
+ * unchanged, or if its CRC32 still matches when they aren't.
+ */
+class NodelistCache final {
+public:
+  /** Where the cache for the text nodelist source lives. */
+  static std::filesystem::path CachePath(const std::filesystem::path& source);
+
+  /** Opens the cache for source, returning nothing if it is missing or stale. */
+  static std::optional<NodelistCache> Open(const std::filesystem::path& source);
+
+  /** Writes the cache for source containing entries. */
+  static bool Write(const std::filesystem::path& source,
+                    const std::map<FidoAddress, NodelistEntry>& entries);
+
+  [[nodiscard]] int size() const noexcept { return size_; }
+  [[nodiscard]] const nodelist_cache_rec_t& at(int i) const noexcept { return recs()[i]; }
+  /** Index of the first record at or after zone:net/node. */
+  [[nodiscard]] int lower_bound(int16_t zone, int16_t net, int16_t node) const noexcept;
+  /** Index of zone:net/node, or -1 if it's not here. */
+  [[nodiscard]] int find(int16_t zone, int16_t net, int16_t node) const noexcept;
+  [[nodiscard]] NodelistEntry entry(int i) const;
+
+private:
+  explicit NodelistCache(std::string data);
+  [[nodiscard]] const nodelist_cache_rec_t* recs() const noexcept;
+  [[nodiscard]] std::string str(uint32_t offset) const;
+
+  std::string data_;
+  int size_{0};
+};
+
+} // namespace wwiv::sdk::fido
+
+#endif
@@ -22,6 +22,7 @@
 #include "core/log.h"
 #include "core/strings.h"
 #include "sdk/filenames.h"
+#include "sdk/files/zip_format.h"
 #include <string>
 #include <vector>
 
@@ -52,59 +53,6 @@ static time_t dos2time_t(uint16_t dos_date, uint16_t dos_time) {
 //
 // https://www.hanshq.net/zip.html
 
-
-// .ZIP structures and defines
-static constexpr uint32_t ZIP_LOCAL_SIG = 0x04034b50;
-static constexpr uint32_t ZIP_CENT_START_SIG = 0x02014b50;
-static constexpr uint32_t ZIP_CENT_END_SIG = 0x06054b50;
-
-#pragma pack(push, 1)
-struct zip_local_header {
-  uint32_t signature; // 0x04034b50
-  uint16_t extract_ver;
-  uint16_t flags;
-  uint16_t comp_meth;
-  uint16_t mod_time;
-  uint16_t mod_date;
-  uint32_t crc_32;
-  uint32_t comp_size;
-  uint32_t uncomp_size;
-  uint16_t filename_len;
-  uint16_t extra_length;
-};
-
-struct zip_central_dir {
-  uint32_t signature; // 0x02014b50
-  uint16_t made_ver;
-  uint16_t extract_ver;
-  uint16_t flags;
-  uint16_t comp_meth;
-  uint16_t mod_time;
-  uint16_t mod_date;
-  uint32_t crc_32;
-  uint32_t comp_size;
-  uint32_t uncomp_size;
-  uint16_t filename_len;
-  uint16_t extra_len;
-  uint16_t comment_len;
-  uint16_t disk_start;
-  uint16_t int_attr;
-  uint32_t ext_attr;
-  uint32_t rel_ofs_header;
-};
-
-struct zip_end_dir {
-  uint32_t signature; // 0x06054b50
-  uint16_t disk_num;
-  uint16_t cent_dir_disk_num;
-  uint16_t total_entries_this_disk;
-  uint16_t total_entries_total;
-  uint32_t central_dir_size;
-  uint32_t ofs_cent_dir;
-  uint16_t comment_len;
-};
-#pragma pack(pop)
-
 archive_method_t zip_method(int z) {
   if (z == 0) {
     return archive_method_t::ZIP_STORED;
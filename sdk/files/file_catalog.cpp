@@ -0,0 +1,593 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/files/file_catalog.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "sdk/files/files.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::files {
+
+static constexpr char kMagic[4] = {'W', 'F', 'C', 'I'};
+static constexpr uint32_t kVersion = 1;
+static constexpr char kJournalAdd = 'A';
+static constexpr char kJournalAddExtended = 'W';
+static constexpr char kJournalRemove = 'R';
+// What ListPlus uses to mean any file.
+static constexpr char kAnyFile[] = "        .   ";
+
+static constexpr char STR_AND = '&';
+static constexpr char STR_SPC = ' ';
+static constexpr char STR_OR = '|';
+static constexpr char STR_NOT = '!';
+static constexpr char STR_OPEN_PAREN = '(';
+static constexpr char STR_CLOSE_PAREN = ')';
+
+static bool is_space(char ch) { return std::isspace(static_cast<unsigned char>(ch)) != 0; }
+
+static std::string upper(std::string s) {
+  for (auto& ch : s) {
+    ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+  }
+  return s;
+}
+
+namespace {
+
+// The recursive descent parser ListPlus has always used for keyword
+// searches, quirks and all, so searching the catalog finds the same files.
+class FormulaParser {
+public:
+  FormulaParser(const std::string& formula, const std::function<bool(const std::string&)>& has_term)
+      : formula_(formula), has_term_(has_term) {}
+
+  bool Evaluate() {
+    pos_ = 0;
+    return CompareStrings();
+  }
+
+private:
+  [[nodiscard]] char at(std::size_t pos) const { return pos < formula_.size() ? formula_[pos] : 0; }
+
+  bool CompareStrings() {
+    auto lvalue = GetValue();
+    while (pos_ < formula_.size()) {
+      switch (GetToken()) {
+      case STR_SPC:
+      case STR_AND: {
+        // The right side is always evaluated since it consumes the formula.
+        const auto rvalue = CompareStrings();
+        lvalue = lvalue && rvalue;
+      } break;
+      case STR_OR: {
+        const auto rvalue = CompareStrings();
+        lvalue = lvalue || rvalue;
+      } break;
+      default:
+        return lvalue;
+      }
+    }
+    return lvalue;
+  }
+
+  char GetToken() {
+    while (at(pos_) && is_space(at(pos_))) {
+      ++pos_;
+    }
+    if (std::isalpha(static_cast<unsigned char>(at(pos_)))) {
+      while (std::isalnum(static_cast<unsigned char>(at(pos_))) || is_space(at(pos_))) {
+        ++pos_;
+      }
+    }
+    ++pos_;
+    return at(pos_ - 1);
+  }
+
+  bool GetValue() {
+    auto sign = true;
+    while (at(pos_) && is_space(at(pos_))) {
+      ++pos_;
+    }
+    auto x = at(pos_);
+    while (x == STR_NOT) {
+      sign = !sign;
+      ++pos_;
+      if (!at(pos_)) {
+        return false;
+      }
+      x = at(pos_);
+    }
+    if (x == STR_AND || x == STR_SPC || x == STR_OR) {
+      return false;
+    }
+    if (x == STR_OPEN_PAREN) {
+      ++pos_;
+      return CompareStrings() == sign;
+    }
+
+    std::string term;
+    auto started = false;
+    for (auto done = false; !done && at(pos_);) {
+      switch (x = at(pos_)) {
+      case STR_NOT:
+        if (started) {
+          done = true;
+          break;
+        }
+        sign = !sign;
+        ++pos_;
+        break;
+      case STR_AND:
+      case STR_SPC:
+      case STR_OR:
+      case STR_OPEN_PAREN:
+      case STR_CLOSE_PAREN:
+        done = true;
+        break;
+      default:
+        started = true;
+        term.push_back(x);
+        ++pos_;
+        break;
+      }
+    }
+    StringTrim(&term);
+    return has_term_(term) == sign;
+  }
+
+  const std::string& formula_;
+  const std::function<bool(const std::string&)>& has_term_;
+  std::size_t pos_{0};
+};
+
+} // namespace
+
+bool keyword_formula_match(const std::string& formula,
+                           const std::function<bool(const std::string&)>& has_term) {
+  return FormulaParser(formula, has_term).Evaluate();
+}
+
+// Checks the files in the catalog against one query.
+class FileCatalog::Matcher {
+public:
+  Matcher(const FileCatalog& catalog, const file_catalog_query_t& q)
+      : catalog_(catalog), q_(q),
+        any_file_(q.filemask.empty() || q.filemask == kAnyFile || q.filemask.size() != 12) {}
+
+  bool matches(uint32_t id, const entry_t& e) {
+    if (!any_file_ && e.filename.size() == 12 &&
+        !aligned_wildcard_match(q_.filemask, e.filename)) {
+      return false;
+    }
+    if (e.daten < q_.newer_than) {
+      return false;
+    }
+    if (q_.keywords.empty()) {
+      return true;
+    }
+    return keyword_formula_match(q_.keywords, [&](const std::string& term) {
+      const auto* ids = files_containing(term);
+      return !ids || std::binary_search(std::begin(*ids), std::end(*ids), id);
+    });
+  }
+
+private:
+  // Sorted ids of the files with a word containing term, or nullptr if
+  // every file may contain it.
+  const std::vector<uint32_t>* files_containing(const std::string& term) {
+    if (term.empty() || std::any_of(std::begin(term), std::end(term), is_space)) {
+      return nullptr;
+    }
+    auto& terms = catalog_.terms_;
+    if (const auto it = terms.find(term); it != std::end(terms)) {
+      return &it->second;
+    }
+    const auto t = upper(term);
+    std::vector<uint32_t> ids;
+    for (const auto& [word, word_ids] : catalog_.postings_) {
+      if (word.find(t) != std::string::npos) {
+        ids.insert(std::end(ids), std::begin(word_ids), std::end(word_ids));
+      }
+    }
+    std::sort(std::begin(ids), std::end(ids));
+    ids.erase(std::unique(std::begin(ids), std::end(ids)), std::end(ids));
+    return &terms.emplace(term, std::move(ids)).first->second;
+  }
+
+  const FileCatalog& catalog_;
+  const file_catalog_query_t& q_;
+  const bool any_file_;
+};
+
+static std::vector<std::string> words(const uploadsrec& u, const std::string& ext_desc) {
+  std::vector<std::string> result;
+  FileCatalog::ForEachWord(u, ext_desc, [&](const std::string& w) { result.push_back(w); });
+  return result;
+}
+
+FileCatalog::FileCatalog(const std::filesystem::path& datadir)
+    : files_(::FilePath(datadir, "files.fci"), ::FilePath(datadir, "files.fcj")) {}
+
+// static
+void FileCatalog::ForEachWord(const uploadsrec& u, const std::string& ext_desc,
+                              const std::function<void(const std::string&)>& fn) {
+  std::unordered_set<std::string> seen;
+  auto split = [&](std::string_view s) {
+    std::string word;
+    for (const auto ch : s) {
+      if (!is_space(ch)) {
+        word.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+      } else if (!word.empty()) {
+        if (seen.insert(word).second) {
+          fn(word);
+        }
+        word.clear();
+      }
+    }
+    if (!word.empty() && seen.insert(word).second) {
+      fn(word);
+    }
+  };
+  // ListPlus searches the extended description, filename and description.
+  split(ext_desc);
+  split(std::string_view(u.filename, strnlen(u.filename, sizeof(u.filename))));
+  split(std::string_view(u.description, strnlen(u.description, sizeof(u.description))));
+}
+
+bool FileCatalog::exists() const { return files_.index_exists(); }
+
+void FileCatalog::Clear() {
+  areas_.clear();
+  keys_.clear();
+  entries_.clear();
+  postings_.clear();
+  terms_.clear();
+  next_id_ = 0;
+  journal_applied_ = 0;
+}
+
+void FileCatalog::AddWords(const std::string& area, const std::string& filename,
+                           std::optional<daten_t> daten, const std::vector<std::string>& words) {
+  uint32_t id;
+  if (const auto it = keys_.find({area, filename}); it != std::end(keys_)) {
+    // Keep the words it already had, they only cost checking a file that
+    // doesn't match, until the catalog is rebuilt.
+    id = it->second;
+    if (daten) {
+      auto& e = entries_.at(id);
+      e.daten = std::max(e.daten, daten.value());
+    }
+  } else if (daten) {
+    areas_.insert(area);
+    id = next_id_++;
+    keys_.emplace(key_t{area, filename}, id);
+    entries_.emplace(id, entry_t{area, filename, daten.value()});
+  } else {
+    // Nothing to add an extended description to.
+    return;
+  }
+  terms_.clear();
+  for (const auto& w : words) {
+    auto& v = postings_[w];
+    if (v.empty() || v.back() < id) {
+      v.push_back(id);
+    } else if (const auto it = std::lower_bound(std::begin(v), std::end(v), id);
+               it == std::end(v) || *it != id) {
+      v.insert(it, id);
+    }
+  }
+}
+
+void FileCatalog::Add(const std::string& area, const uploadsrec& u, const std::string& ext_desc) {
+  AddWords(area, u.filename, u.daten, words(u, ext_desc));
+}
+
+void FileCatalog::AddArea(const std::string& area, FileArea& files) {
+  areas_.insert(area);
+  for (auto i = 1; i <= files.number_of_files(); i++) {
+    auto f = files.ReadFile(i);
+    std::string ext_desc;
+    if (f.has_extended_description()) {
+      ext_desc = files.ReadExtendedDescriptionAsString(f).value_or("");
+    }
+    Add(area, f.u(), ext_desc);
+  }
+}
+
+void FileCatalog::Remove(const std::string& area, const std::string& filename) {
+  // The postings are cleaned up when saving, until then nothing can find it.
+  if (const auto it = keys_.find({area, filename}); it != std::end(keys_)) {
+    entries_.erase(it->second);
+    keys_.erase(it);
+  }
+}
+
+bool FileCatalog::Load() {
+  Clear();
+  const auto data = read_index_file(path());
+  if (!data) {
+    return false;
+  }
+  IndexReader r(data.value());
+  char magic[4]{};
+  uint32_t version{0};
+  uint32_t num_areas{0};
+  uint32_t num_entries{0};
+  uint32_t num_words{0};
+  if (!r.get(magic) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 || !r.get(version) ||
+      version != kVersion || !r.get(num_areas) || !r.get(num_entries) || !r.get(num_words)) {
+    LOG(WARNING) << "Ignoring invalid file catalog: " << path();
+    return false;
+  }
+  std::vector<std::string> areas;
+  areas.reserve(num_areas);
+  for (auto i = 0u; i < num_areas; i++) {
+    std::string area;
+    if (!r.get_string(area)) {
+      LOG(WARNING) << "Ignoring truncated file catalog: " << path();
+      Clear();
+      return false;
+    }
+    areas_.insert(area);
+    areas.emplace_back(std::move(area));
+  }
+  entries_.reserve(num_entries);
+  for (auto id = 0u; id < num_entries; id++) {
+    uint32_t area{0};
+    entry_t e{};
+    if (!r.get_varint(area) || area >= areas.size() || !r.get_string(e.filename) ||
+        !r.get(e.daten)) {
+      LOG(WARNING) << "Ignoring truncated file catalog: " << path();
+      Clear();
+      return false;
+    }
+    e.area = areas[area];
+    keys_.emplace_hint(std::end(keys_), key_t{e.area, e.filename}, id);
+    entries_.emplace(id, std::move(e));
+  }
+  next_id_ = num_entries;
+  postings_.reserve(num_words);
+  for (auto i = 0u; i < num_words; i++) {
+    std::string word;
+    uint32_t count{0};
+    if (!r.get_string(word) || !r.get(count)) {
+      LOG(WARNING) << "Ignoring truncated file catalog: " << path();
+      Clear();
+      return false;
+    }
+    auto& v = postings_[word];
+    v.reserve(count);
+    uint32_t id{0};
+    for (auto j = 0u; j < count; j++) {
+      uint32_t delta{0};
+      if (!r.get_varint(delta)) {
+        LOG(WARNING) << "Ignoring truncated file catalog: " << path();
+        Clear();
+        return false;
+      }
+      id += delta;
+      v.push_back(id);
+    }
+  }
+
+  if (const auto journal = read_index_file(journal_path())) {
+    journal_applied_ = static_cast<File::size_type>(ApplyJournal(journal.value()));
+  }
+  return true;
+}
+
+std::size_t FileCatalog::ApplyJournal(const std::string& data) {
+  IndexReader r(data);
+  // Only whole records count, the last one may still be being written.
+  std::size_t applied = 0;
+  while (!r.done()) {
+    char type{0};
+    std::string area;
+    std::string filename;
+    if (!r.get(type) || !r.get_string(area) || !r.get_string(filename)) {
+      break;
+    }
+    if (type == kJournalRemove) {
+      Remove(area, filename);
+    } else if (type == kJournalAdd || type == kJournalAddExtended) {
+      daten_t daten{0};
+      uint32_t num_words{0};
+      if ((type == kJournalAdd && !r.get(daten)) || !r.get(num_words)) {
+        break;
+      }
+      std::vector<std::string> words;
+      words.reserve(num_words);
+      auto ok = true;
+      for (auto i = 0u; i < num_words && ok; i++) {
+        std::string word;
+        ok = r.get_string(word);
+        words.emplace_back(std::move(word));
+      }
+      if (!ok) {
+        break;
+      }
+      AddWords(area, filename,
+               type == kJournalAdd ? std::optional<daten_t>(daten) : std::nullopt, words);
+    } else {
+      LOG(WARNING) << "Invalid record in file catalog journal: " << journal_path();
+      break;
+    }
+    applied = r.pos();
+  }
+  return applied;
+}
+
+bool FileCatalog::Save() {
+  if (!files_.Rewrite(journal_applied_, [this](const std::string& rest) {
+        ApplyJournal(rest);
+        return Serialize();
+      })) {
+    LOG(ERROR) << "Unable to write file catalog: " << path();
+    return false;
+  }
+  journal_applied_ = 0;
+  return true;
+}
+
+std::string FileCatalog::Serialize() const {
+  // Renumber the files in area and filename order, dropping the ids of
+  // removed ones.
+  std::unordered_map<uint32_t, uint32_t> new_ids;
+  new_ids.reserve(keys_.size());
+  std::unordered_map<std::string, uint32_t> area_nums;
+  for (const auto& a : areas_) {
+    area_nums.emplace(a, static_cast<uint32_t>(area_nums.size()));
+  }
+
+  std::string data(kMagic, sizeof(kMagic));
+  put_u32(data, kVersion);
+  put_u32(data, static_cast<uint32_t>(areas_.size()));
+  put_u32(data, static_cast<uint32_t>(keys_.size()));
+  const auto num_words_pos = data.size();
+  put_u32(data, 0);
+  for (const auto& a : areas_) {
+    put_string(data, a);
+  }
+  for (const auto& [key, id] : keys_) {
+    const auto& e = entries_.at(id);
+    new_ids.emplace(id, static_cast<uint32_t>(new_ids.size()));
+    put_varint(data, area_nums.at(key.first));
+    put_string(data, key.second);
+    put_u32(data, e.daten);
+  }
+  uint32_t num_words = 0;
+  for (const auto& [word, ids] : postings_) {
+    std::vector<uint32_t> live;
+    live.reserve(ids.size());
+    for (const auto id : ids) {
+      if (const auto it = new_ids.find(id); it != std::end(new_ids)) {
+        live.push_back(it->second);
+      }
+    }
+    if (live.empty() || word.size() > 0xffff) {
+      continue;
+    }
+    std::sort(std::begin(live), std::end(live));
+    ++num_words;
+    put_string(data, word);
+    put_u32(data, static_cast<uint32_t>(live.size()));
+    uint32_t last = 0;
+    for (const auto id : live) {
+      put_varint(data, id - last);
+      last = id;
+    }
+  }
+  memcpy(&data[num_words_pos], &num_words, sizeof(num_words));
+  return data;
+}
+
+bool FileCatalog::JournalAdd(const std::string& area, const uploadsrec& u,
+                             const std::string& ext_desc) const {
+  if (!exists()) {
+    return true;
+  }
+  std::string rec(1, kJournalAdd);
+  put_string(rec, area);
+  put_string(rec, u.filename);
+  put_u32(rec, u.daten);
+  const auto w = words(u, ext_desc);
+  put_u32(rec, static_cast<uint32_t>(w.size()));
+  for (const auto& word : w) {
+    put_string(rec, word);
+  }
+  return files_.Append(rec);
+}
+
+bool FileCatalog::JournalAddExtended(const std::string& area, const std::string& filename,
+                                     const std::string& ext_desc) const {
+  if (!exists()) {
+    return true;
+  }
+  std::string rec(1, kJournalAddExtended);
+  put_string(rec, area);
+  put_string(rec, filename);
+  // Only the words of the extended description, so use an empty record.
+  const auto w = words(uploadsrec{}, ext_desc);
+  put_u32(rec, static_cast<uint32_t>(w.size()));
+  for (const auto& word : w) {
+    put_string(rec, word);
+  }
+  return files_.Append(rec);
+}
+
+bool FileCatalog::JournalRemove(const std::string& area, const std::string& filename) const {
+  std::string rec(1, kJournalRemove);
+  put_string(rec, area);
+  put_string(rec, filename);
+  return files_.Append(rec);
+}
+
+bool FileCatalog::MaybeCompact() {
+  if (!files_.needs_compact()) {
+    return true;
+  }
+  VLOG(1) << "Compacting file catalog: " << path();
+  return Load() && Save();
+}
+
+bool FileCatalog::has_area(const std::string& area) const {
+  return areas_.find(area) != std::end(areas_);
+}
+
+std::optional<std::vector<std::string>>
+FileCatalog::candidates(const std::string& area, const file_catalog_query_t& q) const {
+  if (!has_area(area)) {
+    return std::nullopt;
+  }
+  Matcher m(*this, q);
+  std::vector<std::string> result;
+  for (auto it = keys_.lower_bound({area, ""}); it != std::end(keys_) && it->first.first == area;
+       ++it) {
+    if (m.matches(it->second, entries_.at(it->second))) {
+      result.push_back(it->first.second);
+    }
+  }
+  return result;
+}
+
+void FileCatalog::Search(const file_catalog_query_t& q,
+                         const std::function<bool(const entry_t&)>& fn) const {
+  Matcher m(*this, q);
+  for (const auto& [key, id] : keys_) {
+    const auto& e = entries_.at(id);
+    if (m.matches(id, e) && !fn(e)) {
+      return;
+    }
+  }
+}
+
+} // namespace wwiv::sdk::files
@@ -0,0 +1,178 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_FILES_FILE_CATALOG_H
+#define INCLUDED_SDK_FILES_FILE_CATALOG_H
+
+#include "sdk/index_io.h"
+#include "sdk/vardec.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wwiv::sdk::files {
+
+class FileArea;
+
+/** What to look for in the catalog.  Empty fields match everything. */
+struct file_catalog_query_t {
+  // Aligned file mask, i.e. 'FOO?????.ZIP'.
+  std::string filemask;
+  // Only files uploaded on or after this.
+  daten_t newer_than{0};
+  // Keywords to look for in the filename, description and extended
+  // description, in the form used by keyword_formula_match.
+  std::string keywords;
+};
+
+/**
+ * Evaluates a ListPlus keyword search formula, calling has_term to see if
+ * each term in it is found.  Terms are separated by '&' or ' ' (and), or
+ * '|' (or), may be negated with '!' and grouped with parentheses.
+ */
+bool keyword_formula_match(const std::string& formula,
+                           const std::function<bool(const std::string&)>& has_term);
+
+/**
+ * Catalog of the files in every file area, from the (upper cased) words in
+ * the filename, description and extended description of each file to the
+ * files containing it, along with when each file was uploaded.  Areas are
+ * identified by the base filename of their .dir file.
+ *
+ * The catalog is kept in FILES.FCI in the data directory and is only there
+ * once it has been built (with "wwivutil files reindex").  After that,
+ * changes made through FileArea are appended to the journal in FILES.FCJ,
+ * which is applied by Load and folded into the catalog by Save.
+ *
+ * Words are split on whitespace, so a keyword (which can't contain any) is
+ * in a file's text exactly when it is part of one of its words.  Changes
+ * only ever add words to a file, so the catalog may find files that no
+ * longer match, but never misses one that does.  Callers must still check
+ * each file found.
+ */
+class FileCatalog final {
+public:
+  /** An entry in the catalog. */
+  struct entry_t {
+    std::string area;
+    // Aligned filename.
+    std::string filename;
+    daten_t daten;
+  };
+
+  explicit FileCatalog(const std::filesystem::path& datadir);
+
+  /** Loads the catalog and journal.  Returns false if it hasn't been built. */
+  bool Load();
+  /** Writes the catalog and removes the journal. */
+  bool Save();
+  /** Removes everything from the catalog in memory. */
+  void Clear();
+  /** True if the catalog has been built. */
+  [[nodiscard]] bool exists() const;
+
+  /** Adds (or adds to) a file in the catalog in memory. */
+  void Add(const std::string& area, const uploadsrec& u, const std::string& ext_desc);
+  /** Adds every file in files to the catalog in memory as area. */
+  void AddArea(const std::string& area, FileArea& files);
+  /** Removes a file from the catalog in memory. */
+  void Remove(const std::string& area, const std::string& filename);
+
+  /**
+   * Appends adding a file to the journal, if the catalog exists.  This
+   * doesn't need the catalog to be loaded.
+   */
+  bool JournalAdd(const std::string& area, const uploadsrec& u,
+                  const std::string& ext_desc = {}) const;
+  /** Appends adding an extended description to a file to the journal. */
+  bool JournalAddExtended(const std::string& area, const std::string& filename,
+                          const std::string& ext_desc) const;
+  /** Appends removing a file to the journal, if the catalog exists. */
+  bool JournalRemove(const std::string& area, const std::string& filename) const;
+  /** Folds the journal into the catalog once it gets too large. */
+  bool MaybeCompact();
+
+  /** True if area was in the catalog when it was built or has been added to since. */
+  [[nodiscard]] bool has_area(const std::string& area) const;
+  /**
+   * Aligned filenames of the files in area that may match q, sorted.
+   * Returns nullopt if area isn't in the catalog, in which case it needs to
+   * be searched the slow way.
+   */
+  [[nodiscard]] std::optional<std::vector<std::string>>
+  candidates(const std::string& area, const file_catalog_query_t& q) const;
+  /**
+   * Calls fn with each file that may match q, in order of area then
+   * filename, until fn returns false.
+   */
+  void Search(const file_catalog_query_t& q, const std::function<bool(const entry_t&)>& fn) const;
+
+  /** Number of files in the catalog. */
+  [[nodiscard]] int size() const noexcept { return static_cast<int>(entries_.size()); }
+  /** Number of distinct words in the catalog. */
+  [[nodiscard]] int number_of_words() const noexcept { return static_cast<int>(postings_.size()); }
+  [[nodiscard]] const std::filesystem::path& path() const noexcept { return files_.index_path(); }
+  [[nodiscard]] const std::filesystem::path& journal_path() const noexcept {
+    return files_.journal_path();
+  }
+
+  /** Calls fn with each distinct upper cased word in the text of a file. */
+  static void ForEachWord(const uploadsrec& u, const std::string& ext_desc,
+                          const std::function<void(const std::string&)>& fn);
+
+private:
+  typedef std::pair<std::string, std::string> key_t;
+  class Matcher;
+
+  // Adds words to a file, adding the file too if daten is given.
+  void AddWords(const std::string& area, const std::string& filename,
+                std::optional<daten_t> daten, const std::vector<std::string>& words);
+  // Returns the number of bytes of whole records applied.
+  std::size_t ApplyJournal(const std::string& data);
+  // Returns the contents of the catalog file.
+  [[nodiscard]] std::string Serialize() const;
+
+  // FILES.FCI and FILES.FCJ.
+  const IndexJournal files_;
+  std::set<std::string> areas_;
+  // Id of each file by area and filename.
+  std::map<key_t, uint32_t> keys_;
+  // Files in the catalog by id.
+  std::unordered_map<uint32_t, entry_t> entries_;
+  // Word to the sorted ids of the files containing it.
+  std::unordered_map<std::string, std::vector<uint32_t>> postings_;
+  // Keyword to the sorted ids of the files with a word containing it, filled
+  // in as keywords are searched for, so searching area after area for the
+  // same keywords only looks through the words once.
+  mutable std::unordered_map<std::string, std::vector<uint32_t>> terms_;
+  uint32_t next_id_{0};
+  // How much of the journal has been applied.
+  int64_t journal_applied_{0};
+};
+
+} // namespace wwiv::sdk::files
+
+#endif
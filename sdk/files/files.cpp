@@ -25,6 +25,7 @@
 #include "core/stl.h"
 #include "core/strings.h"
 #include "sdk/vardec.h"
+#include "sdk/files/file_catalog.h"
 #include "sdk/files/files_ext.h"
 #include <algorithm>
 #include <string>
@@ -148,6 +149,7 @@ FileAreaHeader& FileArea::header() const {
 
 bool FileArea::Load() {
   dirty_ = false;
+  index_dirty_ = true;
 
   if (auto file = DataFile<uploadsrec>(path(), File::modeReadOnly | File::modeBinary)) {
     if (file.ReadVector(files_)) {
@@ -201,10 +203,10 @@ std::map<FileAreaSortType, UlrCompare> CreateSortFunctions() {
     return r.daten < l.daten;
   });
   m.emplace(FileAreaSortType::FILENAME_ASC, [](const uploadsrec& l, const uploadsrec& r){
-    return StringCompare(l.filename, r.filename) == -1;
+    return StringCompare(l.filename, r.filename) < 0;
   });
   m.emplace(FileAreaSortType::FILENAME_DESC, [](const uploadsrec& l, const uploadsrec& r){
-    return StringCompare(r.filename, l.filename) == -1;
+    return StringCompare(r.filename, l.filename) < 0;
   });
   return m;
 }
@@ -219,6 +221,7 @@ bool FileArea::Sort(FileAreaSortType type) {
   const auto& f = compare_funcs.at(type);
   std::sort(std::begin(files_) + 1, std::end(files_), f);
   dirty_ = true;
+  index_dirty_ = true;
   return true;
 }
 
@@ -236,6 +239,12 @@ bool FileArea::AddFile(const FileRecord& f) {
   header_->set_num_files(stl::size_uint32(files_) - 1);
   header_->set_daten(std::max(header_->daten(), f.u().daten));
   dirty_ = true;
+  if (!index_dirty_) {
+    // Everything else moved down by one, and this is now the first match.
+    ++index_base_;
+    index_[f.u().filename] = 1 - index_base_;
+  }
+  FileCatalog(data_directory_).JournalAdd(base_filename_, f.u());
   return true;
 }
 
@@ -251,9 +260,21 @@ bool FileArea::AddFile(FileRecord& f, const std::string& ext_desc) {
 }
 
 bool FileArea::UpdateFile(FileRecord& f, int num) {
-  files_.at(num) = f.u();
+  auto& u = files_.at(num);
+  const std::string old_filename = u.filename;
+  if (old_filename != f.u().filename) {
+    index_dirty_ = true;
+  }
+  u = f.u();
   header_->set_daten(std::max(header_->daten(), f.u().daten));
   dirty_ = true;
+
+  if (const FileCatalog catalog(data_directory_); catalog.exists()) {
+    if (old_filename != f.u().filename && !contains_filename(old_filename)) {
+      catalog.JournalRemove(base_filename_, old_filename);
+    }
+    catalog.JournalAdd(base_filename_, f.u());
+  }
   return true;
 }
 
@@ -287,8 +308,12 @@ bool FileArea::DeleteFile(int file_number) {
     DeleteExtendedDescription(old.filename);
   }
   dirty_ = true;
+  index_dirty_ = true;
   header_->set_num_files(files_.empty() ? 0 : stl::size_uint32(files_) - 1);
-
+  // Leave it in the catalog if there's another file with the same name.
+  if (!contains_filename(old.filename)) {
+    FileCatalog(data_directory_).JournalRemove(base_filename_, old.filename);
+  }
   return true;
 }
 
@@ -321,7 +346,11 @@ bool FileArea::AddExtendedDescription(const std::string& file_name, const std::s
   if (!o) {
     return false;
   }
-  return o.value()->AddExtended(file_name, text);
+  if (!o.value()->AddExtended(file_name, text)) {
+    return false;
+  }
+  FileCatalog(data_directory_).JournalAddExtended(base_filename_, file_name, text);
+  return true;
 }
 
 bool FileArea::AddExtendedDescription(const FileRecord& f, const std::string& text) {
@@ -379,6 +408,7 @@ const std::vector<uploadsrec>& FileArea::raw_files() const {
 
 bool FileArea::set_raw_files(std::vector<uploadsrec> nf) {
   files_ = std::move(nf);
+  index_dirty_ = true;
   return true;
 }
 
@@ -390,14 +420,32 @@ std::optional<int> FileArea::FindFile(const FileName& f) {
   return FindFile(f.aligned_filename());
 }
 
+void FileArea::BuildIndex() {
+  index_.clear();
+  index_.reserve(files_.size());
+  index_base_ = 0;
+  // Skip the header, it's not a file.
+  for (auto i = 1; i < stl::ssize(files_); i++) {
+    // emplace won't replace an earlier match.
+    index_.emplace(files_[i].filename, i);
+  }
+  index_dirty_ = false;
+}
+
+bool FileArea::contains_filename(const std::string& file_name) const {
+  return std::any_of(std::begin(files_) + (files_.empty() ? 0 : 1), std::end(files_),
+                     [&](const uploadsrec& u) { return file_name == u.filename; });
+}
+
 std::optional<int> FileArea::FindFile(const std::string& file_name) {
-  for (auto i = 0; i < stl::ssize(files_); i++) {
-    const auto& c = stl::at(files_, i);
-    if (file_name == c.filename) {
-      return {i};
-    }
+  if (index_dirty_) {
+    BuildIndex();
   }
-  return std::nullopt;
+  const auto it = index_.find(file_name);
+  if (it == std::end(index_)) {
+    return std::nullopt;
+  }
+  return {it->second + index_base_};
 }
 
 bool aligned_wildcard_match(const std::string& l, const std::string& r) {
@@ -419,6 +467,15 @@ std::optional<int> FileArea::SearchFile(const std::string& filemask, int start_n
     return std::nullopt;
   }
 
+  if (filemask.find('?') == std::string::npos) {
+    // No wildcards, so we only need to scan when there's a match before
+    // start_num, since there may be another one after it.
+    const auto pos = FindFile(filemask);
+    if (!pos || pos.value() >= start_num) {
+      return pos;
+    }
+  }
+
   for (auto i = start_num; i < stl::ssize(files_); i++) {
     const auto& c = stl::at(files_, i);
     if (aligned_wildcard_match(filemask, c.filename)) {
@@ -443,6 +500,7 @@ bool FileArea::Save() {
   const auto result = file.WriteVectorAndTruncate(files_);
   if (result) {
     dirty_ = false;
+    FileCatalog(data_directory_).MaybeCompact();
   }
   return result;
 }
@@ -26,6 +26,7 @@
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wwiv::sdk::files {
@@ -162,6 +163,10 @@ public:
 
 protected:
   bool ValidateFileNum(const FileRecord& f, int num);
+  // Rebuilds index_ from files_.
+  void BuildIndex();
+  // True if any file is named file_name, without needing the index.
+  [[nodiscard]] bool contains_filename(const std::string& file_name) const;
 
   // Not owned.
   FileApi* api_;
@@ -173,6 +178,14 @@ protected:
   bool dirty_{false};
   bool open_{false};
   std::vector<uploadsrec> files_;
+  // Aligned filename to the first position in files_ holding it, less
+  // index_base_.  AddFile inserts at the front, so bumping index_base_ is all
+  // that is needed to renumber the existing entries.
+  std::unordered_map<std::string, int> index_;
+  int index_base_{0};
+  // Set when files_ has changed in a way the index can't follow, it is
+  // rebuilt on the next lookup.
+  bool index_dirty_{true};
 
   std::unique_ptr<FileAreaHeader> header_;
   std::unique_ptr<FileAreaExtendedDesc> ext_desc_;
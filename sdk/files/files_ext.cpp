@@ -18,12 +18,14 @@
 #include "sdk/files/files_ext.h"
 
 #include "core/file.h"
+#include "core/log.h"
 #include "core/stl.h"
 #include "core/strings.h"
 #include "sdk/files/file_record.h"
 #include "sdk/files/files.h"
 #include "sdk/vardec.h"
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -45,34 +47,65 @@ FileAreaExtendedDesc::FileAreaExtendedDesc(FileApi* api, std::string data_direct
       num_files_(std::max<int>(std::numeric_limits<int16_t>::max(), num_files)) {}
 
 bool FileAreaExtendedDesc::Load() {
-  Close();
-
   File f(path());
   if (!f.Open(File::modeReadOnly | File::modeBinary)) {
+    Close();
     return false;
   }
+  return Load(f);
+}
+
+bool FileAreaExtendedDesc::Load(File& f) {
+  Close();
   const auto file_size = f.length();
-  if (!file_size) {
-    open_ = true;
+  data_.resize(static_cast<std::size_t>(file_size));
+  f.Seek(0, File::Whence::begin);
+  if (file_size > 0 && f.Read(&data_[0], file_size) != file_size) {
+    data_.clear();
+    return false;
+  }
+  Index();
+  Loaded();
+  open_ = true;
+  return true;
+}
+
+void FileAreaExtendedDesc::Loaded() {
+  std::error_code ec;
+  data_time_ = std::filesystem::last_write_time(path(), ec);
+}
+
+bool FileAreaExtendedDesc::stale() const {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path(), ec);
+  if (ec || size != data_.size()) {
     return true;
   }
-  for (long file_pos = 0, count = 0; file_pos < file_size && count <= num_files_; count++) {
-    f.Seek(file_pos, File::Whence::begin);
+  return std::filesystem::last_write_time(path(), ec) != data_time_ || ec;
+}
+
+void FileAreaExtendedDesc::Index() {
+  ext_.clear();
+  index_.clear();
+  const auto file_size = data_.size();
+  for (std::size_t file_pos = 0, count = 0;
+       file_pos + sizeof(ext_desc_type) <= file_size && count <= static_cast<std::size_t>(num_files_);
+       count++) {
     ext_desc_type ed{};
-    const auto num_read = f.Read(&ed, sizeof(ext_desc_type));
-    if (num_read != sizeof(ext_desc_type)) {
-      // LOG ERROR? Return false here?
+    memcpy(&ed, data_.data() + file_pos, sizeof(ext_desc_type));
+    if (ed.len < 0) {
+      LOG(ERROR) << "Invalid extended description length: " << ed.len << " in: " << path();
       break;
     }
     ext_desc_rec e{};
-    strcpy(e.name, ed.name);
-    e.offset = file_pos;
+    to_char_array(e.name, string(ed.name, strnlen(ed.name, sizeof(ed.name))));
+    e.offset = static_cast<int32_t>(file_pos);
     ext_.emplace_back(e);
+    // Like a linear search, the first description for a file wins.
+    index_.emplace(e.name, file_pos);
 
-    file_pos += ed.len + static_cast<int>(sizeof(ext_desc_type));
+    file_pos += ed.len + sizeof(ext_desc_type);
   }
-  open_ = true;
-  return true;
 }
 
 bool FileAreaExtendedDesc::Save() {
@@ -81,12 +114,14 @@ bool FileAreaExtendedDesc::Save() {
 
 bool FileAreaExtendedDesc::Close() {
   ext_.clear();
+  index_.clear();
+  data_.clear();
   open_ = false;
   return true;
 }
 
 int FileAreaExtendedDesc::number_of_ext_descriptions() {
-  if (!open_) {
+  if (!open_ || stale()) {
     Load();
   }
   return wwiv::stl::size_int(ext_);
@@ -97,23 +132,35 @@ bool FileAreaExtendedDesc::AddExtended(const FileRecord& f, const std::string& t
 }
 
 bool FileAreaExtendedDesc::AddExtended(const std::string& file_name, const std::string& text) {
-  Close();
-
   ext_desc_type ed{};
   to_char_array(ed.name, file_name);
   ed.len = static_cast<int16_t>(text.size());
 
-  {
-    File file(path());
-    if (!file.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
-      return false;
-    }
-    file.Seek(0L, File::Whence::end);
-    file.Write(&ed, sizeof(ext_desc_type));
-    file.Write(text.c_str(), ed.len);
-    file.Close();
+  File file(path());
+  if (!file.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
+    return false;
   }
-  return Close();
+  const auto file_pos = file.Seek(0L, File::Whence::end);
+  file.Write(&ed, sizeof(ext_desc_type));
+  file.Write(text.c_str(), ed.len);
+  file.Close();
+
+  if (!open_) {
+    return true;
+  }
+  if (file_pos != static_cast<File::size_type>(data_.size())) {
+    // Someone else changed the file since we loaded it, reload it next time.
+    return Close();
+  }
+  data_.append(reinterpret_cast<const char*>(&ed), sizeof(ext_desc_type));
+  data_.append(text.c_str(), ed.len);
+  Loaded();
+  ext_desc_rec e{};
+  to_char_array(e.name, file_name);
+  e.offset = static_cast<int32_t>(file_pos);
+  ext_.emplace_back(e);
+  index_.emplace(e.name, static_cast<std::size_t>(file_pos));
+  return true;
 }
 
 bool FileAreaExtendedDesc::DeleteExtended(const FileRecord& f) {
@@ -122,37 +169,47 @@ bool FileAreaExtendedDesc::DeleteExtended(const FileRecord& f) {
 }
 
 bool FileAreaExtendedDesc::DeleteExtended(const std::string& file_name) {
-
-  ext_desc_type ed{};
-
+  // Keep the file open (and locked) from reading it until it is rewritten so
+  // that nothing added by anyone else in between is lost.
   File file(path());
-  if (!file.Open(File::modeBinary | File::modeCreateFile | File::modeReadWrite)) {
+  if (!file.Open(File::modeBinary | File::modeReadWrite)) {
+    // There is no .ext file, so nothing to delete.
+    Close();
+    return true;
+  }
+  if ((!open_ || stale()) && !Load(file)) {
     return false;
   }
-  const auto file_size = file.length();
-  File::size_type r = 0, w = 0;
-  while (r < file_size) {
-    file.Seek(r, File::Whence::begin);
-    file.Read(&ed, sizeof(ext_desc_type));
-    if (ed.len < 10000) {
-      string ss;
-      ss.resize(ed.len);
-      file.Read(&ss[0], ed.len);
-      if (file_name != ed.name) {
-        if (r != w) {
-          file.Seek(w, File::Whence::begin);
-          file.Write(&ed, sizeof(ext_desc_type));
-          file.Write(ss.data(), ed.len);
-        }
-        w += sizeof(ext_desc_type) + ed.len;
-      }
+  if (index_.find(file_name) == std::end(index_)) {
+    return true;
+  }
+
+  string out;
+  out.reserve(data_.size());
+  for (std::size_t r = 0; r + sizeof(ext_desc_type) <= data_.size();) {
+    ext_desc_type ed{};
+    memcpy(&ed, data_.data() + r, sizeof(ext_desc_type));
+    if (ed.len < 0) {
+      break;
+    }
+    const auto len = std::min<std::size_t>(ed.len, data_.size() - r - sizeof(ext_desc_type));
+    if (ed.len < 10000 && file_name != string(ed.name, strnlen(ed.name, sizeof(ed.name)))) {
+      out.append(data_, r, sizeof(ext_desc_type) + len);
     }
     r += sizeof(ext_desc_type) + ed.len;
   }
-  file.Close();
-  file.set_length(w);
 
-  return Close();
+  file.Seek(0, File::Whence::begin);
+  const auto ok = file.Write(out.data(), out.size()) == static_cast<File::size_type>(out.size()) &&
+                  file.set_length(static_cast<File::size_type>(out.size()));
+  file.Close();
+  if (!ok) {
+    return Close();
+  }
+  data_ = std::move(out);
+  Index();
+  Loaded();
+  return true;
 }
 
 std::optional<std::string> FileAreaExtendedDesc::ReadExtended(const FileRecord& f) {
@@ -160,35 +217,22 @@ std::optional<std::string> FileAreaExtendedDesc::ReadExtended(const FileRecord&
 }
 
 std::optional<std::string> FileAreaExtendedDesc::ReadExtended(const std::string& file_name) {
-    if (!open_) {
+  if (!open_ || stale()) {
     if (!Load()) {
       return std::nullopt;
     }
   }
-  for (const auto& ext : ext_) {
-    if (file_name != ext.name) {
-      continue;
-    }
-    File file(path());
-    if (!file.Open(File::modeBinary | File::modeReadOnly)) {
-      return std::nullopt;
-    }
-    file.Seek(ext.offset, File::Whence::begin);
-    ext_desc_type ed{};
-    const auto num_read = file.Read(&ed, sizeof(ext_desc_type));
-    if (num_read != sizeof(ext_desc_type) || file_name != ed.name) {
-      Close();
-      return std::nullopt;
-    }
-    string ss;
-    ss.resize(ed.len);
-    file.Read(&ss[0], ed.len);
-    file.Close();
-
-    StringTrimEnd(&ss);
-    return {ss};
+  const auto it = index_.find(file_name);
+  if (it == std::end(index_)) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  const auto offset = it->second;
+  ext_desc_type ed{};
+  memcpy(&ed, data_.data() + offset, sizeof(ext_desc_type));
+  const auto start = offset + sizeof(ext_desc_type);
+  auto ss = data_.substr(start, std::min<std::size_t>(ed.len, data_.size() - start));
+  StringTrimEnd(&ss);
+  return {ss};
 }
 
 std::optional<std::vector<std::string>> FileAreaExtendedDesc::ReadExtendedAsLines(
@@ -19,10 +19,12 @@
 #define __INCLUDED_SDK_FILES_FILES_EXT_H__
 
 #include "dirs.h"
+#include "core/file.h"
 #include "sdk/files/file_record.h"
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wwiv::sdk::files {
@@ -31,6 +33,14 @@ namespace wwiv::sdk::files {
 class FileApi;
 class FileRecord;
 
+/**
+ * The extended descriptions for a file area.
+ *
+ * The .ext file is read in one go on Load and kept in memory along with an
+ * index from aligned filename to record, so reading descriptions only goes
+ * back to disk when the file has changed since it was loaded.  Adds and
+ * deletes write through to disk and keep the copy in memory up to date.
+ */
 class FileAreaExtendedDesc final {
 public:
 
@@ -62,6 +72,14 @@ public:
   [[nodiscard]] std::filesystem::path path() const noexcept;
 
 protected:
+  // Reads all of f into data_ and indexes it.
+  bool Load(core::File& f);
+  // Rebuilds ext_ and index_ from data_.
+  void Index();
+  // Remembers the on disk time of the file data_ matches.
+  void Loaded();
+  // True if the file on disk is not the one data_ was loaded from.
+  [[nodiscard]] bool stale() const;
 
   // Not owned.
   FileApi* api_;
@@ -73,6 +91,12 @@ protected:
   bool open_{false};
   std::vector<ext_desc_rec> ext_;
   int num_files_{0};
+  // Contents of the .ext file.
+  std::string data_;
+  // Last write time of the .ext file when data_ was loaded or written.
+  std::filesystem::file_time_type data_time_{};
+  // Offset into data_ of the first record for each aligned filename.
+  std::unordered_map<std::string, std::size_t> index_;
 };
 
 std::string align(const std::string& file_name);
@@ -0,0 +1,83 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_FILES_ZIP_FORMAT_H
+#define INCLUDED_SDK_FILES_ZIP_FORMAT_H
+
+#include <cstdint>
+
+namespace wwiv::sdk::files {
+
+// .ZIP structures and defines
+//
+// https://www.hanshq.net/zip.html
+
+inline constexpr uint32_t ZIP_LOCAL_SIG = 0x04034b50;
+inline constexpr uint32_t ZIP_CENT_START_SIG = 0x02014b50;
+inline constexpr uint32_t ZIP_CENT_END_SIG = 0x06054b50;
+
+#pragma pack(push, 1)
+struct zip_local_header {
+  uint32_t signature; // 0x04034b50
+  uint16_t extract_ver;
+  uint16_t flags;
+  uint16_t comp_meth;
+  uint16_t mod_time;
+  uint16_t mod_date;
+  uint32_t crc_32;
+  uint32_t comp_size;
+  uint32_t uncomp_size;
+  uint16_t filename_len;
+  uint16_t extra_length;
+};
+
+struct zip_central_dir {
+  uint32_t signature; // 0x02014b50
+  uint16_t made_ver;
+  uint16_t extract_ver;
+  uint16_t flags;
+  uint16_t comp_meth;
+  uint16_t mod_time;
+  uint16_t mod_date;
+  uint32_t crc_32;
+  uint32_t comp_size;
+  uint32_t uncomp_size;
+  uint16_t filename_len;
+  uint16_t extra_len;
+  uint16_t comment_len;
+  uint16_t disk_start;
+  uint16_t int_attr;
+  uint32_t ext_attr;
+  uint32_t rel_ofs_header;
+};
+
+struct zip_end_dir {
+  uint32_t signature; // 0x06054b50
+  uint16_t disk_num;
+  uint16_t cent_dir_disk_num;
+  uint16_t total_entries_this_disk;
+  uint16_t total_entries_total;
+  uint32_t central_dir_size;
+  uint32_t ofs_cent_dir;
+  uint16_t comment_len;
+};
+#pragma pack(pop)
+
+} // namespace wwiv::sdk::files
+
+#endif
@@ -0,0 +1,152 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/files/zip_writer.h"
+
+#include "core/crc32.h"
+#include "core/log.h"
+#include "sdk/files/zip_format.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+using namespace wwiv::core;
+
+namespace wwiv::sdk::files {
+
+// Version 1.0 is all that is needed to extract stored files, made by MS-DOS
+// (0) using version 2.0 of the spec.
+static constexpr uint16_t kZipExtractVersion = 10;
+static constexpr uint16_t kZipMadeVersion = 20;
+static constexpr uint16_t kZipMethodStored = 0;
+
+template <typename T> static void append_struct(std::string& s, const T& t) {
+  s.append(reinterpret_cast<const char*>(&t), sizeof(T));
+}
+
+static uint16_t dos_date(const DateTime& dt) {
+  const auto tm = dt.to_tm();
+  // DOS dates start in 1980.
+  const auto year = std::max(0, tm.tm_year - 80);
+  return static_cast<uint16_t>(year << 9 | (tm.tm_mon + 1) << 5 | tm.tm_mday);
+}
+
+static uint16_t dos_time(const DateTime& dt) {
+  const auto tm = dt.to_tm();
+  return static_cast<uint16_t>(tm.tm_hour << 11 | tm.tm_min << 5 | tm.tm_sec / 2);
+}
+
+ZipWriter::ZipWriter(const std::filesystem::path& path) : file_(path) {}
+
+ZipWriter::~ZipWriter() {
+  if (is_open()) {
+    Close();
+  }
+}
+
+bool ZipWriter::Create() {
+  if (!file_.Open(File::modeCreateFile | File::modeExclusive | File::modeReadWrite |
+                      File::modeBinary,
+                  File::shareDenyReadWrite)) {
+    LOG(ERROR) << "Unable to create zip file: " << file_;
+    return false;
+  }
+  central_dir_.clear();
+  num_entries_ = 0;
+  offset_ = 0;
+  return true;
+}
+
+bool ZipWriter::Add(const std::string& filename, const std::string& data, const DateTime& dt) {
+  if (!is_open()) {
+    return false;
+  }
+  constexpr auto kMaxSize = std::numeric_limits<uint32_t>::max();
+  const auto size = sizeof(zip_local_header) + filename.size() + data.size();
+  if (num_entries_ == std::numeric_limits<uint16_t>::max() ||
+      filename.size() > std::numeric_limits<uint16_t>::max() || size > kMaxSize - offset_) {
+    LOG(ERROR) << "Zip file too large to add: " << filename << " to " << file_;
+    return false;
+  }
+
+  zip_local_header lh{};
+  lh.signature = ZIP_LOCAL_SIG;
+  lh.extract_ver = kZipExtractVersion;
+  lh.comp_meth = kZipMethodStored;
+  lh.mod_time = dos_time(dt);
+  lh.mod_date = dos_date(dt);
+  lh.crc_32 = crc32string(data);
+  lh.comp_size = static_cast<uint32_t>(data.size());
+  lh.uncomp_size = static_cast<uint32_t>(data.size());
+  lh.filename_len = static_cast<uint16_t>(filename.size());
+
+  std::string entry;
+  entry.reserve(size);
+  append_struct(entry, lh);
+  entry.append(filename);
+  entry.append(data);
+  if (file_.Write(entry) != static_cast<File::size_type>(entry.size())) {
+    LOG(ERROR) << "Error writing " << filename << " to zip file: " << file_;
+    // Leave the file where the last good entry ended.
+    file_.Seek(offset_, File::Whence::begin);
+    return false;
+  }
+
+  zip_central_dir cd{};
+  cd.signature = ZIP_CENT_START_SIG;
+  cd.made_ver = kZipMadeVersion;
+  cd.extract_ver = lh.extract_ver;
+  cd.comp_meth = lh.comp_meth;
+  cd.mod_time = lh.mod_time;
+  cd.mod_date = lh.mod_date;
+  cd.crc_32 = lh.crc_32;
+  cd.comp_size = lh.comp_size;
+  cd.uncomp_size = lh.uncomp_size;
+  cd.filename_len = lh.filename_len;
+  cd.rel_ofs_header = offset_;
+  append_struct(central_dir_, cd);
+  central_dir_.append(filename);
+
+  offset_ += static_cast<uint32_t>(entry.size());
+  ++num_entries_;
+  return true;
+}
+
+bool ZipWriter::Close() {
+  if (!is_open()) {
+    return false;
+  }
+  zip_end_dir ed{};
+  ed.signature = ZIP_CENT_END_SIG;
+  ed.total_entries_this_disk = num_entries_;
+  ed.total_entries_total = num_entries_;
+  ed.central_dir_size = static_cast<uint32_t>(central_dir_.size());
+  ed.ofs_cent_dir = offset_;
+
+  auto data = central_dir_;
+  append_struct(data, ed);
+  const auto ok = file_.Write(data) == static_cast<File::size_type>(data.size());
+  if (!ok) {
+    LOG(ERROR) << "Error writing central directory to zip file: " << file_;
+  }
+  file_.Close();
+  central_dir_.clear();
+  return ok;
+}
+
+} // namespace wwiv::sdk::files
@@ -0,0 +1,69 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_FILES_ZIP_WRITER_H
+#define INCLUDED_SDK_FILES_ZIP_WRITER_H
+
+#include "core/datetime.h"
+#include "core/file.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace wwiv::sdk::files {
+
+/**
+ * Writes a new ZIP archive without needing an external archiver.  Files are
+ * stored uncompressed, which every unzip can extract, and each one is written
+ * to disk as it is added.
+ *
+ * The archive is only complete once Close writes the central directory, so
+ * don't hand it to anyone else before then.
+ */
+class ZipWriter final {
+public:
+  explicit ZipWriter(const std::filesystem::path& path);
+  ~ZipWriter();
+  ZipWriter(const ZipWriter&) = delete;
+  ZipWriter& operator=(const ZipWriter&) = delete;
+
+  /** Creates the archive.  Fails if a file already exists at path. */
+  bool Create();
+
+  /** Adds a file named filename holding data, last modified at dt. */
+  bool Add(const std::string& filename, const std::string& data, const core::DateTime& dt);
+
+  /** Writes the central directory and closes the archive. */
+  bool Close();
+
+  [[nodiscard]] bool is_open() const noexcept { return file_.IsOpen(); }
+  [[nodiscard]] const std::filesystem::path& path() const noexcept { return file_.path(); }
+  [[nodiscard]] int num_entries() const noexcept { return num_entries_; }
+
+private:
+  core::File file_;
+  // Central directory records for the entries written so far.
+  std::string central_dir_;
+  uint16_t num_entries_{0};
+  // Offset of the next local header.
+  uint32_t offset_{0};
+};
+
+} // namespace wwiv::sdk::files
+
+#endif
@@ -0,0 +1,147 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/index_io.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+
+using namespace wwiv::core;
+
+namespace wwiv::sdk {
+
+void put_u16(std::string& s, uint16_t v) {
+  s.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void put_u32(std::string& s, uint32_t v) {
+  s.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void put_varint(std::string& s, uint32_t v) {
+  while (v >= 0x80) {
+    s.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  s.push_back(static_cast<char>(v));
+}
+
+void put_string(std::string& s, const std::string& v) {
+  const auto len = static_cast<uint16_t>(std::min<std::size_t>(v.size(), 0xffff));
+  put_u16(s, len);
+  s.append(v, 0, len);
+}
+
+bool IndexReader::get_varint(uint32_t& v) {
+  v = 0;
+  for (auto shift = 0; shift < 35; shift += 7) {
+    if (pos_ >= data_.size()) {
+      return false;
+    }
+    const auto b = static_cast<uint8_t>(data_[pos_++]);
+    v |= static_cast<uint32_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IndexReader::get_string(std::string& s) {
+  uint16_t len{0};
+  if (!get(len) || data_.size() - pos_ < len) {
+    return false;
+  }
+  s.assign(data_.data() + pos_, len);
+  pos_ += len;
+  return true;
+}
+
+std::optional<std::string> read_index_file(const std::filesystem::path& path) {
+  File f(path);
+  if (!f.Exists() || !f.Open(File::modeBinary | File::modeReadOnly, File::shareDenyNone)) {
+    return std::nullopt;
+  }
+  const auto len = f.length();
+  if (len <= 0) {
+    return std::string();
+  }
+  std::string data(static_cast<std::size_t>(len), '\0');
+  if (f.Read(&data[0], len) != len) {
+    return std::nullopt;
+  }
+  return data;
+}
+
+IndexJournal::IndexJournal(std::filesystem::path index_path, std::filesystem::path journal_path)
+    : index_path_(std::move(index_path)), journal_path_(std::move(journal_path)) {}
+
+bool IndexJournal::index_exists() const { return File::Exists(index_path_); }
+
+bool IndexJournal::Append(const std::string& rec) const {
+  if (!index_exists()) {
+    return true;
+  }
+  File f(journal_path_);
+  if (!f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile)) {
+    LOG(ERROR) << "Unable to open index journal: " << journal_path_;
+    return false;
+  }
+  f.Seek(0, File::Whence::end);
+  return f.Write(rec) == static_cast<File::size_type>(rec.size());
+}
+
+bool IndexJournal::needs_compact() const {
+  if (!index_exists() || !File::Exists(journal_path_)) {
+    return false;
+  }
+  const auto journal_size = File(journal_path_).length();
+  return journal_size >= kMinCompactSize && journal_size >= File(index_path_).length() / 2;
+}
+
+bool IndexJournal::Rewrite(File::size_type offset,
+                           const std::function<std::string(const std::string&)>& build) const {
+  // Hold the journal locked so nothing is added to it while we fold it into
+  // the index and empty it.
+  File journal(journal_path_);
+  std::string rest;
+  if (journal.Exists() && journal.Open(File::modeBinary | File::modeReadWrite)) {
+    const auto len = journal.length();
+    if (len > offset) {
+      rest.resize(static_cast<std::size_t>(len - offset));
+      journal.Seek(offset, File::Whence::begin);
+      if (journal.Read(&rest[0], len - offset) != len - offset) {
+        rest.clear();
+      }
+    }
+  }
+  const auto data = build(rest);
+
+  if (!File::ReplaceContents(index_path_, data)) {
+    return false;
+  }
+  if (journal.IsOpen()) {
+    journal.set_length(0);
+  }
+  return true;
+}
+
+} // namespace wwiv::sdk
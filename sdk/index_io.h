@@ -0,0 +1,118 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_INDEX_IO_H
+#define INCLUDED_SDK_INDEX_IO_H
+
+#include "core/file.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * Helpers shared by the indexes kept next to WWIV's own data files (the
+ * message search index and the file catalog): a simple binary encoding, and
+ * the index file plus journal of changes appended since it was written.
+ */
+namespace wwiv::sdk {
+
+void put_u16(std::string& s, uint16_t v);
+void put_u32(std::string& s, uint32_t v);
+/** Writes v 7 bits at a time, low bits first, so small values take one byte. */
+void put_varint(std::string& s, uint32_t v);
+/** Writes a u16 length followed by (at most 0xffff bytes of) v. */
+void put_string(std::string& s, const std::string& v);
+
+/** Reads the values written by the put_ functions, failing once past the end. */
+class IndexReader final {
+public:
+  explicit IndexReader(std::string_view data) : data_(data) {}
+
+  template <typename T> bool get(T& v) {
+    if (data_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    memcpy(&v, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool get_varint(uint32_t& v);
+  bool get_string(std::string& s);
+
+  [[nodiscard]] bool done() const noexcept { return pos_ == data_.size(); }
+  [[nodiscard]] std::size_t pos() const noexcept { return pos_; }
+
+private:
+  std::string_view data_;
+  std::size_t pos_{0};
+};
+
+/** Reads all of path, without locking it, or returns nullopt if it can't. */
+std::optional<std::string> read_index_file(const std::filesystem::path& path);
+
+/**
+ * An index file along with the journal of records appended to it since the
+ * index was last written.
+ *
+ * The journal is only written once the index exists.  Readers apply the
+ * whole records in it after loading the index.  Rewrite folds it into the
+ * index while holding it locked, so nothing can be added in between, and
+ * then empties it.
+ */
+class IndexJournal final {
+public:
+  IndexJournal(std::filesystem::path index_path, std::filesystem::path journal_path);
+
+  [[nodiscard]] const std::filesystem::path& index_path() const noexcept { return index_path_; }
+  [[nodiscard]] const std::filesystem::path& journal_path() const noexcept { return journal_path_; }
+  [[nodiscard]] bool index_exists() const;
+
+  /** Appends rec to the journal, if there is an index for it to apply to. */
+  bool Append(const std::string& rec) const;
+
+  /**
+   * True once the journal is bigger than kMinCompactSize and bigger than
+   * half of the index, so it's worth folding it into the index.
+   */
+  [[nodiscard]] bool needs_compact() const;
+
+  /**
+   * Rewrites the index while holding the journal locked.  build is passed
+   * whatever was appended to the journal past offset and returns the new
+   * contents of the index, which is written under a temporary name first so
+   * nobody reads a partial one.  The journal is emptied afterwards.
+   */
+  bool Rewrite(core::File::size_type offset,
+               const std::function<std::string(const std::string&)>& build) const;
+
+  static constexpr core::File::size_type kMinCompactSize = 256 * 1024;
+
+private:
+  const std::filesystem::path index_path_;
+  const std::filesystem::path journal_path_;
+};
+
+} // namespace wwiv::sdk
+
+#endif
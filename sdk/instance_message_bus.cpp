@@ -0,0 +1,177 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/instance_message_bus.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "fmt/format.h"
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk {
+
+// Largest message we'll receive.
+static constexpr std::size_t kMaxMessageSize = 64 * 1024;
+
+// static
+std::filesystem::path InstanceMessageBus::SocketPath(const std::filesystem::path& datadir,
+                                                     int instance) {
+  return FilePath(FilePath(datadir, "inst"), fmt::format("inst{:03}.sock", instance));
+}
+
+#ifdef _WIN32
+
+// Windows only has stream Unix domain sockets, so everything goes through
+// the message files there.
+InstanceMessageBus::InstanceMessageBus(const std::filesystem::path& datadir, int instance)
+    : datadir_(datadir), path_(SocketPath(datadir, instance)) {}
+
+InstanceMessageBus::~InstanceMessageBus() = default;
+
+bool InstanceMessageBus::Send(int, const std::string&) { return false; }
+
+bool InstanceMessageBus::waiting() const { return false; }
+
+bool InstanceMessageBus::Wait(std::chrono::milliseconds) const { return false; }
+
+std::vector<std::string> InstanceMessageBus::Receive() { return {}; }
+
+#else // _WIN32
+
+static bool to_sockaddr(const std::filesystem::path& path, sockaddr_un& addr) {
+  const auto s = path.string();
+  if (s.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+  return true;
+}
+
+InstanceMessageBus::InstanceMessageBus(const std::filesystem::path& datadir, int instance)
+    : datadir_(datadir), path_(SocketPath(datadir, instance)) {
+  sockaddr_un addr{};
+  if (!to_sockaddr(path_, addr)) {
+    LOG(WARNING) << "Path too long for instance message socket: " << path_;
+    return;
+  }
+  if (!File::mkdirs(path_.parent_path())) {
+    LOG(WARNING) << "Unable to create directory: " << path_.parent_path();
+    return;
+  }
+  fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd_ < 0) {
+    LOG(WARNING) << "Unable to create instance message socket: " << strerror(errno);
+    return;
+  }
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+  fcntl(fd_, F_SETFD, FD_CLOEXEC);
+  // Any socket left here was from an instance with our number that exited
+  // without cleaning up.
+  unlink(addr.sun_path);
+  if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    LOG(WARNING) << "Unable to bind instance message socket: " << path_ << "; "
+                 << strerror(errno);
+    close(fd_);
+    fd_ = -1;
+    return;
+  }
+  struct stat st {};
+  if (stat(addr.sun_path, &st) == 0) {
+    dev_ = static_cast<uint64_t>(st.st_dev);
+    ino_ = static_cast<uint64_t>(st.st_ino);
+  }
+}
+
+InstanceMessageBus::~InstanceMessageBus() {
+  if (fd_ >= 0) {
+    close(fd_);
+    struct stat st {};
+    if (ino_ != 0 && stat(path_.string().c_str(), &st) == 0 &&
+        static_cast<uint64_t>(st.st_dev) == dev_ && static_cast<uint64_t>(st.st_ino) == ino_) {
+      unlink(path_.string().c_str());
+    }
+  }
+}
+
+bool InstanceMessageBus::Send(int dest, const std::string& message) {
+  if (fd_ < 0 || message.size() > kMaxMessageSize) {
+    return false;
+  }
+  sockaddr_un addr{};
+  if (!to_sockaddr(SocketPath(datadir_, dest), addr)) {
+    return false;
+  }
+  // Fails right away if nobody is bound there or their queue is full.
+  const auto num = sendto(fd_, message.data(), message.size(), 0,
+                          reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  if (num != static_cast<ssize_t>(message.size())) {
+    VLOG(1) << "Unable to send instance message to #" << dest << "; " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool InstanceMessageBus::waiting() const { return Wait(std::chrono::milliseconds(0)); }
+
+bool InstanceMessageBus::Wait(std::chrono::milliseconds timeout) const {
+  if (fd_ < 0) {
+    return false;
+  }
+  pollfd p{};
+  p.fd = fd_;
+  p.events = POLLIN;
+  return poll(&p, 1, static_cast<int>(timeout.count())) > 0 && (p.revents & POLLIN);
+}
+
+std::vector<std::string> InstanceMessageBus::Receive() {
+  std::vector<std::string> messages;
+  if (fd_ < 0) {
+    return messages;
+  }
+  std::string buf(kMaxMessageSize, '\0');
+  for (;;) {
+    const auto num = recv(fd_, &buf[0], buf.size(), 0);
+    if (num < 0) {
+      // EAGAIN, we're done.
+      break;
+    }
+    messages.emplace_back(buf.data(), static_cast<std::size_t>(num));
+  }
+  return messages;
+}
+
+#endif // _WIN32
+
+} // namespace wwiv::sdk
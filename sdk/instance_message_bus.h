@@ -0,0 +1,81 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_INSTANCE_MESSAGE_BUS_H
+#define INCLUDED_SDK_INSTANCE_MESSAGE_BUS_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace wwiv::sdk {
+
+/**
+ * Delivers inter-instance messages between BBS instances on the same host.
+ *
+ * Each instance binds a Unix domain datagram socket named for its instance
+ * number under {datadir}/inst, and others send to it directly.  The socket
+ * can be polled, so an instance waiting for input wakes up as soon as a
+ * message arrives instead of polling the directory for msg*.nnn files.
+ *
+ * Sending fails if the other instance isn't listening (or this platform
+ * doesn't support it), in which case callers should fall back to writing the
+ * message file.
+ */
+class InstanceMessageBus final {
+public:
+  InstanceMessageBus(const std::filesystem::path& datadir, int instance);
+  ~InstanceMessageBus();
+  InstanceMessageBus(const InstanceMessageBus&) = delete;
+  InstanceMessageBus& operator=(const InstanceMessageBus&) = delete;
+
+  /** True if this instance is listening for messages. */
+  [[nodiscard]] bool ok() const noexcept { return fd_ >= 0; }
+
+  /** Sends message to instance dest.  Returns false if it couldn't be delivered. */
+  bool Send(int dest, const std::string& message);
+
+  /** Returns true if a message is waiting without blocking. */
+  [[nodiscard]] bool waiting() const;
+
+  /** Waits up to timeout for a message, returning true if one is waiting. */
+  bool Wait(std::chrono::milliseconds timeout) const;
+
+  /** Returns all of the waiting messages. */
+  std::vector<std::string> Receive();
+
+  /** The socket to poll for readability, or -1. */
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+
+  static std::filesystem::path SocketPath(const std::filesystem::path& datadir, int instance);
+
+private:
+  const std::filesystem::path datadir_;
+  const std::filesystem::path path_;
+  int fd_{-1};
+  // Identity of the socket file we bound, so we never remove one that a
+  // newer instance with our number has since bound in its place.
+  uint64_t dev_{0};
+  uint64_t ino_{0};
+};
+
+} // namespace wwiv::sdk
+
+#endif
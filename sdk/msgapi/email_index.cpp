@@ -0,0 +1,222 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/msgapi/email_index.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::msgapi {
+
+static constexpr char kMagic[4] = {'W', 'E', 'I', 'X'};
+static constexpr uint32_t kVersion = 1;
+// Records read at a time while rebuilding.
+static constexpr int kRebuildChunk = 4096;
+
+EmailIndex::EmailIndex(const std::filesystem::path& email_dat)
+    : path_(std::filesystem::path(email_dat).replace_extension(".idx")) {}
+
+// static
+uint16_t EmailIndex::owner(const mailrec& m) {
+  if (m.tosys == 0 && m.touser == 0) {
+    return kFreeSlot;
+  }
+  if (m.tosys != 0 || m.touser == kFreeSlot) {
+    return kNoUser;
+  }
+  return m.touser;
+}
+
+void EmailIndex::Clear() {
+  owners_.clear();
+  mailboxes_.clear();
+  free_.clear();
+  data_size_ = 0;
+}
+
+void EmailIndex::Set(int slot, uint16_t owner) {
+  if (slot < 0) {
+    return;
+  }
+  if (slot >= number_of_slots()) {
+    // Anything between the old end and the new slot reads back as zeros.
+    for (auto i = number_of_slots(); i < slot; i++) {
+      free_.insert(i);
+    }
+    owners_.resize(slot + 1, kFreeSlot);
+    free_.insert(slot);
+    data_size_ = std::max<File::size_type>(
+        data_size_, static_cast<File::size_type>(owners_.size() * sizeof(mailrec)));
+  }
+  auto& old = owners_[slot];
+  if (old == owner) {
+    return;
+  }
+  if (old == kFreeSlot) {
+    free_.erase(slot);
+  } else if (old != kNoUser) {
+    auto& mb = mailboxes_[old];
+    if (const auto it = std::lower_bound(std::begin(mb), std::end(mb), slot);
+        it != std::end(mb) && *it == slot) {
+      mb.erase(it);
+    }
+    if (mb.empty()) {
+      mailboxes_.erase(old);
+    }
+  }
+  if (owner == kFreeSlot) {
+    free_.insert(slot);
+  } else if (owner != kNoUser) {
+    auto& mb = mailboxes_[owner];
+    // New mail almost always goes at the end.
+    if (mb.empty() || mb.back() < slot) {
+      mb.push_back(slot);
+    } else {
+      mb.insert(std::lower_bound(std::begin(mb), std::end(mb), slot), slot);
+    }
+  }
+  old = owner;
+}
+
+bool EmailIndex::Load(File& email_dat) {
+  const auto data_size = email_dat.length();
+  File f(path_);
+  if (f.Exists() && f.Open(File::modeBinary | File::modeReadOnly, File::shareDenyNone)) {
+    email_index_header_t h{};
+    if (f.Read(&h, sizeof(h)) == static_cast<File::size_type>(sizeof(h)) &&
+        memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+        h.data_size == static_cast<uint64_t>(data_size) &&
+        f.length() == static_cast<File::size_type>(sizeof(h) + h.num_slots * sizeof(uint16_t))) {
+      std::vector<uint16_t> owners(h.num_slots);
+      const auto len = static_cast<File::size_type>(owners.size() * sizeof(uint16_t));
+      if (owners.empty() || f.Read(&owners[0], len) == len) {
+        Clear();
+        owners_.reserve(owners.size());
+        for (auto i = 0; i < static_cast<int>(owners.size()); i++) {
+          Set(i, owners[i]);
+        }
+        data_size_ = data_size;
+        return true;
+      }
+    }
+    f.Close();
+  }
+  VLOG(1) << "Rebuilding email index: " << path_;
+  return Rebuild(email_dat);
+}
+
+bool EmailIndex::Rebuild(File& email_dat) {
+  Clear();
+  const auto data_size = email_dat.length();
+  const auto num_slots = static_cast<int>(data_size / sizeof(mailrec));
+  owners_.reserve(num_slots);
+  std::vector<mailrec> recs(kRebuildChunk);
+  for (auto start = 0; start < num_slots; start += kRebuildChunk) {
+    const auto num = std::min(kRebuildChunk, num_slots - start);
+    const auto len = static_cast<File::size_type>(num * sizeof(mailrec));
+    email_dat.Seek(static_cast<File::size_type>(start) * sizeof(mailrec), File::Whence::begin);
+    if (email_dat.Read(&recs[0], len) != len) {
+      LOG(ERROR) << "Unable to read email file while rebuilding index: " << email_dat;
+      Clear();
+      return false;
+    }
+    for (auto i = 0; i < num; i++) {
+      Set(start + i, owner(recs[i]));
+    }
+  }
+  data_size_ = data_size;
+  return Save();
+}
+
+bool EmailIndex::Save() {
+  email_index_header_t h{};
+  memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.data_size = static_cast<uint64_t>(data_size_);
+  h.num_slots = static_cast<uint32_t>(owners_.size());
+
+  std::string data(reinterpret_cast<const char*>(&h), sizeof(h));
+  data.append(reinterpret_cast<const char*>(owners_.data()), owners_.size() * sizeof(uint16_t));
+
+  if (!File::ReplaceContents(path_, data)) {
+    LOG(ERROR) << "Unable to write email index: " << path_;
+    return false;
+  }
+  return true;
+}
+
+int EmailIndex::next_slot() const {
+  auto slot = number_of_slots();
+  for (auto it = free_.rbegin(); it != free_.rend() && *it == slot - 1; ++it) {
+    --slot;
+  }
+  return slot;
+}
+
+void EmailIndex::Update(int slot, const mailrec& m) { Set(slot, owner(m)); }
+
+void EmailIndex::Remove(int slot) {
+  if (slot >= 0 && slot < number_of_slots()) {
+    Set(slot, kFreeSlot);
+  }
+}
+
+void EmailIndex::Truncate(int num_slots) {
+  num_slots = std::max(0, num_slots);
+  for (auto i = number_of_slots() - 1; i >= num_slots; i--) {
+    Set(i, kFreeSlot);
+    free_.erase(i);
+  }
+  if (num_slots < number_of_slots()) {
+    owners_.resize(num_slots);
+  }
+  data_size_ = static_cast<File::size_type>(num_slots * sizeof(mailrec));
+}
+
+std::vector<int> EmailIndex::slots(int user_number) const {
+  if (user_number <= 0 || user_number >= kFreeSlot) {
+    return {};
+  }
+  const auto it = mailboxes_.find(static_cast<uint16_t>(user_number));
+  return it == std::end(mailboxes_) ? std::vector<int>{} : it->second;
+}
+
+int EmailIndex::count(int user_number) const {
+  if (user_number <= 0 || user_number >= kFreeSlot) {
+    return 0;
+  }
+  const auto it = mailboxes_.find(static_cast<uint16_t>(user_number));
+  return it == std::end(mailboxes_) ? 0 : static_cast<int>(it->second.size());
+}
+
+int EmailIndex::number_of_messages() const noexcept {
+  return number_of_slots() - static_cast<int>(free_.size());
+}
+
+int EmailIndex::number_of_slots() const noexcept { return static_cast<int>(owners_.size()); }
+
+} // namespace wwiv::sdk::msgapi
@@ -0,0 +1,120 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_MSGAPI_EMAIL_INDEX_H
+#define INCLUDED_SDK_MSGAPI_EMAIL_INDEX_H
+
+#include "core/file.h"
+#include "sdk/vardec.h"
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace wwiv::sdk::msgapi {
+
+#pragma pack(push, 1)
+struct email_index_header_t {
+  char magic[4];
+  uint32_t version;
+  // Size of EMAIL.DAT when the index was written.
+  uint64_t data_size;
+  uint32_t num_slots;
+  uint32_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(email_index_header_t) == 24);
+
+/**
+ * Index of the mailboxes in EMAIL.DAT, kept in EMAIL.IDX next to it.  For
+ * every record slot it holds the local user the mail in it is addressed to,
+ * from which it keeps the list of slots for each user and the list of free
+ * slots, so finding a user's mail doesn't need to read all of EMAIL.DAT.
+ *
+ * The index must only be used while EMAIL.DAT is open (and so locked), and
+ * anything that adds, removes or moves records in EMAIL.DAT must update it.
+ * Changes are saved before the matching record is written, so a crash in
+ * between leaves the index either listing a slot that doesn't hold the
+ * user's mail, which is why callers check each record they read, or a
+ * different size than EMAIL.DAT, which makes the next Load rebuild it.
+ */
+class EmailIndex final {
+public:
+  // Owner of a slot holding network mail, or mail not addressed to a user.
+  static constexpr uint16_t kNoUser = 0;
+  // Owner of a free slot.
+  static constexpr uint16_t kFreeSlot = 0xffff;
+
+  /** Creates the index for the EMAIL.DAT file at email_dat. */
+  explicit EmailIndex(const std::filesystem::path& email_dat);
+
+  /**
+   * Loads the index for the open EMAIL.DAT file, rebuilding and saving it if
+   * it is missing or out of date.
+   */
+  bool Load(core::File& email_dat);
+  /** Rebuilds the index by reading every record in email_dat and saves it. */
+  bool Rebuild(core::File& email_dat);
+  /** Writes the index to disk. */
+  bool Save();
+
+  /**
+   * Slot to write a new message to.  This is the first slot after the last
+   * one in use, like the BBS has always done, so that mailboxes stay in the
+   * order the mail arrived in.
+   */
+  [[nodiscard]] int next_slot() const;
+  /** Records that m is being written to slot. */
+  void Update(int slot, const mailrec& m);
+  /** Records that slot has been freed. */
+  void Remove(int slot);
+  /** Drops any slots from num_slots onwards. */
+  void Truncate(int num_slots);
+
+  /** Slots holding mail for user_number, in ascending order. */
+  [[nodiscard]] std::vector<int> slots(int user_number) const;
+  /** Number of messages waiting for user_number. */
+  [[nodiscard]] int count(int user_number) const;
+  /** Number of slots holding a message. */
+  [[nodiscard]] int number_of_messages() const noexcept;
+  /** Number of slots, including free ones. */
+  [[nodiscard]] int number_of_slots() const noexcept;
+  /** Free slots, in ascending order. */
+  [[nodiscard]] const std::set<int>& free_slots() const noexcept { return free_; }
+  /** The index file. */
+  [[nodiscard]] const std::filesystem::path& path() const noexcept { return path_; }
+
+  /** Owner of the slot holding m. */
+  static uint16_t owner(const mailrec& m);
+
+private:
+  void Clear();
+  void Set(int slot, uint16_t owner);
+
+  const std::filesystem::path path_;
+  std::vector<uint16_t> owners_;
+  std::unordered_map<uint16_t, std::vector<int>> mailboxes_;
+  std::set<int> free_;
+  core::File::size_type data_size_{0};
+};
+
+} // namespace wwiv::sdk::msgapi
+
+#endif
@@ -52,8 +52,11 @@ WWIVEmail::WWIVEmail(const Config& config, const std::filesystem::path& data_fil
   : Type2Text(text_filename), 
     config_(config), data_filename_(data_filename),
     mail_file_(data_filename_, File::modeBinary | File::modeReadWrite, File::shareDenyReadWrite),
-    max_net_num_(max_net_num) {
+    index_(data_filename_), max_net_num_(max_net_num) {
   open_ = mail_file_ && File::Exists(data_filename);
+  if (open_) {
+    index_.Load(mail_file_.file());
+  }
 }
 
 bool WWIVEmail::Close() {
@@ -140,21 +143,10 @@ static bool is_mailrec_deleted(const mailrec& h) {
 
 /** Total number of email messages in the system. */
 int WWIVEmail::number_of_messages() {
-  const auto num = mail_file_.number_of_records();
-  if (num == 0) { return 0; }
-  std::vector<mailrec> headers;
-  mail_file_.Seek(0);
-  if (!mail_file_.ReadVector(headers)) {
-    // WTF
-    return false;
-  }
-  int count = 0;
-  for (const auto& h : headers) {
-    if (!is_mailrec_deleted(h)) {
-      ++count;
-    }
+  if (!open_) {
+    return 0;
   }
-  return count;
+  return index_.number_of_messages();
 }
 
 int WWIVEmail::number_of_email_records() const {
@@ -164,6 +156,21 @@ int WWIVEmail::number_of_email_records() const {
   return static_cast<int>(mail_file_.number_of_records());
 }
 
+std::vector<int> WWIVEmail::messages_for_user(int user_number) {
+  std::vector<int> result;
+  if (!open_) {
+    return result;
+  }
+  for (const auto slot : index_.slots(user_number)) {
+    // The index may be behind EMAIL.DAT, so make sure it's still theirs.
+    mailrec m{};
+    if (mail_file_.Read(slot, &m) && m.tosys == 0 && m.touser == user_number) {
+      result.push_back(slot);
+    }
+  }
+  return result;
+}
+
 /** Temporary API to read the header from an email message. */
 bool WWIVEmail::read_email_header(int email_number, mailrec& m) {
   if (!open_) {
@@ -238,6 +245,8 @@ bool WWIVEmail::DeleteMessage(int email_number) {
 
   // Clear out the email record and write it back to EMAIL.DAT
   // so the slot may be reused later.
+  index_.Remove(email_number);
+  index_.Save();
   m.touser = 0;
   m.tosys = 0;
   m.daten = 0xffffffff;
@@ -266,27 +275,22 @@ bool WWIVEmail::DeleteAllMailToOrFrom(int user_number) {
   return true;
 }
 
+bool WWIVEmail::RebuildIndex() {
+  if (!open_) {
+    return false;
+  }
+  return index_.Rebuild(mail_file_.file());
+}
+
 // Implementation Details
 
 bool WWIVEmail::add_email(const mailrec& m) {
   if (!open_) {
     return false;
   }
-  auto recno = 0;
-  const int max_size = static_cast<int>(mail_file_.number_of_records());
-  if (max_size > 0) {
-    mailrec temprec{};
-    recno = max_size - 1;
-    mail_file_.Read(recno, &temprec);
-    while (recno > 0 && temprec.tosys == 0 && temprec.touser == 0) {
-      --recno;
-      mail_file_.Read(recno, &temprec);
-    }
-    if (temprec.tosys || temprec.touser) {
-      ++recno;
-    }
-  }
-
+  const auto recno = index_.next_slot();
+  index_.Update(recno, m);
+  index_.Save();
   return mail_file_.Write(recno, &m);
 }
 
@@ -20,10 +20,12 @@
 
 #include "core/datafile.h"
 #include "sdk/config.h"
+#include "sdk/msgapi/email_index.h"
 #include "sdk/msgapi/message_wwiv.h"
 #include "sdk/msgapi/type2_text.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace wwiv::sdk::msgapi {
 
@@ -70,6 +72,8 @@ public:
   [[nodiscard]] int number_of_messages();
   /** Total number of email records in the system. This includes any deleted messages. */
   [[nodiscard]] int number_of_email_records() const;
+  /** Email numbers of the messages waiting for user_number, in the order received. */
+  [[nodiscard]] std::vector<int> messages_for_user(int user_number);
 
   /** Temporary API to read the header from an email message. */
   bool read_email_header(int email_number, mailrec& m);
@@ -79,12 +83,15 @@ public:
   bool DeleteMessage(int email_number);
   /** Delete all email to a specified user */
   bool DeleteAllMailToOrFrom(int user_number);
+  /** Rebuilds the mailbox index from the email records. */
+  bool RebuildIndex();
 
 private:
   bool add_email(const mailrec& m);
   const Config& config_;
   const std::filesystem::path data_filename_;
   core::DataFile<mailrec> mail_file_;
+  EmailIndex index_;
   bool open_{false};
   const int max_net_num_{-1};
 
@@ -41,7 +41,8 @@ WWIVMessageApi::WWIVMessageApi(const wwiv::sdk::msgapi::MessageApiOptions& optio
                                WWIVLastReadImpl* last_read)
     : MessageApi(options, config.root_directory(), config.datadir(), config.msgsdir(),
                  net_networks),
-      last_read_(last_read), config_(config) {}
+      last_read_(last_read), config_(config),
+      status_manager_(std::make_unique<StatusMgr>(config.datadir())) {}
 
 bool WWIVMessageApi::Exist(const wwiv::sdk::subboard_t& sub) const {
   return File::Exists(FilePath(subs_directory_, StrCat(sub.filename, ".sub")));
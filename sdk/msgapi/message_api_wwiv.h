@@ -21,6 +21,7 @@
 #include "sdk/config.h"
 #include "sdk/msgapi/email_wwiv.h"
 #include "sdk/msgapi/message_api.h"
+#include "sdk/status.h"
 #include "sdk/net/net.h"
 #include <filesystem>
 #include <memory>
@@ -67,10 +68,13 @@ public:
   [[nodiscard]] uint32_t last_read(int area) const;
   void set_last_read(int area, uint32_t last_read);
   [[nodiscard]] const Config& config() const noexcept { return config_; }
+  /** STATUS.DAT for this BBS, which new messages get their qscan pointers from. */
+  [[nodiscard]] StatusMgr& status_manager() const noexcept { return *status_manager_; }
 
 private:
   std::unique_ptr<WWIVLastReadImpl> last_read_;
   const Config config_;
+  std::unique_ptr<StatusMgr> status_manager_;
 };
 
 } // namespace
@@ -29,10 +29,13 @@
 #include "sdk/config.h"
 #include "sdk/filenames.h"
 #include "sdk/msgapi/message_api_wwiv.h"
+#include "sdk/msgapi/message_search_index.h"
 #include "sdk/net/packets.h"
 #include "sdk/ssm.h"
 #include "sdk/usermanager.h"
 #include "sdk/vardec.h"
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -91,6 +94,15 @@ static std::unique_ptr<WWIVMessageAreaHeader> ReadHeader(DataFile<postrec>& file
   return std::make_unique<WWIVMessageAreaHeader>(raw_header);
 }
 
+// Since we don't have a global message id, posts are the same when they
+// have the same date + title + from system + from user.  The title is
+// compared as stored in the postrec.
+static std::string dupe_key(daten_t d, const std::string& title, uint16_t from_system,
+                            uint16_t from_user) {
+  const auto t = ToStringUpperCase(title.substr(0, sizeof(postrec::title) - 1));
+  return StrCat(d, ":", from_system, ":", from_user, ":", t);
+}
+
 WWIVMessageAreaLastRead::WWIVMessageAreaLastRead(WWIVMessageApi* api, int message_area_number)
     : MessageAreaLastRead(api), wapi_(api), message_area_number_(message_area_number) {}
 
@@ -141,8 +153,12 @@ WWIVMessageArea::WWIVMessageArea(WWIVMessageApi* api, const subboard_t& sub,
 WWIVMessageArea::~WWIVMessageArea() { WWIVMessageArea::Close(); }
 
 bool WWIVMessageArea::Close() {
+  auto result = true;
+  if (batch_) {
+    result = EndBatch();
+  }
   open_ = false;
-  return true;
+  return result;
 }
 
 bool WWIVMessageArea::Lock() { return false; }
@@ -309,29 +325,6 @@ unique_ptr<MessageText> WWIVMessageArea::ReadMessageText(int message_number) {
   return msg->release_text();
 }
 
-static uint32_t next_qscan_value_and_increment_post(const string& bbsdir) {
-  statusrec_t statusrec{};
-  const Config config(bbsdir);
-  if (!config.IsInitialized()) {
-    LOG(ERROR) << "Unable to load CONFIG.DAT.";
-    return 1;
-  }
-  DataFile<statusrec_t> file(FilePath(config.datadir(), STATUS_DAT),
-                             File::modeBinary | File::modeReadWrite);
-  if (!file) {
-    return 0;
-  }
-  if (!file.Read(0, &statusrec)) {
-    return 0;
-  }
-  const auto next_qscan = statusrec.qscanptr++;
-  ++statusrec.msgposttoday;
-  if (!file.Write(0, &statusrec)) {
-    return 0;
-  }
-  return next_qscan;
-}
-
 /**
  * Deletes all excess messages in an area, depending on the
  * overflow strategy set on the API.
@@ -343,48 +336,78 @@ static uint32_t next_qscan_value_and_increment_post(const string& bbsdir) {
  * Returns the number of messages deleted.
  */
 int WWIVMessageArea::DeleteExcess() {
-  if (api_->options().overflow_strategy == OverflowStrategy::delete_none) {
+  const auto strategy = api_->options().overflow_strategy;
+  if (strategy == OverflowStrategy::delete_none) {
     LOG(INFO) << "overflow_strategy is delete_none. Not deleting overflow messages";
     return 0;
   }
 
-  int result = 0;
-  auto done = false;
-  while (!done) {
-    if (api_->options().overflow_strategy == OverflowStrategy::delete_one) {
-      LOG(INFO) << "overflow_strategy is delete_one.";
-      done = true;
-    }
-    const auto num = number_of_messages();
-    if (num <= max_messages_) {
-      VLOG(1) << "No overflow messages. " << num << " <= " << max_messages_;
-      return result;
-    }
-    int i = 1;
-    int dm = 0;
-    while (i <= number_of_messages()) {
-      const auto pp = ReadMessageHeader(i);
-      if (!pp) {
-        break;
-      }
-      if (!pp->locked()) {
-        dm = i;
-        break;
-      }
-      ++i;
-    }
-    if (dm == 0) {
-      LOG(INFO) << "DeleteExcess: No message to delete.";
-      return result;
-    }
-    if (!DeleteMessage(dm)) {
-      LOG(INFO) << "DeleteExcess: Failed to delete message #" << dm;
-      return result;
+  DataFile<postrec> sub(sub_filename_, File::modeBinary | File::modeReadWrite);
+  if (!sub) {
+    return 0;
+  }
+  auto wwiv_header = ReadHeader(sub);
+  if (!wwiv_header->initialized()) {
+    return 0;
+  }
+  const auto num = wwiv_header->active_message_count();
+  if (num <= max_messages()) {
+    VLOG(1) << "No overflow messages. " << num << " <= " << max_messages();
+    return 0;
+  }
+  std::vector<postrec> posts;
+  if (!sub.Seek(0) || !sub.ReadVector(posts, num + 1)) {
+    return 0;
+  }
+  posts.resize(num + 1);
+  const auto max_deletes =
+      strategy == OverflowStrategy::delete_one ? 1 : std::numeric_limits<int>::max();
+  const auto removed = RemoveExcess(posts, max_deletes);
+  if (removed.empty()) {
+    return 0;
+  }
+  wwiv_header->set_active_message_count(static_cast<uint16_t>(posts.size() - 1));
+  if (!sub.Seek(1) || !sub.Write(posts.data() + 1, ssize(posts) - 1) || !WriteHeader(sub, *wwiv_header)) {
+    LOG(ERROR) << "DeleteExcess: Failed to write: " << sub_filename_;
+    return 0;
+  }
+  DeleteText(removed);
+  return size_int(removed);
+}
+
+std::vector<postrec> WWIVMessageArea::RemoveExcess(std::vector<postrec>& posts,
+                                                   int max_deletes) {
+  const auto num = static_cast<int>(posts.size()) - 1;
+  const auto num_to_delete = std::min(num - max_messages(), max_deletes);
+  std::vector<postrec> removed;
+  if (num_to_delete <= 0) {
+    return removed;
+  }
+  // Delete the oldest unlocked messages, keeping the rest in order.
+  auto out = std::begin(posts) + 1;
+  for (auto it = std::begin(posts) + 1; it != std::end(posts); ++it) {
+    if (ssize(removed) < num_to_delete && !(it->status & status_no_delete)) {
+      removed.push_back(*it);
+      continue;
     }
-    LOG(INFO) << "DeleteExcess: Deleted message #" << dm;
-    ++result;
+    *out++ = *it;
+  }
+  posts.erase(out, std::end(posts));
+  if (removed.empty()) {
+    LOG(INFO) << "DeleteExcess: No message to delete.";
+  } else {
+    LOG(INFO) << "DeleteExcess: Deleted " << removed.size() << " messages.";
+  }
+  return removed;
+}
+
+void WWIVMessageArea::DeleteText(const std::vector<postrec>& removed) {
+  MessageSearchIndex index(sub_filename_);
+  for (const auto& p : removed) {
+    // Remove text.  Ignore the return code, the header is already gone.
+    (void)remove_link(p.msg);
+    index.JournalRemove(p.qscan);
   }
-  return result;
 }
 
 static bool has_ftn_network(const std::vector<subboard_network_data_t>& sub_nets, const std::vector<net_networks_rec>& nets) {
@@ -407,10 +430,16 @@ bool WWIVMessageArea::AddMessage(const Message& message, const MessageAreaOption
   p.msg = m;
   p.ownersys = header.from_system();
   p.owneruser = header.from_usernum();
-  if (p.qscan == 0) {
+  if (p.qscan == 0 && batch_) {
+    // EndBatch assigns the qscan values for the whole batch.
+  } else if (p.qscan == 0) {
     // new message.
     VLOG(3) << "AddMessage needs a qscan";
-    p.qscan = next_qscan_value_and_increment_post(api_->root_directory());
+    // Newscan needs each post to get a higher qscan than every post before
+    // it, so don't hand one out from a block reserved earlier.
+    auto& qscan_allocator = wwiv_api_->status_manager().qscan_allocator();
+    qscan_allocator.Flush();
+    p.qscan = qscan_allocator.reserve(1);
     if (p.qscan == 0) {
       LOG(ERROR) << "Failed to get qscan value!";
       return false;
@@ -494,8 +523,17 @@ bool WWIVMessageArea::AddMessage(const Message& message, const MessageAreaOption
     return false;
   }
   p.msg = msg.value();
+  if (batch_) {
+    batch_->keys.insert(dupe_key(p.daten, p.title, p.ownersys, p.owneruser));
+    batch_->posts.push_back(p);
+    batch_->texts.emplace_back(std::move(text));
+    return true;
+  }
   auto result = add_post(p);
   if (result) {
+    MessageSearchIndex index(sub_filename_);
+    index.JournalAdd(p, text);
+    index.MaybeCompact();
     DeleteExcess();
   }
   return result;
@@ -525,6 +563,7 @@ bool WWIVMessageArea::DeleteMessage(int message_number) {
 
   // Remove text.  Ignore the return code, try to remove the header anyway.
   (void)remove_link(post.msg);
+  MessageSearchIndex(sub_filename_).JournalRemove(post.qscan);
 
   // Remove post record.
   for (auto cur = message_number + 1; cur <= num_messages; cur++) {
@@ -655,6 +694,9 @@ std::unique_ptr<Message> WWIVMessageArea::CreateMessage() {
 
 bool WWIVMessageArea::Exists(daten_t d, const std::string& title, uint16_t from_system,
                              uint16_t from_user) {
+  if (batch_) {
+    return batch_->keys.count(dupe_key(d, title, from_system, from_user)) > 0;
+  }
   DataFile<postrec> sub(sub_filename_);
   if (!sub) {
     return false;
@@ -699,6 +741,130 @@ message_anonymous_t WWIVMessageArea::anonymous_type() const noexcept {
   }
 }
 
+bool WWIVMessageArea::RebuildSearchIndex() {
+  const auto num_messages = number_of_messages();
+  std::vector<postrec> posts;
+  {
+    DataFile<postrec> sub(sub_filename_, File::modeBinary | File::modeReadOnly);
+    if (!sub || !sub.ReadVector(posts)) {
+      return false;
+    }
+  }
+  MessageSearchIndex index(sub_filename_);
+  // Record 0 is the header.
+  for (auto i = 1; i <= num_messages && i < ssize(posts); i++) {
+    const auto& p = at(posts, i);
+    if (auto text = readfile(p.msg)) {
+      index.Add(p, text.value());
+    }
+  }
+  return index.Save();
+}
+
+bool WWIVMessageArea::BeginBatch() {
+  if (batch_) {
+    return true;
+  }
+  DataFile<postrec> sub(sub_filename_, File::modeBinary | File::modeReadOnly);
+  if (!sub) {
+    return false;
+  }
+  const auto wwiv_header = ReadHeader(sub);
+  if (!wwiv_header->initialized()) {
+    return false;
+  }
+  std::vector<postrec> posts;
+  if (!sub.Seek(0) || !sub.ReadVector(posts, wwiv_header->active_message_count() + 1)) {
+    return false;
+  }
+  batch_ = std::make_unique<batch_t>();
+  // Record 0 is the header.
+  for (auto i = 1; i <= wwiv_header->active_message_count() && i < ssize(posts); i++) {
+    const auto& h = at(posts, i);
+    if (!(h.status & status_delete)) {
+      batch_->keys.insert(dupe_key(h.daten, h.title, h.ownersys, h.owneruser));
+    }
+  }
+  return true;
+}
+
+bool WWIVMessageArea::EndBatch() {
+  if (!batch_) {
+    return false;
+  }
+  const auto batch = std::move(batch_);
+  if (batch->posts.empty()) {
+    return true;
+  }
+  const auto num_added = size_int(batch->posts);
+  auto failed = [&](const std::string& why) {
+    LOG(ERROR) << "Failed to add " << num_added << " messages to " << sub_filename_ << ": " << why;
+    for (const auto& p : batch->posts) {
+      (void)remove_link(p.msg);
+    }
+    return false;
+  };
+
+  DataFile<postrec> sub(sub_filename_, File::modeBinary | File::modeReadWrite);
+  if (!sub || sub.number_of_records() == 0) {
+    return failed("unable to open the sub");
+  }
+  auto wwiv_header = ReadHeader(sub);
+  if (!wwiv_header->initialized()) {
+    return failed("invalid header");
+  }
+  // Reread the posts since someone else may have posted since BeginBatch.
+  const auto num = wwiv_header->active_message_count();
+  std::vector<postrec> posts;
+  if (!sub.Seek(0) || !sub.ReadVector(posts, num + 1)) {
+    return failed("unable to read the posts");
+  }
+  posts.resize(num + 1);
+
+  const auto num_qscans =
+      std::count_if(std::begin(batch->posts), std::end(batch->posts),
+                    [](const postrec& p) { return p.qscan == 0; });
+  auto& qscan_allocator = wwiv_api_->status_manager().qscan_allocator();
+  if (num_qscans > 0) {
+    auto qscan = qscan_allocator.reserve(static_cast<int>(num_qscans));
+    if (qscan == 0) {
+      return failed("unable to get qscan values");
+    }
+    for (auto& p : batch->posts) {
+      if (p.qscan == 0) {
+        p.qscan = qscan++;
+      }
+    }
+  }
+
+  posts.insert(std::end(posts), std::begin(batch->posts), std::end(batch->posts));
+
+  std::vector<postrec> removed;
+  const auto strategy = api_->options().overflow_strategy;
+  if (strategy == OverflowStrategy::delete_none) {
+    VLOG(1) << "overflow_strategy is delete_none. Not deleting overflow messages";
+  } else {
+    // delete_one deletes one message per message added.
+    const auto max_deletes =
+        strategy == OverflowStrategy::delete_one ? num_added : std::numeric_limits<int>::max();
+    removed = RemoveExcess(posts, max_deletes);
+  }
+
+  wwiv_header->set_active_message_count(static_cast<uint16_t>(posts.size() - 1));
+  if (!sub.Seek(1) || !sub.Write(posts.data() + 1, ssize(posts) - 1) || !WriteHeader(sub, *wwiv_header)) {
+    return failed("unable to write the posts");
+  }
+  MessageSearchIndex index(sub_filename_);
+  for (auto i = 0; i < num_added; i++) {
+    index.JournalAdd(at(batch->posts, i), at(batch->texts, i));
+  }
+  DeleteText(removed);
+  index.MaybeCompact();
+  qscan_allocator.Flush();
+  ++nonce_;
+  return true;
+}
+
 // Implementation Details
 
 bool WWIVMessageArea::add_post(const postrec& post) {
@@ -26,6 +26,8 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace wwiv::sdk::msgapi {
 
@@ -108,8 +110,38 @@ public:
   [[nodiscard]] MessageAreaLastRead& last_read() const noexcept override;
   [[nodiscard]] message_anonymous_t anonymous_type() const noexcept override;
 
+  /** Rebuilds the full text search index for this area from every message in it. */
+  bool RebuildSearchIndex();
+
+  /**
+   * Starts adding a batch of messages, such as when tossing a packet full of
+   * posts.  Until EndBatch is called, Exists is a lookup in the posts loaded
+   * here plus the ones added since, and AddMessage only saves the message
+   * text.  The new post records are then appended, the sub header and
+   * STATUS.DAT are updated, and any excess messages are deleted all at once
+   * by EndBatch.  Messages added in the batch can't be read until then.
+   */
+  bool BeginBatch();
+  /** Writes out the messages added since BeginBatch.  Also called by Close. */
+  bool EndBatch();
+  [[nodiscard]] bool in_batch() const noexcept { return batch_ != nullptr; }
+
 private:
+  struct batch_t {
+    // Keys (see dupe_key) of the posts in the sub and in the batch.
+    std::unordered_set<std::string> keys;
+    // Posts added, and their text for the search index.
+    std::vector<postrec> posts;
+    std::vector<std::string> texts;
+  };
+
   int DeleteExcess();
+  // Removes up to max_deletes of the oldest unlocked posts over max_messages
+  // from posts, where record 0 is the sub header, and returns them.  Their
+  // text is left alone for DeleteText once posts has been written.
+  std::vector<postrec> RemoveExcess(std::vector<postrec>& posts, int max_deletes);
+  // Deletes the text and search index entries of posts removed from the sub.
+  void DeleteText(const std::vector<postrec>& removed);
   [[nodiscard]] bool add_post(const postrec& post);
   [[nodiscard]] std::optional<wwiv_parsed_text_fieds> ParseMessageText(const postrec& header, int message_number);
   [[nodiscard]] [[nodiscard]] bool HasSubChanged() const;
@@ -128,6 +160,7 @@ private:
   subfile_header_t header_;
   const std::vector<net_networks_rec> net_networks_;
   std::unique_ptr<MessageAreaLastRead> last_read_;
+  std::unique_ptr<batch_t> batch_;
   int nonce_{0};
 };
 
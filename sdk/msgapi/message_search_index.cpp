@@ -0,0 +1,343 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/msgapi/message_search_index.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::msgapi {
+
+static constexpr char kMagic[4] = {'W', 'F', 'T', 'I'};
+static constexpr uint32_t kVersion = 1;
+static constexpr char kJournalAdd = 'A';
+static constexpr char kJournalRemove = 'R';
+
+static bool is_word_char(char ch) {
+  const auto c = static_cast<unsigned char>(ch);
+  return c < 128 && std::isalnum(c);
+}
+
+// FNV-1a, since this needs to be the same everywhere the index is used.
+static uint32_t title_hash(const postrec& p) {
+  uint32_t h = 2166136261u;
+  for (auto i = 0u; i < sizeof(p.title) && p.title[i]; i++) {
+    h = (h ^ static_cast<uint8_t>(p.title[i])) * 16777619u;
+  }
+  return h;
+}
+
+static std::vector<std::string> words(const postrec& p, const std::string& text) {
+  std::vector<std::string> result;
+  MessageSearchIndex::ForEachWord(p.title, text,
+                                  [&](const std::string& w) { result.push_back(w); });
+  return result;
+}
+
+MessageSearchIndex::MessageSearchIndex(const std::filesystem::path& sub_filename)
+    : files_(std::filesystem::path(sub_filename).replace_extension(".fti"),
+             std::filesystem::path(sub_filename).replace_extension(".ftj")) {}
+
+// static
+void MessageSearchIndex::ForEachWord(const std::string& title, const std::string& text,
+                                     const std::function<void(const std::string&)>& fn) {
+  std::unordered_set<std::string> seen;
+  auto split = [&](const std::string& s) {
+    std::string word;
+    for (const auto ch : s) {
+      if (is_word_char(ch)) {
+        word.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+      } else if (!word.empty()) {
+        if (seen.insert(word).second) {
+          fn(word);
+        }
+        word.clear();
+      }
+    }
+    if (!word.empty() && seen.insert(word).second) {
+      fn(word);
+    }
+  };
+  // Message find looks for the search string in the title without colors.
+  split(stripcolors(title));
+  split(text);
+}
+
+bool MessageSearchIndex::exists() const { return files_.index_exists(); }
+
+void MessageSearchIndex::Clear() {
+  docs_.clear();
+  postings_.clear();
+  journal_applied_ = 0;
+}
+
+void MessageSearchIndex::AddWords(uint32_t qscan, const doc_t& doc,
+                                  const std::vector<std::string>& words) {
+  // If it was already here its old words stay until the index is rebuilt,
+  // which only costs checking the text of a message that doesn't match.
+  docs_[qscan] = doc;
+  for (const auto& w : words) {
+    auto& v = postings_[w];
+    if (v.empty() || v.back() < qscan) {
+      v.push_back(qscan);
+    } else if (const auto it = std::lower_bound(std::begin(v), std::end(v), qscan);
+               it == std::end(v) || *it != qscan) {
+      v.insert(it, qscan);
+    }
+  }
+}
+
+void MessageSearchIndex::Add(const postrec& p, const std::string& text) {
+  AddWords(p.qscan, {p.msg.stored_as, title_hash(p)}, words(p, text));
+}
+
+void MessageSearchIndex::Remove(uint32_t qscan) {
+  // The postings are cleaned up when saving, until then candidates skips it.
+  docs_.erase(qscan);
+}
+
+bool MessageSearchIndex::Load() {
+  Clear();
+  const auto data = read_index_file(path());
+  if (!data) {
+    return false;
+  }
+  IndexReader r(data.value());
+  char magic[4]{};
+  uint32_t version{0};
+  uint32_t num_docs{0};
+  uint32_t num_words{0};
+  if (!r.get(magic) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 || !r.get(version) ||
+      version != kVersion || !r.get(num_docs) || !r.get(num_words)) {
+    LOG(WARNING) << "Ignoring invalid message search index: " << path();
+    return false;
+  }
+  for (auto i = 0u; i < num_docs; i++) {
+    uint32_t qscan{0};
+    doc_t doc{};
+    if (!r.get(qscan) || !r.get(doc.stored_as) || !r.get(doc.title_hash)) {
+      LOG(WARNING) << "Ignoring truncated message search index: " << path();
+      Clear();
+      return false;
+    }
+    docs_.emplace_hint(std::end(docs_), qscan, doc);
+  }
+  postings_.reserve(num_words);
+  for (auto i = 0u; i < num_words; i++) {
+    std::string word;
+    uint32_t count{0};
+    if (!r.get_string(word) || !r.get(count)) {
+      LOG(WARNING) << "Ignoring truncated message search index: " << path();
+      Clear();
+      return false;
+    }
+    auto& v = postings_[word];
+    v.reserve(count);
+    uint32_t qscan{0};
+    for (auto j = 0u; j < count; j++) {
+      uint32_t delta{0};
+      if (!r.get_varint(delta)) {
+        LOG(WARNING) << "Ignoring truncated message search index: " << path();
+        Clear();
+        return false;
+      }
+      qscan += delta;
+      v.push_back(qscan);
+    }
+  }
+
+  if (const auto journal = read_index_file(journal_path())) {
+    journal_applied_ = static_cast<File::size_type>(ApplyJournal(journal.value()));
+  }
+  return true;
+}
+
+std::size_t MessageSearchIndex::ApplyJournal(const std::string& data) {
+  IndexReader r(data);
+  // Only whole records count, the last one may still be being written.
+  std::size_t applied = 0;
+  while (!r.done()) {
+    char type{0};
+    uint32_t qscan{0};
+    if (!r.get(type) || !r.get(qscan)) {
+      break;
+    }
+    if (type == kJournalRemove) {
+      Remove(qscan);
+    } else if (type == kJournalAdd) {
+      doc_t doc{};
+      uint32_t num_words{0};
+      if (!r.get(doc.stored_as) || !r.get(doc.title_hash) || !r.get(num_words)) {
+        break;
+      }
+      std::vector<std::string> words;
+      words.reserve(num_words);
+      auto ok = true;
+      for (auto i = 0u; i < num_words && ok; i++) {
+        std::string word;
+        ok = r.get_string(word);
+        words.emplace_back(std::move(word));
+      }
+      if (!ok) {
+        break;
+      }
+      AddWords(qscan, doc, words);
+    } else {
+      LOG(WARNING) << "Invalid record in message search journal: " << journal_path();
+      break;
+    }
+    applied = r.pos();
+  }
+  return applied;
+}
+
+bool MessageSearchIndex::Save() {
+  if (!files_.Rewrite(journal_applied_, [this](const std::string& rest) {
+        ApplyJournal(rest);
+        return Serialize();
+      })) {
+    LOG(ERROR) << "Unable to write message search index: " << path();
+    return false;
+  }
+  journal_applied_ = 0;
+  return true;
+}
+
+std::string MessageSearchIndex::Serialize() const {
+  std::vector<std::pair<const std::string*, std::vector<uint32_t>>> words;
+  words.reserve(postings_.size());
+  for (const auto& [word, qscans] : postings_) {
+    std::vector<uint32_t> live;
+    live.reserve(qscans.size());
+    std::copy_if(std::begin(qscans), std::end(qscans), std::back_inserter(live),
+                 [this](uint32_t q) { return docs_.find(q) != std::end(docs_); });
+    if (!live.empty() && word.size() <= 0xffff) {
+      words.emplace_back(&word, std::move(live));
+    }
+  }
+
+  std::string data(kMagic, sizeof(kMagic));
+  put_u32(data, kVersion);
+  put_u32(data, static_cast<uint32_t>(docs_.size()));
+  put_u32(data, static_cast<uint32_t>(words.size()));
+  for (const auto& [qscan, doc] : docs_) {
+    put_u32(data, qscan);
+    put_u32(data, doc.stored_as);
+    put_u32(data, doc.title_hash);
+  }
+  for (const auto& [word, qscans] : words) {
+    put_string(data, *word);
+    put_u32(data, static_cast<uint32_t>(qscans.size()));
+    uint32_t last = 0;
+    for (const auto q : qscans) {
+      put_varint(data, q - last);
+      last = q;
+    }
+  }
+  return data;
+}
+
+bool MessageSearchIndex::JournalAdd(const postrec& p, const std::string& text) const {
+  std::string rec(1, kJournalAdd);
+  put_u32(rec, p.qscan);
+  put_u32(rec, p.msg.stored_as);
+  put_u32(rec, title_hash(p));
+  const auto w = words(p, text);
+  put_u32(rec, static_cast<uint32_t>(w.size()));
+  for (const auto& word : w) {
+    put_string(rec, word);
+  }
+  return files_.Append(rec);
+}
+
+bool MessageSearchIndex::JournalRemove(uint32_t qscan) const {
+  std::string rec(1, kJournalRemove);
+  put_u32(rec, qscan);
+  return files_.Append(rec);
+}
+
+bool MessageSearchIndex::MaybeCompact() {
+  if (!files_.needs_compact()) {
+    return true;
+  }
+  VLOG(1) << "Compacting message search index: " << path();
+  return Load() && Save();
+}
+
+bool MessageSearchIndex::indexed(const postrec& p) const {
+  const auto it = docs_.find(p.qscan);
+  return it != std::end(docs_) && it->second.stored_as == p.msg.stored_as &&
+         it->second.title_hash == title_hash(p);
+}
+
+std::optional<std::vector<uint32_t>>
+MessageSearchIndex::candidates(const std::string& search_string) const {
+  // The search string matches anywhere in the text, so each word in it can
+  // be part of a longer word in the message, but must be within one.
+  std::vector<std::string> parts;
+  ForEachWord("", search_string, [&](const std::string& w) { parts.push_back(w); });
+  if (parts.empty()) {
+    return std::nullopt;
+  }
+  // Look for the longest first, it's likely to match the fewest words.
+  std::sort(std::begin(parts), std::end(parts),
+            [](const auto& l, const auto& r) { return l.size() > r.size(); });
+
+  std::vector<uint32_t> result;
+  auto first = true;
+  for (const auto& part : parts) {
+    std::vector<uint32_t> matches;
+    for (const auto& [word, qscans] : postings_) {
+      if (word.find(part) != std::string::npos) {
+        matches.insert(std::end(matches), std::begin(qscans), std::end(qscans));
+      }
+    }
+    std::sort(std::begin(matches), std::end(matches));
+    matches.erase(std::unique(std::begin(matches), std::end(matches)), std::end(matches));
+    if (first) {
+      result = std::move(matches);
+      first = false;
+    } else {
+      std::vector<uint32_t> both;
+      std::set_intersection(std::begin(result), std::end(result), std::begin(matches),
+                            std::end(matches), std::back_inserter(both));
+      result = std::move(both);
+    }
+    if (result.empty()) {
+      break;
+    }
+  }
+  result.erase(std::remove_if(std::begin(result), std::end(result),
+                              [this](uint32_t q) { return docs_.find(q) == std::end(docs_); }),
+               std::end(result));
+  return result;
+}
+
+} // namespace wwiv::sdk::msgapi
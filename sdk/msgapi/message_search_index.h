@@ -0,0 +1,129 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_MSGAPI_MESSAGE_SEARCH_INDEX_H
+#define INCLUDED_SDK_MSGAPI_MESSAGE_SEARCH_INDEX_H
+
+#include "sdk/index_io.h"
+#include "sdk/vardec.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace wwiv::sdk::msgapi {
+
+/**
+ * Full text index of a type-2 message area, from each word in the (upper
+ * cased) title and text of the messages to the qscan pointers of the
+ * messages containing it.  Qscan pointers are used rather than message
+ * numbers since they don't change when earlier messages are deleted.
+ *
+ * The index is kept in SUBNAME.FTI next to SUBNAME.SUB and is only there
+ * once it has been built (with "wwivutil messages reindex").  After that,
+ * messages added or deleted are appended to the journal in SUBNAME.FTJ,
+ * which is applied by Load and folded into the index by Save.
+ *
+ * Each message is indexed along with where its text is stored and a hash
+ * of its title, so a message added or edited by something that didn't
+ * update the index can be spotted with indexed() and searched the slow way.
+ */
+class MessageSearchIndex final {
+public:
+  /** Creates the index for the message area whose .sub file is sub_filename. */
+  explicit MessageSearchIndex(const std::filesystem::path& sub_filename);
+
+  /** Loads the index and journal.  Returns false if it hasn't been built. */
+  bool Load();
+  /** Writes the index and removes the journal. */
+  bool Save();
+  /** Removes everything from the index in memory. */
+  void Clear();
+  /** True if the index has been built for this area. */
+  [[nodiscard]] bool exists() const;
+
+  /** Adds (or replaces) a message in the index in memory. */
+  void Add(const postrec& p, const std::string& text);
+  /** Removes a message from the index in memory. */
+  void Remove(uint32_t qscan);
+
+  /**
+   * Appends adding a message to the journal, if the index exists.  This
+   * doesn't need the index to be loaded.
+   */
+  bool JournalAdd(const postrec& p, const std::string& text) const;
+  /** Appends removing a message to the journal, if the index exists. */
+  bool JournalRemove(uint32_t qscan) const;
+  /** Folds the journal into the index once it gets too large. */
+  bool MaybeCompact();
+
+  /** True if p, with its current text, is in the index. */
+  [[nodiscard]] bool indexed(const postrec& p) const;
+  /**
+   * Qscan pointers of the messages that may contain search_string, in
+   * ascending order.  Every message containing it is returned, but the
+   * caller must still check the text since not every message returned
+   * contains it.  Returns nullopt if search_string has no words, in which
+   * case the index can't help.
+   */
+  [[nodiscard]] std::optional<std::vector<uint32_t>>
+  candidates(const std::string& search_string) const;
+
+  /** Number of messages in the index. */
+  [[nodiscard]] int size() const noexcept { return static_cast<int>(docs_.size()); }
+  /** Number of distinct words in the index. */
+  [[nodiscard]] int number_of_words() const noexcept { return static_cast<int>(postings_.size()); }
+  [[nodiscard]] const std::filesystem::path& path() const noexcept { return files_.index_path(); }
+  [[nodiscard]] const std::filesystem::path& journal_path() const noexcept {
+    return files_.journal_path();
+  }
+
+  /** Calls fn with each distinct upper cased word in the title and text of a message. */
+  static void ForEachWord(const std::string& title, const std::string& text,
+                          const std::function<void(const std::string&)>& fn);
+
+private:
+  struct doc_t {
+    uint32_t stored_as;
+    uint32_t title_hash;
+  };
+  void AddWords(uint32_t qscan, const doc_t& doc, const std::vector<std::string>& words);
+  // Returns the number of bytes of whole records applied.
+  std::size_t ApplyJournal(const std::string& data);
+  // Returns the contents of the index file.
+  [[nodiscard]] std::string Serialize() const;
+
+  // SUBNAME.FTI and SUBNAME.FTJ.
+  const IndexJournal files_;
+  // Messages in the index by qscan pointer.
+  std::map<uint32_t, doc_t> docs_;
+  // Word to the sorted qscan pointers of the messages containing it.
+  std::unordered_map<std::string, std::vector<uint32_t>> postings_;
+  // How much of the journal has been applied.
+  int64_t journal_applied_{0};
+};
+
+} // namespace wwiv::sdk::msgapi
+
+#endif
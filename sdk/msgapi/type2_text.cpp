@@ -22,7 +22,11 @@
 #include "core/stl.h"
 #include "core/strings.h"
 #include "sdk/vardec.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <utility>
@@ -42,9 +46,72 @@ using namespace wwiv::strings;
 
 constexpr char CZ = 26;
 
+// Maximum number of GAT sections in a message file.
+constexpr int MAX_GAT_SECTIONS = 1024;
+
 template <class S>
 constexpr auto MSG_STARTING(S section) { return section * GATSECLEN + GAT_SECTION_SIZE; }
 
+namespace {
+
+/**
+ * Process wide index of the number of free blocks in each GAT section of
+ * each message file, as of when we last loaded that section.
+ *
+ * These are only hints used to skip sections that can not hold a message.
+ * A section is always reloaded from disk before blocks are allocated from
+ * it, so a stale count (say another node has posted or deleted since) can
+ * never cause a block to be allocated twice.  Sections skipped because of
+ * the hint are looked at again before the file is grown or we give up.
+ */
+class GatFreeIndex {
+public:
+  static GatFreeIndex& instance() {
+    static GatFreeIndex index;
+    return index;
+  }
+
+  /**
+   * Returns the free count for section, or -1 if it is not known.  If the
+   * file has shrunk since it was indexed (it was recreated or packed) then
+   * everything we knew about it is forgotten.
+   */
+  int free_blocks(const std::filesystem::path& p, int section, File::size_type file_length) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& e = index_[p];
+    if (file_length < e.file_length) {
+      e = {};
+    }
+    return section < ssize(e.free_blocks) ? e.free_blocks[section] : -1;
+  }
+
+  void set_free_blocks(const std::filesystem::path& p, int section, int num_free,
+                       File::size_type file_length) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& e = index_[p];
+    if (section >= ssize(e.free_blocks)) {
+      e.free_blocks.resize(section + 1, -1);
+    }
+    e.free_blocks[section] = num_free;
+    e.file_length = file_length;
+  }
+
+private:
+  struct entry_t {
+    std::vector<int> free_blocks;
+    File::size_type file_length{0};
+  };
+  std::mutex mu_;
+  std::map<std::filesystem::path, entry_t> index_;
+};
+
+int count_free_blocks(const std::vector<gati_t>& gat) {
+  // Block 0 is never used.
+  return static_cast<int>(std::count(std::begin(gat) + 1, std::end(gat), 0));
+}
+
+} // namespace
+
 Type2Text::Type2Text(std::filesystem::path p) : path_(std::move(p)) {}
 
 // Implementation Details
@@ -57,12 +124,15 @@ bool Type2Text::remove_link(const messagerec& msg) {
   const auto section = static_cast<int>(msg.stored_as / GAT_NUMBER_ELEMENTS);
   auto gat = load_gat(*file, section);
   auto current_section = msg.stored_as % GAT_NUMBER_ELEMENTS;
-  while (current_section > 0 && current_section < GAT_NUMBER_ELEMENTS) {
+  for (auto num = 0; num < GAT_NUMBER_ELEMENTS && current_section > 0 &&
+                     current_section < GAT_NUMBER_ELEMENTS;
+       num++) {
     const uint32_t next_section = static_cast<long>(gat[current_section]);
     gat[current_section] = 0;
     current_section = next_section;
   }
   save_gat(*file, section, gat);
+  GatFreeIndex::instance().set_free_blocks(path_, section, count_free_blocks(gat), file->length());
   file->Close();
   return true;
 }
@@ -130,25 +200,50 @@ std::optional<std::string> Type2Text::readfile(const messagerec& msg) {
   const uint32_t gat_section = msg.stored_as / GAT_NUMBER_ELEMENTS;
   auto gat = load_gat(*file, gat_section);
 
+  // Walk the chain first so that runs of consecutive blocks, which is how
+  // savefile allocates them when it can, are read with a single read.
+  std::vector<uint32_t> blocks;
   auto current_section = msg.stored_as % GAT_NUMBER_ELEMENTS;
-  std::string out;
   while (current_section > 0 && current_section < GAT_NUMBER_ELEMENTS) {
-    const auto pos = file->Seek(MSG_STARTING(gat_section) + MSG_BLOCK_SIZE * current_section, File::Whence::begin);
+    if (ssize(blocks) >= GAT_NUMBER_ELEMENTS) {
+      LOG(ERROR) << "Loop in GAT chain for message stored_as: " << msg.stored_as;
+      return std::nullopt;
+    }
+    blocks.push_back(current_section);
+    current_section = gat[current_section];
+  }
+
+  std::string out;
+  std::vector<char> buf;
+  for (size_t i = 0; i < blocks.size();) {
+    auto run = 1;
+    while (i + run < blocks.size() && blocks[i + run] == blocks[i] + run) {
+      ++run;
+    }
+    const auto pos = file->Seek(MSG_STARTING(gat_section) + MSG_BLOCK_SIZE * blocks[i], File::Whence::begin);
     if (pos == -1) {
       // Error seeking occurred.
       LOG(ERROR) << "Error seeking to position for message stored_as: " << msg.stored_as;
       return std::nullopt;
     }
-    char b[MSG_BLOCK_SIZE + 1];
-    const auto ret = file->Read(b, MSG_BLOCK_SIZE);
+    buf.resize(run * MSG_BLOCK_SIZE);
+    const auto ret = file->Read(buf.data(), run * MSG_BLOCK_SIZE);
     if (ret == -1) {
       // Error seeking occurred.
       LOG(ERROR) << "Error reading block for message stored_as: " << msg.stored_as;
       return std::nullopt;
     }
-    b[MSG_BLOCK_SIZE] = '\0';
-    out.append(b);
-    current_section = gat[current_section];
+    if (ret < run * MSG_BLOCK_SIZE) {
+      // Treat a short read past the end of the file as empty blocks.
+      std::fill(std::begin(buf) + ret, std::end(buf), '\0');
+    }
+    for (auto b = 0; b < run; b++) {
+      // Each block is terminated by the first NUL in it (if any).
+      const auto* block = &buf[b * MSG_BLOCK_SIZE];
+      const auto* end = static_cast<const char*>(memchr(block, 0, MSG_BLOCK_SIZE));
+      out.append(block, end ? end : block + MSG_BLOCK_SIZE);
+    }
+    i += run;
   }
 
   const auto last_cz = out.find_last_of(CZ);
@@ -161,41 +256,92 @@ std::optional<std::string> Type2Text::readfile(const messagerec& msg) {
 }
 
 std::optional<messagerec> Type2Text::savefile(const string& text) {
-  vector<gati_t> gati;
   auto msgfile(OpenMessageFile());
   if (!msgfile || !msgfile->IsOpen()) {
     // Unable to write to the message file.
     return std::nullopt;
   }
-  int section = 0;
-  for (; section < 1024; section++) {
-    auto gat = load_gat(*msgfile, section);
-    const auto num_blocks_required = static_cast<int>((text.length() + MSG_BLOCK_SIZE - 1) / MSG_BLOCK_SIZE);
-    gati_t i4 = 1;
-    gati.clear();
-    while (ssize(gati) < num_blocks_required && i4 < GAT_NUMBER_ELEMENTS) {
-      if (gat[i4] == 0) {
-        gati.push_back(i4);
+  const auto num_blocks_required = static_cast<int>((text.length() + MSG_BLOCK_SIZE - 1) / MSG_BLOCK_SIZE);
+  auto& index = GatFreeIndex::instance();
+  const auto file_length = msgfile->length();
+  // Sections skipped because the index says they are too full.  Another
+  // process may have freed blocks in them since, so they are looked at again
+  // before growing the file with a new section or giving up.
+  std::vector<int> skipped;
+  const auto save_in_skipped = [&]() -> std::optional<messagerec> {
+    for (const auto section : skipped) {
+      if (auto m = savefile_in_section(*msgfile, section, text, num_blocks_required)) {
+        return m;
       }
-      ++i4;
     }
-    if (ssize(gati) >= num_blocks_required) {
-      constexpr auto none = static_cast<uint16_t>(-1);
-      gati.push_back(none);
-      const auto text_len = ssize(text);
-      for (auto i = 0; i < num_blocks_required; i++) {
-        char block[MSG_BLOCK_SIZE + 1];
-        memset(block, 0, sizeof(block));
-        msgfile->Seek(MSG_STARTING(section) + MSG_BLOCK_SIZE * static_cast<long>(gati[i]), File::Whence::begin);
-        const auto remaining = std::min(text_len - (i * MSG_BLOCK_SIZE), MSG_BLOCK_SIZE);
-        memcpy(block, &text[i * MSG_BLOCK_SIZE], remaining);
-        msgfile->Write(block, MSG_BLOCK_SIZE);
-        gat[gati[i]] = gati[i + 1];
+    skipped.clear();
+    return std::nullopt;
+  };
+  for (auto section = 0; section < MAX_GAT_SECTIONS; section++) {
+    const auto known_free = index.free_blocks(path_, section, file_length);
+    if (known_free != -1 && known_free < num_blocks_required) {
+      // Skip sections we already know are too full without touching the disk.
+      skipped.push_back(section);
+      continue;
+    }
+    const auto section_end = static_cast<File::size_type>(section) * GATSECLEN + GAT_SECTION_SIZE;
+    if (!skipped.empty() && section_end > file_length) {
+      if (auto m = save_in_skipped()) {
+        return m;
       }
-      save_gat(*msgfile, section, gat);
-      break;
+    }
+    if (auto m = savefile_in_section(*msgfile, section, text, num_blocks_required)) {
+      return m;
     }
   }
+  if (auto m = save_in_skipped()) {
+    return m;
+  }
+  LOG(ERROR) << "No room left in message file: " << path_.string();
+  return std::nullopt;
+}
+
+std::optional<messagerec> Type2Text::savefile_in_section(File& msgfile, int section,
+                                                         const std::string& text,
+                                                         int num_blocks_required) {
+  auto& index = GatFreeIndex::instance();
+  auto gat = load_gat(msgfile, section);
+  vector<gati_t> gati;
+  for (gati_t i4 = 1; ssize(gati) < num_blocks_required && i4 < GAT_NUMBER_ELEMENTS; ++i4) {
+    if (gat[i4] == 0) {
+      gati.push_back(i4);
+    }
+  }
+  if (ssize(gati) < num_blocks_required) {
+    index.set_free_blocks(path_, section, ssize(gati), msgfile.length());
+    return std::nullopt;
+  }
+  constexpr auto none = static_cast<uint16_t>(-1);
+  gati.push_back(none);
+  // Write the text for runs of consecutive blocks with a single write.
+  const auto text_len = ssize(text);
+  std::vector<char> buf;
+  for (auto i = 0; i < num_blocks_required;) {
+    auto run = 1;
+    while (i + run < num_blocks_required && gati[i + run] == gati[i] + run) {
+      ++run;
+    }
+    buf.assign(run * MSG_BLOCK_SIZE, '\0');
+    const auto start = i * MSG_BLOCK_SIZE;
+    const auto remaining = std::min(text_len - start, run * MSG_BLOCK_SIZE);
+    memcpy(buf.data(), &text[start], remaining);
+    msgfile.Seek(MSG_STARTING(section) + MSG_BLOCK_SIZE * static_cast<long>(gati[i]), File::Whence::begin);
+    msgfile.Write(buf.data(), run * MSG_BLOCK_SIZE);
+    i += run;
+  }
+  // Only link the blocks into the GAT once the text is on disk, so a crash
+  // part way through leaves the blocks free rather than a broken chain.
+  for (auto i = 0; i < num_blocks_required; i++) {
+    gat[gati[i]] = gati[i + 1];
+  }
+  save_gat(msgfile, section, gat);
+  index.set_free_blocks(path_, section, count_free_blocks(gat), msgfile.length());
+
   messagerec m{};
   m.storage_type = STORAGE_TYPE;
   m.stored_as = static_cast<uint32_t>(gati[0]) + static_cast<uint32_t>(section) * GAT_NUMBER_ELEMENTS;
@@ -50,6 +50,10 @@ public:
 
 private:
   [[nodiscard]] std::optional<core::File> OpenMessageFile() const;
+  // Saves text in section if it has num_blocks_required free blocks.
+  [[nodiscard]] std::optional<messagerec> savefile_in_section(core::File& msgfile, int section,
+                                                              const std::string& text,
+                                                              int num_blocks_required);
   const std::filesystem::path path_;
 };
 
@@ -27,7 +27,10 @@
 #include "sdk/usermanager.h"
 #include "sdk/vardec.h"
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <string>
+#include <vector>
 
 using std::endl;
 using std::string;
@@ -40,21 +43,32 @@ Names::Names(const wwiv::sdk::Config& config) : data_directory_(config.datadir()
   loaded_ = Load();
 }
 
-static smalrec smalrec_for(uint32_t user_number, const std::vector<smalrec>& names) {
-  for (const auto& n : names) {
-    if (n.number == user_number) {
-      return n;
-    }
+static const char* name_of(const smalrec& sr) {
+  return reinterpret_cast<const char*>(sr.name);
+}
+
+// Orders by name, then by user number if the names match.
+static bool smalrec_less(const smalrec& a, const smalrec& b) {
+  const auto equal = strcmp(name_of(a), name_of(b));
+  if (equal == 0) {
+    return a.number < b.number;
   }
-  return smalrec{"", 0};
+  return equal < 0;
+}
+
+static smalrec make_smalrec(const std::string& upper_case_name, uint32_t user_number) {
+  smalrec sr{};
+  strncpy(reinterpret_cast<char*>(sr.name), upper_case_name.c_str(), sizeof(sr.name) - 1);
+  sr.number = static_cast<uint16_t>(user_number);
+  return sr;
 }
 
 std::string Names::UserName(uint32_t user_number) const {
-  const auto sr = smalrec_for(user_number, names_);
-  if (sr.number == 0) {
+  const auto it = by_number_.find(user_number);
+  if (it == std::end(by_number_) || user_number == 0) {
     return "";
   }
-  const auto name = properize(string(reinterpret_cast<const char*>(sr.name)));
+  const auto name = properize(it->second);
   return fmt::format("{} #{}", name, user_number);
 }
 
@@ -67,77 +81,93 @@ std::string Names::UserName(uint32_t user_number, uint32_t system_number) const
 }
 
 bool Names::Add(const std::string& name, uint32_t user_number) {
-  const auto upper_case_name = ToStringUpperCase(name);
-  auto it = names_.begin();
-  for (; it != names_.end()
-         && StringCompare(upper_case_name.c_str(), reinterpret_cast<char*>((*it).name)) > 0;
-         ++it) {
+  const auto sr = make_smalrec(ToStringUpperCase(name), user_number);
+  names_.insert(std::upper_bound(std::begin(names_), std::end(names_), sr, smalrec_less), sr);
+  const std::string upper_case_name{name_of(sr)};
+  by_number_[sr.number] = upper_case_name;
+  if (const auto [it, inserted] = by_name_.emplace(upper_case_name, sr.number);
+      !inserted && sr.number < it->second) {
+    it->second = sr.number;
   }
-  smalrec sr{};
-  strcpy(reinterpret_cast<char*>(sr.name), upper_case_name.c_str());
-  sr.number = static_cast<uint16_t>(user_number);
-  names_.insert(it, sr);
+  dirty_ = true;
   return true;
 }
 
 bool Names::AddUnsorted(const std::string& name, uint32_t user_number) {
-  const auto upper_case_name = ToStringUpperCase(name);
-  smalrec sr{};
-  strcpy(reinterpret_cast<char*>(sr.name), upper_case_name.c_str());
-  sr.number = static_cast<uint16_t>(user_number);
-  names_.emplace_back(sr);
+  names_.emplace_back(make_smalrec(ToStringUpperCase(name), user_number));
+  dirty_ = true;
   return true;
 }
 
 bool Names::Remove(uint32_t user_number) {
-  const string name(reinterpret_cast<char*>(smalrec_for(user_number, names_).name));
-  if (name.empty()) {
+  const auto num_it = by_number_.find(user_number);
+  if (num_it == std::end(by_number_)) {
     return false;
   }
-
-  auto upper_case_name(name);
-  StringUpperCase(&upper_case_name);
-  auto it = names_.begin();
-  for (; it != names_.end()
-         && StringCompare(upper_case_name.c_str(), reinterpret_cast<char*>((*it).name)) > 0;
-         ++it) {
-  }
-  if (!IsEquals(upper_case_name.c_str(), reinterpret_cast<char*>((*it).name))) {
+  const auto upper_case_name = num_it->second;
+  const auto key = make_smalrec(upper_case_name, user_number);
+  const auto it = std::lower_bound(std::begin(names_), std::end(names_), key, smalrec_less);
+  if (it == std::end(names_) || it->number != key.number ||
+      !IsEquals(upper_case_name.c_str(), name_of(*it))) {
     return false;
   }
   names_.erase(it);
+  by_number_.erase(num_it);
+
+  // Point the name index at the next user with the same name, if any.
+  if (const auto name_it = by_name_.find(upper_case_name);
+      name_it != std::end(by_name_) && name_it->second == user_number) {
+    const auto next = std::lower_bound(std::begin(names_), std::end(names_),
+                                       make_smalrec(upper_case_name, 0), smalrec_less);
+    if (next != std::end(names_) && IsEquals(upper_case_name.c_str(), name_of(*next))) {
+      name_it->second = next->number;
+    } else {
+      by_name_.erase(name_it);
+    }
+  }
+  dirty_ = true;
   return true;
 }
 
+void Names::SortAndIndex() {
+  if (!std::is_sorted(std::begin(names_), std::end(names_), smalrec_less)) {
+    std::sort(std::begin(names_), std::end(names_), smalrec_less);
+  }
+  by_number_.clear();
+  by_name_.clear();
+  by_number_.reserve(names_.size());
+  by_name_.reserve(names_.size());
+  for (const auto& n : names_) {
+    by_number_.emplace(n.number, name_of(n));
+    // Sorted by number within a name, so the first one wins.
+    by_name_.emplace(name_of(n), n.number);
+  }
+}
+
 bool Names::Load() {
   DataFile<smalrec> file(FilePath(data_directory_, NAMES_LST));
   if (!file) {
     return false;
   }
   names_.clear();
-  return file.ReadVector(names_);
+  const auto ok = file.ReadVector(names_);
+  SortAndIndex();
+  dirty_ = false;
+  return ok;
 }
 
 bool Names::Save() {
-  DataFile<smalrec> file(FilePath(data_directory_, NAMES_LST),
-                         File::modeReadWrite | File::modeBinary | File::modeTruncate |
-                             File::modeCreateFile);
-  if (!file) {
+  SortAndIndex();
+
+  // Other nodes must never see a truncated or partially written file.
+  const std::string data(reinterpret_cast<const char*>(names_.data()),
+                         names_.size() * sizeof(smalrec));
+  if (!File::ReplaceContents(FilePath(data_directory_, NAMES_LST), data)) {
     LOG(ERROR) << "Error saving NAMES.LST";
     return false;
   }
-
-  std::sort(names_.begin(), names_.end(), [](const smalrec& a, const smalrec& b) -> bool {
-    const auto equal = strcmp((char*)a.name, (char*)b.name);
-    // Sort by user number if names match.
-    if (equal == 0) {
-      return a.number < b.number;
-    }
-    // Otherwise sort by name comparison.
-    return equal < 0;
-  });
-
-  return file.WriteVector(names_);
+  dirty_ = false;
+  return true;
 }
 
 bool Names::Rebuild(const UserManager& um) {
@@ -147,28 +177,55 @@ bool Names::Rebuild(const UserManager& um) {
   }
 
   names_.clear();
-  for (auto i = 1; i <= num_user_records; i++) {
-    User user;
-    um.readuser(&user, i);
+  um.for_each_user([this](int user_number, const User& user) {
     if (!user.IsUserDeleted() && !user.IsUserInactive()) {
-      AddUnsorted(user.name(), i);
+      AddUnsorted(user.name(), user_number);
     }
-  }
+    return true;
+  });
+  SortAndIndex();
   return true;
 }
 
 
-int Names::FindUser(const std::string& search_string) {
-  for (const auto& n : names_) {
-    if (iequals(search_string.c_str(), reinterpret_cast<const char*>(n.name))) {
-      return n.number;
-    }
+int Names::FindUser(const std::string& search_string) const {
+  const auto it = by_name_.find(ToStringUpperCase(search_string));
+  return it == std::end(by_name_) ? 0 : static_cast<int>(it->second);
+}
+
+std::pair<std::vector<smalrec>::const_iterator, std::vector<smalrec>::const_iterator>
+Names::PrefixRange(const std::string& upper_prefix) const {
+  const auto first = std::lower_bound(std::begin(names_), std::end(names_),
+                                      make_smalrec(upper_prefix, 0), smalrec_less);
+  auto last = first;
+  while (last != std::end(names_) && starts_with(name_of(*last), upper_prefix)) {
+    ++last;
   }
-  return 0;
+  return {first, last};
+}
+
+std::vector<smalrec> Names::FindUsersWithPrefix(const std::string& prefix) const {
+  const auto [first, last] = PrefixRange(ToStringUpperCase(prefix));
+  return {first, last};
+}
+
+std::vector<smalrec> Names::FindUsersContaining(const std::string& part) const {
+  const auto upper_part = ToStringUpperCase(part);
+  auto contains = [&upper_part](const smalrec& sr) {
+    return strstr(name_of(sr), upper_part.c_str()) != nullptr;
+  };
+  // Names starting with part are one contiguous run, so only the names
+  // outside of it need to be searched.
+  const auto [first, last] = PrefixRange(upper_part);
+  std::vector<smalrec> result;
+  std::copy_if(std::cbegin(names_), first, std::back_inserter(result), contains);
+  result.insert(std::end(result), first, last);
+  std::copy_if(last, std::cend(names_), std::back_inserter(result), contains);
+  return result;
 }
 
 Names::~Names() {
-  if (!save_on_exit_) {
+  if (!save_on_exit_ || !dirty_) {
     return;
   }
   Save();
@@ -21,6 +21,8 @@
 #include "sdk/config.h"
 #include "sdk/vardec.h"
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace wwiv::sdk {
@@ -38,8 +40,21 @@ public:
   bool Load();
   bool Save();
   bool Rebuild(const UserManager& um);
-  [[nodiscard]] int FindUser(const std::string& search_string);
+  [[nodiscard]] int FindUser(const std::string& search_string) const;
 
+  /**
+   * Returns the entries whose name starts with prefix (case insensitive),
+   * in name order.
+   */
+  [[nodiscard]] std::vector<smalrec> FindUsersWithPrefix(const std::string& prefix) const;
+
+  /**
+   * Returns the entries whose name contains part (case insensitive), in
+   * name order.
+   */
+  [[nodiscard]] std::vector<smalrec> FindUsersContaining(const std::string& part) const;
+
+  /** Entries sorted by name, then by user number. */
   [[nodiscard]] const std::vector<smalrec>& names_vector() const { return names_;  }
   [[nodiscard]] int size() const { return static_cast<int>(names_.size()); }
   void set_save_on_exit(bool save_on_exit) { save_on_exit_ = save_on_exit; }
@@ -52,10 +67,25 @@ private:
    */
   bool AddUnsorted(const std::string& name, uint32_t user_number);
 
+  /** Returns the run of names_ starting with upper_prefix. */
+  [[nodiscard]] std::pair<std::vector<smalrec>::const_iterator,
+                          std::vector<smalrec>::const_iterator>
+  PrefixRange(const std::string& upper_prefix) const;
+
+  /** Sorts names_ and rebuilds the number and name indexes from it. */
+  void SortAndIndex();
+
   const std::string data_directory_;
   bool loaded_{false};
   bool save_on_exit_{false};
+  // True when names_ has changed since it was loaded or saved.
+  bool dirty_{false};
+  // Sorted by name then number, this doubles as the prefix index.
   std::vector<smalrec> names_;
+  // user number -> name
+  std::unordered_map<uint32_t, std::string> by_number_;
+  // upper case name -> lowest user number with that name
+  std::unordered_map<std::string, uint32_t> by_name_;
 };
 
 
@@ -26,9 +26,12 @@
 #include "sdk/fido/fido_packets.h"
 #include "sdk/fido/fido_util.h"
 #include "sdk/filenames.h"
+#include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <filesystem>
 #include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
@@ -40,10 +43,91 @@ using namespace wwiv::strings;
 
 namespace wwiv::sdk {
 
+// Crc32Counts
+
+static constexpr std::size_t kInitialSlots = 1024;
+
+static std::size_t hash_crc(uint32_t key) noexcept {
+  return static_cast<std::size_t>(key * 0x9E3779B1u);
+}
+
+Crc32Counts::Crc32Counts() : slots_(kInitialSlots, slot_t{0, 0}), mask_(kInitialSlots - 1) {}
+
+std::size_t Crc32Counts::find(uint32_t key) const noexcept {
+  auto i = hash_crc(key) & mask_;
+  while (slots_[i].key != 0 && slots_[i].key != key) {
+    i = (i + 1) & mask_;
+  }
+  return i;
+}
+
+void Crc32Counts::grow() {
+  auto old = std::move(slots_);
+  slots_.assign(old.size() * 2, slot_t{0, 0});
+  mask_ = slots_.size() - 1;
+  for (const auto& s : old) {
+    if (s.key != 0) {
+      slots_[find(s.key)] = s;
+    }
+  }
+}
+
+void Crc32Counts::insert(uint32_t key) {
+  if (key == 0) {
+    return;
+  }
+  // Keep the table at most half full so probes stay short.
+  if (static_cast<std::size_t>(size_ + 1) * 2 > slots_.size()) {
+    grow();
+  }
+  auto& s = slots_[find(key)];
+  if (s.key == key) {
+    ++s.count;
+    return;
+  }
+  s = slot_t{key, 1};
+  ++size_;
+}
+
+void Crc32Counts::erase(uint32_t key) {
+  if (key == 0) {
+    return;
+  }
+  auto i = find(key);
+  if (slots_[i].key != key || --slots_[i].count > 0) {
+    return;
+  }
+  --size_;
+  // Shift back any entries in this run that would no longer be found
+  // once this slot is empty.
+  for (auto j = (i + 1) & mask_; slots_[j].key != 0; j = (j + 1) & mask_) {
+    const auto home = hash_crc(slots_[j].key) & mask_;
+    const auto between = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!between) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i] = slot_t{0, 0};
+}
+
+bool Crc32Counts::contains(uint32_t key) const noexcept {
+  return key != 0 && slots_[find(key)].key == key;
+}
+
+void Crc32Counts::clear() {
+  slots_.assign(kInitialSlots, slot_t{0, 0});
+  mask_ = kInitialSlots - 1;
+  size_ = 0;
+}
+
+// FtnMessageDupe
+
 FtnMessageDupe::FtnMessageDupe(const Config& config) : FtnMessageDupe(config.datadir(), true) {}
 
-FtnMessageDupe::FtnMessageDupe(std::string datadir, bool use_filesystem)
-    : datadir_(std::move(datadir)), use_filesystem_(use_filesystem) {
+FtnMessageDupe::FtnMessageDupe(std::string datadir, bool use_filesystem, int max_entries)
+    : datadir_(std::move(datadir)), max_entries_(std::max(1, max_entries)),
+      use_filesystem_(use_filesystem) {
   if (!datadir_.empty()) {
     initialized_ = Load();
   } else {
@@ -55,40 +139,129 @@ bool FtnMessageDupe::Load() {
   if (!use_filesystem_) {
     return true;
   }
-  DataFile<msgids> file(FilePath(datadir_, MSGDUPE_DAT),
-                        File::modeReadWrite | File::modeBinary | File::modeCreateFile);
-  if (!file) {
-    LOG(ERROR) << "Unable to initialize FtnMessageDupe: Unable to create file.";
-    return false;
+  std::vector<msgids> dupes;
+  {
+    DataFile<msgids> file(FilePath(datadir_, MSGDUPE_DAT),
+                          File::modeReadWrite | File::modeBinary | File::modeCreateFile);
+    if (!file) {
+      LOG(ERROR) << "Unable to initialize FtnMessageDupe: Unable to create file.";
+      return false;
+    }
+
+    records_on_disk_ = file.number_of_records();
+    if (records_on_disk_ > 0 && !file.ReadVector(dupes)) {
+      LOG(ERROR) << "Unable to initialize FtnMessageDupe: Read Failed";
+      return false;
+    }
+  }
+  Stamp();
+  // Only the newest max_entries_ are remembered.
+  const auto num = static_cast<int>(dupes.size());
+  const auto start = std::max(0, num - max_entries_);
+  ring_.reserve(num - start);
+  for (auto i = start; i < num; i++) {
+    Remember(dupes[i]);
   }
+  if (records_on_disk_ > max_entries_) {
+    return Compact();
+  }
+  return true;
+}
+
+void FtnMessageDupe::Remember(const msgids& ids) {
+  if (static_cast<int>(ring_.size()) < max_entries_) {
+    ring_.push_back(ids);
+  } else {
+    // Forget the oldest one.
+    auto& oldest = ring_[head_];
+    header_dupes_.erase(oldest.header);
+    msgid_dupes_.erase(oldest.msgid);
+    oldest = ids;
+    head_ = (head_ + 1) % max_entries_;
+  }
+  header_dupes_.insert(ids.header);
+  msgid_dupes_.insert(ids.msgid);
+}
 
-  const auto num_records = file.number_of_records();
-  if (num_records == 0) {
-    // nothing to read.
+std::vector<msgids> FtnMessageDupe::ordered() const {
+  std::vector<msgids> v;
+  v.reserve(ring_.size());
+  v.insert(std::end(v), std::begin(ring_) + head_, std::end(ring_));
+  v.insert(std::end(v), std::begin(ring_), std::begin(ring_) + head_);
+  return v;
+}
+
+bool FtnMessageDupe::Append(const msgids& ids) {
+  if (!use_filesystem_) {
     return true;
   }
-  if (!file.ReadVector(dupes_)) {
-    LOG(ERROR) << "Unable to initialize FtnMessageDupe: Read Failed";
-    return false;
+  if (records_on_disk_ >= max_entries_ * 2) {
+    // Half of the file is entries we've forgotten.
+    return Compact();
   }
-  for (const auto& d : dupes_) {
-    header_dupes_.insert(d.header);
-    msgid_dupes_.insert(d.msgid);
+  {
+    DataFile<msgids> file(FilePath(datadir_, MSGDUPE_DAT),
+                          File::modeReadWrite | File::modeBinary | File::modeCreateFile);
+    if (!file) {
+      return false;
+    }
+    const auto num_records = file.number_of_records();
+    if (num_records != records_on_disk_) {
+      changed_elsewhere_ = true;
+    }
+    records_on_disk_ = num_records;
+    if (!file.Write(records_on_disk_, &ids)) {
+      return false;
+    }
+    ++records_on_disk_;
   }
+  Stamp();
   return true;
 }
 
-bool FtnMessageDupe::Save() {
+bool FtnMessageDupe::Compact() {
   if (!use_filesystem_) {
     return true;
   }
-  DataFile<msgids> file(FilePath(datadir_, MSGDUPE_DAT),
-                        File::modeReadWrite | File::modeBinary | File::modeCreateFile |
-                            File::modeTruncate);
-  if (!file) {
+  {
+    DataFile<msgids> file(FilePath(datadir_, MSGDUPE_DAT),
+                          File::modeReadWrite | File::modeBinary | File::modeCreateFile |
+                              File::modeTruncate);
+    if (!file) {
+      return false;
+    }
+    const auto dupes = ordered();
+    records_on_disk_ = static_cast<int>(dupes.size());
+    if (!file.WriteVector(dupes)) {
+      return false;
+    }
+  }
+  Stamp();
+  return true;
+}
+
+void FtnMessageDupe::Stamp() {
+  std::error_code ec;
+  const auto path = FilePath(datadir_, MSGDUPE_DAT);
+  file_size_ = std::filesystem::file_size(path, ec);
+  file_mtime_ = std::filesystem::last_write_time(path, ec);
+}
+
+bool FtnMessageDupe::stale() const {
+  if (!use_filesystem_) {
     return false;
   }
-  return file.WriteVector(dupes_);
+  if (changed_elsewhere_) {
+    return true;
+  }
+  std::error_code ec;
+  const auto path = FilePath(datadir_, MSGDUPE_DAT);
+  const auto size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return true;
+  }
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  return ec || size != file_size_ || mtime != file_mtime_;
 }
 
 std::string FtnMessageDupe::CreateMessageID(const wwiv::sdk::fido::FidoAddress& a) {
@@ -168,15 +341,17 @@ std::string FtnMessageDupe::GetMessageIDFromWWIVText(const std::string& text) {
 // static
 bool FtnMessageDupe::GetMessageCrc32s(const wwiv::sdk::fido::FidoPackedMessage& msg,
                                       uint32_t& header_crc32, uint32_t& msgid_crc32) {
-  std::ostringstream s;
-  s << msg.nh.orig_net << "/" << msg.nh.orig_node << "\r\n";
-  s << msg.nh.dest_net << "/" << msg.nh.dest_node << "\r\n";
-  s << msg.vh.date_time << "\r\n";
-  s << msg.vh.from_user_name << "\r\n";
-  s << msg.vh.subject << "\r\n";
-  s << msg.vh.to_user_name << "\r\n";
-
-  header_crc32 = crc32string(s.str());
+  // Feed the header lines to the CRC as we go rather than building a string
+  // of them first; this is called for every tossed message.
+  Crc32 crc;
+  crc.update(fmt::format("{}/{}\r\n{}/{}\r\n", msg.nh.orig_net, msg.nh.orig_node,
+                         msg.nh.dest_net, msg.nh.dest_node));
+  for (const auto* line :
+       {&msg.vh.date_time, &msg.vh.from_user_name, &msg.vh.subject, &msg.vh.to_user_name}) {
+    crc.update(*line);
+    crc.update("\r\n");
+  }
+  header_crc32 = crc.value();
   const auto msgid = FtnMessageDupe::GetMessageIDFromText(msg.vh.text);
   msgid_crc32 = crc32string(msgid);
   return true;
@@ -194,43 +369,35 @@ bool FtnMessageDupe::add(const FidoPackedMessage& msg) {
 }
 
 bool FtnMessageDupe::add(uint32_t header_crc32, uint32_t msgid_crc32) {
-  if (header_crc32 != 0) {
-    header_dupes_.insert(header_crc32);
-  }
-  if (msgid_crc32 != 0) {
-    msgid_dupes_.insert(msgid_crc32);
-  }
-
   msgids ids{};
   ids.header = header_crc32;
   ids.msgid = msgid_crc32;
 
-  dupes_.emplace_back(ids);
-  return Save();
+  Remember(ids);
+  return Append(ids);
 }
 
 bool FtnMessageDupe::remove(uint32_t header_crc32, uint32_t msgid_crc32) {
-  for (auto it = dupes_.begin(); it != std::end(dupes_);) {
-    const auto& d = *it;
-    if (d.header == header_crc32 && d.msgid == msgid_crc32) {
-      dupes_.erase(it);
-      header_dupes_.erase(header_crc32);
-      msgid_dupes_.erase(msgid_crc32);
-      return Save();
+  auto dupes = ordered();
+  for (auto it = dupes.begin(); it != std::end(dupes); ++it) {
+    if (it->header == header_crc32 && it->msgid == msgid_crc32) {
+      dupes.erase(it);
+      // This is rare, so just rebuild everything.
+      ring_.clear();
+      head_ = 0;
+      header_dupes_.clear();
+      msgid_dupes_.clear();
+      for (const auto& d : dupes) {
+        Remember(d);
+      }
+      return Compact();
     }
-    ++it;
   }
   return false;
 }
 
 bool FtnMessageDupe::is_dupe(uint32_t header_crc32, uint32_t msgid_crc32) const {
-  if (contains(header_dupes_, header_crc32) && header_crc32 != 0) {
-    return true;
-  }
-  if (contains(msgid_dupes_, msgid_crc32) && msgid_crc32 != 0) {
-    return true;
-  }
-  return false;
+  return header_dupes_.contains(header_crc32) || msgid_dupes_.contains(msgid_crc32);
 }
 
 bool FtnMessageDupe::is_dupe(const FidoPackedMessage& msg) const {
@@ -18,8 +18,9 @@
 #ifndef INCLUDED_SDK_FTN_MSGDUPE_H
 #define INCLUDED_SDK_FTN_MSGDUPE_H
 
+#include <cstdint>
+#include <filesystem>
 #include <string>
-#include <set>
 #include <vector>
 #include "sdk/config.h"
 #include "sdk/fido/fido_address.h"
@@ -37,10 +38,40 @@ namespace wwiv::sdk {
 static_assert(std::is_trivial<msgids>::value == true);
 static_assert(sizeof(msgids) == sizeof(uint64_t), "sizeof(msgids) must be the same as an int64.");
 
+/**
+ * Set of CRC32 values (with a count of how many times each was added), stored
+ * in a flat open addressing table.  Zero is never stored.
+ */
+class Crc32Counts final {
+public:
+  Crc32Counts();
+  void insert(uint32_t key);
+  /** Removes one instance of key. */
+  void erase(uint32_t key);
+  [[nodiscard]] bool contains(uint32_t key) const noexcept;
+  [[nodiscard]] int size() const noexcept { return size_; }
+  void clear();
+
+private:
+  struct slot_t {
+    uint32_t key;
+    uint32_t count;
+  };
+  [[nodiscard]] std::size_t find(uint32_t key) const noexcept;
+  void grow();
+
+  std::vector<slot_t> slots_;
+  std::size_t mask_;
+  int size_{0};
+};
+
 class FtnMessageDupe final {
 public:
+  // Number of messages remembered before the oldest start to be forgotten.
+  static constexpr int kDefaultMaxEntries = 256 * 1024;
+
   explicit FtnMessageDupe(const Config& config);
-  FtnMessageDupe(std::string datadir, bool use_filesystem);
+  FtnMessageDupe(std::string datadir, bool use_filesystem, int max_entries = kDefaultMaxEntries);
   ~FtnMessageDupe() = default;
 
   [[nodiscard]] bool IsInitialized() const { return initialized_; }
@@ -51,6 +82,13 @@ public:
   /** returns true if either the header or msgid crc is duplicated */
   [[nodiscard]] bool is_dupe(uint32_t header_crc32, uint32_t msgid_crc32) const;
   [[nodiscard]] bool is_dupe(const fido::FidoPackedMessage& msg) const;
+  /** Number of messages remembered. */
+  [[nodiscard]] int size() const noexcept { return static_cast<int>(ring_.size()); }
+  /**
+   * True if MSGDUPE.DAT has been changed by someone else (i.e. the BBS) since
+   * we loaded it, so anything they added isn't known to us.
+   */
+  [[nodiscard]] bool stale() const;
 
   /** Returns the MSGID from this message or an empty string. */
   [[nodiscard]] static std::string GetMessageIDFromText(const std::string& text);
@@ -65,14 +103,34 @@ public:
 
 private:
   bool Load();
-  bool Save();
+  // Appends ids to MSGDUPE.DAT, compacting it once it has grown too large.
+  bool Append(const msgids& ids);
+  // Rewrites MSGDUPE.DAT with only the entries we still remember.
+  bool Compact();
+  // Adds ids to the ring, forgetting the oldest entry if it is full.
+  void Remember(const msgids& ids);
+  // Returns the remembered entries, oldest first.
+  [[nodiscard]] std::vector<msgids> ordered() const;
+  // Remembers the size and time of MSGDUPE.DAT after we've read or written it.
+  void Stamp();
 
   bool initialized_;
   std::string datadir_;
-  std::vector<msgids> dupes_;
-  std::set<uint32_t> msgid_dupes_;
-  std::set<uint32_t> header_dupes_;
+  const int max_entries_;
+  // Circular buffer of the last max_entries_ messages. Once full, head_ is
+  // the oldest entry and the next one to be replaced.
+  std::vector<msgids> ring_;
+  int head_{0};
+  Crc32Counts msgid_dupes_;
+  Crc32Counts header_dupes_;
+  // Number of records in MSGDUPE.DAT, which may include ones we've forgotten.
+  int records_on_disk_{0};
   bool use_filesystem_{true};
+  // MSGDUPE.DAT as of our last read or write of it.
+  std::uintmax_t file_size_{0};
+  std::filesystem::file_time_type file_mtime_{};
+  // Set if records were appended by someone else before one of ours.
+  bool changed_elsewhere_{false};
 };
 
 }
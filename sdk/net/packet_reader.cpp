@@ -0,0 +1,196 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/net/packet_reader.h"
+
+#include "core/log.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <utility>
+
+using namespace wwiv::core;
+
+namespace wwiv::sdk::net {
+
+uint16_t PacketView::list_at(int i) const noexcept {
+  const auto offset = i * sizeof(uint16_t);
+  uint16_t n{0};
+  if (offset < list_.size()) {
+    std::memcpy(&n, list_.data() + offset, std::min(sizeof(uint16_t), list_.size() - offset));
+  }
+  return n;
+}
+
+std::vector<uint16_t> PacketView::list() const {
+  std::vector<uint16_t> l(list_size());
+  const auto num_bytes = std::min(l.size() * sizeof(uint16_t), list_.size());
+  if (num_bytes > 0) {
+    std::memcpy(&l[0], list_.data(), num_bytes);
+  }
+  return l;
+}
+
+bool PacketView::UpdateRouting(const net_networks_rec& net) {
+  auto r = routing_information(net, nh, text_);
+  if (!r) {
+    return false;
+  }
+  // Only one routing line is ever added as a packet passes through.
+  std::tie(routing_, routing_pos_) = std::move(r.value());
+  nh.length = static_cast<uint32_t>(text_.size() + routing_.size());
+  return true;
+}
+
+Packet PacketView::ToPacket() const {
+  std::string text;
+  text.reserve(text_.size() + routing_.size());
+  text.append(text_.substr(0, routing_pos_)).append(routing_).append(text_.substr(routing_pos_));
+  return Packet(nh, list(), std::move(text));
+}
+
+bool append_wwivnet_packet(std::string& out, const PacketView& p) {
+  if (p.nh.length != p.text_.size() + p.routing_.size()) {
+    LOG(ERROR) << "Mismatched text and p.nh.length.  text =" << p.text_.size() + p.routing_.size()
+               << " nh.length = " << p.nh.length;
+    return false;
+  }
+  const auto list_bytes = sizeof(uint16_t) * p.nh.list_len;
+  out.reserve(out.size() + sizeof(net_header_rec) + list_bytes + p.nh.length);
+  out.append(reinterpret_cast<const char*>(&p.nh), sizeof(net_header_rec));
+  out.append(p.list_.substr(0, list_bytes));
+  if (p.list_.size() < list_bytes) {
+    out.append(list_bytes - p.list_.size(), '\0');
+  }
+  out.append(p.text_.substr(0, p.routing_pos_));
+  out.append(p.routing_);
+  out.append(p.text_.substr(p.routing_pos_));
+  return true;
+}
+
+bool write_wwivnet_packet(const std::string& filename, const net_networks_rec& net,
+                          const PacketView& p) {
+  LOG(INFO) << "write_wwivnet_packet: Writing type " << p.nh.main_type << "/" << p.nh.minor_type
+            << " message to packet: " << filename;
+  std::string data;
+  if (!append_wwivnet_packet(data, p)) {
+    LOG(ERROR) << "Error while writing packet: " << net.dir << filename;
+    return false;
+  }
+  File file(FilePath(net.dir, filename));
+  if (!file.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
+    LOG(ERROR) << "Error while writing packet: " << net.dir << filename << "Unable to open file.";
+    return false;
+  }
+  file.Seek(0L, File::Whence::end);
+  const auto num = file.Write(data);
+  if (num != static_cast<File::size_type>(data.size())) {
+    LOG(ERROR) << "Error while writing packet: " << net.dir << filename << " num written (" << num
+               << ") != packet size: " << data.size();
+    return false;
+  }
+  return true;
+}
+
+PacketReader::PacketReader(const std::filesystem::path& path, bool process_de, int buffer_size)
+    : file_(path), process_de_(process_de) {
+  buf_.resize(std::max<std::size_t>(sizeof(net_header_rec), buffer_size));
+  open_ = file_.Open(File::modeBinary | File::modeReadOnly);
+  if (!open_) {
+    LOG(ERROR) << "Unable to open file: " << path;
+  }
+}
+
+PacketReader::PacketReader(std::string data, bool process_de)
+    : file_(""), process_de_(process_de), open_(true), buf_(std::move(data)), end_(buf_.size()),
+      eof_(true) {}
+
+std::size_t PacketReader::Fill(std::size_t n) {
+  if (end_ - pos_ >= n || eof_) {
+    return end_ - pos_;
+  }
+  // Move what's left to the front, then read as much as fits.
+  std::memmove(&buf_[0], &buf_[pos_], end_ - pos_);
+  end_ -= pos_;
+  pos_ = 0;
+  if (n > buf_.size()) {
+    buf_.resize(n);
+  }
+  while (end_ < n) {
+    const auto num_read = file_.Read(&buf_[end_], static_cast<File::size_type>(buf_.size() - end_));
+    if (num_read <= 0) {
+      eof_ = true;
+      break;
+    }
+    end_ += static_cast<std::size_t>(num_read);
+  }
+  return end_ - pos_;
+}
+
+std::string_view PacketReader::Take(std::size_t n) {
+  n = std::min(n, end_ - pos_);
+  const std::string_view v(&buf_[pos_], n);
+  pos_ += n;
+  return v;
+}
+
+std::tuple<PacketView, ReadPacketResponse> PacketReader::Next() {
+  if (!open_) {
+    return std::make_tuple(PacketView{}, ReadPacketResponse::ERROR);
+  }
+  const auto avail = Fill(sizeof(net_header_rec));
+  if (avail == 0) {
+    // at the end of the packet.
+    return std::make_tuple(PacketView{}, ReadPacketResponse::END_OF_FILE);
+  }
+  if (avail < sizeof(net_header_rec)) {
+    LOG(INFO) << "error reading header, got short read of size: " << avail
+              << "; expected: " << sizeof(net_header_rec);
+    Take(avail);
+    return std::make_tuple(PacketView{}, ReadPacketResponse::ERROR);
+  }
+
+  net_header_rec nh{};
+  std::memcpy(&nh, Take(sizeof(net_header_rec)).data(), sizeof(net_header_rec));
+  if (nh.method > 0) {
+    LOG(INFO) << "compression: de" << nh.method;
+  }
+  if (nh.length > static_cast<uint32_t>(std::numeric_limits<int32_t>::max())) {
+    LOG(INFO) << "error reading header, got length too big (underflow?): " << nh.length;
+    return std::make_tuple(PacketView{}, ReadPacketResponse::ERROR);
+  }
+
+  // Buffer the whole packet first so the list and text views stay valid.
+  const std::size_t list_bytes = sizeof(uint16_t) * nh.list_len;
+  Fill(list_bytes + nh.length);
+  const auto list = Take(list_bytes);
+  if (nh.method > 0 && process_de_ && nh.length > 146 /* Make sure we have enough for a header */) {
+    // HACK - this should do this in a shim DE
+    // 146 is the sizeof EN/DE header.
+    nh.length -= 146;
+    Take(146);
+  }
+  const auto text = Take(nh.length);
+  // Like read_packet, the header matches what was actually read.
+  nh.length = static_cast<uint32_t>(text.size());
+  return std::make_tuple(PacketView(nh, list, text), ReadPacketResponse::OK);
+}
+
+} // namespace wwiv::sdk::net
@@ -0,0 +1,122 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_NET_PACKET_READER_H
+#define INCLUDED_SDK_NET_PACKET_READER_H
+
+#include "core/file.h"
+#include "sdk/net/net.h"
+#include "sdk/net/packets.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace wwiv::sdk::net {
+
+/**
+ * A packet as it sits in the PacketReader's buffer.  The list and text point
+ * into that buffer, so a view is only valid until the next call to
+ * PacketReader::Next.  Use ToPacket to get a copy that owns its data.
+ */
+class PacketView final {
+public:
+  PacketView() = default;
+  PacketView(const net_header_rec& h, std::string_view list, std::string_view text)
+      : nh(h), list_(list), text_(text) {}
+
+  // A truncated list is zero filled out to nh.list_len, like read_packet.
+  [[nodiscard]] int list_size() const noexcept { return nh.list_len; }
+  // The list isn't aligned within the buffer, so items are copied out.
+  [[nodiscard]] uint16_t list_at(int i) const noexcept;
+  [[nodiscard]] std::vector<uint16_t> list() const;
+  /** Points the list at other memory, which must outlive the view. */
+  void set_list(std::string_view list) noexcept { list_ = list; }
+
+  /** The text as read, without any routing line added by UpdateRouting. */
+  [[nodiscard]] std::string_view text() const noexcept { return text_; }
+
+  /**
+   * Like Packet::UpdateRouting, but the routing line is held aside and
+   * spliced into the text by ToPacket and append_wwivnet_packet.
+   */
+  bool UpdateRouting(const net_networks_rec& net);
+
+  [[nodiscard]] Packet ToPacket() const;
+
+  net_header_rec nh{};
+
+private:
+  friend bool append_wwivnet_packet(std::string& out, const PacketView& p);
+
+  std::string_view list_;
+  std::string_view text_;
+  std::string routing_;
+  std::size_t routing_pos_{0};
+};
+
+/** Appends p to out in the same format as append_wwivnet_packet for a Packet. */
+bool append_wwivnet_packet(std::string& out, const PacketView& p);
+
+/** Appends p to filename in the network directory. */
+bool write_wwivnet_packet(const std::string& filename, const net_networks_rec& net,
+                          const PacketView& p);
+
+/**
+ * Reads the packets in a WWIVnet packet file using large reads into a
+ * reusable buffer, instead of separate reads for the header, list and text
+ * of each packet like read_packet does.
+ *
+ * A truncated final packet is handled the same way as read_packet: a short
+ * header is an error, a short list is zero filled and a short text is
+ * returned as-is.
+ */
+class PacketReader final {
+public:
+  PacketReader(const std::filesystem::path& path, bool process_de,
+               int buffer_size = 256 * 1024);
+  /** Reads the packets in data, which is in the same format as a packet file. */
+  PacketReader(std::string data, bool process_de);
+  ~PacketReader() = default;
+  PacketReader(const PacketReader&) = delete;
+  PacketReader& operator=(const PacketReader&) = delete;
+
+  [[nodiscard]] bool IsOpen() const noexcept { return open_; }
+
+  /** Reads the next packet. The view is only valid until the next call. */
+  std::tuple<PacketView, ReadPacketResponse> Next();
+
+private:
+  // Ensures at least n bytes are buffered past pos_, returns how many are.
+  std::size_t Fill(std::size_t n);
+  std::string_view Take(std::size_t n);
+
+  core::File file_;
+  const bool process_de_;
+  bool open_{false};
+  std::string buf_;
+  std::size_t pos_{0};
+  std::size_t end_{0};
+  bool eof_{false};
+};
+
+} // namespace wwiv::sdk::net
+
+#endif
@@ -0,0 +1,135 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/net/packet_spool.h"
+
+#include "core/file.h"
+#include "core/findfiles.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+namespace wwiv::sdk::net {
+
+static const std::string kHeldExtension = ".hld";
+
+PacketSpool::PacketSpool(const net_networks_rec& net) : net_(net) {}
+
+PacketSpool::~PacketSpool() { Commit(); }
+
+void PacketSpool::Hold(const std::string& filename) { held_.try_emplace(filename); }
+
+bool PacketSpool::holds(const std::string& filename) const {
+  return held_.find(filename) != std::end(held_);
+}
+
+bool PacketSpool::has_packets(const std::string& filename) const { return size(filename) > 0; }
+
+std::size_t PacketSpool::size(const std::string& filename) const {
+  const auto it = held_.find(filename);
+  return it == std::end(held_) ? 0 : it->second.size();
+}
+
+std::string& PacketSpool::data(const std::string& filename) { return held_.at(filename); }
+
+std::string PacketSpool::Take(const std::string& filename) {
+  std::string data;
+  if (const auto it = held_.find(filename); it != std::end(held_)) {
+    data.swap(it->second);
+  }
+  return data;
+}
+
+void PacketSpool::PutBack(const std::string& filename, std::string data) {
+  auto& held = held_[filename];
+  data.append(held);
+  held = std::move(data);
+}
+
+bool PacketSpool::Remove(const std::filesystem::path& input) {
+  const auto any_held = std::any_of(std::begin(held_), std::end(held_),
+                                    [](const auto& h) { return !h.second.empty(); });
+  if (!any_held) {
+    return File::Remove(input);
+  }
+  auto aside = input;
+  aside += kHeldExtension;
+  if (!File::Rename(input, aside)) {
+    LOG(ERROR) << "Unable to rename: " << input << " to: " << aside;
+    return false;
+  }
+  inputs_.push_back(aside);
+  return true;
+}
+
+bool PacketSpool::Commit() {
+  auto ok = true;
+  for (auto& [filename, data] : held_) {
+    if (data.empty()) {
+      continue;
+    }
+    File f(FilePath(net_.dir, filename));
+    if (!f.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
+      LOG(ERROR) << "Unable to open: " << f << "; keeping the inputs of the held packets.";
+      ok = false;
+      continue;
+    }
+    f.Seek(0L, File::Whence::end);
+    if (f.Write(data) != static_cast<File::size_type>(data.size()) || !f.fsync()) {
+      LOG(ERROR) << "Error writing held packets to: " << f
+                 << "; keeping the inputs of the held packets.";
+      ok = false;
+      continue;
+    }
+    VLOG(1) << "Wrote " << data.size() << " bytes of held packets to: " << f;
+    data.clear();
+  }
+  if (!ok) {
+    return false;
+  }
+  for (const auto& input : inputs_) {
+    if (!File::Remove(input)) {
+      LOG(ERROR) << "Unable to remove: " << input;
+    }
+  }
+  inputs_.clear();
+  return true;
+}
+
+void PacketSpool::Recover(const std::filesystem::path& dir) {
+  FindFiles ff(FilePath(dir, StrCat("*", kHeldExtension)), FindFiles::FindFilesType::files);
+  for (const auto& f : ff) {
+    const std::filesystem::path name(f.name.substr(0, f.name.size() - kHeldExtension.size()));
+    auto target = FilePath(dir, name);
+    // Don't clobber a new file of the same name, i.e. another p0.net.
+    for (auto i = 1; File::Exists(target); i++) {
+      target = FilePath(dir, StrCat(name.stem().string(), "-", i, name.extension().string()));
+    }
+    LOG(INFO) << "Recovering packets held by an earlier run: " << f.name << " as: " << target;
+    if (!File::Rename(FilePath(dir, f.name), target)) {
+      LOG(ERROR) << "Unable to rename: " << FilePath(dir, f.name) << " to: " << target;
+    }
+  }
+}
+
+} // namespace wwiv::sdk::net
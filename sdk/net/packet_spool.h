@@ -0,0 +1,98 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_NET_PACKET_SPOOL_H
+#define INCLUDED_SDK_NET_PACKET_SPOOL_H
+
+#include "sdk/net/net.h"
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace wwiv::sdk::net {
+
+/**
+ * Packet files held in memory for the next network stage running in the same
+ * process, instead of being written to the network directory and read back.
+ * networkc uses this to hand local.net from network1 to network2, and the FTN
+ * outbound packet from network1 to networkf.  The files themselves are only
+ * the fallback: anything still held by Commit, or when the spool is
+ * destroyed, is appended to its file.
+ *
+ * An input that held packets were read from isn't removed while they're held,
+ * or dying before the next stage reads them would lose them.  Remove renames
+ * it aside instead, and Commit removes it once nothing is held any longer.
+ * Recover puts back any inputs left aside by a process that didn't get that
+ * far, so they are processed again.
+ */
+class PacketSpool final {
+public:
+  explicit PacketSpool(const net_networks_rec& net);
+  ~PacketSpool();
+  PacketSpool(const PacketSpool&) = delete;
+  PacketSpool& operator=(const PacketSpool&) = delete;
+
+  /** Holds packets for filename in the network directory from now on. */
+  void Hold(const std::string& filename);
+  /** True if packets for filename are held here rather than written. */
+  [[nodiscard]] bool holds(const std::string& filename) const;
+  /** True if any packets for filename are being held. */
+  [[nodiscard]] bool has_packets(const std::string& filename) const;
+  /** Number of bytes held for filename. */
+  [[nodiscard]] std::size_t size(const std::string& filename) const;
+
+  /**
+   * The packets held for filename, in the same format as the packet file.
+   * Packets are appended to it by PacketWriter.
+   */
+  [[nodiscard]] std::string& data(const std::string& filename);
+
+  /** Takes the packets held for filename to be read by the next stage. */
+  [[nodiscard]] std::string Take(const std::string& filename);
+
+  /** Puts back packets from Take that couldn't be processed, ahead of any held since. */
+  void PutBack(const std::string& filename, std::string data);
+
+  /**
+   * Removes input, a file that packets were read from.  If any are held it is
+   * renamed aside (with a .hld extension) and only removed by Commit.
+   */
+  bool Remove(const std::filesystem::path& input);
+
+  /**
+   * Appends anything still held to its file, then removes the inputs renamed
+   * aside by Remove.  Returns false if any held packets couldn't be written,
+   * in which case the inputs are kept.
+   */
+  bool Commit();
+
+  /** Renames inputs left aside in dir by a spool that never committed back. */
+  static void Recover(const std::filesystem::path& dir);
+
+private:
+  const net_networks_rec& net_;
+  std::map<std::string, std::string> held_;
+  // Inputs renamed aside by Remove.
+  std::vector<std::filesystem::path> inputs_;
+};
+
+} // namespace wwiv::sdk::net
+
+#endif
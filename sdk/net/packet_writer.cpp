@@ -0,0 +1,158 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "sdk/net/packet_writer.h"
+
+#include "core/log.h"
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+
+using namespace wwiv::core;
+
+namespace wwiv::sdk::net {
+
+PacketWriter::PacketWriter(const net_networks_rec& net, int max_open_files, int buffer_size)
+    : net_(net), max_open_files_(std::max(1, max_open_files)),
+      buffer_size_(static_cast<std::size_t>(std::max(1, buffer_size))) {}
+
+PacketWriter::~PacketWriter() { Close(); }
+
+PacketWriter::lru_t::iterator PacketWriter::Open(const std::string& filename) {
+  if (const auto it = index_.find(filename); it != std::end(index_)) {
+    // Move it to the front of the list.
+    files_.splice(std::begin(files_), files_, it->second);
+    return it->second;
+  }
+
+  if (static_cast<int>(files_.size()) >= max_open_files_) {
+    if (!Evict(std::prev(std::end(files_)))) {
+      error_ = true;
+    }
+  }
+
+  File file(FilePath(net_.dir, filename));
+  if (!file.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
+    LOG(ERROR) << "Error while writing packet: " << net_.dir << filename << "Unable to open file.";
+    return std::end(files_);
+  }
+  file.Seek(0L, File::Whence::end);
+  ++stats_.opens;
+  files_.emplace_front(filename, std::move(file));
+  files_.front().buffer.reserve(buffer_size_);
+  index_[filename] = std::begin(files_);
+  return std::begin(files_);
+}
+
+bool PacketWriter::WriteBuffer(open_file_t& f) {
+  if (f.buffer.empty()) {
+    return true;
+  }
+  ++stats_.writes;
+  f.dirty = true;
+  const auto num = f.file.Write(f.buffer);
+  const auto ok = num == static_cast<File::size_type>(f.buffer.size());
+  if (!ok) {
+    LOG(ERROR) << "Error while writing packet: " << f.file << " num written (" << num
+               << ") != " << f.buffer.size();
+  }
+  f.buffer.clear();
+  return ok;
+}
+
+bool PacketWriter::Sync(open_file_t& f) {
+  auto ok = WriteBuffer(f);
+  if (f.dirty && !f.file.fsync()) {
+    LOG(ERROR) << "Error syncing packet file: " << f.file;
+    ok = false;
+  }
+  f.dirty = false;
+  return ok;
+}
+
+bool PacketWriter::Evict(lru_t::iterator it) {
+  const auto ok = Sync(*it);
+  index_.erase(it->filename);
+  files_.erase(it);
+  return ok;
+}
+
+bool PacketWriter::Write(const std::string& filename, const Packet& p) {
+  return Write(filename, p.nh,
+               [&p](std::string& out) { return append_wwivnet_packet(out, p); });
+}
+
+bool PacketWriter::Write(const std::string& filename, const PacketView& p) {
+  return Write(filename, p.nh,
+               [&p](std::string& out) { return append_wwivnet_packet(out, p); });
+}
+
+bool PacketWriter::Write(const std::string& filename, const net_header_rec& nh,
+                         const std::function<bool(std::string&)>& append) {
+  VLOG(2) << "PacketWriter::Write: Writing type " << nh.main_type << "/" << nh.minor_type
+          << " message to packet: " << filename;
+  if (spool_ && spool_->holds(filename)) {
+    auto& data = spool_->data(filename);
+    const auto start = data.size();
+    if (!append(data)) {
+      LOG(ERROR) << "Error while holding packet for: " << net_.dir << filename;
+      data.resize(start);
+      return false;
+    }
+    ++stats_.packets;
+    stats_.bytes += static_cast<int64_t>(data.size() - start);
+    return true;
+  }
+  const auto it = Open(filename);
+  if (it == std::end(files_)) {
+    return false;
+  }
+  auto& f = *it;
+  const auto start = f.buffer.size();
+  if (!append(f.buffer)) {
+    LOG(ERROR) << "Error while writing packet: " << net_.dir << filename;
+    return false;
+  }
+  ++stats_.packets;
+  stats_.bytes += static_cast<int64_t>(f.buffer.size() - start);
+  if (f.buffer.size() >= buffer_size_) {
+    return WriteBuffer(f);
+  }
+  return true;
+}
+
+bool PacketWriter::Flush() {
+  auto ok = !error_;
+  error_ = false;
+  for (auto& f : files_) {
+    if (!Sync(f)) {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool PacketWriter::Close() {
+  const auto ok = Flush();
+  index_.clear();
+  files_.clear();
+  return ok;
+}
+
+} // namespace wwiv::sdk::net
@@ -0,0 +1,115 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_SDK_NET_PACKET_WRITER_H
+#define INCLUDED_SDK_NET_PACKET_WRITER_H
+
+#include "core/file.h"
+#include "sdk/net/net.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_spool.h"
+#include "sdk/net/packets.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace wwiv::sdk::net {
+
+struct packet_writer_stats_t {
+  // Packets appended.
+  int64_t packets{0};
+  // Bytes appended.
+  int64_t bytes{0};
+  // Number of times a packet file was opened.
+  int64_t opens{0};
+  // Number of write calls made.
+  int64_t writes{0};
+};
+
+/**
+ * Appends packets to the packet files in a network directory.  The most
+ * recently used files are kept open and writes to them are buffered, rather
+ * than opening, appending to, and closing the file for each packet like
+ * write_wwivnet_packet does.
+ *
+ * Packets are only guaranteed to be on disk once Flush or Close returns
+ * true, so callers must flush before removing the input the packets came
+ * from.  Open files stay locked until they are evicted or closed.
+ *
+ * Packets for files held by the spool, if one is set, are appended there
+ * instead of being written.
+ */
+class PacketWriter final {
+public:
+  explicit PacketWriter(const net_networks_rec& net, int max_open_files = 16,
+                        int buffer_size = 64 * 1024);
+  ~PacketWriter();
+  PacketWriter(const PacketWriter&) = delete;
+  PacketWriter& operator=(const PacketWriter&) = delete;
+
+  /** Holds packets for the files that spool holds in it.  spool must outlive us. */
+  void set_spool(PacketSpool* spool) noexcept { spool_ = spool; }
+
+  /** Appends p to filename in the network directory. */
+  bool Write(const std::string& filename, const Packet& p);
+  bool Write(const std::string& filename, const PacketView& p);
+
+  /** Writes out anything buffered and syncs every open file to disk. */
+  bool Flush();
+
+  /** Flushes and closes all open files. */
+  bool Close();
+
+  [[nodiscard]] const packet_writer_stats_t& stats() const noexcept { return stats_; }
+
+private:
+  struct open_file_t {
+    open_file_t(std::string n, core::File&& f) : filename(std::move(n)), file(std::move(f)) {}
+    std::string filename;
+    core::File file;
+    std::string buffer;
+    // True if written to since the last fsync.
+    bool dirty{false};
+  };
+  typedef std::list<open_file_t> lru_t;
+
+  bool Write(const std::string& filename, const net_header_rec& nh,
+             const std::function<bool(std::string&)>& append);
+  lru_t::iterator Open(const std::string& filename);
+  bool WriteBuffer(open_file_t& f);
+  bool Sync(open_file_t& f);
+  bool Evict(lru_t::iterator it);
+
+  const net_networks_rec& net_;
+  const int max_open_files_;
+  const std::size_t buffer_size_;
+  // Most recently used first.
+  lru_t files_;
+  std::unordered_map<std::string, lru_t::iterator> index_;
+  packet_writer_stats_t stats_;
+  PacketSpool* spool_{nullptr};
+  // Set when writing out a file we have since closed fails, so the next
+  // Flush reports it.
+  bool error_{false};
+};
+
+} // namespace wwiv::sdk::net
+
+#endif
@@ -106,14 +106,37 @@ std::tuple<Packet, ReadPacketResponse>  read_packet(File& f, bool process_de) {
   return std::make_tuple(packet, ReadPacketResponse::OK);
 }
 
+bool append_wwivnet_packet(std::string& out, const Packet& p) {
+  if (p.nh.length != p.text().size()) {
+    LOG(ERROR) << "Mismatched text and p.nh.length.  text =" << p.text().size()
+               << " nh.length = " << p.nh.length;
+    return false;
+  }
+  if (p.nh.list_len != p.list.size()) {
+    LOG(WARNING) << "p.nh.list_len [" << p.nh.list_len << "] != p.list.size() [" << p.list.size()
+                 << "]";
+    if (p.nh.list_len > p.list.size()) {
+      return false;
+    }
+  }
+  VLOG(4) << "p.nh.list_len: " << p.nh.list_len;
+  const auto list_bytes = sizeof(uint16_t) * p.nh.list_len;
+  out.reserve(out.size() + sizeof(net_header_rec) + list_bytes + p.text().size());
+  out.append(reinterpret_cast<const char*>(&p.nh), sizeof(net_header_rec));
+  if (p.nh.list_len) {
+    out.append(reinterpret_cast<const char*>(&p.list[0]), list_bytes);
+  }
+  out.append(p.text());
+  return true;
+}
+
 bool write_wwivnet_packet(const string& filename, const net_networks_rec& net, const Packet& p) {
   VLOG(2) << "write_wwivnet_packet: " << filename;
   LOG(INFO) << "write_wwivnet_packet: Writing type " << p.nh.main_type << "/" << p.nh.minor_type
             << " message to packet: " << filename;
-  if (p.nh.length != p.text().size()) {
+  std::string data;
+  if (!append_wwivnet_packet(data, p)) {
     LOG(ERROR) << "Error while writing packet: " << net.dir << filename;
-    LOG(ERROR) << "Mismatched text and p.nh.length.  text =" << p.text().size()
-               << " nh.length = " << p.nh.length;
     return false;
   }
   File file(FilePath(net.dir, filename));
@@ -122,22 +145,13 @@ bool write_wwivnet_packet(const string& filename, const net_networks_rec& net, c
     return false;
   }
   file.Seek(0L, File::Whence::end);
-  const auto num = file.Write(&p.nh, sizeof(net_header_rec));
-  if (num != sizeof(net_header_rec)) {
-    // Let's fail now since we didn't write this right.
+  // Write the header, list and text with one call.
+  const auto num = file.Write(data);
+  if (num != static_cast<File::size_type>(data.size())) {
     LOG(ERROR) << "Error while writing packet: " << net.dir << filename << " num written (" << num
-               << ") != net_header_rec size.";
+               << ") != packet size: " << data.size();
     return false;
   }
-  if (p.nh.list_len != p.list.size()) {
-    LOG(WARNING) << "p.nh.list_len [" << p.nh.list_len << "] != p.list.size() [" << p.list.size()
-                 << "]";
-  }
-  VLOG(4) << "p.nh.list_len: " << p.nh.list_len;
-  if (p.nh.list_len) {
-    file.Write(&p.list[0], sizeof(uint16_t) * (p.nh.list_len));
-  }
-  file.Write(p.text());
   file.Close();
   return true;
 }
@@ -267,9 +281,10 @@ Packet::Packet(const net_header_rec& h, const std::vector<uint16_t>& l, const Pa
 
 Packet::Packet() = default;
 
-bool Packet::UpdateRouting(const net_networks_rec& net) {
+std::optional<std::pair<std::string, std::size_t>>
+routing_information(const net_networks_rec& net, const net_header_rec& nh, std::string_view text) {
   if (!need_to_update_routing(nh.main_type)) {
-    return false;
+    return std::nullopt;
   }
 
   std::ostringstream ss;
@@ -277,24 +292,33 @@ bool Packet::UpdateRouting(const net_networks_rec& net) {
      << "0R " << wwiv_network_compatible_version() << " - " << date() << " " << times() << " "
      << net.name << " ->" << net.sysnum << "\r\n";
 
-  const auto routing_information = ss.str();
+  auto routing_information = ss.str();
 
   if (nh.length + routing_information.size() >= (32 * 1024)) {
     LOG(INFO) << "Can't updating routing information, already have 32k of message.";
-    return false;
+    return std::nullopt;
   }
-  nh.length += stl::size_uint32(routing_information);
 
   // Need to skip over either 3 or 4 lines 1st depending on the packet type.
   const auto lines = number_of_header_lines(nh.main_type);
-  auto iter = text_.begin();
+  auto iter = text.begin();
   for (auto i = 0; i < lines; i++) {
     // Skip over this line
-    [[maybe_unused]] auto _ = get_message_field(text_, iter, {'\0', '\r', '\n'}, 80);
+    [[maybe_unused]] auto _ = get_message_field(text, iter, {'\0', '\r', '\n'}, 80);
   }
 
-  const auto pos = std::distance(text_.begin(), iter);
-  text_.insert(pos, routing_information);
+  const auto pos = static_cast<std::size_t>(std::distance(text.begin(), iter));
+  return std::make_pair(std::move(routing_information), pos);
+}
+
+bool Packet::UpdateRouting(const net_networks_rec& net) {
+  auto r = routing_information(net, nh, text_);
+  if (!r) {
+    return false;
+  }
+  auto& [routing, pos] = r.value();
+  nh.length += stl::size_uint32(routing);
+  text_.insert(pos, routing);
   return true;
 }
 
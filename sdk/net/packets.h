@@ -23,8 +23,11 @@
 #include "sdk/msgapi/message_wwiv.h"
 #include "sdk/net/net.h"
 #include <filesystem>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace wwiv::sdk::net {
@@ -60,6 +63,14 @@ public:
   std::string text_;
 };
 
+/**
+ * Returns the routing line that Packet::UpdateRouting adds to a packet with
+ * header nh and text, and the offset into text where it goes.  Returns
+ * nullopt if packets of this type don't get one, or there's no room left.
+ */
+std::optional<std::pair<std::string, std::size_t>>
+routing_information(const net_networks_rec& net, const net_header_rec& nh, std::string_view text);
+
 // Alpha subtypes are seven characters -- the first must be a letter, but the rest can be any
 // character allowed in a DOS filename.This main_type covers both subscriber - to - host and
 // host - to - subscriber messages. Minor type is always zero(since it's ignored), and the
@@ -156,6 +167,12 @@ uint16_t get_forsys(const wwiv::sdk::BbsListNet& b, uint16_t node);
 
 std::tuple<Packet, ReadPacketResponse> read_packet(wwiv::core::File& file, bool process_de);
 
+/**
+ * Appends the on disk form of p (header, list, and text) to out.
+ * Returns false if the packet header doesn't match its contents.
+ */
+bool append_wwivnet_packet(std::string& out, const Packet& p);
+
 bool write_wwivnet_packet(const std::string& filename, const net_networks_rec& net,
                           const Packet& packet);
 
@@ -27,6 +27,7 @@
 #include "fmt/printf.h"
 #include "sdk/filenames.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -190,5 +191,91 @@ bool StatusMgr::Run(status_txn_fn fn) {
   return false;
 }
 
+QScanAllocator& StatusMgr::qscan_allocator() {
+  if (!qscan_allocator_) {
+    qscan_allocator_ = std::make_unique<QScanAllocator>(datadir_);
+  }
+  return *qscan_allocator_;
+}
+
+// QScanAllocator
+
+QScanAllocator::QScanAllocator(std::string datadir, int block_size)
+    : datadir_(std::move(datadir)), block_size_(std::max(1, block_size)) {}
+
+QScanAllocator::~QScanAllocator() { Flush(); }
+
+bool QScanAllocator::Update(const std::function<void(statusrec_t&)>& fn) {
+  // Deny sharing so STATUS.DAT stays locked from the read until the write.
+  DataFile<statusrec_t> file(FilePath(datadir_, STATUS_DAT),
+                             File::modeBinary | File::modeReadWrite, File::shareDenyReadWrite);
+  statusrec_t s{};
+  if (!file || !file.Read(0, &s)) {
+    LOG(ERROR) << "Unable to read " << STATUS_DAT << " to allocate qscan pointers.";
+    return false;
+  }
+  fn(s);
+  s.msgposttoday = static_cast<uint16_t>(s.msgposttoday + pending_posts_);
+  if (!file.Write(0, &s)) {
+    LOG(ERROR) << "Unable to write " << STATUS_DAT << " to allocate qscan pointers.";
+    return false;
+  }
+  pending_posts_ = 0;
+  ++writes_;
+  return true;
+}
+
+uint32_t QScanAllocator::next() {
+  if (next_ == end_) {
+    uint32_t first = 0;
+    if (!Update([&](statusrec_t& s) {
+          first = s.qscanptr;
+          s.qscanptr += block_size_;
+        })) {
+      return 0;
+    }
+    next_ = first;
+    end_ = first + block_size_;
+  }
+  ++pending_posts_;
+  return next_++;
+}
+
+uint32_t QScanAllocator::reserve(int count) {
+  if (count <= 0) {
+    return 0;
+  }
+  if (available() >= count) {
+    pending_posts_ += count;
+    const auto first = next_;
+    next_ += count;
+    return first;
+  }
+  uint32_t first = 0;
+  pending_posts_ += count;
+  if (!Update([&](statusrec_t& s) {
+        // Use what's left of our block if nobody has reserved after it.
+        first = next_ != end_ && s.qscanptr == end_ ? next_ : s.qscanptr;
+        s.qscanptr = first + count;
+      })) {
+    pending_posts_ -= count;
+    return 0;
+  }
+  next_ = end_ = first + count;
+  return first;
+}
+
+bool QScanAllocator::Flush() {
+  if (pending_posts_ == 0 && next_ == end_) {
+    return true;
+  }
+  const auto ok = Update([&](statusrec_t& s) {
+    if (next_ != end_ && s.qscanptr == end_) {
+      s.qscanptr = next_;
+    }
+  });
+  next_ = end_ = 0;
+  return ok;
+}
 
 }
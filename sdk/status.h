@@ -23,6 +23,7 @@
 #include "core/strings.h"
 #include "sdk/vardec.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -117,6 +118,63 @@ private:
   const std::string datadir_;
 };
 
+/**
+ * Hands out qscan pointers for new posts without a read-modify-write of
+ * STATUS.DAT for each one.  Pointers are reserved from STATUS.DAT in blocks,
+ * with the file locked, and handed out from memory.  The posts are counted
+ * in msgposttoday when the next block is reserved or on Flush.
+ *
+ * Pointers are unique across processes, but only increase within a
+ * process: while one process hands out the rest of its block, another may
+ * reserve the next block and use those (higher) pointers first.  Flush
+ * gives back what is left of the block if nobody has reserved after it, so
+ * callers should Flush once they are done with a batch of posts.  Anything
+ * that needs each post to get a higher pointer than every post before it
+ * should Flush and then reserve(1) for each post, or use
+ * Status::next_qscanptr like the BBS does when a user posts.
+ */
+class QScanAllocator final {
+public:
+  static constexpr int kDefaultBlockSize = 32;
+
+  explicit QScanAllocator(std::string datadir, int block_size = kDefaultBlockSize);
+  ~QScanAllocator();
+  QScanAllocator(const QScanAllocator&) = delete;
+  QScanAllocator& operator=(const QScanAllocator&) = delete;
+
+  /** Returns the qscan pointer for a new post, or 0 on error. */
+  [[nodiscard]] uint32_t next();
+
+  /**
+   * Returns the first of count consecutive qscan pointers for count new
+   * posts, or 0 on error.
+   */
+  [[nodiscard]] uint32_t reserve(int count);
+
+  /**
+   * Adds the posts not yet counted to msgposttoday and gives back the rest
+   * of the current block if nobody has reserved pointers since.
+   */
+  bool Flush();
+
+  /** Number of pointers left in the current block. */
+  [[nodiscard]] int available() const noexcept { return static_cast<int>(end_ - next_); }
+  /** Number of times STATUS.DAT has been updated. */
+  [[nodiscard]] int writes() const noexcept { return writes_; }
+
+private:
+  bool Update(const std::function<void(statusrec_t&)>& fn);
+
+  const std::string datadir_;
+  const int block_size_;
+  // Next pointer to hand out, and the end of the block it's in.
+  uint32_t next_{0};
+  uint32_t end_{0};
+  // Posts not yet added to msgposttoday.
+  int pending_posts_{0};
+  int writes_{0};
+};
+
 /*!
  * @class StatusMgr
  * manages STATUS.DAT
@@ -148,10 +206,17 @@ public:
 
   bool Run(status_txn_fn fn);
 
+  /**
+   * The allocator for qscan pointers of new posts, created on first use.
+   * Anything it holds is flushed when this is destroyed.
+   */
+  QScanAllocator& qscan_allocator();
+
 private:
   const std::string datadir_;
   status_callabck_fn callback_;
   statusrec_t statusrec_{};
+  std::unique_ptr<QScanAllocator> qscan_allocator_;
 };
 
 } // namespace
@@ -31,7 +31,11 @@
 #include "sdk/user.h"
 #include "sdk/msgapi/email_wwiv.h"
 #include "sdk/msgapi/message_api_wwiv.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <memory>
+#include <system_error>
 #include <vector>
 
 using namespace wwiv::core;
@@ -40,6 +44,17 @@ using namespace wwiv::sdk::msgapi;
 
 namespace wwiv::sdk {
 
+// Number of user records per page of the readuser cache.
+static constexpr int kUsersPerPage = 32;
+// Number of cached pages at which the cache is emptied.
+static constexpr std::size_t kMaxCachedPages = 256;
+// Number of user records read at a time by for_each_user.
+static constexpr int kUsersPerBlock = 256;
+// The cache isn't trusted while USER.LST was written this recently, since
+// another write within the same tick of the file system's clock would leave
+// the modification time unchanged.
+static constexpr auto kRacyInterval = std::chrono::seconds(2);
+
 /////////////////////////////////////////////////////////////////////////////
 // class UserManager
 
@@ -63,11 +78,12 @@ UserManager::UserManager(const wwiv::sdk::Config& config)
 UserManager::~UserManager() = default;
 
 int  UserManager::num_user_records() const {
-  File userList(FilePath(data_directory_, USER_LST));
-  if (userList.Open(File::modeReadOnly | File::modeBinary)) {
-    return static_cast<int>(userList.length() / userrec_length_) - 1;
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(FilePath(data_directory_, USER_LST), ec);
+  if (ec || size < static_cast<std::uintmax_t>(userrec_length_)) {
+    return 0;
   }
-  return 0;
+  return static_cast<int>(size / userrec_length_) - 1;
 }
 
 bool UserManager::readuser_nocache(User *pUser, int user_number) const {
@@ -92,8 +108,90 @@ bool UserManager::readuser_nocache(User *pUser, int user_number) const {
   return true;
 }
 
+bool UserManager::readuser_cached(User* pUser, int user_number) const {
+  const auto path = FilePath(data_directory_, USER_LST);
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return readuser_nocache(pUser, user_number);
+  }
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return readuser_nocache(pUser, user_number);
+  }
+  if (size != pages_size_ || mtime != pages_mtime_ || pages_.size() >= kMaxCachedPages) {
+    pages_.clear();
+    pages_size_ = size;
+    pages_mtime_ = mtime;
+  }
+  if (user_number < 0 || mtime > std::filesystem::file_time_type::clock::now() - kRacyInterval) {
+    return readuser_nocache(pUser, user_number);
+  }
+
+  const auto num_user_records = static_cast<int>(size / userrec_length_) - 1;
+  if (user_number > num_user_records) {
+    pUser->data.inact = inact_deleted;
+    pUser->FixUp();
+    return false;
+  }
+
+  const auto page_num = user_number / kUsersPerPage;
+  auto it = pages_.find(page_num);
+  if (it == std::end(pages_)) {
+    File userList(path);
+    if (!userList.Open(File::modeReadOnly | File::modeBinary)) {
+      return readuser_nocache(pUser, user_number);
+    }
+    std::vector<char> page(static_cast<size_t>(kUsersPerPage) * userrec_length_);
+    userList.Seek(static_cast<File::size_type>(page_num) * kUsersPerPage * userrec_length_,
+                  File::Whence::begin);
+    const auto num_read = userList.Read(page.data(), static_cast<File::size_type>(page.size()));
+    page.resize(static_cast<size_t>(std::max<File::size_type>(0, num_read)));
+    it = pages_.emplace(page_num, std::move(page)).first;
+  }
+  const auto offset = static_cast<size_t>(user_number % kUsersPerPage) * userrec_length_;
+  if (offset + userrec_length_ > it->second.size()) {
+    // Short read; USER.LST changed underneath us.
+    pages_.erase(it);
+    return readuser_nocache(pUser, user_number);
+  }
+  memcpy(&pUser->data, &it->second[offset],
+         std::min<size_t>(userrec_length_, sizeof(pUser->data)));
+  pUser->FixUp();
+  return true;
+}
+
 bool UserManager::readuser(User *pUser, int user_number) const {
-  return this->readuser_nocache(pUser, user_number);
+  return readuser_cached(pUser, user_number);
+}
+
+bool UserManager::for_each_user(
+    const std::function<bool(int user_number, const User& user)>& fn) const {
+  File userList(FilePath(data_directory_, USER_LST));
+  if (!userList.Open(File::modeReadOnly | File::modeBinary)) {
+    return false;
+  }
+  const auto num_user_records = static_cast<int>(userList.length() / userrec_length_) - 1;
+  std::vector<char> block(static_cast<size_t>(kUsersPerBlock) * userrec_length_);
+  // Skip record 0, which is never a user.
+  userList.Seek(userrec_length_, File::Whence::begin);
+  User user;
+  for (auto user_number = 1; user_number <= num_user_records;) {
+    const auto count = std::min(kUsersPerBlock, num_user_records - user_number + 1);
+    const auto len = static_cast<File::size_type>(count) * userrec_length_;
+    if (userList.Read(block.data(), len) != len) {
+      return false;
+    }
+    for (auto i = 0; i < count; i++, user_number++) {
+      memcpy(&user.data, &block[static_cast<size_t>(i) * userrec_length_],
+             std::min<size_t>(userrec_length_, sizeof(user.data)));
+      user.FixUp();
+      if (!fn(user_number, user)) {
+        return true;
+      }
+    }
+  }
+  return true;
 }
 
 std::optional<User> UserManager::readuser(int user_number) const {
@@ -105,6 +203,7 @@ std::optional<User> UserManager::readuser(int user_number) const {
 }
 
 bool UserManager::writeuser_nocache(User *pUser, int user_number) {
+  pages_.clear();
   File userList(FilePath(data_directory_, USER_LST));
   if (userList.Open(File::modeReadWrite | File::modeBinary | File::modeCreateFile)) {
     const auto pos = static_cast<long>(userrec_length_) * static_cast<long>(user_number);
@@ -22,7 +22,13 @@
 
 #include "sdk/config.h"
 #include "sdk/user.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace wwiv::sdk {
 
@@ -30,6 +36,10 @@ namespace wwiv::sdk {
  * WWIV User Manager.
  * 
  * Responsible for loading and saving users.
+ *
+ * readuser keeps the pages of USER.LST it has read in memory, and drops them
+ * whenever the size or modification time of USER.LST changes, so that writes
+ * made by other nodes are seen.  Use for_each_user to scan every user.
  */
 class UserManager {
  public:
@@ -44,6 +54,14 @@ class UserManager {
     * Optionally returns the user specified by user_number.
     */
    [[nodiscard]] std::optional<User> readuser(int user_number) const;
+
+  /**
+   * Calls fn for each user record from 1 to num_user_records(), reading
+   * USER.LST a block of records at a time.  Stops early once fn returns false.
+   * Returns false if USER.LST can not be read.
+   */
+  bool for_each_user(const std::function<bool(int user_number, const User& user)>& fn) const;
+
    bool writeuser_nocache(User *pUser, int user_number);
    bool writeuser(User *pUser, int user_number);
 
@@ -63,12 +81,19 @@ class UserManager {
   }
 
 private:
+  bool readuser_cached(User* pUser, int user_number) const;
 
   const Config config_;
   const std::string data_directory_;
   int userrec_length_;
   int max_number_users_;
   bool allow_writes_{false};
+
+  // Pages of USER.LST read by readuser, by page number.
+  mutable std::unordered_map<int, std::vector<char>> pages_;
+  // The size and modification time of USER.LST when pages_ was filled.
+  mutable std::uintmax_t pages_size_{0};
+  mutable std::filesystem::file_time_type pages_mtime_{};
 };
 
 }  // namespace
@@ -58,6 +58,7 @@ void serialize(Archive& ar, wwivd_blocking_t &b) {
 
   SERIALIZE(b, auto_bl_sessions);
   SERIALIZE(b, auto_bl_seconds);
+  SERIALIZE(b, auto_bl_subnet_sessions);
   SERIALIZE(b, use_dns_rbl);
   SERIALIZE(b, dns_rbl_server);
   SERIALIZE(b, use_dns_cc);
@@ -34,6 +34,11 @@ struct wwivd_blocking_t {
   bool auto_blocklist = true;
   int auto_bl_sessions = 3;
   int auto_bl_seconds = 30;
+  // Sessions from a /24 (IPv4) or /64 (IPv6) subnet within auto_bl_seconds
+  // before blocking the whole subnet.  0 (the default) disables subnet
+  // blocking; set "Max Subnet Sessions Before Blocking" in wwivconfig's
+  // wwivd blocking configuration to turn it on.
+  int auto_bl_subnet_sessions = 0;
 
   bool use_dns_rbl = true;
   // xbl.spamhaus.org
@@ -0,0 +1,221 @@
+/**************************************************************************/
+/*                                                                        */
+/*                            WWIV Version 5                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/log.h"
+#include "sdk/config.h"
+#include "sdk/user.h"
+#include "sdk/acs/acs.h"
+#include "sdk/acs/compiled_acs.h"
+#include "sdk/acs/eval.h"
+#include "sdk/acs/uservalueprovider.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using std::string;
+using namespace std::chrono;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::acs;
+
+class CompiledAcsTest : public ::testing::Test {
+public:
+  CompiledAcsTest() : config_(".", config_t{}) {}
+
+  bool eval(const std::string& expr) {
+    const CompiledAcs c(expr);
+    return c.eval(config_, &user_, user_.sl());
+  }
+
+  // Result from the existing (uncompiled) evaluator.
+  bool eval_slow(const std::string& expr) {
+    Eval e(expr);
+    e.add("user", std::make_unique<UserValueProvider>(&user_, user_.sl(), config_.sl(user_.sl())));
+    return e.eval();
+  }
+
+  Config config_;
+  User user_{};
+};
+
+TEST_F(CompiledAcsTest, SL) {
+  user_.sl(201);
+  EXPECT_TRUE(eval("user.sl>200"));
+  EXPECT_FALSE(eval("user.sl<200"));
+}
+
+TEST_F(CompiledAcsTest, Groups) {
+  user_.sl(10);
+  user_.dsl(201);
+  user_.set_name("SYSOP");
+  EXPECT_TRUE(eval("(user.sl>200 || user.dsl > 200) || user.name == \"Rushfan\""));
+  EXPECT_TRUE(eval("(user.sl>5 && user.dsl > 200) && user.name == \"sysop\""));
+  EXPECT_FALSE(eval("(user.sl>200 || user.dsl > 250) || user.name == \"Rushfan\""));
+}
+
+TEST_F(CompiledAcsTest, Ar) {
+  user_.ar_int(2); // B
+  EXPECT_TRUE(eval("user.ar == 'B'"));
+  EXPECT_TRUE(eval("user.ar == \"AB\""));
+  EXPECT_FALSE(eval("user.ar == 'C'"));
+  EXPECT_TRUE(eval("user.ar != 'C'"));
+}
+
+TEST_F(CompiledAcsTest, Sysop) {
+  user_.sl(255);
+  EXPECT_TRUE(eval("user.sysop"));
+  EXPECT_TRUE(eval("user.sysop == true"));
+  EXPECT_TRUE(eval("user.sysop == \"true\""));
+  user_.sl(200);
+  EXPECT_FALSE(eval("user.sysop"));
+  EXPECT_TRUE(eval("user.sysop == false"));
+}
+
+TEST_F(CompiledAcsTest, CoSysop) {
+  user_.sl(200);
+  EXPECT_FALSE(eval("user.cosysop == true"));
+  slrec sl{};
+  sl.ability |= ability_cosysop;
+  config_.sl(200, sl);
+  EXPECT_TRUE(eval("user.cosysop == true"));
+}
+
+TEST_F(CompiledAcsTest, BadAttrOnUser) {
+  const CompiledAcs c("user.foo<20");
+  EXPECT_FALSE(c.ok());
+  EXPECT_EQ(c.error_text(), "No user attribute named 'user.foo' exists.");
+  EXPECT_FALSE(c.eval(config_, &user_, user_.sl()));
+}
+
+TEST_F(CompiledAcsTest, BadAttr_EvenWhenShortCircuited) {
+  // Eval fails the whole expression on an unknown attribute, so must we even
+  // though we'd never look at the right hand side.
+  user_.sl(255);
+  EXPECT_FALSE(eval("user.sysop || user.foo == 1"));
+}
+
+TEST_F(CompiledAcsTest, BadExpression) {
+  const CompiledAcs c("foo == ~ foo");
+  EXPECT_FALSE(c.ok());
+  EXPECT_FALSE(c.eval(config_, &user_, user_.sl()));
+}
+
+TEST_F(CompiledAcsTest, MatchesEval) {
+  const std::vector<std::string> exprs{
+      "user.sl>200",
+      "user.sl >= 50 && user.dsl >= 50",
+      "user.ar == 'B' || user.dar == 'C'",
+      "(user.sl>200 || user.dsl > 200) || user.name == \"Rushfan\"",
+      "user.age > 17 && user.regnum == true",
+      "user.sysop",
+      "user.cosysop == false",
+      "user.sl + 10 > 60",
+      "true",
+      "false || user.sl == 50",
+      "user.foo == 1",
+      "42",
+      "user.name == \"sysop\"",
+      "user.name != \"Rushfan\"",
+      "user.name + \"!\" == \"SYSOP!\"",
+      "user.sl == \"50\"",
+      "user.ar == \"AB\"",
+  };
+  user_.set_name("SYSOP");
+  for (auto sl : {10, 50, 201, 255}) {
+    user_.sl(sl);
+    user_.dsl(sl);
+    user_.ar_int(sl & 0xff);
+    user_.dar_int(sl & 0x0f);
+    for (const auto& e : exprs) {
+      EXPECT_EQ(eval_slow(e), eval(e)) << e << "; sl: " << sl;
+    }
+  }
+}
+
+TEST_F(CompiledAcsTest, Cache) {
+  CompiledAcs::clear_cache();
+  const auto a = CompiledAcs::get("user.sl > 10");
+  const auto b = CompiledAcs::get("user.sl > 10");
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_EQ(1, CompiledAcs::cache_size());
+  EXPECT_NE(a.get(), CompiledAcs::get("user.sl > 20").get());
+  EXPECT_EQ(2, CompiledAcs::cache_size());
+  CompiledAcs::clear_cache();
+  EXPECT_EQ(0, CompiledAcs::cache_size());
+}
+
+TEST_F(CompiledAcsTest, CheckAcs_UsesCache) {
+  CompiledAcs::clear_cache();
+  user_.sl(60);
+  auto [result, debug_lines] = check_acs(config_, &user_, user_.sl(), "user.sl > 50");
+  EXPECT_TRUE(result);
+  EXPECT_TRUE(debug_lines.empty());
+  EXPECT_EQ(1, CompiledAcs::cache_size());
+
+  // Debug output still comes from the full evaluator.
+  auto [dresult, ddebug_lines] =
+      check_acs(config_, &user_, user_.sl(), "user.sl > 50", acs_debug_t::local);
+  EXPECT_TRUE(dresult);
+  EXPECT_FALSE(ddebug_lines.empty());
+}
+
+// Benchmark of checking typical sub/dir/menu expressions.
+TEST_F(CompiledAcsTest, DISABLED_Benchmark_CheckAcs) {
+  // Every distinct ACS string in the stock menus (install/gfiles/menus/wwiv)
+  // and the subs and dirs that wwivconfig creates.
+  const std::vector<std::string> exprs{
+      "user.sl >= 255 && user.sysop == true",
+      "user.sysop == true && user.cosysop == true",
+      "user.cosysop == true",
+      "user.sysop == true",
+      "user.dsl >= 100 && user.cosysop == true",
+      "user.sl >= 255 && user.dsl >= 255",
+      "user.sl >= 10",
+      "user.sysop",
+      "user.sl >= 60 && user.dsl >= 60",
+      "user.sl >= 200 && user.sysop == true",
+      "user.sl >= 20",
+      "user.dsl >= 100",
+      "user.dsl >= 10",
+  };
+  constexpr auto kNumIterations = 20000;
+  user_.sl(50);
+  user_.dsl(50);
+
+  auto count = 0;
+  auto start = steady_clock::now();
+  for (auto i = 0; i < kNumIterations; i++) {
+    for (const auto& e : exprs) {
+      count += eval_slow(e) ? 1 : 0;
+    }
+  }
+  const auto slow = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+  CompiledAcs::clear_cache();
+  start = steady_clock::now();
+  for (auto i = 0; i < kNumIterations; i++) {
+    for (const auto& e : exprs) {
+      count += std::get<0>(check_acs(config_, &user_, user_.sl(), e)) ? 1 : 0;
+    }
+  }
+  const auto fast = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+  const auto n = kNumIterations * static_cast<int64_t>(exprs.size());
+  LOG(INFO) << "Eval: " << slow / n << "ns/check; CompiledAcs: " << fast / n
+            << "ns/check; (" << count << ")";
+}
@@ -0,0 +1,299 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/fido/fido_packet_reader.h"
+#include "sdk/fido/fido_packets.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk::fido;
+using namespace wwiv::sdk::net;
+using namespace wwiv::strings;
+
+class FidoPacketReaderTest : public testing::Test {
+public:
+  static FidoPackedMessage CreateMessage(const std::string& to, const std::string& subject,
+                                         const std::string& text) {
+    fido_packed_message_t nh{};
+    nh.message_type = 2;
+    nh.orig_node = 1;
+    nh.dest_node = 2;
+    fido_variable_length_header_t vh{};
+    vh.date_time = "01 Jan 21  12:34:56";
+    vh.to_user_name = to;
+    vh.from_user_name = "Sysop";
+    vh.subject = subject;
+    vh.text = text;
+    return FidoPackedMessage(nh, vh);
+  }
+
+  // CreateTempFile stops at the first null.
+  std::filesystem::path WriteFile(const std::string& name, const std::string& data) const {
+    const auto path = helper_.CreateTempFilePath(name);
+    File f(path);
+    EXPECT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile |
+                       File::modeTruncate));
+    EXPECT_EQ(static_cast<File::size_type>(data.size()), f.Write(data));
+    return path;
+  }
+
+  // Creates a packet file holding messages.
+  std::filesystem::path CreatePacket(const std::string& name,
+                                     const std::vector<FidoPackedMessage>& messages) {
+    packet_header_2p_t header{};
+    header.packet_ver = 2;
+    to_char_array(header.password, "PW");
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& m : messages) {
+      append_packed_message(data, m);
+    }
+    data.append(2, '\0');
+    return WriteFile(name, data);
+  }
+
+  FileHelper helper_;
+};
+
+TEST_F(FidoPacketReaderTest, Smoke) {
+  const auto path = CreatePacket("a.pkt", {CreateMessage("Rushfan", "Hello", "World\r"),
+                                           CreateMessage("Someone", "Second", "")});
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoPacketReader reader(f);
+  packet_header_2p_t header{};
+  ASSERT_TRUE(reader.ReadHeader(header));
+  EXPECT_EQ(2, header.packet_ver);
+  EXPECT_STREQ("PW", header.password);
+
+  FidoPackedMessage msg;
+  ASSERT_EQ(ReadPacketResponse::OK, reader.Next(msg));
+  EXPECT_EQ(2, msg.nh.message_type);
+  EXPECT_EQ(2, msg.nh.dest_node);
+  EXPECT_EQ("01 Jan 21  12:34:56", msg.vh.date_time);
+  EXPECT_EQ("Rushfan", msg.vh.to_user_name);
+  EXPECT_EQ("Sysop", msg.vh.from_user_name);
+  EXPECT_EQ("Hello", msg.vh.subject);
+  EXPECT_EQ("World\r", msg.vh.text);
+
+  ASSERT_EQ(ReadPacketResponse::OK, reader.Next(msg));
+  EXPECT_EQ("Someone", msg.vh.to_user_name);
+  EXPECT_EQ("", msg.vh.text);
+  EXPECT_EQ(ReadPacketResponse::END_OF_FILE, reader.Next(msg));
+  EXPECT_EQ(f.length(), reader.position());
+}
+
+TEST_F(FidoPacketReaderTest, SameAsReadPackedMessage) {
+  // A name without a null after 36 characters runs into the next field, so
+  // the text is read as another message, which is longer than a read.
+  const auto path = CreatePacket(
+      "a.pkt", {CreateMessage(std::string(40, 'T'), "Long", std::string(100000, 'x')),
+                CreateMessage("Someone", "Short", "Text")});
+
+  std::vector<FidoPackedMessage> expected;
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+    f.Seek(sizeof(packet_header_2p_t), File::Whence::begin);
+    for (;;) {
+      FidoPackedMessage msg;
+      if (read_packed_message(f, msg) != ReadPacketResponse::OK) {
+        break;
+      }
+      expected.emplace_back(msg);
+    }
+  }
+  ASSERT_EQ(3u, expected.size());
+  EXPECT_EQ(std::string(36, 'T'), expected[0].vh.to_user_name);
+  EXPECT_EQ("TTTT", expected[0].vh.from_user_name);
+  EXPECT_EQ("Sysop", expected[0].vh.subject);
+  EXPECT_EQ("Long", expected[0].vh.text);
+
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoPacketReader reader(f, 4096);
+  packet_header_2p_t header{};
+  ASSERT_TRUE(reader.ReadHeader(header));
+  for (const auto& e : expected) {
+    FidoPackedMessage msg;
+    ASSERT_EQ(ReadPacketResponse::OK, reader.Next(msg));
+    EXPECT_EQ(e.vh.to_user_name, msg.vh.to_user_name);
+    EXPECT_EQ(e.vh.from_user_name, msg.vh.from_user_name);
+    EXPECT_EQ(e.vh.subject, msg.vh.subject);
+    EXPECT_EQ(e.vh.text, msg.vh.text);
+  }
+}
+
+TEST_F(FidoPacketReaderTest, Truncated) {
+  std::string data;
+  append_packed_message(data, CreateMessage("Rushfan", "Hello", "World"));
+  data.resize(data.size() - 3);
+  const auto path = WriteFile("a.pkt", data);
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoPacketReader reader(f);
+  FidoPackedMessage msg;
+  ASSERT_EQ(ReadPacketResponse::OK, reader.Next(msg));
+  EXPECT_EQ("Wor", msg.vh.text);
+  EXPECT_EQ(ReadPacketResponse::END_OF_FILE, reader.Next(msg));
+}
+
+TEST_F(FidoPacketReaderTest, ShortHeader) {
+  const auto path = WriteFile("a.pkt", std::string(5, '\x02'));
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoPacketReader reader(f);
+  FidoPackedMessage msg;
+  EXPECT_EQ(ReadPacketResponse::ERROR, reader.Next(msg));
+}
+
+TEST_F(FidoPacketReaderTest, WritePackedMessage) {
+  const auto path = helper_.CreateTempFilePath("a.pkt");
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile));
+    auto m = CreateMessage("Rushfan", "Hello", "World");
+    ASSERT_TRUE(write_packed_message(f, m));
+  }
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoPackedMessage msg;
+  ASSERT_EQ(ReadPacketResponse::OK, read_packed_message(f, msg));
+  EXPECT_EQ("World", msg.vh.text);
+  EXPECT_EQ(ReadPacketResponse::END_OF_FILE, read_packed_message(f, msg));
+}
+
+TEST_F(FidoPacketReaderTest, StoredMessage) {
+  const auto path = helper_.CreateTempFilePath("1.msg");
+  {
+    fido_stored_message_t h{};
+    to_char_array(h.from, "Sysop");
+    to_char_array(h.subject, "Hello");
+    h.dest_node = 2;
+    FidoStoredMessage m(h, "World\r");
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile));
+    ASSERT_TRUE(write_stored_message(f, m));
+  }
+  File f(path);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  FidoStoredMessage msg;
+  ASSERT_EQ(ReadPacketResponse::OK, read_stored_message(f, msg));
+  EXPECT_STREQ("Sysop", msg.nh.from);
+  EXPECT_STREQ("Hello", msg.nh.subject);
+  EXPECT_EQ(2, msg.nh.dest_node);
+  EXPECT_EQ("World\r", msg.text);
+}
+
+namespace {
+
+// read_packed_message as it was before it used FidoPacketReader, reading the
+// variable length fields a byte at a time, so the benchmark has something to
+// compare against.
+char original_read_char(File& f) {
+  char ch;
+  return f.Read(&ch, 1) == 1 ? ch : 0;
+}
+
+std::string original_read_fixed(File& f, int len) {
+  std::string s(len, '\0');
+  s.resize(f.Read(&s[0], len));
+  while (!s.empty() && s.back() == '\0') {
+    s.pop_back();
+  }
+  return s;
+}
+
+std::string original_read_variable(File& f, int max_len) {
+  std::string s;
+  for (auto i = 0; i < max_len; i++) {
+    const auto ch = original_read_char(f);
+    if (ch == 0) {
+      return s;
+    }
+    s.push_back(ch);
+  }
+  return s;
+}
+
+ReadPacketResponse original_read_packed_message(File& f, FidoPackedMessage& packet) {
+  const auto num_read = f.Read(&packet.nh, sizeof(fido_packed_message_t));
+  if (num_read == 0 || (num_read == 2 && packet.nh.message_type == 0)) {
+    return ReadPacketResponse::END_OF_FILE;
+  }
+  if (num_read != sizeof(fido_packed_message_t)) {
+    return ReadPacketResponse::ERROR;
+  }
+  packet.vh.date_time = original_read_fixed(f, 20);
+  packet.vh.to_user_name = original_read_variable(f, 36);
+  packet.vh.from_user_name = original_read_variable(f, 36);
+  packet.vh.subject = original_read_variable(f, 72);
+  packet.vh.text = original_read_variable(f, 256 * 1024);
+  return ReadPacketResponse::OK;
+}
+
+} // namespace
+
+TEST_F(FidoPacketReaderTest, DISABLED_Benchmark_Read10MB) {
+  std::vector<FidoPackedMessage> messages;
+  const std::string text = StrCat("AREA:WWIV\r", std::string(2000, 'x'), "\r");
+  for (auto size = 0; size < 10 * 1024 * 1024; size += 2100) {
+    messages.emplace_back(CreateMessage("All", "Echomail", text));
+  }
+  const auto path = CreatePacket("echo.pkt", messages);
+
+  auto start = steady_clock::now();
+  auto old_count = 0;
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+    f.Seek(sizeof(packet_header_2p_t), File::Whence::begin);
+    FidoPackedMessage msg;
+    while (original_read_packed_message(f, msg) == ReadPacketResponse::OK) {
+      ++old_count;
+    }
+  }
+  const auto old_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  auto new_count = 0;
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+    FidoPacketReader reader(f);
+    packet_header_2p_t header{};
+    ASSERT_TRUE(reader.ReadHeader(header));
+    FidoPackedMessage msg;
+    while (reader.Next(msg) == ReadPacketResponse::OK) {
+      ++new_count;
+    }
+  }
+  const auto new_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+  EXPECT_EQ(static_cast<int>(messages.size()), old_count);
+  EXPECT_EQ(old_count, new_count);
+
+  LOG(INFO) << "Original reader:  " << old_ms << "ms for " << old_count << " messages";
+  LOG(INFO) << "FidoPacketReader: " << new_ms << "ms for " << new_count << " messages";
+}
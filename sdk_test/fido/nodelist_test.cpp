@@ -18,9 +18,17 @@
 /**************************************************************************/
 #include "gtest/gtest.h"
 
+#include "core/file.h"
+#include "core/log.h"
 #include "core/stl.h"
 #include "core/strings.h"
+#include "core/textfile.h"
+#include "core_test/file_helper.h"
 #include "sdk/fido/nodelist.h"
+#include "sdk/fido/nodelist_cache.h"
+#include <chrono>
+#include <cstddef>
+#include <sstream>
 #include <type_traits>
 
 using std::cout;
@@ -28,6 +36,7 @@ using std::endl;
 using std::is_standard_layout;
 using std::string;
 
+using namespace wwiv::core;
 using namespace wwiv::sdk;
 using namespace wwiv::stl;
 using namespace wwiv::strings;
@@ -127,4 +136,141 @@ TEST(NodelistTest, Nodes) {
   const auto nets = nl.nodes(1, 261);
   const std::vector<uint16_t>expected{1, 1300};
   EXPECT_EQ(expected, nets);
-}
\ No newline at end of file
+}
+class NodelistCacheTest : public testing::Test {
+public:
+  NodelistCacheTest() : path_(helper_.CreateTempFile("NODELIST.123", raw)) {}
+
+  FileHelper helper_;
+  std::filesystem::path path_;
+};
+
+TEST_F(NodelistCacheTest, CreatedThenUsed) {
+  const Nodelist text(path_);
+  ASSERT_TRUE(text);
+  EXPECT_FALSE(text.cached());
+  EXPECT_TRUE(File::Exists(NodelistCache::CachePath(path_)));
+
+  const Nodelist nl(path_);
+  ASSERT_TRUE(nl);
+  ASSERT_TRUE(nl.cached());
+
+  EXPECT_EQ(text.zones(), nl.zones());
+  EXPECT_EQ(text.nets(1), nl.nets(1));
+  EXPECT_EQ(text.nodes(1, 261), nl.nodes(1, 261));
+  EXPECT_EQ(text.entries(1).size(), nl.entries(1).size());
+  EXPECT_TRUE(nl.contains(FidoAddress("1:261/1300")));
+  EXPECT_FALSE(nl.contains(FidoAddress("1:261/1301")));
+  EXPECT_FALSE(nl.contains(FidoAddress("1:261/1300.1")));
+
+  const auto& e = nl.entry(FidoAddress("1:261/1"));
+  EXPECT_EQ("Weather Station Hub", e.name_);
+  EXPECT_EQ("Sysop Name261 1", e.sysop_name_);
+  EXPECT_EQ("Bel Air MD", e.location_);
+  EXPECT_TRUE(e.binkp_);
+  EXPECT_TRUE(e.cm_);
+  EXPECT_FALSE(e.mo_);
+  EXPECT_EQ("bbs.weather-station.org", e.hostname_);
+  EXPECT_EQ("bbs.weather-station.org", e.binkp_hostname_);
+  EXPECT_EQ(24555, e.binkp_port_);
+  EXPECT_EQ(300u, e.baud_rate_);
+
+  ASSERT_EQ(text.entries().size(), nl.entries().size());
+  for (const auto& [a, te] : text.entries()) {
+    const auto& ce = nl.entry(a);
+    EXPECT_EQ(te.address_, ce.address_);
+    EXPECT_EQ(te.keyword_, ce.keyword_);
+    EXPECT_EQ(te.name_, ce.name_);
+    EXPECT_EQ(te.phone_number_, ce.phone_number_);
+    EXPECT_EQ(te.binkp_hostname_, ce.binkp_hostname_);
+    EXPECT_EQ(te.binkp_port_, ce.binkp_port_);
+  }
+}
+
+TEST_F(NodelistCacheTest, RebuiltWhenChanged) {
+  { const Nodelist nl(path_); }
+  {
+    TextFile f(path_, "at");
+    f.WriteLine(",1400,New_BBS,Bel_Air_MD,Sysop,-Unpublished-,300,CM");
+  }
+  const Nodelist nl(path_);
+  EXPECT_FALSE(nl.cached());
+  EXPECT_TRUE(nl.contains(FidoAddress("1:261/1400")));
+
+  const Nodelist again(path_);
+  EXPECT_TRUE(again.cached());
+  EXPECT_TRUE(again.contains(FidoAddress("1:261/1400")));
+}
+
+TEST_F(NodelistCacheTest, TouchedButUnchanged) {
+  { const Nodelist nl(path_); }
+  {
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeReadWrite | File::modeBinary));
+    f.set_last_write_time(File::last_write_time(path_) - 3600);
+  }
+  const Nodelist nl(path_);
+  EXPECT_TRUE(nl.cached());
+}
+
+TEST_F(NodelistCacheTest, IgnoredWithBadStringOffset) {
+  { const Nodelist nl(path_); }
+  const auto cache_path = NodelistCache::CachePath(path_);
+  {
+    File f(cache_path);
+    ASSERT_TRUE(f.Open(File::modeReadWrite | File::modeBinary));
+    const uint32_t offset = 0x7fffffff;
+    f.Seek(sizeof(nodelist_cache_header_t) + offsetof(nodelist_cache_rec_t, location),
+           File::Whence::begin);
+    f.Write(&offset, sizeof(offset));
+  }
+  EXPECT_FALSE(NodelistCache::Open(path_).has_value());
+  const Nodelist nl(path_);
+  EXPECT_FALSE(nl.cached());
+  EXPECT_EQ("Bel Air MD", nl.entry(FidoAddress("1:261/1")).location_);
+}
+
+TEST_F(NodelistCacheTest, NotUsedWhenDisabled) {
+  const Nodelist nl(path_, false);
+  EXPECT_FALSE(nl.cached());
+  EXPECT_FALSE(File::Exists(NodelistCache::CachePath(path_)));
+}
+
+TEST_F(NodelistCacheTest, FindLatestNodelist_IgnoresCache) {
+  { const Nodelist nl(path_); }
+  EXPECT_EQ("NODELIST.123", Nodelist::FindLatestNodelist(path_.parent_path(), "NODELIST"));
+}
+
+// Benchmark of loading a large nodelist from text and from the cache.
+TEST_F(NodelistCacheTest, DISABLED_Benchmark_Load) {
+  std::ostringstream ss;
+  ss << "Zone,1,North_America,Somewhere,Sysop,-Unpublished-,300,CM,INA:zone.example.com,IBN\n";
+  for (auto net = 100; net < 400; net++) {
+    ss << "Host," << net << ",Net_" << net << ",Somewhere,Sysop,-Unpublished-,300,CM\n";
+    for (auto node = 1; node <= 100; node++) {
+      ss << "," << node << ",BBS_" << net << "_" << node << ",City_" << node % 50
+         << ",Sysop_" << node << ",-Unpublished-,300,CM,XA,INA:bbs" << node << ".example.com,IBN\n";
+    }
+  }
+  const auto path = helper_.CreateTempFile("NODELIST.200", ss.str());
+
+  auto start = std::chrono::steady_clock::now();
+  const Nodelist text(path);
+  const auto text_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  ASSERT_FALSE(text.cached());
+
+  start = std::chrono::steady_clock::now();
+  const Nodelist nl(path);
+  ASSERT_TRUE(nl.cached());
+  const auto* e = nl.entry(FidoAddress("1:250/50")).name_.c_str();
+  const auto cache_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  EXPECT_STREQ("BBS 250 50", e);
+
+  LOG(INFO) << "Entries: " << text.entries().size()
+            << "; cache size: " << File(NodelistCache::CachePath(path)).length() << " bytes";
+  LOG(INFO) << "Text: " << text_ms << "ms; Cache: " << cache_ms << "ms";
+}
@@ -0,0 +1,281 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "fmt/format.h"
+#include "sdk/files/file_catalog.h"
+#include "sdk/files/files.h"
+#include "sdk_test/sdk_helper.h"
+#include "sdk_test/files/filesapi_helper.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::files;
+using namespace wwiv::strings;
+
+static bool formula(const std::string& text, const std::string& f) {
+  return keyword_formula_match(f, [&](const std::string& term) { return ifind_first(text, term); });
+}
+
+TEST(KeywordFormulaTest, Smoke) {
+  const std::string text = "FOO     .ZIP The quick brown fox";
+  EXPECT_TRUE(formula(text, "quick"));
+  EXPECT_TRUE(formula(text, "QUICK"));
+  EXPECT_FALSE(formula(text, "slow"));
+  EXPECT_TRUE(formula(text, "quick&fox"));
+  EXPECT_FALSE(formula(text, "quick&slow"));
+  EXPECT_TRUE(formula(text, "slow|fox"));
+  EXPECT_FALSE(formula(text, "slow|dog"));
+  EXPECT_TRUE(formula(text, "!slow"));
+  EXPECT_FALSE(formula(text, "!quick"));
+  EXPECT_TRUE(formula(text, "(slow|quick)&brown"));
+  EXPECT_FALSE(formula(text, "!(slow|quick)"));
+  EXPECT_TRUE(formula(text, ".ZIP"));
+}
+
+class FileCatalogTest : public testing::Test {
+public:
+  FileCatalogTest() : api_(helper_.data()), api_helper_(&api_) {}
+
+  static std::vector<std::string> names(const std::optional<std::vector<std::string>>& c) {
+    return c.value_or(std::vector<std::string>{});
+  }
+
+  void Build() {
+    auto a = api_helper_.CreateAndPopulate("games",
+                                           {FileRecord(ul("doom.zip", "Doom shareware", 1000, 100)),
+                                            FileRecord(ul("quake.zip", "Quake demo", 1000, 200))});
+    FileRecord f(ul("tetris.zip", "Falling blocks", 100, 300));
+    a->AddFile(f, "Classic puzzle game\r\nfor DOS");
+    a->Close();
+    api_helper_.CreateAndPopulate("utils", {FileRecord(ul("pkzip.exe", "Zip utility", 1000, 150)),
+                                            FileRecord(ul("arj.exe", "ARJ archiver", 1000, 250))});
+    api_helper_.CreateAndPopulate("empty", {});
+
+    FileCatalog catalog(helper_.data());
+    for (const auto& name : {"games", "utils", "empty"}) {
+      auto area = api_.Open(name);
+      catalog.AddArea(name, *area);
+    }
+    ASSERT_TRUE(catalog.Save());
+  }
+
+  SdkHelper helper_;
+  FileApi api_;
+  FilesApiHelper api_helper_;
+};
+
+TEST_F(FileCatalogTest, NotBuilt) {
+  FileCatalog catalog(helper_.data());
+  EXPECT_FALSE(catalog.exists());
+  EXPECT_FALSE(catalog.Load());
+
+  // Changes aren't journaled until it has been built.
+  api_helper_.CreateAndPopulate("games", {FileRecord(ul("doom.zip", "Doom shareware", 1000))});
+  EXPECT_FALSE(File::Exists(catalog.journal_path()));
+}
+
+TEST_F(FileCatalogTest, Query) {
+  Build();
+  FileCatalog catalog(helper_.data());
+  ASSERT_TRUE(catalog.Load());
+  EXPECT_EQ(5, catalog.size());
+  EXPECT_TRUE(catalog.has_area("empty"));
+  EXPECT_FALSE(catalog.has_area("other"));
+  EXPECT_FALSE(catalog.candidates("other", {}));
+
+  using v = std::vector<std::string>;
+  EXPECT_EQ((v{"DOOM    .ZIP", "QUAKE   .ZIP", "TETRIS  .ZIP"}), names(catalog.candidates("games", {})));
+  EXPECT_EQ(v{}, names(catalog.candidates("empty", {})));
+
+  file_catalog_query_t q{};
+  q.filemask = "????????.EXE";
+  EXPECT_EQ(v{}, names(catalog.candidates("games", q)));
+  EXPECT_EQ((v{"ARJ     .EXE", "PKZIP   .EXE"}), names(catalog.candidates("utils", q)));
+  q.filemask = "        .   ";
+  EXPECT_EQ(3u, names(catalog.candidates("games", q)).size());
+
+  q = {};
+  q.newer_than = 200;
+  EXPECT_EQ((v{"QUAKE   .ZIP", "TETRIS  .ZIP"}), names(catalog.candidates("games", q)));
+  EXPECT_EQ(v{"ARJ     .EXE"}, names(catalog.candidates("utils", q)));
+
+  q = {};
+  q.keywords = "puzzle";
+  EXPECT_EQ(v{"TETRIS  .ZIP"}, names(catalog.candidates("games", q)));
+  q.keywords = "sharew|DEMO";
+  EXPECT_EQ((v{"DOOM    .ZIP", "QUAKE   .ZIP"}), names(catalog.candidates("games", q)));
+  q.keywords = "zip & !doom";
+  EXPECT_EQ((v{"QUAKE   .ZIP", "TETRIS  .ZIP"}), names(catalog.candidates("games", q)));
+  EXPECT_EQ(v{"PKZIP   .EXE"}, names(catalog.candidates("utils", q)));
+  q.keywords = "nothing";
+  EXPECT_EQ(v{}, names(catalog.candidates("games", q)));
+}
+
+TEST_F(FileCatalogTest, Search) {
+  Build();
+  FileCatalog catalog(helper_.data());
+  ASSERT_TRUE(catalog.Load());
+  file_catalog_query_t q{};
+  q.keywords = "zip";
+  std::vector<std::string> found;
+  catalog.Search(q, [&](const FileCatalog::entry_t& e) {
+    found.push_back(StrCat(e.area, ":", e.filename));
+    return true;
+  });
+  EXPECT_EQ((std::vector<std::string>{"games:DOOM    .ZIP", "games:QUAKE   .ZIP",
+                                      "games:TETRIS  .ZIP", "utils:PKZIP   .EXE"}),
+            found);
+
+  found.clear();
+  catalog.Search(q, [&](const FileCatalog::entry_t& e) {
+    found.push_back(e.filename);
+    return found.size() < 2;
+  });
+  EXPECT_EQ(2u, found.size());
+}
+
+TEST_F(FileCatalogTest, FollowsFileArea) {
+  Build();
+  {
+    auto area = api_.Open("games");
+    FileRecord f(ul("descent.zip", "Flying", 100, 400));
+    ASSERT_TRUE(area->AddFile(f, "Six degrees of freedom"));
+    ASSERT_TRUE(area->DeleteFile(area->FindFile("DOOM    .ZIP").value()));
+    auto q = area->ReadFile(area->FindFile("QUAKE   .ZIP").value());
+    q.set_filename("quake2.zip");
+    ASSERT_TRUE(area->UpdateFile(q, area->FindFile("QUAKE   .ZIP").value()));
+    ASSERT_TRUE(area->Close());
+  }
+  api_helper_.CreateAndPopulate("new", {FileRecord(ul("new.txt", "Brand new", 10, 500))});
+
+  FileCatalog catalog(helper_.data());
+  ASSERT_TRUE(File::Exists(catalog.journal_path()));
+  ASSERT_TRUE(catalog.Load());
+  using v = std::vector<std::string>;
+  EXPECT_EQ((v{"DESCENT .ZIP", "QUAKE2  .ZIP", "TETRIS  .ZIP"}),
+            names(catalog.candidates("games", {})));
+  file_catalog_query_t q{};
+  q.keywords = "freedom";
+  EXPECT_EQ(v{"DESCENT .ZIP"}, names(catalog.candidates("games", q)));
+  q.keywords = "brand";
+  EXPECT_EQ(v{"NEW     .TXT"}, names(catalog.candidates("new", q)));
+
+  // Saving folds in the journal.
+  ASSERT_TRUE(catalog.Save());
+  EXPECT_EQ(0, File(catalog.journal_path()).length());
+  FileCatalog reloaded(helper_.data());
+  ASSERT_TRUE(reloaded.Load());
+  EXPECT_EQ(catalog.size(), reloaded.size());
+  // Words only the deleted file had are gone.
+  EXPECT_LT(reloaded.number_of_words(), catalog.number_of_words());
+  q.keywords = "freedom";
+  EXPECT_EQ(v{"DESCENT .ZIP"}, names(reloaded.candidates("games", q)));
+}
+
+TEST_F(FileCatalogTest, Duplicate_KeptUntilLastRemoved) {
+  Build();
+  {
+    auto area = api_.Open("utils");
+    FileRecord f(ul("arj.exe", "Second copy", 100, 400));
+    ASSERT_TRUE(area->AddFile(f));
+    ASSERT_TRUE(area->DeleteFile(1));
+    ASSERT_TRUE(area->Close());
+  }
+  FileCatalog catalog(helper_.data());
+  ASSERT_TRUE(catalog.Load());
+  file_catalog_query_t q{};
+  q.keywords = "archiver";
+  EXPECT_EQ(std::vector<std::string>{"ARJ     .EXE"}, names(catalog.candidates("utils", q)));
+}
+
+// Benchmark of a keyword search across 300 file areas.
+TEST_F(FileCatalogTest, DISABLED_Benchmark_Search300Areas) {
+  constexpr auto kNumAreas = 300;
+  constexpr auto kFilesPerArea = 100;
+  std::vector<std::string> areas;
+  for (auto a = 0; a < kNumAreas; a++) {
+    const auto name = fmt::format("area{}", a);
+    auto area = api_helper_.CreateAndPopulate(name, {});
+    for (auto i = 0; i < kFilesPerArea; i++) {
+      FileRecord f(ul(fmt::format("F{:03}{:04}.ZIP", a, i), fmt::format("File {} in {}", i, a),
+                      1234, 1000 + i));
+      area->AddFile(f, fmt::format("Extended description\r\nkeyword{}", a * kFilesPerArea + i));
+    }
+    area->Close();
+    areas.push_back(name);
+  }
+  {
+    FileCatalog catalog(helper_.data());
+    for (const auto& name : areas) {
+      catalog.AddArea(name, *api_.Open(name));
+    }
+    ASSERT_TRUE(catalog.Save());
+  }
+  const std::string keywords = "keyword1234|keyword20000";
+
+  auto start = steady_clock::now();
+  auto old_found = 0;
+  for (const auto& name : areas) {
+    auto area = api_.Open(name);
+    for (auto i = 1; i <= area->number_of_files(); i++) {
+      auto f = area->ReadFile(i);
+      const auto text = StrCat(area->ReadExtendedDescriptionAsString(f).value_or(""), " ",
+                               f.u().filename, " ", f.u().description);
+      if (formula(text, keywords)) {
+        ++old_found;
+      }
+    }
+  }
+  const auto old_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  auto new_found = 0;
+  FileCatalog catalog(helper_.data());
+  ASSERT_TRUE(catalog.Load());
+  file_catalog_query_t q{};
+  q.keywords = keywords;
+  for (const auto& name : areas) {
+    const auto c = catalog.candidates(name, q);
+    if (!c || c->empty()) {
+      continue;
+    }
+    auto area = api_.Open(name);
+    for (const auto& fn : c.value()) {
+      auto f = area->ReadFile(area->FindFile(fn).value());
+      const auto text = StrCat(area->ReadExtendedDescriptionAsString(f).value_or(""), " ",
+                               f.u().filename, " ", f.u().description);
+      if (formula(text, keywords)) {
+        ++new_found;
+      }
+    }
+  }
+  const auto new_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+  EXPECT_EQ(old_found, new_found);
+
+  LOG(INFO) << "Scanning every area: " << old_ms << "ms; found " << old_found;
+  LOG(INFO) << "FileCatalog:         " << new_ms << "ms; found " << new_found;
+}
@@ -92,3 +92,95 @@ TEST_F(FilesExtTest, Smoke) {
   EXPECT_EQ(s1, e->ReadExtended(f1).value());
   EXPECT_EQ(s2, e->ReadExtended(f2).value());
 }
+
+TEST_F(FilesExtTest, AddAndDelete_AfterLoad) {
+  const string name = test_info_->name();
+
+  const FileRecord f1{ul("FILE0001.ZIP", "", 1234)};
+  const FileRecord f2{ul("FILE0002.ZIP", "", 1234)};
+  const FileRecord f3{ul("FILE0003.ZIP", "", 1234)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1, f2, f3});
+  ASSERT_TRUE(area);
+
+  auto* e = area->ext_desc().value();
+  EXPECT_TRUE(e->AddExtended(f1, "One"));
+  EXPECT_TRUE(e->AddExtended(f2, "Two"));
+  EXPECT_EQ("One", e->ReadExtended(f1).value());
+
+  // Now that it's loaded, adds and deletes need to update what's in memory.
+  EXPECT_TRUE(e->AddExtended(f3, "Three"));
+  EXPECT_EQ("Three", e->ReadExtended(f3).value());
+  EXPECT_TRUE(e->DeleteExtended(f2));
+  EXPECT_FALSE(e->ReadExtended(f2).has_value());
+  EXPECT_EQ("One", e->ReadExtended(f1).value());
+  EXPECT_EQ("Three", e->ReadExtended(f3).value());
+  EXPECT_EQ(2, e->number_of_ext_descriptions());
+
+  // And on disk.
+  FileAreaExtendedDesc reloaded(&api_, helper.data(), name, 3);
+  EXPECT_EQ(2, reloaded.number_of_ext_descriptions());
+  EXPECT_FALSE(reloaded.ReadExtended(f2).has_value());
+  EXPECT_EQ("One", reloaded.ReadExtended(f1).value());
+  EXPECT_EQ("Three", reloaded.ReadExtended(f3).value());
+}
+
+TEST_F(FilesExtTest, AddedByOther_ThenDelete) {
+  const string name = test_info_->name();
+
+  const FileRecord f1{ul("FILE0001.ZIP", "", 1234)};
+  const FileRecord f2{ul("FILE0002.ZIP", "", 1234)};
+  const FileRecord f3{ul("FILE0003.ZIP", "", 1234)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1, f2, f3});
+  ASSERT_TRUE(area);
+
+  auto* e = area->ext_desc().value();
+  EXPECT_TRUE(e->AddExtended(f1, "One"));
+  EXPECT_EQ("One", e->ReadExtended(f1).value());
+
+  // Another node adds descriptions after we've loaded the file.
+  FileAreaExtendedDesc other(&api_, helper.data(), name, 3);
+  EXPECT_EQ(1, other.number_of_ext_descriptions());
+  EXPECT_TRUE(other.AddExtended(f2, "Two"));
+  EXPECT_TRUE(other.AddExtended(f3, "Three"));
+
+  // We need to see them, and not lose them when deleting.
+  EXPECT_EQ("Two", e->ReadExtended(f2).value());
+  EXPECT_TRUE(e->DeleteExtended(f1));
+  EXPECT_FALSE(e->ReadExtended(f1).has_value());
+  EXPECT_EQ("Three", e->ReadExtended(f3).value());
+
+  FileAreaExtendedDesc reloaded(&api_, helper.data(), name, 3);
+  EXPECT_EQ(2, reloaded.number_of_ext_descriptions());
+  EXPECT_EQ("Two", reloaded.ReadExtended(f2).value());
+  EXPECT_EQ("Three", reloaded.ReadExtended(f3).value());
+
+  // The other one sees the delete too.
+  EXPECT_FALSE(other.ReadExtended(f1).has_value());
+}
+
+TEST_F(FilesExtTest, Duplicate_FirstWins) {
+  const string name = test_info_->name();
+
+  const FileRecord f1{ul("FILE0001.ZIP", "", 1234)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1});
+  ASSERT_TRUE(area);
+
+  auto* e = area->ext_desc().value();
+  EXPECT_TRUE(e->AddExtended(f1, "First"));
+  EXPECT_TRUE(e->AddExtended(f1, "Second"));
+  EXPECT_EQ(2, e->number_of_ext_descriptions());
+  EXPECT_EQ("First", e->ReadExtended(f1).value());
+
+  // Deleting removes both.
+  EXPECT_TRUE(e->DeleteExtended(f1));
+  EXPECT_EQ(0, e->number_of_ext_descriptions());
+  EXPECT_FALSE(e->ReadExtended(f1).has_value());
+}
+
+TEST_F(FilesExtTest, Delete_NoExtFile) {
+  const string name = test_info_->name();
+  const FileRecord f1{ul("FILE0001.ZIP", "", 1234)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1});
+  ASSERT_TRUE(area);
+  EXPECT_TRUE(area->ext_desc().value()->DeleteExtended(f1));
+}
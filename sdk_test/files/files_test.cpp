@@ -23,13 +23,16 @@
 #include "gtest/gtest.h"
 
 #include "core/file.h"
+#include "core/log.h"
 #include "core/stl.h"
 #include "core/strings.h"
 #include "core_test/file_helper.h"
+#include "fmt/format.h"
 #include "sdk/config.h"
 #include "sdk/files/files.h"
 #include "sdk_test/sdk_helper.h"
 #include "sdk_test/files/filesapi_helper.h"
+#include <chrono>
 #include <string>
 
 using namespace std;
@@ -308,6 +311,53 @@ TEST_F(FilesTest, SearchFile) {
   EXPECT_FALSE(area->SearchFile("F???????.ZIP", 4).has_value());
 }
 
+TEST_F(FilesTest, SearchFile_Duplicate) {
+  const string name = test_info_->name();
+  FileRecord f1{ul("FILE0001.ZIP", "", 1234)};
+  FileRecord f2{ul("FILE0002.ZIP", "", 1234)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1, f2, f1});
+
+  EXPECT_EQ(1, area->SearchFile("FILE0001.ZIP").value());
+  EXPECT_EQ(3, area->SearchFile("FILE0001.ZIP", 2).value());
+  EXPECT_FALSE(area->SearchFile("FILE0002.ZIP", 3).has_value());
+  EXPECT_FALSE(area->SearchFile("FILE0003.ZIP").has_value());
+}
+
+TEST_F(FilesTest, FindFile_FollowsChanges) {
+  const string name = test_info_->name();
+  const auto now = DateTime::now().to_daten_t();
+  FileRecord f1{ul("FILE0001.ZIP", "", 1234, now)};
+  FileRecord f2{ul("FILE0002.ZIP", "", 1234, now - 200)};
+  FileRecord f3{ul("FILE0003.ZIP", "", 1234, now - 100)};
+  FileRecord f4{ul("FILE0004.ZIP", "", 1234, now - 300)};
+  auto area = api_helper_.CreateAndPopulate(name, {f1, f2, f3});
+  EXPECT_EQ(3, area->FindFile(f1).value());
+
+  // Add
+  ASSERT_TRUE(area->AddFile(f4));
+  EXPECT_EQ(1, area->FindFile(f4).value());
+  EXPECT_EQ(4, area->FindFile(f1).value());
+  EXPECT_EQ(3, area->FindFile(f2).value());
+
+  // Delete
+  ASSERT_TRUE(area->DeleteFile(f2, 3));
+  EXPECT_FALSE(area->FindFile(f2).has_value());
+  EXPECT_EQ(3, area->FindFile(f1).value());
+  EXPECT_EQ(2, area->FindFile(f3).value());
+
+  // Sort
+  ASSERT_TRUE(area->Sort(FileAreaSortType::FILENAME_ASC));
+  EXPECT_EQ(1, area->FindFile(f1).value());
+  EXPECT_EQ(2, area->FindFile(f3).value());
+  EXPECT_EQ(3, area->FindFile(f4).value());
+
+  // Update
+  f1.set_filename("foo.zip");
+  ASSERT_TRUE(area->UpdateFile(f1, 1));
+  EXPECT_EQ(1, area->FindFile("FOO     .ZIP").value());
+  EXPECT_FALSE(area->FindFile("FILE0001.ZIP").has_value());
+}
+
 TEST_F(FilesTest, UpdateFile) {
   const string name = test_info_->name();
   const auto now = DateTime::now().to_daten_t();
@@ -340,6 +390,40 @@ TEST_F(FilesTest, Update_ExtendedDescription) {
   EXPECT_STREQ("Hello", area->ReadExtendedDescriptionAsString(af).value().c_str());
 }
 
+// Lists a 20k file area with extended descriptions, the way the file
+// listing does.
+TEST_F(FilesTest, DISABLED_Benchmark_List20k) {
+  constexpr auto kNumFiles = 20000;
+  const string name = test_info_->name();
+  {
+    auto area = api_helper_.CreateAndPopulate(name, {});
+    for (auto i = 0; i < kNumFiles; i++) {
+      FileRecord f{ul(fmt::format("F{:07}.ZIP", i), "Description", 1234)};
+      ASSERT_TRUE(area->AddFile(f, fmt::format("Extended description\r\nfor file {}", i)));
+    }
+    ASSERT_TRUE(area->Close());
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto area = api_.Open(name);
+  ASSERT_TRUE(area);
+  ASSERT_EQ(kNumFiles, area->number_of_files());
+  auto found = 0;
+  for (auto i = 1; i <= area->number_of_files(); i++) {
+    auto f = area->ReadFile(i);
+    if (f.has_extended_description() && area->ReadExtendedDescriptionAsString(f)) {
+      ++found;
+    }
+    if (area->FindFile(f).value_or(0) == i) {
+      ++found;
+    }
+  }
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(kNumFiles * 2, found);
+  LOG(INFO) << "Listed " << kNumFiles << " files: " << ms << "ms";
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 // FileRecordTest
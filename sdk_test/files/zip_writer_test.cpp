@@ -0,0 +1,88 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/crc32.h"
+#include "core/datetime.h"
+#include "core/file.h"
+#include "core_test/file_helper.h"
+#include "sdk/files/arc.h"
+#include "sdk/files/zip_format.h"
+#include "sdk/files/zip_writer.h"
+#include "gtest/gtest.h"
+#include <string>
+
+using namespace wwiv::core;
+using namespace wwiv::sdk::files;
+
+class ZipWriterTest : public testing::Test {
+public:
+  ZipWriterTest() : path_(FilePath(helper_.TempDir(), "test.zip")) {}
+
+  FileHelper helper_;
+  const std::filesystem::path path_;
+};
+
+TEST_F(ZipWriterTest, Smoke) {
+  const auto dt = DateTime::now();
+  {
+    ZipWriter zip(path_);
+    ASSERT_TRUE(zip.Create());
+    EXPECT_TRUE(zip.Add("01020304.pkt", "Hello", dt));
+    EXPECT_TRUE(zip.Add("01020305.pkt", std::string(1000, 'x'), dt));
+    EXPECT_EQ(2, zip.num_entries());
+    EXPECT_TRUE(zip.Close());
+  }
+
+  const auto o = list_archive(path_);
+  ASSERT_TRUE(o.has_value());
+  const auto& files = o.value();
+  ASSERT_EQ(2u, files.size());
+  EXPECT_EQ("01020304.pkt", files[0].filename);
+  EXPECT_EQ(archive_method_t::ZIP_STORED, files[0].method);
+  EXPECT_EQ(5, files[0].uncompress_size);
+  EXPECT_EQ(5, files[0].compress_size);
+  EXPECT_EQ(crc32string("Hello"), files[0].crc32);
+  // DOS times only have 2 second resolution.
+  EXPECT_LE(std::abs(dt.to_time_t() - files[0].dt), 2);
+  EXPECT_EQ("01020305.pkt", files[1].filename);
+  EXPECT_EQ(1000, files[1].uncompress_size);
+  EXPECT_EQ(crc32string(std::string(1000, 'x')), files[1].crc32);
+
+  // Stored files follow their local header and name.
+  const auto contents = helper_.ReadFile(path_);
+  EXPECT_EQ("Hello", contents.substr(sizeof(zip_local_header) + 12, 5));
+}
+
+TEST_F(ZipWriterTest, Empty) {
+  {
+    ZipWriter zip(path_);
+    ASSERT_TRUE(zip.Create());
+  }
+  EXPECT_EQ(sizeof(zip_end_dir), File(path_).length());
+  const auto o = list_archive(path_);
+  ASSERT_TRUE(o.has_value());
+  EXPECT_TRUE(o.value().empty());
+}
+
+TEST_F(ZipWriterTest, Create_AlreadyExists) {
+  helper_.CreateTempFile("test.zip", "something");
+  ZipWriter zip(path_);
+  EXPECT_FALSE(zip.Create());
+  EXPECT_FALSE(zip.Add("01020304.pkt", "Hello", DateTime::now()));
+  EXPECT_EQ("something", helper_.ReadFile(path_));
+}
@@ -0,0 +1,96 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/file.h"
+#include "core_test/file_helper.h"
+#include "sdk/index_io.h"
+#include <string>
+
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+
+TEST(IndexIOTest, RoundTrip) {
+  std::string data;
+  put_u16(data, 0x1234);
+  put_u32(data, 0xdeadbeef);
+  put_varint(data, 5);
+  put_varint(data, 300);
+  put_varint(data, 0xffffffff);
+  put_string(data, "HELLO");
+  EXPECT_EQ(2u + 4u + 1u + 2u + 5u + 2u + 5u, data.size());
+
+  IndexReader r(data);
+  uint16_t u16{0};
+  uint32_t u32{0};
+  uint32_t v1{0}, v2{0}, v3{0};
+  std::string s;
+  ASSERT_TRUE(r.get(u16));
+  ASSERT_TRUE(r.get(u32));
+  ASSERT_TRUE(r.get_varint(v1));
+  ASSERT_TRUE(r.get_varint(v2));
+  ASSERT_TRUE(r.get_varint(v3));
+  ASSERT_TRUE(r.get_string(s));
+  EXPECT_TRUE(r.done());
+  EXPECT_EQ(0x1234, u16);
+  EXPECT_EQ(0xdeadbeef, u32);
+  EXPECT_EQ(5u, v1);
+  EXPECT_EQ(300u, v2);
+  EXPECT_EQ(0xffffffff, v3);
+  EXPECT_EQ("HELLO", s);
+  EXPECT_FALSE(r.get(u16));
+}
+
+TEST(IndexIOTest, Truncated) {
+  std::string data;
+  put_string(data, "HELLO");
+  data.pop_back();
+  IndexReader r(data);
+  std::string s;
+  EXPECT_FALSE(r.get_string(s));
+
+  IndexReader v(std::string(1, '\x80'));
+  uint32_t n{0};
+  EXPECT_FALSE(v.get_varint(n));
+}
+
+TEST(IndexIOTest, Journal) {
+  FileHelper helper;
+  IndexJournal j(helper.CreateTempFilePath("test.idx"), helper.CreateTempFilePath("test.jnl"));
+  // Nothing is journaled until there is an index.
+  EXPECT_TRUE(j.Append("A"));
+  EXPECT_FALSE(File::Exists(j.journal_path()));
+
+  EXPECT_TRUE(j.Rewrite(0, [](const std::string& rest) {
+    EXPECT_EQ("", rest);
+    return std::string("INDEX");
+  }));
+  EXPECT_EQ("INDEX", read_index_file(j.index_path()).value());
+
+  EXPECT_TRUE(j.Append("AB"));
+  EXPECT_TRUE(j.Append("CD"));
+  EXPECT_EQ("ABCD", read_index_file(j.journal_path()).value());
+  EXPECT_FALSE(j.needs_compact());
+
+  // Only what's past the offset hasn't been applied yet.
+  EXPECT_TRUE(j.Rewrite(2, [](const std::string& rest) { return "INDEX" + rest; }));
+  EXPECT_EQ("INDEXCD", read_index_file(j.index_path()).value());
+  EXPECT_EQ("", read_index_file(j.journal_path()).value());
+  EXPECT_FALSE(File::Exists(j.index_path().string() + ".tmp"));
+}
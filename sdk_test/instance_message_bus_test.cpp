@@ -0,0 +1,171 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/log.h"
+#include "core_test/file_helper.h"
+#include "sdk/instance_message_bus.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using namespace wwiv::sdk;
+
+#ifndef _WIN32
+
+class InstanceMessageBusTest : public testing::Test {
+public:
+  InstanceMessageBusTest() : dir_(helper_.TempDir()) {}
+
+  FileHelper helper_;
+  std::filesystem::path dir_;
+};
+
+TEST_F(InstanceMessageBusTest, Smoke) {
+  InstanceMessageBus one(dir_, 1);
+  InstanceMessageBus two(dir_, 2);
+  ASSERT_TRUE(one.ok());
+  ASSERT_TRUE(two.ok());
+  EXPECT_FALSE(two.waiting());
+
+  EXPECT_TRUE(one.Send(2, "Hello"));
+  EXPECT_TRUE(one.Send(2, std::string("Wor\0ld", 6)));
+  EXPECT_TRUE(two.waiting());
+  const auto messages = two.Receive();
+  ASSERT_EQ(2u, messages.size());
+  EXPECT_EQ("Hello", messages[0]);
+  EXPECT_EQ(std::string("Wor\0ld", 6), messages[1]);
+  EXPECT_FALSE(two.waiting());
+  EXPECT_TRUE(two.Receive().empty());
+}
+
+TEST_F(InstanceMessageBusTest, NotListening) {
+  InstanceMessageBus one(dir_, 1);
+  ASSERT_TRUE(one.ok());
+  EXPECT_FALSE(one.Send(3, "Hello"));
+  {
+    InstanceMessageBus three(dir_, 3);
+    EXPECT_TRUE(one.Send(3, "Hello"));
+  }
+  // Gone again.
+  EXPECT_FALSE(one.Send(3, "Hello"));
+  EXPECT_FALSE(std::filesystem::exists(InstanceMessageBus::SocketPath(dir_, 3)));
+}
+
+TEST_F(InstanceMessageBusTest, ReplacesStaleSocket) {
+  InstanceMessageBus one(dir_, 1);
+  auto stale = std::make_unique<InstanceMessageBus>(dir_, 2);
+  // A new instance 2 starts while the old one's socket is still there.
+  InstanceMessageBus two(dir_, 2);
+  ASSERT_TRUE(two.ok());
+  EXPECT_TRUE(one.Send(2, "Hello"));
+  EXPECT_EQ(1u, two.Receive().size());
+
+  // The old instance exiting must not remove the new instance's socket.
+  stale.reset();
+  EXPECT_TRUE(std::filesystem::exists(InstanceMessageBus::SocketPath(dir_, 2)));
+  EXPECT_TRUE(one.Send(2, "Hello"));
+  EXPECT_EQ(1u, two.Receive().size());
+}
+
+TEST_F(InstanceMessageBusTest, Wait_WakesUp) {
+  InstanceMessageBus one(dir_, 1);
+  InstanceMessageBus two(dir_, 2);
+  EXPECT_FALSE(two.Wait(1ms));
+
+  std::thread t([&] {
+    std::this_thread::sleep_for(20ms);
+    one.Send(2, "Hello");
+  });
+  const auto start = steady_clock::now();
+  EXPECT_TRUE(two.Wait(10s));
+  EXPECT_LT(steady_clock::now() - start, 5s);
+  t.join();
+  EXPECT_EQ("Hello", two.Receive().at(0));
+}
+
+// Benchmark of node to node delivery latency with 32 instances.
+TEST_F(InstanceMessageBusTest, DISABLED_Benchmark_Latency32) {
+  constexpr auto kNumInstances = 32;
+  constexpr auto kNumMessages = 2000;
+  std::vector<std::unique_ptr<InstanceMessageBus>> buses;
+  for (auto i = 1; i <= kNumInstances; i++) {
+    buses.emplace_back(std::make_unique<InstanceMessageBus>(dir_, i));
+    ASSERT_TRUE(buses.back()->ok());
+  }
+
+  // Each instance waits like it would for user input, and records how long
+  // each message took to arrive.
+  std::atomic<bool> done{false};
+  std::atomic<int> received{0};
+  std::vector<std::vector<int64_t>> latencies(kNumInstances);
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < kNumInstances; i++) {
+    threads.emplace_back([&, i] {
+      auto& bus = *buses[i];
+      while (!done) {
+        if (!bus.Wait(100ms)) {
+          continue;
+        }
+        const auto now = steady_clock::now().time_since_epoch().count();
+        for (const auto& m : bus.Receive()) {
+          int64_t sent;
+          memcpy(&sent, m.data(), sizeof(sent));
+          latencies[i].push_back(duration_cast<microseconds>(
+                                     steady_clock::duration(now - sent)).count());
+          ++received;
+        }
+      }
+    });
+  }
+
+  for (auto n = 0; n < kNumMessages; n++) {
+    const auto from = n % kNumInstances;
+    const auto to = (n * 7 + 3) % kNumInstances;
+    const auto sent = steady_clock::now().time_since_epoch().count();
+    std::string m(reinterpret_cast<const char*>(&sent), sizeof(sent));
+    EXPECT_TRUE(buses[from]->Send(to + 1, m));
+    std::this_thread::sleep_for(100us);
+  }
+  while (received < kNumMessages) {
+    std::this_thread::sleep_for(1ms);
+  }
+  done = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::vector<int64_t> all;
+  for (const auto& l : latencies) {
+    all.insert(std::end(all), std::begin(l), std::end(l));
+  }
+  std::sort(std::begin(all), std::end(all));
+  LOG(INFO) << "Delivered " << all.size() << " messages between " << kNumInstances
+            << " instances; p50: " << all[all.size() / 2]
+            << "us; p99: " << all[all.size() * 99 / 100] << "us; max: " << all.back() << "us";
+}
+
+#endif // _WIN32
@@ -0,0 +1,232 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/log.h"
+#include "core_test/file_helper.h"
+#include "sdk/filenames.h"
+#include "sdk/msgapi/email_index.h"
+#include "sdk/vardec.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <set>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::msgapi;
+
+class EmailIndexTest : public testing::Test {
+public:
+  EmailIndexTest() : path_(FilePath(helper_.TempDir(), EMAIL_DAT)) {}
+
+  static mailrec Mail(uint16_t touser, uint16_t tosys = 0) {
+    mailrec m{};
+    m.touser = touser;
+    m.tosys = tosys;
+    m.daten = 1;
+    return m;
+  }
+
+  static mailrec Deleted() {
+    mailrec m{};
+    m.daten = 0xffffffff;
+    return m;
+  }
+
+  void WriteMail(const std::vector<mailrec>& recs) const {
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile |
+                       File::modeTruncate));
+    f.Write(recs.data(), static_cast<File::size_type>(recs.size() * sizeof(mailrec)));
+  }
+
+  void AppendMail(const mailrec& m) const {
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile));
+    f.Seek(0, File::Whence::end);
+    f.Write(&m, sizeof(mailrec));
+  }
+
+  EmailIndex Load() const {
+    EmailIndex index(path_);
+    File f(path_);
+    EXPECT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile));
+    EXPECT_TRUE(index.Load(f));
+    return index;
+  }
+
+  FileHelper helper_;
+  const std::filesystem::path path_;
+};
+
+TEST_F(EmailIndexTest, Empty) {
+  WriteMail({});
+  const auto index = Load();
+  EXPECT_EQ(0, index.number_of_slots());
+  EXPECT_EQ(0, index.number_of_messages());
+  EXPECT_EQ(0, index.next_slot());
+  EXPECT_TRUE(index.slots(1).empty());
+  EXPECT_TRUE(File::Exists(index.path()));
+  EXPECT_EQ(FilePath(helper_.TempDir(), "email.idx"), index.path());
+}
+
+TEST_F(EmailIndexTest, BuildsFromEmail) {
+  WriteMail({Mail(2), Mail(3), Deleted(), Mail(2), Mail(5, 10), Deleted()});
+  const auto index = Load();
+  EXPECT_EQ(6, index.number_of_slots());
+  EXPECT_EQ(4, index.number_of_messages());
+  EXPECT_EQ((std::vector<int>{0, 3}), index.slots(2));
+  EXPECT_EQ(2, index.count(2));
+  EXPECT_EQ((std::vector<int>{1}), index.slots(3));
+  // Network mail isn't in anyone's mailbox.
+  EXPECT_TRUE(index.slots(5).empty());
+  EXPECT_EQ((std::set<int>{2, 5}), index.free_slots());
+  EXPECT_EQ(5, index.next_slot());
+}
+
+TEST_F(EmailIndexTest, UsesSavedIndex) {
+  WriteMail({Mail(2), Mail(3)});
+  {
+    auto index = Load();
+    index.Update(2, Mail(4));
+    index.Remove(0);
+    ASSERT_TRUE(index.Save());
+  }
+  // Write the record the index was told about.  Slot 0 isn't cleared, which
+  // only the saved index knows.
+  AppendMail(Mail(4));
+
+  const auto index = Load();
+  EXPECT_TRUE(index.slots(2).empty());
+  EXPECT_EQ((std::vector<int>{1}), index.slots(3));
+  EXPECT_EQ((std::vector<int>{2}), index.slots(4));
+  EXPECT_EQ((std::set<int>{0}), index.free_slots());
+}
+
+TEST_F(EmailIndexTest, RebuildsWhenStale) {
+  WriteMail({Mail(2), Mail(3)});
+  (void)Load();
+  // Written behind the index's back.
+  AppendMail(Mail(2));
+
+  const auto index = Load();
+  EXPECT_EQ((std::vector<int>{0, 2}), index.slots(2));
+  EXPECT_EQ(3, index.number_of_messages());
+}
+
+TEST_F(EmailIndexTest, RebuildsWhenCorrupt) {
+  WriteMail({Mail(2), Mail(3)});
+  const auto idx_path = Load().path();
+  {
+    File f(idx_path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(10);
+  }
+  const auto index = Load();
+  EXPECT_EQ((std::vector<int>{0}), index.slots(2));
+  EXPECT_EQ((std::vector<int>{1}), index.slots(3));
+}
+
+TEST_F(EmailIndexTest, NextSlot_ReusesTrailingFreeSlots) {
+  WriteMail({Mail(2), Deleted(), Mail(3), Deleted(), Deleted()});
+  auto index = Load();
+  EXPECT_EQ(3, index.next_slot());
+  index.Update(index.next_slot(), Mail(2));
+  EXPECT_EQ(4, index.next_slot());
+  index.Remove(2);
+  index.Remove(3);
+  // Slot 1 stays free so the mailbox stays in order.
+  EXPECT_EQ(1, index.next_slot());
+  index.Remove(0);
+  EXPECT_EQ(0, index.next_slot());
+  EXPECT_EQ(0, index.number_of_messages());
+}
+
+TEST_F(EmailIndexTest, Update_KeepsSlotsSorted) {
+  WriteMail({Deleted(), Deleted(), Deleted(), Deleted()});
+  auto index = Load();
+  index.Update(3, Mail(2));
+  index.Update(1, Mail(2));
+  index.Update(2, Mail(2));
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), index.slots(2));
+  // Reused for someone else.
+  index.Update(2, Mail(3));
+  EXPECT_EQ((std::vector<int>{1, 3}), index.slots(2));
+  EXPECT_EQ((std::vector<int>{2}), index.slots(3));
+  // Past the end.
+  index.Update(6, Mail(3));
+  EXPECT_EQ(7, index.number_of_slots());
+  EXPECT_EQ((std::set<int>{0, 4, 5}), index.free_slots());
+}
+
+TEST_F(EmailIndexTest, Truncate) {
+  WriteMail({Mail(2), Mail(3), Mail(2), Deleted()});
+  auto index = Load();
+  index.Truncate(2);
+  EXPECT_EQ(2, index.number_of_slots());
+  EXPECT_EQ((std::vector<int>{0}), index.slots(2));
+  EXPECT_TRUE(index.free_slots().empty());
+  EXPECT_EQ(2, index.next_slot());
+}
+
+// Benchmark of finding one user's mail in a large EMAIL.DAT.
+TEST_F(EmailIndexTest, DISABLED_Benchmark_UserMail) {
+  constexpr auto kNumRecords = 200000;
+  constexpr auto kNumUsers = 500;
+  std::vector<mailrec> recs;
+  recs.reserve(kNumRecords);
+  for (auto i = 0; i < kNumRecords; i++) {
+    recs.emplace_back(Mail(static_cast<uint16_t>(1 + i % kNumUsers)));
+  }
+  WriteMail(recs);
+  (void)Load();
+
+  File f(path_);
+  ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+  auto start = steady_clock::now();
+  auto scan_count = 0;
+  for (auto i = 0; i < kNumRecords; i++) {
+    mailrec m{};
+    f.Seek(static_cast<File::size_type>(i) * sizeof(mailrec), File::Whence::begin);
+    f.Read(&m, sizeof(mailrec));
+    if (m.tosys == 0 && m.touser == 7) {
+      ++scan_count;
+    }
+  }
+  const auto scan_us = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  EmailIndex index(path_);
+  index.Load(f);
+  auto index_count = 0;
+  for (const auto slot : index.slots(7)) {
+    mailrec m{};
+    f.Seek(static_cast<File::size_type>(slot) * sizeof(mailrec), File::Whence::begin);
+    f.Read(&m, sizeof(mailrec));
+    if (m.tosys == 0 && m.touser == 7) {
+      ++index_count;
+    }
+  }
+  const auto index_us = duration_cast<microseconds>(steady_clock::now() - start).count();
+  EXPECT_EQ(scan_count, index_count);
+
+  LOG(INFO) << "Full scan:  " << scan_us << "us";
+  LOG(INFO) << "EmailIndex: " << index_us << "us";
+}
@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "core/file.h"
 #include <filesystem>
@@ -100,3 +101,34 @@ TEST_F(EmailTest, Delete) {
   EXPECT_FALSE(email->read_email_header(1, nm));
   EXPECT_TRUE(email->read_email_header(2, nm));
 }
+
+TEST_F(EmailTest, MessagesForUser) {
+  ASSERT_TRUE(Add(1, 2, "Title", "Text"));
+  ASSERT_TRUE(Add(1, 3, "Title2", "Text2"));
+  ASSERT_TRUE(Add(1, 2, "Title3", "Text3"));
+  EXPECT_EQ((std::vector<int>{0, 2}), email->messages_for_user(2));
+  EXPECT_EQ((std::vector<int>{1}), email->messages_for_user(3));
+
+  ASSERT_TRUE(email->DeleteMessage(0));
+  EXPECT_EQ((std::vector<int>{2}), email->messages_for_user(2));
+  EXPECT_EQ(2, email->number_of_messages());
+
+  // The trailing record is reused, the one in the middle isn't.
+  ASSERT_TRUE(email->DeleteMessage(2));
+  ASSERT_TRUE(Add(1, 4, "Title4", "Text4"));
+  EXPECT_EQ((std::vector<int>{2}), email->messages_for_user(4));
+  EXPECT_TRUE(email->messages_for_user(2).empty());
+}
+
+TEST_F(EmailTest, RebuildIndex) {
+  ASSERT_TRUE(Add(1, 2, "Title", "Text"));
+  ASSERT_TRUE(Add(1, 3, "Title2", "Text2"));
+  const auto idx = FilePath(helper.data(), "email.idx");
+  ASSERT_TRUE(File::Exists(idx));
+  File::Remove(idx);
+
+  ASSERT_TRUE(email->RebuildIndex());
+  EXPECT_TRUE(File::Exists(idx));
+  EXPECT_EQ(2, email->number_of_messages());
+  EXPECT_EQ((std::vector<int>{1}), email->messages_for_user(3));
+}
@@ -0,0 +1,262 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/msgapi/message_search_index.h"
+#include "sdk/vardec.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk::msgapi;
+using namespace wwiv::strings;
+
+class MessageSearchIndexTest : public testing::Test {
+public:
+  MessageSearchIndexTest() : sub_fn_(FilePath(helper_.TempDir(), "general.sub")) {}
+
+  static postrec Post(uint32_t qscan, const std::string& title) {
+    postrec p{};
+    p.qscan = qscan;
+    p.msg.storage_type = 2;
+    p.msg.stored_as = qscan * 10;
+    to_char_array(p.title, title);
+    return p;
+  }
+
+  static std::vector<std::string> Words(const std::string& title, const std::string& text) {
+    std::vector<std::string> words;
+    MessageSearchIndex::ForEachWord(title, text, [&](const std::string& w) { words.push_back(w); });
+    return words;
+  }
+
+  FileHelper helper_;
+  const std::filesystem::path sub_fn_;
+};
+
+TEST_F(MessageSearchIndexTest, ForEachWord) {
+  EXPECT_EQ((std::vector<std::string>{"HELLO", "WORLD", "RE", "2ND"}),
+            Words("|#1Hello world", "re: hello, 2nd World!"));
+  // Colors are only removed from the title, like message find does.
+  EXPECT_EQ((std::vector<std::string>{"HI", "09BYE"}), Words("|09Hi", "|09bye"));
+  EXPECT_TRUE(Words("", "!! --").empty());
+}
+
+TEST_F(MessageSearchIndexTest, Candidates) {
+  MessageSearchIndex index(sub_fn_);
+  index.Add(Post(1, "First"), "The quick brown fox");
+  index.Add(Post(2, "Second"), "jumps over the lazy dog");
+  index.Add(Post(3, "Third"), "The Quick Silver Fox");
+
+  EXPECT_EQ((std::vector<uint32_t>{1, 3}), index.candidates("QUICK"));
+  // Part of a word.
+  EXPECT_EQ((std::vector<uint32_t>{1, 3}), index.candidates("UIC"));
+  EXPECT_EQ((std::vector<uint32_t>{1}), index.candidates("QUICK BROWN"));
+  EXPECT_EQ((std::vector<uint32_t>{2}), index.candidates("SECOND"));
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 3}), index.candidates("THE"));
+  EXPECT_TRUE(index.candidates("ZEBRA")->empty());
+  // Nothing to look up.
+  EXPECT_FALSE(index.candidates("!!"));
+
+  index.Remove(1);
+  EXPECT_EQ((std::vector<uint32_t>{3}), index.candidates("QUICK"));
+}
+
+TEST_F(MessageSearchIndexTest, Indexed) {
+  MessageSearchIndex index(sub_fn_);
+  auto p = Post(1, "First");
+  EXPECT_FALSE(index.indexed(p));
+  index.Add(p, "text");
+  EXPECT_TRUE(index.indexed(p));
+
+  // Edited.
+  auto moved = p;
+  moved.msg.stored_as = 1234;
+  EXPECT_FALSE(index.indexed(moved));
+  auto retitled = p;
+  to_char_array(retitled.title, "New Title");
+  EXPECT_FALSE(index.indexed(retitled));
+}
+
+TEST_F(MessageSearchIndexTest, SaveAndLoad) {
+  {
+    MessageSearchIndex index(sub_fn_);
+    EXPECT_FALSE(index.exists());
+    EXPECT_FALSE(index.Load());
+    index.Add(Post(1, "First"), "The quick brown fox");
+    index.Add(Post(2, "Second"), "jumps over the lazy dog");
+    index.Add(Post(3, "Third"), "The quick silver fox");
+    index.Remove(2);
+    ASSERT_TRUE(index.Save());
+  }
+  MessageSearchIndex index(sub_fn_);
+  EXPECT_TRUE(index.exists());
+  ASSERT_TRUE(index.Load());
+  EXPECT_EQ(2, index.size());
+  EXPECT_TRUE(index.indexed(Post(3, "Third")));
+  EXPECT_FALSE(index.indexed(Post(2, "Second")));
+  EXPECT_EQ((std::vector<uint32_t>{1, 3}), index.candidates("FOX"));
+  EXPECT_TRUE(index.candidates("LAZY")->empty());
+  // Words only in removed messages are dropped when saving.
+  EXPECT_EQ(7, index.number_of_words());
+}
+
+TEST_F(MessageSearchIndexTest, Journal) {
+  // Nothing is journaled until the index is built.
+  ASSERT_TRUE(MessageSearchIndex(sub_fn_).JournalAdd(Post(1, "First"), "quick"));
+  EXPECT_FALSE(File::Exists(MessageSearchIndex(sub_fn_).journal_path()));
+
+  {
+    MessageSearchIndex index(sub_fn_);
+    index.Add(Post(1, "First"), "The quick brown fox");
+    ASSERT_TRUE(index.Save());
+  }
+  const MessageSearchIndex writer(sub_fn_);
+  ASSERT_TRUE(writer.JournalAdd(Post(2, "Second"), "a quick dog"));
+  ASSERT_TRUE(writer.JournalRemove(1));
+  EXPECT_TRUE(File::Exists(writer.journal_path()));
+
+  MessageSearchIndex index(sub_fn_);
+  ASSERT_TRUE(index.Load());
+  EXPECT_EQ((std::vector<uint32_t>{2}), index.candidates("QUICK"));
+  EXPECT_TRUE(index.indexed(Post(2, "Second")));
+
+  // Added while we had it loaded.
+  ASSERT_TRUE(writer.JournalAdd(Post(3, "Third"), "quickly"));
+  ASSERT_TRUE(index.Save());
+  EXPECT_EQ(0, File(index.journal_path()).length());
+
+  MessageSearchIndex saved(sub_fn_);
+  ASSERT_TRUE(saved.Load());
+  EXPECT_EQ((std::vector<uint32_t>{2, 3}), saved.candidates("QUICK"));
+}
+
+TEST_F(MessageSearchIndexTest, Journal_IgnoresPartialRecord) {
+  {
+    MessageSearchIndex index(sub_fn_);
+    index.Add(Post(1, "First"), "The quick brown fox");
+    ASSERT_TRUE(index.Save());
+  }
+  const MessageSearchIndex writer(sub_fn_);
+  ASSERT_TRUE(writer.JournalAdd(Post(2, "Second"), "a quick dog"));
+  {
+    File f(writer.journal_path());
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(f.length() - 3);
+  }
+  MessageSearchIndex index(sub_fn_);
+  ASSERT_TRUE(index.Load());
+  EXPECT_EQ((std::vector<uint32_t>{1}), index.candidates("QUICK"));
+}
+
+TEST_F(MessageSearchIndexTest, Load_Corrupt) {
+  {
+    MessageSearchIndex index(sub_fn_);
+    index.Add(Post(1, "First"), "The quick brown fox");
+    ASSERT_TRUE(index.Save());
+  }
+  MessageSearchIndex index(sub_fn_);
+  {
+    File f(index.path());
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(f.length() - 2);
+  }
+  EXPECT_FALSE(index.Load());
+  EXPECT_EQ(0, index.size());
+}
+
+// Benchmark of finding a message in a 50k message area.
+TEST_F(MessageSearchIndexTest, DISABLED_Benchmark_Search50k) {
+  constexpr auto kNumMessages = 50000;
+  constexpr auto kNumWords = 20000;
+  constexpr auto kWordsPerMessage = 200;
+  std::mt19937 rng(1);
+  std::vector<std::string> vocab;
+  for (auto i = 0; i < kNumWords; i++) {
+    std::string w;
+    for (auto len = 3 + rng() % 7; len > 0; len--) {
+      w.push_back(static_cast<char>('a' + rng() % 26));
+    }
+    vocab.emplace_back(std::move(w));
+  }
+  // Word frequencies are skewed, like in real messages.
+  std::geometric_distribution<int> pick(0.002);
+  std::vector<postrec> posts;
+  std::vector<std::string> texts;
+  for (auto i = 0; i < kNumMessages; i++) {
+    std::string text;
+    for (auto j = 0; j < kWordsPerMessage; j++) {
+      text.append(vocab[pick(rng) % kNumWords]).push_back(' ');
+    }
+    posts.emplace_back(Post(i + 1, StrCat("Message ", i)));
+    texts.emplace_back(std::move(text));
+  }
+
+  auto start = steady_clock::now();
+  {
+    MessageSearchIndex index(sub_fn_);
+    for (auto i = 0; i < kNumMessages; i++) {
+      index.Add(posts[i], texts[i]);
+    }
+    index.Save();
+  }
+  const auto build_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  MessageSearchIndex index(sub_fn_);
+  index.Load();
+  const auto load_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  for (const auto& word : {vocab[5], vocab[500], vocab[15000]}) {
+    const auto search = ToStringUpperCase(word);
+    // What message find did for each message.
+    start = steady_clock::now();
+    auto linear = 0;
+    for (const auto& t : texts) {
+      if (ToStringUpperCase(t).find(search) != std::string::npos) {
+        ++linear;
+      }
+    }
+    const auto linear_us = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    auto found = 0;
+    const auto c = index.candidates(search);
+    for (const auto q : c.value()) {
+      if (ToStringUpperCase(texts[q - 1]).find(search) != std::string::npos) {
+        ++found;
+      }
+    }
+    const auto index_us = duration_cast<microseconds>(steady_clock::now() - start).count();
+    EXPECT_EQ(linear, found);
+
+    LOG(INFO) << "'" << search << "': " << found << " messages; linear scan: " << linear_us
+              << "us; index: " << index_us << "us (" << c->size() << " candidates)";
+  }
+  LOG(INFO) << "Built index of " << index.size() << " messages and " << index.number_of_words()
+            << " words in " << build_ms << "ms; loaded in " << load_ms << "ms; "
+            << File(index.path()).length() << " bytes";
+}
@@ -23,12 +23,17 @@
 #include "core_test/file_helper.h"
 #include "sdk/config.h"
 #include "sdk/msgapi/message_api_wwiv.h"
+#include "sdk/msgapi/message_area_wwiv.h"
+#include "sdk/msgapi/message_search_index.h"
 #include "sdk/msgapi/msgapi.h"
 #include "sdk_test/sdk_helper.h"
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace std;
+using namespace std::chrono;
 using namespace wwiv::core;
 using namespace wwiv::sdk;
 using namespace wwiv::sdk::msgapi;
@@ -175,3 +180,198 @@ TEST_F(MsgApiTest, Resynch_MessageNumber) {
   a2->ResyncMessage(msgnum);
   EXPECT_EQ(1, msgnum);
 }
+
+TEST_F(MsgApiTest, SearchIndex) {
+  subboard_t sub{};
+  sub.filename = "a1";
+  ASSERT_TRUE(api->Create(sub, -1));
+  unique_ptr<MessageArea> area(api->Open(sub, -1));
+  const auto m1(CreateMessage(*area, 1, "From", "Title1", "The quick brown fox\r\n"));
+  EXPECT_TRUE(area->AddMessage(*m1, {}));
+
+  MessageSearchIndex index(FilePath(helper.data(), "a1.sub"));
+  EXPECT_FALSE(index.exists());
+  auto* wa = dynamic_cast<WWIVMessageArea*>(area.get());
+  ASSERT_NE(nullptr, wa);
+  ASSERT_TRUE(wa->RebuildSearchIndex());
+  ASSERT_TRUE(index.Load());
+  EXPECT_EQ(1, index.size());
+  const auto qscan1 = area->ReadMessage(1)->header().last_read();
+  EXPECT_EQ((std::vector<uint32_t>{qscan1}), index.candidates("QUICK"));
+
+  // Adding and deleting once built updates it.
+  const auto m2(CreateMessage(*area, 1, "From", "Title2", "Quickly now\r\n"));
+  EXPECT_TRUE(area->AddMessage(*m2, {}));
+  const auto qscan2 = area->ReadMessage(2)->header().last_read();
+  EXPECT_TRUE(area->DeleteMessage(1));
+  ASSERT_TRUE(index.Load());
+  EXPECT_EQ((std::vector<uint32_t>{qscan2}), index.candidates("QUICK"));
+}
+
+TEST_F(MsgApiTest, Batch_AddMessages) {
+  subboard_t sub{};
+  sub.filename = "a1";
+  ASSERT_TRUE(api->Create(sub, -1));
+  unique_ptr<MessageArea> area(api->Open(sub, -1));
+  auto* wa = dynamic_cast<WWIVMessageArea*>(area.get());
+  ASSERT_NE(nullptr, wa);
+  const auto m1(CreateMessage(*area, 1, "From", "Title1", "Text1\r\n"));
+  EXPECT_TRUE(area->AddMessage(*m1, {}));
+
+  ASSERT_TRUE(wa->BeginBatch());
+  EXPECT_TRUE(area->Exists(m1->header().daten(), "TITLE1", 0, 1));
+  const auto m2(CreateMessage(*area, 1, "From", "Title2", "Text2\r\n"));
+  const auto m3(CreateMessage(*area, 1, "From", "Title3", "Text3\r\n"));
+  EXPECT_FALSE(area->Exists(m2->header().daten(), "Title2", 0, 1));
+  EXPECT_TRUE(area->AddMessage(*m2, {}));
+  EXPECT_TRUE(area->AddMessage(*m3, {}));
+  EXPECT_TRUE(area->Exists(m2->header().daten(), "Title2", 0, 1));
+  EXPECT_FALSE(area->Exists(m2->header().daten(), "Title2", 0, 2));
+  // Nothing is written until the batch ends.
+  EXPECT_EQ(1, area->number_of_messages());
+  ASSERT_TRUE(wa->EndBatch());
+  EXPECT_FALSE(wa->in_batch());
+
+  ASSERT_EQ(3, area->number_of_messages());
+  const auto r1 = area->ReadMessage(1);
+  const auto r2 = area->ReadMessage(2);
+  const auto r3 = area->ReadMessage(3);
+  EXPECT_EQ("Title2", r2->header().title());
+  EXPECT_EQ("Text2\r\n", r2->text().text());
+  EXPECT_EQ("Title3", r3->header().title());
+  EXPECT_LT(r1->header().last_read(), r2->header().last_read());
+  EXPECT_LT(r2->header().last_read(), r3->header().last_read());
+}
+
+TEST_F(MsgApiTest, Batch_CloseEndsBatch) {
+  subboard_t sub{};
+  sub.filename = "a1";
+  ASSERT_TRUE(api->Create(sub, -1));
+  {
+    unique_ptr<MessageArea> area(api->Open(sub, -1));
+    ASSERT_TRUE(dynamic_cast<WWIVMessageArea*>(area.get())->BeginBatch());
+    const auto m1(CreateMessage(*area, 1, "From", "Title1", "Text1\r\n"));
+    EXPECT_TRUE(area->AddMessage(*m1, {}));
+  }
+  unique_ptr<MessageArea> area(api->Open(sub, -1));
+  ASSERT_EQ(1, area->number_of_messages());
+  EXPECT_EQ("Title1", area->ReadMessage(1)->header().title());
+}
+
+TEST_F(MsgApiTest, Batch_DeletesExcess) {
+  MessageApiOptions options;
+  options.overflow_strategy = OverflowStrategy::delete_all;
+  WWIVMessageApi delete_api(options, *config, {}, new NullLastReadImpl());
+  subboard_t sub{};
+  sub.filename = "a1";
+  sub.maxmsgs = 4;
+  ASSERT_TRUE(delete_api.Create(sub, -1));
+  unique_ptr<MessageArea> area(delete_api.Open(sub, -1));
+  auto* wa = dynamic_cast<WWIVMessageArea*>(area.get());
+  ASSERT_NE(nullptr, wa);
+  for (auto i = 1; i <= 3; i++) {
+    const auto m(CreateMessage(*area, 1, "From", StrCat("Title", i), "Text\r\n"));
+    m->header().set_locked(i == 2);
+    EXPECT_TRUE(area->AddMessage(*m, {}));
+  }
+
+  ASSERT_TRUE(wa->BeginBatch());
+  for (auto i = 4; i <= 7; i++) {
+    const auto m(CreateMessage(*area, 1, "From", StrCat("Title", i), "Text\r\n"));
+    EXPECT_TRUE(area->AddMessage(*m, {}));
+  }
+  ASSERT_TRUE(wa->EndBatch());
+
+  // The oldest unlocked messages are gone.
+  ASSERT_EQ(4, area->number_of_messages());
+  std::vector<std::string> titles;
+  for (auto i = 1; i <= 4; i++) {
+    titles.push_back(area->ReadMessage(i)->header().title());
+  }
+  EXPECT_EQ((std::vector<std::string>{"Title2", "Title5", "Title6", "Title7"}), titles);
+}
+
+TEST_F(MsgApiTest, DeleteExcess) {
+  MessageApiOptions options;
+  options.overflow_strategy = OverflowStrategy::delete_all;
+  WWIVMessageApi delete_api(options, *config, {}, new NullLastReadImpl());
+  subboard_t sub{};
+  sub.filename = "a1";
+  sub.maxmsgs = 2;
+  ASSERT_TRUE(delete_api.Create(sub, -1));
+  unique_ptr<MessageArea> area(delete_api.Open(sub, -1));
+  for (auto i = 1; i <= 4; i++) {
+    const auto m(CreateMessage(*area, 1, "From", StrCat("Title", i), "Text\r\n"));
+    EXPECT_TRUE(area->AddMessage(*m, {}));
+  }
+  ASSERT_EQ(2, area->number_of_messages());
+  EXPECT_EQ("Title3", area->ReadMessage(1)->header().title());
+  EXPECT_EQ("Title4", area->ReadMessage(2)->header().title());
+}
+
+// Benchmark of tossing 5,000 posts into a few full subs, like network2 does.
+TEST_F(MsgApiTest, DISABLED_Benchmark_Toss5k) {
+  constexpr auto kNumPosts = 5000;
+  constexpr auto kNumSubs = 4;
+  MessageApiOptions options;
+  options.overflow_strategy = OverflowStrategy::delete_all;
+  WWIVMessageApi toss_api(options, *config, {}, new NullLastReadImpl());
+  // Before batching, DeleteExcess deleted one message at a time with
+  // DeleteMessage, so the per post side does that itself.
+  MessageApiOptions old_options;
+  old_options.overflow_strategy = OverflowStrategy::delete_none;
+  WWIVMessageApi old_api(old_options, *config, {}, new NullLastReadImpl());
+
+  auto toss = [&](const std::string& prefix, bool batch) {
+    std::vector<subboard_t> subs;
+    for (auto s = 0; s < kNumSubs; s++) {
+      subboard_t sub{};
+      sub.filename = StrCat(prefix, s);
+      sub.maxmsgs = 1000;
+      EXPECT_TRUE(toss_api.Create(sub, -1));
+      subs.push_back(sub);
+    }
+    std::vector<unique_ptr<MessageArea>> areas;
+    if (batch) {
+      for (const auto& sub : subs) {
+        areas.emplace_back(toss_api.Open(sub, -1));
+        dynamic_cast<WWIVMessageArea*>(areas.back().get())->BeginBatch();
+      }
+    }
+    const auto start = steady_clock::now();
+    for (auto i = 0; i < kNumPosts; i++) {
+      const auto& sub = subs.at(i % kNumSubs);
+      unique_ptr<MessageArea> opened;
+      if (!batch) {
+        opened.reset(old_api.Open(sub, -1));
+      }
+      auto* area = batch ? areas.at(i % kNumSubs).get() : opened.get();
+      const auto m(CreateMessage(*area, 1, "From", StrCat("Title", i), "Some text\r\n"));
+      if (!area->Exists(m->header().daten(), m->header().title(), 0, 1)) {
+        EXPECT_TRUE(area->AddMessage(*m, {}));
+      }
+      while (!batch && area->number_of_messages() > sub.maxmsgs) {
+        auto dm = 1;
+        while (dm <= area->number_of_messages() && area->ReadMessageHeader(dm)->locked()) {
+          ++dm;
+        }
+        if (!area->DeleteMessage(dm)) {
+          break;
+        }
+      }
+    }
+    for (auto& area : areas) {
+      dynamic_cast<WWIVMessageArea*>(area.get())->EndBatch();
+    }
+    for (const auto& sub : subs) {
+      unique_ptr<MessageArea> area(toss_api.Open(sub, -1));
+      EXPECT_EQ(1000, area->number_of_messages());
+    }
+    return duration_cast<milliseconds>(steady_clock::now() - start).count();
+  };
+
+  const auto old_ms = toss("old", false);
+  const auto new_ms = toss("new", true);
+  LOG(INFO) << "Open + Exists + AddMessage + DeleteMessage per post: " << old_ms << "ms";
+  LOG(INFO) << "Batched by sub:                                     " << new_ms << "ms";
+}
@@ -19,17 +19,24 @@
 #include "gtest/gtest.h"
 
 #include "core/file.h"
+#include "core/log.h"
+#include "core/stl.h"
 #include "core/strings.h"
 #include "core_test/file_helper.h"
 #include "sdk/msgapi/message_api_wwiv.h"
 #include "sdk/msgapi/type2_text.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <optional>
+#include <vector>
 
 using namespace std;
 using namespace wwiv::core;
 using namespace wwiv::sdk;
 using namespace wwiv::sdk::msgapi;
+using namespace wwiv::stl;
 using namespace wwiv::strings;
 
 class Type2TextTest : public testing::Test {
@@ -149,3 +156,207 @@ TEST_F(Type2TextTest, Move_To_Next_Gat_Section) {
 }
 
 
+
+TEST_F(Type2TextTest, Reuse_Block_After_Delete_In_Full_Section) {
+  ASSERT_TRUE(CreateMsgTextFile());
+
+  const std::string msg32k(32 * 1024, 'x');
+  for (auto i = 0; i < 31; i++) {
+    ASSERT_TRUE(save_message(msg32k).has_value());
+  }
+  // Section 0 now only has 63 free blocks, so this goes to section 1.
+  auto m1 = save_message(msg32k);
+  ASSERT_EQ(1u, m1->stored_as / 2048);
+
+  // Free up the first message in section 0, it should be reused.
+  ASSERT_TRUE(t_->remove_link(messagerec{STORAGE_TYPE, 1}));
+  auto m2 = save_message(msg32k);
+  ASSERT_EQ(1u, m2->stored_as);
+  EXPECT_EQ(msg32k, readfile(m2.value()).value());
+}
+
+TEST_F(Type2TextTest, Reuse_Block_Freed_By_Other_Process) {
+  ASSERT_TRUE(CreateMsgTextFile());
+
+  const std::string msg32k(32 * 1024, 'x');
+  for (auto i = 0; i < 31; i++) {
+    ASSERT_TRUE(save_message(msg32k).has_value());
+  }
+
+  // Free the first message behind our back, like another node would, so
+  // we still think section 0 only has 63 free blocks.
+  {
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    auto gat = t_->load_gat(f, 0);
+    std::fill(std::begin(gat) + 1, std::begin(gat) + 65, static_cast<gati_t>(0));
+    t_->save_gat(f, 0, gat);
+  }
+
+  // It should be reused rather than starting section 1.
+  const auto length = File(path_).length();
+  auto m = save_message(msg32k);
+  ASSERT_EQ(1u, m->stored_as);
+  EXPECT_EQ(msg32k, readfile(m.value()).value());
+  EXPECT_EQ(length, File(path_).length());
+}
+
+TEST_F(Type2TextTest, Read_NonContiguous_Blocks) {
+  ASSERT_TRUE(CreateMsgTextFile());
+
+  auto m1 = save_message("A");
+  auto m2 = save_message("B");
+  auto m3 = save_message("C");
+  ASSERT_TRUE(t_->remove_link(m2.value()));
+
+  // Block 2 is free, so this message will use blocks 2, 4, 5.
+  const auto text = StrCat(std::string(512, '1'), std::string(512, '2'), "3");
+  auto m4 = save_message(text);
+  ASSERT_EQ(2u, m4->stored_as);
+  EXPECT_EQ(text, readfile(m4.value()).value());
+  EXPECT_EQ("A", readfile(m1.value()).value());
+  EXPECT_EQ("C", readfile(m3.value()).value());
+}
+
+namespace {
+
+// Type2Text::savefile and readfile as they were before the free block index
+// and reading and writing in runs, so the benchmark has something to compare
+// against.
+std::vector<gati_t> original_load_gat(File& file, int section) {
+  std::vector<gati_t> gat(GAT_NUMBER_ELEMENTS);
+  auto file_size = file.length();
+  const auto section_pos = static_cast<File::size_type>(section) * GATSECLEN;
+  if (file_size < section_pos) {
+    file.set_length(section_pos);
+    file_size = section_pos;
+  }
+  file.Seek(section_pos, File::Whence::begin);
+  if (file_size < section_pos + GAT_SECTION_SIZE) {
+    file.Write(&gat[0], GAT_SECTION_SIZE);
+  } else {
+    file.Read(&gat[0], GAT_SECTION_SIZE);
+  }
+  return gat;
+}
+
+File::size_type original_msg_starting(int section) {
+  return static_cast<File::size_type>(section) * GATSECLEN + GAT_SECTION_SIZE;
+}
+
+std::optional<messagerec> original_savefile(const std::filesystem::path& path,
+                                            const std::string& text) {
+  File f(path);
+  if (!f.Open(File::modeReadWrite | File::modeBinary)) {
+    return std::nullopt;
+  }
+  std::vector<gati_t> gati;
+  auto section = 0;
+  for (; section < 1024; section++) {
+    auto gat = original_load_gat(f, section);
+    const auto num_blocks_required =
+        static_cast<int>((text.length() + MSG_BLOCK_SIZE - 1) / MSG_BLOCK_SIZE);
+    gati_t i4 = 1;
+    gati.clear();
+    while (ssize(gati) < num_blocks_required && i4 < GAT_NUMBER_ELEMENTS) {
+      if (gat[i4] == 0) {
+        gati.push_back(i4);
+      }
+      ++i4;
+    }
+    if (ssize(gati) >= num_blocks_required) {
+      gati.push_back(static_cast<gati_t>(-1));
+      const auto text_len = ssize(text);
+      for (auto i = 0; i < num_blocks_required; i++) {
+        char block[MSG_BLOCK_SIZE + 1]{};
+        f.Seek(original_msg_starting(section) + MSG_BLOCK_SIZE * static_cast<long>(gati[i]),
+               File::Whence::begin);
+        const auto remaining = std::min(text_len - (i * MSG_BLOCK_SIZE), MSG_BLOCK_SIZE);
+        memcpy(block, &text[i * MSG_BLOCK_SIZE], remaining);
+        f.Write(block, MSG_BLOCK_SIZE);
+        gat[gati[i]] = gati[i + 1];
+      }
+      f.Seek(static_cast<File::size_type>(section) * GATSECLEN, File::Whence::begin);
+      f.Write(&gat[0], GAT_SECTION_SIZE);
+      break;
+    }
+  }
+  messagerec m{};
+  m.storage_type = 2;
+  m.stored_as = static_cast<uint32_t>(gati[0]) + static_cast<uint32_t>(section) * GAT_NUMBER_ELEMENTS;
+  return m;
+}
+
+std::optional<std::string> original_readfile(const std::filesystem::path& path,
+                                             const messagerec& msg) {
+  File f(path);
+  if (!f.Open(File::modeReadWrite | File::modeBinary)) {
+    return std::nullopt;
+  }
+  const auto section = static_cast<int>(msg.stored_as / GAT_NUMBER_ELEMENTS);
+  const auto gat = original_load_gat(f, section);
+  auto current = msg.stored_as % GAT_NUMBER_ELEMENTS;
+  std::string out;
+  while (current > 0 && current < GAT_NUMBER_ELEMENTS) {
+    f.Seek(original_msg_starting(section) + MSG_BLOCK_SIZE * static_cast<long>(current),
+           File::Whence::begin);
+    char b[MSG_BLOCK_SIZE + 1];
+    if (f.Read(b, MSG_BLOCK_SIZE) == -1) {
+      return std::nullopt;
+    }
+    b[MSG_BLOCK_SIZE] = '\0';
+    out.append(b);
+    current = gat[current];
+  }
+  return out;
+}
+
+} // namespace
+
+TEST_F(Type2TextTest, DISABLED_Benchmark_Post_And_Read_100k) {
+  constexpr auto kNumMessages = 100000;
+  const std::string text(1500, 'x');
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  using std::chrono::steady_clock;
+
+  const auto original_path = helper.CreateTempFilePath("original.dat");
+  {
+    File f(original_path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeCreateFile | File::modeReadWrite));
+    f.set_length(GAT_SECTION_SIZE + (75L * 1024L));
+  }
+  std::vector<messagerec> msgs;
+  msgs.reserve(kNumMessages);
+  auto start = steady_clock::now();
+  for (auto i = 0; i < kNumMessages; i++) {
+    auto m = original_savefile(original_path, text);
+    ASSERT_TRUE(m.has_value());
+    msgs.push_back(m.value());
+  }
+  auto posted = steady_clock::now();
+  for (const auto& m : msgs) {
+    ASSERT_EQ(text, original_readfile(original_path, m).value());
+  }
+  auto read = steady_clock::now();
+  LOG(INFO) << "Original:  posted " << kNumMessages << " messages in "
+            << duration_cast<milliseconds>(posted - start).count() << "ms; read in "
+            << duration_cast<milliseconds>(read - posted).count() << "ms";
+
+  ASSERT_TRUE(CreateMsgTextFile());
+  msgs.clear();
+  start = steady_clock::now();
+  for (auto i = 0; i < kNumMessages; i++) {
+    auto m = save_message(text);
+    ASSERT_TRUE(m.has_value());
+    msgs.push_back(m.value());
+  }
+  posted = steady_clock::now();
+  for (const auto& m : msgs) {
+    ASSERT_EQ(text, readfile(m).value());
+  }
+  read = steady_clock::now();
+  LOG(INFO) << "Type2Text: posted " << kNumMessages << " messages in "
+            << duration_cast<milliseconds>(posted - start).count() << "ms; read in "
+            << duration_cast<milliseconds>(read - posted).count() << "ms";
+}
@@ -19,6 +19,7 @@
 #include "gtest/gtest.h"
 
 #include "core/file.h"
+#include "core/log.h"
 #include "core/strings.h"
 #include "core_test/file_helper.h"
 #include "sdk/config.h"
@@ -27,6 +28,7 @@
 #include "sdk/user.h"
 #include "sdk/usermanager.h"
 #include "sdk_test/sdk_helper.h"
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -107,6 +109,101 @@ TEST_F(NamesTest, Insert) {
   EXPECT_EQ(4, names_->size());
 }
 
+TEST_F(NamesTest, FindUser) {
+  EXPECT_EQ(3, names_->FindUser("A"));
+  EXPECT_EQ(3, names_->FindUser("a"));
+  EXPECT_EQ(1, names_->FindUser("C"));
+  EXPECT_EQ(0, names_->FindUser("D"));
+}
+
+TEST_F(NamesTest, FindUser_AfterAddAndRemove) {
+  ASSERT_TRUE(names_->Add("Rushfan", 10));
+  EXPECT_EQ(10, names_->FindUser("RUSHFAN"));
+  ASSERT_TRUE(names_->Remove(10));
+  EXPECT_EQ(0, names_->FindUser("RUSHFAN"));
+  EXPECT_TRUE(names_->UserName(10).empty());
+}
+
+TEST_F(NamesTest, FindUser_DuplicateNames) {
+  ASSERT_TRUE(names_->Add("Dupe", 20));
+  ASSERT_TRUE(names_->Add("Dupe", 10));
+  EXPECT_EQ(10, names_->FindUser("Dupe"));
+
+  // Removing one should leave the other findable.
+  ASSERT_TRUE(names_->Remove(10));
+  EXPECT_EQ(20, names_->FindUser("Dupe"));
+  EXPECT_EQ("Dupe #20", names_->UserName(20));
+}
+
+TEST_F(NamesTest, FindUsersWithPrefix) {
+  ASSERT_TRUE(names_->Add("Rushfan", 10));
+  ASSERT_TRUE(names_->Add("Rush", 11));
+  ASSERT_TRUE(names_->Add("Ru", 12));
+  ASSERT_TRUE(names_->Add("Sysop", 13));
+
+  const auto v = names_->FindUsersWithPrefix("rus");
+  ASSERT_EQ(2u, v.size());
+  EXPECT_EQ(11, v.at(0).number);
+  EXPECT_EQ(10, v.at(1).number);
+  EXPECT_TRUE(names_->FindUsersWithPrefix("x").empty());
+}
+
+TEST_F(NamesTest, FindUsersContaining) {
+  ASSERT_TRUE(names_->Add("Rushfan", 10));
+  ASSERT_TRUE(names_->Add("Brush", 11));
+  ASSERT_TRUE(names_->Add("Rush", 12));
+  ASSERT_TRUE(names_->Add("Sysop", 13));
+  ASSERT_TRUE(names_->Add("Thrush", 14));
+
+  // In name order, not prefix matches first.
+  const auto v = names_->FindUsersContaining("rush");
+  ASSERT_EQ(4u, v.size());
+  EXPECT_EQ(11, v.at(0).number);
+  EXPECT_EQ(12, v.at(1).number);
+  EXPECT_EQ(10, v.at(2).number);
+  EXPECT_EQ(14, v.at(3).number);
+  EXPECT_TRUE(names_->FindUsersContaining("x").empty());
+}
+
+TEST_F(NamesTest, Save_NoTempFileLeftBehind) {
+  ASSERT_TRUE(names_->Add("Z", 26));
+  ASSERT_TRUE(names_->Save());
+  EXPECT_FALSE(File::ExistsWildcard(FilePath(config_.datadir(), StrCat(NAMES_LST, ".*"))));
+
+  Names n(config_);
+  EXPECT_EQ(4, n.size());
+  EXPECT_EQ(26, n.FindUser("Z"));
+}
+
+// Benchmark of lookups over a large NAMES.LST.
+TEST_F(NamesTest, DISABLED_Benchmark_100k) {
+  constexpr auto kNumNames = 100000;
+  const auto start = std::chrono::steady_clock::now();
+  for (auto i = 1; i <= kNumNames; i++) {
+    names_->Add(StrCat("USER ", i), i % 65000 + 4);
+  }
+  const auto added = std::chrono::steady_clock::now();
+  auto found = 0;
+  for (auto i = 1; i <= kNumNames; i++) {
+    if (!names_->UserName(i % 65000 + 4).empty()) {
+      ++found;
+    }
+    if (names_->FindUser(StrCat("USER ", i)) != 0) {
+      ++found;
+    }
+  }
+  const auto looked_up = std::chrono::steady_clock::now();
+  ASSERT_TRUE(names_->Save());
+  const auto saved = std::chrono::steady_clock::now();
+  EXPECT_EQ(kNumNames * 2, found);
+
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  LOG(INFO) << "Add: " << duration_cast<milliseconds>(added - start).count() << "ms";
+  LOG(INFO) << "Lookups: " << duration_cast<milliseconds>(looked_up - added).count() << "ms";
+  LOG(INFO) << "Save: " << duration_cast<milliseconds>(saved - looked_up).count() << "ms";
+}
+
 TEST_F(NamesTest, SaveOnExit) {
   names_->set_save_on_exit(true);
   ASSERT_TRUE(names_->save_on_exit());
@@ -29,9 +29,12 @@
 #include "sdk/fido/fido_address.h"
 #include "sdk/net/ftn_msgdupe.h"
 #include "sdk_test/sdk_helper.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <ctime>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -133,4 +136,182 @@ TEST_F(FtnMsgDupeTest, Remove) {
   EXPECT_TRUE(dupe.is_dupe(1, 2));
   dupe.remove(1, 2);
   EXPECT_FALSE(dupe.is_dupe(1, 2));
-}
\ No newline at end of file
+}
+TEST_F(FtnMsgDupeTest, Load_ExistingFile) {
+  ASSERT_TRUE(CreateDupes({{1, 2}, {3, 4}}));
+  FtnMessageDupe dupe(config_.datadir(), true);
+  ASSERT_TRUE(dupe.IsInitialized());
+  EXPECT_EQ(2, dupe.size());
+  // msgids is {msgid, header}.
+  EXPECT_TRUE(dupe.is_dupe(2, 0));
+  EXPECT_TRUE(dupe.is_dupe(0, 3));
+  EXPECT_FALSE(dupe.is_dupe(1, 4));
+}
+
+TEST_F(FtnMsgDupeTest, Add_Appends) {
+  const auto path = FilePath(config_.datadir(), MSGDUPE_DAT);
+  {
+    FtnMessageDupe dupe(config_.datadir(), true);
+    EXPECT_TRUE(dupe.add(1, 2));
+    EXPECT_TRUE(dupe.add(3, 4));
+  }
+  EXPECT_EQ(2 * sizeof(msgids), File(path).length());
+
+  FtnMessageDupe dupe(config_.datadir(), true);
+  EXPECT_TRUE(dupe.is_dupe(1, 2));
+  EXPECT_TRUE(dupe.is_dupe(3, 0));
+  EXPECT_TRUE(dupe.is_dupe(0, 4));
+  EXPECT_FALSE(dupe.is_dupe(2, 1));
+}
+
+TEST_F(FtnMsgDupeTest, ZeroIsNeverADupe) {
+  FtnMessageDupe dupe(config_.datadir(), false);
+  dupe.add(0, 2);
+  EXPECT_FALSE(dupe.is_dupe(0, 0));
+  EXPECT_TRUE(dupe.is_dupe(0, 2));
+}
+
+TEST_F(FtnMsgDupeTest, ForgetsOldest) {
+  FtnMessageDupe dupe(config_.datadir(), false, 3);
+  for (uint32_t i = 1; i <= 5; i++) {
+    dupe.add(i, i + 100);
+  }
+  EXPECT_EQ(3, dupe.size());
+  EXPECT_FALSE(dupe.is_dupe(1, 101));
+  EXPECT_FALSE(dupe.is_dupe(2, 102));
+  for (uint32_t i = 3; i <= 5; i++) {
+    EXPECT_TRUE(dupe.is_dupe(i, 0)) << i;
+    EXPECT_TRUE(dupe.is_dupe(0, i + 100)) << i;
+  }
+}
+
+TEST_F(FtnMsgDupeTest, ForgetsOldest_SameCrcStillRemembered) {
+  FtnMessageDupe dupe(config_.datadir(), false, 2);
+  dupe.add(1, 2);
+  dupe.add(1, 3);
+  dupe.add(4, 5);
+  // The first 1 is gone, but the second one is still here.
+  EXPECT_TRUE(dupe.is_dupe(1, 0));
+  EXPECT_FALSE(dupe.is_dupe(0, 2));
+}
+
+TEST_F(FtnMsgDupeTest, Compacts) {
+  const auto path = FilePath(config_.datadir(), MSGDUPE_DAT);
+  {
+    FtnMessageDupe dupe(config_.datadir(), true, 2);
+    for (uint32_t i = 1; i <= 10; i++) {
+      dupe.add(i, i + 100);
+      EXPECT_LE(File(path).length(), 4 * sizeof(msgids));
+    }
+  }
+  FtnMessageDupe dupe(config_.datadir(), true, 2);
+  EXPECT_EQ(2, dupe.size());
+  EXPECT_TRUE(dupe.is_dupe(10, 0));
+  EXPECT_TRUE(dupe.is_dupe(9, 0));
+  EXPECT_FALSE(dupe.is_dupe(8, 0));
+}
+
+TEST_F(FtnMsgDupeTest, Load_KeepsNewest) {
+  ASSERT_TRUE(CreateDupes({{1, 2}, {3, 4}, {5, 6}}));
+  const auto path = FilePath(config_.datadir(), MSGDUPE_DAT);
+  FtnMessageDupe dupe(config_.datadir(), true, 2);
+  EXPECT_EQ(2, dupe.size());
+  EXPECT_FALSE(dupe.is_dupe(2, 1));
+  EXPECT_TRUE(dupe.is_dupe(4, 3));
+  EXPECT_TRUE(dupe.is_dupe(6, 5));
+  EXPECT_EQ(2 * sizeof(msgids), File(path).length());
+}
+
+TEST_F(FtnMsgDupeTest, Remove_Persists) {
+  {
+    FtnMessageDupe dupe(config_.datadir(), true);
+    dupe.add(1, 2);
+    dupe.add(3, 4);
+    EXPECT_TRUE(dupe.remove(1, 2));
+    EXPECT_FALSE(dupe.remove(1, 2));
+  }
+  FtnMessageDupe dupe(config_.datadir(), true);
+  EXPECT_FALSE(dupe.is_dupe(1, 2));
+  EXPECT_TRUE(dupe.is_dupe(3, 4));
+}
+
+TEST_F(FtnMsgDupeTest, Stale) {
+  FtnMessageDupe dupe(config_.datadir(), true);
+  EXPECT_FALSE(dupe.stale());
+  // Our own writes don't make it stale.
+  dupe.add(1, 2);
+  EXPECT_FALSE(dupe.stale());
+
+  // Someone else's do.
+  FtnMessageDupe other(config_.datadir(), true);
+  other.add(3, 4);
+  EXPECT_TRUE(dupe.stale());
+  EXPECT_FALSE(dupe.is_dupe(3, 4));
+  // Even once we've written to it again since.
+  dupe.add(5, 6);
+  EXPECT_TRUE(dupe.stale());
+}
+
+TEST(Crc32CountsTest, InsertErase_Random) {
+  Crc32Counts c;
+  std::multiset<uint32_t> expected;
+  uint32_t seed = 12345;
+  auto next = [&seed] {
+    seed = seed * 1103515245 + 12345;
+    // Keep the values small so there are lots of collisions.
+    return (seed >> 16) % 5000 + 1;
+  };
+  for (auto i = 0; i < 50000; i++) {
+    const auto key = next();
+    if (i % 3 == 0) {
+      c.erase(key);
+      if (auto it = expected.find(key); it != std::end(expected)) {
+        expected.erase(it);
+      }
+    } else {
+      c.insert(key);
+      expected.insert(key);
+    }
+  }
+  for (uint32_t key = 1; key <= 5000; key++) {
+    EXPECT_EQ(expected.count(key) > 0, c.contains(key)) << key;
+  }
+  EXPECT_EQ(static_cast<int>(std::set<uint32_t>(expected.begin(), expected.end()).size()),
+            c.size());
+}
+
+// Benchmark of loading and checking a full dupe file.
+TEST_F(FtnMsgDupeTest, DISABLED_Benchmark_1M) {
+  constexpr auto kNumEntries = 1000000;
+  std::vector<msgids> ids;
+  ids.reserve(kNumEntries);
+  for (uint32_t i = 0; i < kNumEntries; i++) {
+    ids.push_back(msgids{i * 2654435761u + 1, i * 40503u + 7});
+  }
+  ASSERT_TRUE(CreateDupes(ids));
+
+  auto start = std::chrono::steady_clock::now();
+  FtnMessageDupe dupe(config_.datadir(), true, kNumEntries);
+  const auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  ASSERT_EQ(kNumEntries, dupe.size());
+
+  start = std::chrono::steady_clock::now();
+  auto found = 0;
+  for (uint32_t i = 0; i < kNumEntries; i++) {
+    // Half hits, half misses.
+    if (dupe.is_dupe(i % 2 ? i * 40503u + 7 : 0, i % 2 ? 0 : i + 0x80000000u)) {
+      ++found;
+    }
+  }
+  const auto lookup_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  EXPECT_GE(found, kNumEntries / 2);
+
+  LOG(INFO) << "Load " << kNumEntries << " entries: " << load_ms << "ms";
+  LOG(INFO) << "Lookups: "
+            << static_cast<int64_t>(kNumEntries) * 1000 / std::max<int64_t>(1, lookup_ms)
+            << "/sec";
+}
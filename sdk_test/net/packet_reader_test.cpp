@@ -0,0 +1,287 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_writer.h"
+#include "sdk/net/packets.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::net;
+using namespace wwiv::strings;
+
+class PacketReaderTest : public testing::Test {
+public:
+  PacketReaderTest() {
+    net_.dir = helper_.TempDir();
+    net_.sysnum = 1;
+  }
+
+  static Packet CreatePacket(uint16_t tosys, const std::vector<uint16_t>& list,
+                             const std::string& text) {
+    net_header_rec nh{};
+    nh.tosys = tosys;
+    nh.fromsys = 2;
+    nh.main_type = main_type_email;
+    nh.list_len = static_cast<uint16_t>(list.size());
+    nh.length = static_cast<uint32_t>(text.size());
+    return Packet(nh, list, text);
+  }
+
+  std::vector<Packet> ReadAll(const std::string& filename, bool process_de,
+                              int buffer_size = 256 * 1024) const {
+    std::vector<Packet> packets;
+    PacketReader r(FilePath(net_.dir, filename), process_de, buffer_size);
+    for (;;) {
+      auto [view, response] = r.Next();
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      packets.emplace_back(view.ToPacket());
+    }
+    return packets;
+  }
+
+  std::vector<Packet> ReadAllOld(const std::string& filename, bool process_de) const {
+    std::vector<Packet> packets;
+    File f(FilePath(net_.dir, filename));
+    if (!f.Open(File::modeBinary | File::modeReadOnly)) {
+      return packets;
+    }
+    for (;;) {
+      auto [packet, response] = read_packet(f, process_de);
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      packets.emplace_back(packet);
+    }
+    return packets;
+  }
+
+  static void ExpectSame(const std::vector<Packet>& expected, const std::vector<Packet>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto i = 0u; i < expected.size(); i++) {
+      EXPECT_EQ(0, memcmp(&expected[i].nh, &actual[i].nh, sizeof(net_header_rec))) << i;
+      EXPECT_EQ(expected[i].list, actual[i].list) << i;
+      EXPECT_EQ(expected[i].text(), actual[i].text()) << i;
+    }
+  }
+
+  FileHelper helper_;
+  net_networks_rec net_{};
+};
+
+TEST_F(PacketReaderTest, Smoke) {
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "Hello"));
+  write_wwivnet_packet("s2.net", net_, CreatePacket(3, {3, 4, 5}, "World"));
+
+  PacketReader r(FilePath(net_.dir, "s2.net"), false);
+  ASSERT_TRUE(r.IsOpen());
+  {
+    auto [v, response] = r.Next();
+    ASSERT_EQ(ReadPacketResponse::OK, response);
+    EXPECT_EQ(2, v.nh.tosys);
+    EXPECT_EQ(0, v.list_size());
+    EXPECT_EQ("Hello", v.text());
+  }
+  {
+    auto [v, response] = r.Next();
+    ASSERT_EQ(ReadPacketResponse::OK, response);
+    ASSERT_EQ(3, v.list_size());
+    EXPECT_EQ(4, v.list_at(1));
+    EXPECT_EQ((std::vector<uint16_t>{3, 4, 5}), v.list());
+    EXPECT_EQ("World", v.text());
+  }
+  EXPECT_EQ(ReadPacketResponse::END_OF_FILE, std::get<1>(r.Next()));
+}
+
+TEST_F(PacketReaderTest, MissingFile) {
+  PacketReader r(FilePath(net_.dir, "s2.net"), false);
+  EXPECT_FALSE(r.IsOpen());
+  EXPECT_EQ(ReadPacketResponse::ERROR, std::get<1>(r.Next()));
+}
+
+TEST_F(PacketReaderTest, SameAsReadPacket_SmallBuffer) {
+  PacketWriter w(net_);
+  for (auto i = 0; i < 100; i++) {
+    std::vector<uint16_t> list;
+    for (auto j = 0; j < i % 5; j++) {
+      list.push_back(static_cast<uint16_t>(j + 10));
+    }
+    w.Write("s2.net", CreatePacket(2, list, std::string(i * 7, static_cast<char>('a' + i % 26))));
+  }
+  w.Close();
+
+  const auto expected = ReadAllOld("s2.net", false);
+  ASSERT_EQ(100u, expected.size());
+  // Packets larger than the buffer and ones that straddle a refill.
+  ExpectSame(expected, ReadAll("s2.net", false, 64));
+  ExpectSame(expected, ReadAll("s2.net", false));
+}
+
+TEST_F(PacketReaderTest, ProcessDe) {
+  auto p = CreatePacket(2, {}, std::string(146, 'h') + "Hello");
+  p.nh.method = 1;
+  write_wwivnet_packet("s2.net", net_, p);
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "World"));
+
+  const auto packets = ReadAll("s2.net", true);
+  ASSERT_EQ(2u, packets.size());
+  EXPECT_EQ("Hello", packets[0].text());
+  EXPECT_EQ(5u, packets[0].nh.length);
+  EXPECT_EQ("World", packets[1].text());
+  ExpectSame(ReadAllOld("s2.net", true), packets);
+}
+
+TEST_F(PacketReaderTest, TruncatedText) {
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "Hello"));
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "World"));
+  const auto path = FilePath(net_.dir, "s2.net");
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(f.length() - 2);
+  }
+
+  const auto packets = ReadAll("s2.net", false);
+  ASSERT_EQ(2u, packets.size());
+  EXPECT_EQ("Wor", packets[1].text());
+  ExpectSame(ReadAllOld("s2.net", false), packets);
+}
+
+TEST_F(PacketReaderTest, TruncatedHeader) {
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "Hello"));
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "World"));
+  const auto path = FilePath(net_.dir, "s2.net");
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(sizeof(net_header_rec) + 5 + 4);
+  }
+
+  PacketReader r(path, false);
+  auto [v, response] = r.Next();
+  ASSERT_EQ(ReadPacketResponse::OK, response);
+  EXPECT_EQ("Hello", v.text());
+  EXPECT_EQ(ReadPacketResponse::ERROR, std::get<1>(r.Next()));
+}
+
+TEST_F(PacketReaderTest, TruncatedList) {
+  write_wwivnet_packet("s2.net", net_, CreatePacket(0, {3, 4, 5}, "Hello"));
+  const auto path = FilePath(net_.dir, "s2.net");
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.set_length(sizeof(net_header_rec) + 3);
+  }
+
+  {
+    PacketReader r(path, false);
+    auto [v, response] = r.Next();
+    ASSERT_EQ(ReadPacketResponse::OK, response);
+    // Zero filled like read_packet, not shortened.
+    ASSERT_EQ(3, v.list_size());
+    EXPECT_EQ(3, v.list_at(0));
+    EXPECT_EQ(4, v.list_at(1));
+    EXPECT_EQ(0, v.list_at(2));
+  }
+  ExpectSame(ReadAllOld("s2.net", false), ReadAll("s2.net", false));
+}
+
+TEST_F(PacketReaderTest, UpdateRouting) {
+  const std::string text("Title\0Sender\r\nDate\r\nBody", 24);
+  write_wwivnet_packet("s2.net", net_, CreatePacket(0, {3, 4}, text));
+
+  PacketReader r(FilePath(net_.dir, "s2.net"), false);
+  auto [v, response] = r.Next();
+  ASSERT_EQ(ReadPacketResponse::OK, response);
+  auto expected = v.ToPacket();
+  ASSERT_TRUE(expected.UpdateRouting(net_));
+  ASSERT_TRUE(v.UpdateRouting(net_));
+  EXPECT_EQ(text, v.text());
+  EXPECT_EQ(expected.nh.length, v.nh.length);
+  EXPECT_EQ(expected.text(), v.ToPacket().text());
+
+  std::string expected_data;
+  ASSERT_TRUE(append_wwivnet_packet(expected_data, expected));
+  std::string data;
+  ASSERT_TRUE(append_wwivnet_packet(data, v));
+  EXPECT_EQ(expected_data, data);
+
+  {
+    PacketWriter w(net_);
+    ASSERT_TRUE(w.Write("s3.net", v));
+  }
+  ExpectSame({expected}, ReadAll("s3.net", false));
+}
+
+// Benchmark of reading a multi-megabyte packet file.
+TEST_F(PacketReaderTest, DISABLED_Benchmark_Read) {
+  constexpr auto kNumPackets = 20000;
+  {
+    PacketWriter w(net_);
+    for (auto i = 0; i < kNumPackets; i++) {
+      w.Write("s2.net", CreatePacket(2, {}, std::string(200 + i % 400, 'x')));
+    }
+  }
+  const auto path = FilePath(net_.dir, "s2.net");
+
+  auto start = steady_clock::now();
+  int64_t old_bytes = 0;
+  {
+    File f(path);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadOnly));
+    for (;;) {
+      auto [packet, response] = read_packet(f, false);
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      old_bytes += packet.text().size();
+    }
+  }
+  const auto old_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  int64_t new_bytes = 0;
+  {
+    PacketReader r(path, false);
+    for (;;) {
+      auto [v, response] = r.Next();
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      new_bytes += v.text().size();
+    }
+  }
+  const auto new_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+  EXPECT_EQ(old_bytes, new_bytes);
+
+  LOG(INFO) << "File size: " << File(path).length() << " bytes";
+  LOG(INFO) << "read_packet:  " << old_ms << "ms";
+  LOG(INFO) << "PacketReader: " << new_ms << "ms";
+}
@@ -0,0 +1,154 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/filenames.h"
+#include "sdk/net/packet_reader.h"
+#include "sdk/net/packet_spool.h"
+#include "sdk/net/packet_writer.h"
+#include "sdk/net/packets.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::net;
+using namespace wwiv::strings;
+
+class PacketSpoolTest : public testing::Test {
+public:
+  PacketSpoolTest() {
+    net_.dir = helper_.TempDir();
+    net_.sysnum = 1;
+  }
+
+  static Packet CreatePacket(uint16_t tosys, const std::string& text) {
+    net_header_rec nh{};
+    nh.tosys = tosys;
+    nh.fromsys = 2;
+    nh.main_type = main_type_email;
+    nh.length = static_cast<uint32_t>(text.size());
+    return Packet(nh, {}, text);
+  }
+
+  static std::vector<std::string> Texts(PacketReader& r) {
+    std::vector<std::string> texts;
+    for (;;) {
+      auto [view, response] = r.Next();
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      texts.emplace_back(view.text());
+    }
+    return texts;
+  }
+
+  std::vector<std::string> ReadTexts(const std::string& filename) const {
+    PacketReader r(FilePath(net_.dir, filename), false);
+    return Texts(r);
+  }
+
+  FileHelper helper_;
+  net_networks_rec net_{};
+};
+
+TEST_F(PacketSpoolTest, HeldPacketsAreNotWritten) {
+  PacketSpool spool(net_);
+  spool.Hold(LOCAL_NET);
+  {
+    PacketWriter w(net_);
+    w.set_spool(&spool);
+    ASSERT_TRUE(w.Write(LOCAL_NET, CreatePacket(1, "Hello")));
+    ASSERT_TRUE(w.Write("s2.net", CreatePacket(2, "World")));
+  }
+  EXPECT_FALSE(File::Exists(FilePath(net_.dir, LOCAL_NET)));
+  EXPECT_TRUE(File::Exists(FilePath(net_.dir, "s2.net")));
+  EXPECT_TRUE(spool.has_packets(LOCAL_NET));
+  EXPECT_FALSE(spool.has_packets("s2.net"));
+
+  PacketReader r(spool.Take(LOCAL_NET), false);
+  ASSERT_TRUE(r.IsOpen());
+  EXPECT_EQ(std::vector<std::string>{"Hello"}, Texts(r));
+  EXPECT_FALSE(spool.has_packets(LOCAL_NET));
+}
+
+TEST_F(PacketSpoolTest, CommitWritesWhatIsLeft) {
+  {
+    PacketSpool spool(net_);
+    spool.Hold(LOCAL_NET);
+    PacketWriter w(net_);
+    w.set_spool(&spool);
+    ASSERT_TRUE(w.Write(LOCAL_NET, CreatePacket(1, "Hello")));
+    const auto taken = spool.Take(LOCAL_NET);
+    ASSERT_TRUE(w.Write(LOCAL_NET, CreatePacket(1, "World")));
+    // Couldn't process them, so they go back in front.
+    spool.PutBack(LOCAL_NET, taken);
+    ASSERT_TRUE(spool.Commit());
+    EXPECT_FALSE(spool.has_packets(LOCAL_NET));
+  }
+  EXPECT_EQ((std::vector<std::string>{"Hello", "World"}), ReadTexts(LOCAL_NET));
+}
+
+TEST_F(PacketSpoolTest, Destructor_Commits) {
+  {
+    PacketSpool spool(net_);
+    spool.Hold(LOCAL_NET);
+    ASSERT_TRUE(append_wwivnet_packet(spool.data(LOCAL_NET), CreatePacket(1, "Hello")));
+  }
+  EXPECT_EQ(std::vector<std::string>{"Hello"}, ReadTexts(LOCAL_NET));
+}
+
+TEST_F(PacketSpoolTest, Remove_NothingHeld) {
+  const auto input = helper_.CreateTempFile("p1.net", "x");
+  PacketSpool spool(net_);
+  spool.Hold(LOCAL_NET);
+  ASSERT_TRUE(spool.Remove(input));
+  EXPECT_FALSE(File::Exists(input));
+}
+
+TEST_F(PacketSpoolTest, Remove_KeptUntilCommit) {
+  const auto input = helper_.CreateTempFile("p1.net", "x");
+  PacketSpool spool(net_);
+  spool.Hold(LOCAL_NET);
+  ASSERT_TRUE(append_wwivnet_packet(spool.data(LOCAL_NET), CreatePacket(1, "Hello")));
+  ASSERT_TRUE(spool.Remove(input));
+  EXPECT_FALSE(File::Exists(input));
+  EXPECT_TRUE(File::Exists(FilePath(net_.dir, "p1.net.hld")));
+
+  // Read by the next stage.
+  EXPECT_FALSE(spool.Take(LOCAL_NET).empty());
+  ASSERT_TRUE(spool.Commit());
+  EXPECT_FALSE(File::Exists(FilePath(net_.dir, "p1.net.hld")));
+  EXPECT_FALSE(File::Exists(FilePath(net_.dir, LOCAL_NET)));
+}
+
+TEST_F(PacketSpoolTest, Recover) {
+  helper_.CreateTempFile("p1.net.hld", "old");
+  helper_.CreateTempFile("p2.net.hld", "old");
+  // A new p2.net arrived since.
+  helper_.CreateTempFile("p2.net", "new");
+  PacketSpool::Recover(net_.dir);
+  EXPECT_FALSE(File::Exists(FilePath(net_.dir, "p1.net.hld")));
+  EXPECT_FALSE(File::Exists(FilePath(net_.dir, "p2.net.hld")));
+  EXPECT_EQ("old", helper_.ReadFile(FilePath(net_.dir, "p1.net")));
+  EXPECT_EQ("new", helper_.ReadFile(FilePath(net_.dir, "p2.net")));
+  EXPECT_EQ("old", helper_.ReadFile(FilePath(net_.dir, "p2-1.net")));
+}
@@ -0,0 +1,192 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core_test/file_helper.h"
+#include "sdk/net/packet_writer.h"
+#include "sdk/net/packets.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::sdk::net;
+using namespace wwiv::strings;
+
+class PacketWriterTest : public testing::Test {
+public:
+  PacketWriterTest() {
+    net_.dir = helper_.TempDir();
+    net_.sysnum = 1;
+  }
+
+  static Packet CreatePacket(uint16_t tosys, const std::vector<uint16_t>& list,
+                             const std::string& text) {
+    net_header_rec nh{};
+    nh.tosys = tosys;
+    nh.fromsys = 2;
+    nh.main_type = main_type_email;
+    nh.list_len = static_cast<uint16_t>(list.size());
+    nh.length = static_cast<uint32_t>(text.size());
+    return Packet(nh, list, text);
+  }
+
+  std::vector<Packet> ReadPackets(const std::string& filename) const {
+    std::vector<Packet> packets;
+    File f(FilePath(net_.dir, filename));
+    if (!f.Open(File::modeBinary | File::modeReadOnly)) {
+      return packets;
+    }
+    for (;;) {
+      auto [packet, response] = read_packet(f, false);
+      if (response != ReadPacketResponse::OK) {
+        break;
+      }
+      packets.emplace_back(packet);
+    }
+    return packets;
+  }
+
+  FileHelper helper_;
+  net_networks_rec net_{};
+};
+
+TEST_F(PacketWriterTest, Smoke) {
+  {
+    PacketWriter w(net_);
+    EXPECT_TRUE(w.Write("s2.net", CreatePacket(2, {}, "Hello")));
+    EXPECT_TRUE(w.Write("s2.net", CreatePacket(3, {3, 4}, "World")));
+    EXPECT_TRUE(w.Write("local.net", CreatePacket(1, {}, "Local")));
+    EXPECT_TRUE(w.Close());
+    EXPECT_EQ(3, w.stats().packets);
+    EXPECT_EQ(2, w.stats().opens);
+  }
+
+  const auto s2 = ReadPackets("s2.net");
+  ASSERT_EQ(2u, s2.size());
+  EXPECT_EQ("Hello", s2[0].text());
+  EXPECT_EQ(2, s2[0].nh.tosys);
+  EXPECT_EQ("World", s2[1].text());
+  EXPECT_EQ((std::vector<uint16_t>{3, 4}), s2[1].list);
+  const auto local = ReadPackets("local.net");
+  ASSERT_EQ(1u, local.size());
+  EXPECT_EQ("Local", local[0].text());
+}
+
+TEST_F(PacketWriterTest, SameBytesAsWriteWwivnetPacket) {
+  const auto p1 = CreatePacket(2, {}, "Hello");
+  const auto p2 = CreatePacket(3, {3, 4}, "World");
+  write_wwivnet_packet("a.net", net_, p1);
+  write_wwivnet_packet("a.net", net_, p2);
+  {
+    PacketWriter w(net_);
+    w.Write("b.net", p1);
+    w.Write("b.net", p2);
+  }
+  const auto a = helper_.ReadFile(FilePath(net_.dir, "a.net"));
+  EXPECT_FALSE(a.empty());
+  EXPECT_EQ(a, helper_.ReadFile(FilePath(net_.dir, "b.net")));
+}
+
+TEST_F(PacketWriterTest, AppendsToExistingFile) {
+  write_wwivnet_packet("s2.net", net_, CreatePacket(2, {}, "First"));
+  {
+    PacketWriter w(net_);
+    w.Write("s2.net", CreatePacket(2, {}, "Second"));
+  }
+  const auto s2 = ReadPackets("s2.net");
+  ASSERT_EQ(2u, s2.size());
+  EXPECT_EQ("First", s2[0].text());
+  EXPECT_EQ("Second", s2[1].text());
+}
+
+TEST_F(PacketWriterTest, Evicts_LeastRecentlyUsed) {
+  PacketWriter w(net_, 2);
+  for (auto i = 0; i < 3; i++) {
+    w.Write("s2.net", CreatePacket(2, {}, StrCat("2-", i)));
+    w.Write("s3.net", CreatePacket(3, {}, StrCat("3-", i)));
+    w.Write("s4.net", CreatePacket(4, {}, StrCat("4-", i)));
+  }
+  EXPECT_TRUE(w.Close());
+  // Every write needed to reopen the file.
+  EXPECT_EQ(9, w.stats().opens);
+
+  for (const auto n : {2, 3, 4}) {
+    const auto packets = ReadPackets(StrCat("s", n, ".net"));
+    ASSERT_EQ(3u, packets.size());
+    for (auto i = 0; i < 3; i++) {
+      EXPECT_EQ(StrCat(n, "-", i), packets[i].text());
+    }
+  }
+}
+
+TEST_F(PacketWriterTest, Flush_WritesBuffered) {
+  PacketWriter w(net_);
+  w.Write("s2.net", CreatePacket(2, {}, "Hello"));
+  const auto path = FilePath(net_.dir, "s2.net");
+  EXPECT_EQ(0u, std::filesystem::file_size(path));
+  EXPECT_TRUE(w.Flush());
+  // Still open, but the data must be on disk.
+  EXPECT_EQ(sizeof(net_header_rec) + 5, std::filesystem::file_size(path));
+}
+
+TEST_F(PacketWriterTest, MismatchedLength) {
+  PacketWriter w(net_);
+  auto p = CreatePacket(2, {}, "Hello");
+  p.nh.length = 100;
+  EXPECT_FALSE(w.Write("s2.net", p));
+  EXPECT_TRUE(w.Close());
+  EXPECT_TRUE(ReadPackets("s2.net").empty());
+}
+
+// Benchmark of tossing a 50k packet bundle to a handful of packet files.
+TEST_F(PacketWriterTest, DISABLED_Benchmark_Write50k) {
+  constexpr auto kNumPackets = 50000;
+  const std::string text(400, 'x');
+  std::vector<Packet> packets;
+  for (auto i = 0; i < kNumPackets; i++) {
+    packets.emplace_back(CreatePacket(static_cast<uint16_t>(2 + i % 8), {}, text));
+  }
+
+  auto start = steady_clock::now();
+  for (const auto& p : packets) {
+    write_wwivnet_packet(Packet::wwivnet_packet_name(net_, p.nh.tosys), net_, p);
+  }
+  const auto old_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  {
+    PacketWriter w(net_);
+    for (const auto& p : packets) {
+      w.Write(Packet::wwivnet_packet_name(net_, p.nh.tosys), p);
+    }
+    w.Close();
+  }
+  const auto new_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  LOG(INFO) << "write_wwivnet_packet: " << old_ms << "ms; "
+            << kNumPackets * 1000 / std::max<int64_t>(1, old_ms) << " packets/sec";
+  LOG(INFO) << "PacketWriter:         " << new_ms << "ms; "
+            << kNumPackets * 1000 / std::max<int64_t>(1, new_ms) << " packets/sec";
+}
@@ -0,0 +1,200 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/datafile.h"
+#include "core/file.h"
+#include "core/strings.h"
+#include "sdk/filenames.h"
+#include "sdk/status.h"
+#include "sdk_test/sdk_helper.h"
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::strings;
+
+class QScanAllocatorTest : public testing::Test {
+public:
+  [[nodiscard]] std::string datadir() const { return helper.data(); }
+
+  [[nodiscard]] statusrec_t ReadStatus() const {
+    statusrec_t s{};
+    DataFile<statusrec_t> file(FilePath(datadir(), STATUS_DAT));
+    EXPECT_TRUE(file.Read(0, &s));
+    return s;
+  }
+
+  SdkHelper helper;
+};
+
+TEST_F(QScanAllocatorTest, Next_ReservesBlocks) {
+  const auto start = ReadStatus().qscanptr;
+  QScanAllocator a(datadir(), 4);
+  for (auto i = 0u; i < 6; i++) {
+    EXPECT_EQ(start + i, a.next());
+  }
+  EXPECT_EQ(2, a.writes());
+  EXPECT_EQ(start + 8, ReadStatus().qscanptr);
+  // Posts aren't counted until the next write.
+  EXPECT_EQ(4, ReadStatus().msgposttoday);
+
+  EXPECT_TRUE(a.Flush());
+  // The rest of the block is given back.
+  EXPECT_EQ(start + 6, ReadStatus().qscanptr);
+  EXPECT_EQ(6, ReadStatus().msgposttoday);
+  EXPECT_EQ(start + 6, a.next());
+}
+
+TEST_F(QScanAllocatorTest, Flush_KeepsBlockWhenOthersReserved) {
+  const auto start = ReadStatus().qscanptr;
+  QScanAllocator a(datadir(), 4);
+  EXPECT_EQ(start, a.next());
+  StatusMgr sm(datadir());
+  uint32_t other = 0;
+  sm.Run([&](Status& s) { other = s.next_qscanptr(); });
+  EXPECT_EQ(start + 4, other);
+
+  EXPECT_TRUE(a.Flush());
+  EXPECT_EQ(start + 5, ReadStatus().qscanptr);
+  EXPECT_EQ(start + 5, a.next());
+}
+
+TEST_F(QScanAllocatorTest, Reserve) {
+  const auto start = ReadStatus().qscanptr;
+  QScanAllocator a(datadir(), 4);
+  EXPECT_EQ(start, a.next());
+  // Fits in the block.
+  EXPECT_EQ(start + 1, a.reserve(2));
+  EXPECT_EQ(1, a.writes());
+  // Doesn't, so continue on from the block.
+  EXPECT_EQ(start + 3, a.reserve(10));
+  EXPECT_EQ(2, a.writes());
+  EXPECT_EQ(0, a.available());
+  EXPECT_EQ(start + 13, ReadStatus().qscanptr);
+  EXPECT_EQ(13, ReadStatus().msgposttoday);
+  EXPECT_TRUE(a.Flush());
+  EXPECT_EQ(start + 13, ReadStatus().qscanptr);
+  EXPECT_EQ(13, ReadStatus().msgposttoday);
+  EXPECT_EQ(0u, a.reserve(0));
+}
+
+TEST_F(QScanAllocatorTest, FlushThenReserve_IsAfterOthers) {
+  const auto start = ReadStatus().qscanptr;
+  QScanAllocator a(datadir(), 4);
+  QScanAllocator b(datadir(), 4);
+  EXPECT_EQ(start, a.next());
+  EXPECT_EQ(start + 4, b.next());
+  // a still has start+1..start+3 cached, but those are older than b's.
+  EXPECT_TRUE(a.Flush());
+  EXPECT_EQ(start + 8, a.reserve(1));
+  EXPECT_EQ(0, a.available());
+  EXPECT_TRUE(a.Flush());
+  EXPECT_EQ(start + 9, ReadStatus().qscanptr);
+}
+
+TEST_F(QScanAllocatorTest, StatusMgr_FlushesOnDestruction) {
+  const auto start = ReadStatus().qscanptr;
+  {
+    StatusMgr sm(datadir());
+    EXPECT_EQ(start, sm.qscan_allocator().next());
+    EXPECT_EQ(start + 1, sm.qscan_allocator().next());
+  }
+  EXPECT_EQ(start + 2, ReadStatus().qscanptr);
+  EXPECT_EQ(2, ReadStatus().msgposttoday);
+}
+
+#ifndef _WIN32
+// Several processes allocating at once must never hand out the same pointer
+// or lose a post.
+TEST_F(QScanAllocatorTest, MultiProcess) {
+  constexpr auto kNumProcs = 6;
+  constexpr auto kNumRounds = 1000;
+  const auto start = ReadStatus().qscanptr;
+  const auto go = FilePath(datadir(), "go");
+  std::vector<pid_t> pids;
+  for (auto p = 0; p < kNumProcs; p++) {
+    const auto pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+      // Start together to make the most of the contention.
+      while (!File::Exists(go)) {
+        usleep(100);
+      }
+      std::string out;
+      {
+        QScanAllocator a(datadir(), 1 + p % 3);
+        for (auto i = 0; i < kNumRounds; i++) {
+          out += StrCat(a.next(), "\n");
+          if (i % 7 == 0) {
+            const auto first = a.reserve(5);
+            for (auto j = 0u; j < 5; j++) {
+              out += StrCat(first + j, "\n");
+            }
+          }
+          if (i % 10 == 0) {
+            a.Flush();
+          }
+        }
+      }
+      File f(FilePath(datadir(), StrCat("proc", p, ".txt")));
+      f.Open(File::modeCreateFile | File::modeReadWrite | File::modeBinary);
+      f.Write(out);
+      f.Close();
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  File gofile(go);
+  ASSERT_TRUE(gofile.Open(File::modeCreateFile | File::modeReadWrite));
+  gofile.Close();
+  for (const auto pid : pids) {
+    int status = 0;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+  }
+
+  std::set<uint32_t> seen;
+  auto num_posts = 0;
+  for (auto p = 0; p < kNumProcs; p++) {
+    const auto text = helper.files().ReadFile(FilePath(datadir(), StrCat("proc", p, ".txt")));
+    for (const auto& line : SplitString(text, "\n")) {
+      const auto q = to_number<uint32_t>(line);
+      ASSERT_NE(0u, q);
+      EXPECT_TRUE(seen.insert(q).second) << "Duplicate qscan pointer: " << q;
+      ++num_posts;
+    }
+  }
+  // 1000 posts plus 143 reserves of 5 each.
+  EXPECT_EQ(kNumProcs * (kNumRounds + 143 * 5), num_posts);
+  const auto s = ReadStatus();
+  EXPECT_EQ(num_posts, s.msgposttoday);
+  EXPECT_GE(*std::begin(seen), start);
+  EXPECT_GT(s.qscanptr, *std::rbegin(seen));
+}
+#endif
@@ -0,0 +1,222 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/file.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "sdk/config.h"
+#include "sdk/filenames.h"
+#include "sdk/user.h"
+#include "sdk/usermanager.h"
+#include "sdk_test/sdk_helper.h"
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::strings;
+
+class UserManagerTest : public testing::Test {
+public:
+  UserManagerTest() : config_(helper_.root()), path_(FilePath(config_.datadir(), USER_LST)) {}
+
+  static User CreateUser(const std::string& name) {
+    User u{};
+    User::CreateNewUserRecord(&u, 50, 20, 0, 0.1234f, {7, 11, 14, 13, 31, 10, 12, 9, 5, 3},
+                              {7, 15, 15, 15, 112, 15, 15, 7, 7, 7});
+    u.set_name(name);
+    return u;
+  }
+
+  // Writes num users straight to USER.LST.
+  void CreateUsers(int num) const {
+    std::vector<userrec> users(num + 1);
+    for (auto i = 1; i <= num; i++) {
+      users[i] = CreateUser(StrCat("USER ", i)).data;
+    }
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite | File::modeCreateFile |
+                       File::modeTruncate));
+    f.Write(&users[0], static_cast<File::size_type>(users.size() * sizeof(userrec)));
+  }
+
+  // Makes USER.LST look like it was last written an hour ago, so readers will
+  // trust their caches of it.
+  void AgeUserList() const {
+    std::filesystem::last_write_time(
+        path_, std::filesystem::file_time_type::clock::now() - hours(1));
+  }
+
+  SdkHelper helper_;
+  Config config_;
+  std::filesystem::path path_;
+};
+
+TEST_F(UserManagerTest, ReadWrite) {
+  UserManager um(config_);
+  auto u = CreateUser("FOO");
+  ASSERT_TRUE(um.writeuser(&u, 1));
+  EXPECT_EQ(1, um.num_user_records());
+
+  User r;
+  ASSERT_TRUE(um.readuser(&r, 1));
+  EXPECT_EQ("FOO", r.name());
+
+  AgeUserList();
+  const auto o = um.readuser(1);
+  ASSERT_TRUE(o.has_value());
+  EXPECT_EQ("FOO", o->name());
+  EXPECT_FALSE(um.readuser(2).has_value());
+}
+
+TEST_F(UserManagerTest, NoUserList) {
+  UserManager um(config_);
+  EXPECT_EQ(0, um.num_user_records());
+  User r;
+  EXPECT_FALSE(um.readuser(&r, 1));
+  EXPECT_TRUE(r.IsUserDeleted());
+  EXPECT_FALSE(um.for_each_user([](int, const User&) { return true; }));
+}
+
+TEST_F(UserManagerTest, ForEachUser) {
+  CreateUsers(600);
+  UserManager um(config_);
+  std::vector<int> numbers;
+  ASSERT_TRUE(um.for_each_user([&](int n, const User& u) {
+    EXPECT_EQ(StrCat("USER ", n), u.name());
+    numbers.push_back(n);
+    return true;
+  }));
+  ASSERT_EQ(600u, numbers.size());
+  EXPECT_EQ(1, numbers.front());
+  EXPECT_EQ(600, numbers.back());
+}
+
+TEST_F(UserManagerTest, ForEachUser_StopsEarly) {
+  CreateUsers(10);
+  UserManager um(config_);
+  auto count = 0;
+  EXPECT_TRUE(um.for_each_user([&](int n, const User&) {
+    ++count;
+    return n < 3;
+  }));
+  EXPECT_EQ(3, count);
+}
+
+TEST_F(UserManagerTest, Readuser_SeesWritesFromOtherNodes) {
+  CreateUsers(100);
+  AgeUserList();
+  UserManager um(config_);
+  User u;
+  ASSERT_TRUE(um.readuser(&u, 40));
+  EXPECT_EQ("USER 40", u.name());
+
+  UserManager other(config_);
+  auto changed = CreateUser("CHANGED");
+  ASSERT_TRUE(other.writeuser(&changed, 41));
+
+  ASSERT_TRUE(um.readuser(&u, 41));
+  EXPECT_EQ("CHANGED", u.name());
+  ASSERT_TRUE(um.readuser(&u, 40));
+  EXPECT_EQ("USER 40", u.name());
+}
+
+TEST_F(UserManagerTest, Readuser_Cached) {
+  CreateUsers(100);
+  AgeUserList();
+  const auto mtime = std::filesystem::last_write_time(path_);
+  UserManager um(config_);
+  User u;
+  ASSERT_TRUE(um.readuser(&u, 5));
+
+  // Change the record behind its back, but leave the size and time alone.
+  {
+    auto changed = CreateUser("CHANGED");
+    File f(path_);
+    ASSERT_TRUE(f.Open(File::modeBinary | File::modeReadWrite));
+    f.Seek(6 * sizeof(userrec), File::Whence::begin);
+    f.Write(&changed.data, sizeof(userrec));
+  }
+  std::filesystem::last_write_time(path_, mtime);
+  ASSERT_TRUE(um.readuser(&u, 6));
+  EXPECT_EQ("USER 6", u.name());
+
+  // readuser_nocache always goes to the file.
+  ASSERT_TRUE(um.readuser_nocache(&u, 6));
+  EXPECT_EQ("CHANGED", u.name());
+
+  // Now it looks like it was written.
+  std::filesystem::last_write_time(path_, mtime + seconds(1));
+  ASSERT_TRUE(um.readuser(&u, 6));
+  EXPECT_EQ("CHANGED", u.name());
+}
+
+TEST_F(UserManagerTest, Readuser_PastEnd) {
+  CreateUsers(10);
+  AgeUserList();
+  UserManager um(config_);
+  User u;
+  EXPECT_FALSE(um.readuser(&u, 11));
+  EXPECT_TRUE(u.IsUserDeleted());
+}
+
+// Benchmark of scanning 100k users.
+TEST_F(UserManagerTest, DISABLED_Benchmark_100k) {
+  constexpr auto kNumUsers = 100000;
+  CreateUsers(kNumUsers);
+  AgeUserList();
+  UserManager um(config_);
+
+  auto count = 0;
+  auto start = steady_clock::now();
+  for (auto i = 1; i <= um.num_user_records(); i++) {
+    User u;
+    if (um.readuser_nocache(&u, i) && !u.IsUserDeleted()) {
+      ++count;
+    }
+  }
+  const auto nocache_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  for (auto i = 1; i <= um.num_user_records(); i++) {
+    User u;
+    if (um.readuser(&u, i) && !u.IsUserDeleted()) {
+      ++count;
+    }
+  }
+  const auto cached_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  um.for_each_user([&count](int, const User& u) {
+    if (!u.IsUserDeleted()) {
+      ++count;
+    }
+    return true;
+  });
+  const auto for_each_ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+  EXPECT_EQ(kNumUsers * 3, count);
+
+  LOG(INFO) << "readuser_nocache: " << nocache_ms << "ms";
+  LOG(INFO) << "readuser:         " << cached_ms << "ms";
+  LOG(INFO) << "for_each_user:    " << for_each_ms << "ms";
+}
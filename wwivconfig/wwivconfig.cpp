@@ -170,13 +170,13 @@ static bool CreateSysopAccountIfNeeded(const std::string& bbsdir) {
   }
   {
     const UserManager usermanager(config);
-    const auto num_users = usermanager.num_user_records();
-    for (auto n = 1; n <= num_users; n++) {
-      if (auto u = usermanager.readuser(n)) {
-        if (!IsUserDeleted(u.value())) {
-          return true;
-        }
-      }
+    auto found = false;
+    usermanager.for_each_user([&found](int, const User& u) {
+      found = !IsUserDeleted(u);
+      return !found;
+    });
+    if (found) {
+      return true;
     }
   }
 
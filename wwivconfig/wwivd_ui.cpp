@@ -142,6 +142,9 @@ static void edit_blocking(const Config& config, wwivd_blocking_t& b, CursesWindo
   y++;
   items.add(new Label("Max Seconds Before Blocking:"), new NumberEditItem<int>(&b.auto_bl_seconds),
             1, y);
+  y++;
+  items.add(new Label("Max Subnet Sessions Before Blocking:"),
+            new NumberEditItem<int>(&b.auto_bl_subnet_sessions), 1, y);
 
   items.relayout_items_and_labels();
   items.Run("Blocking Configuration");
@@ -21,6 +21,7 @@
 #include "core/net.h"
 #include "sdk/config.h"
 #include "sdk/wwivd_config.h"
+#include "wwivd/connection_pool.h"
 #include "wwivd/ips.h"
 #include "wwivd/node_manager.h"
 #include <map>
@@ -41,6 +42,7 @@ struct ConnectionData {
   std::shared_ptr<GoodIp> good_ips_;
   std::shared_ptr<BadIp> bad_ips_;
   std::shared_ptr<AutoBlocker> auto_blocker_;
+  std::shared_ptr<ConnectionPool> pool_;
 };
 
 }  // namespace wwivd
@@ -0,0 +1,168 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "wwivd/connection_pool.h"
+
+#include "core/log.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+using namespace std::chrono;
+
+namespace wwiv::wwivd {
+
+struct ConnectionPool::state_t {
+  struct job_t {
+    job_fn run;
+    job_fn cancel;
+    steady_clock::time_point queued;
+  };
+
+  state_t(int w, int q) : max_workers(std::max(1, w)), max_queue(std::max(0, q)) {}
+
+  const int max_workers;
+  const int max_queue;
+
+  mutable std::mutex mu;
+  // Signaled when work is queued or we start draining.
+  std::condition_variable work_cv;
+  // Signaled when a worker exits.
+  std::condition_variable exit_cv;
+  std::deque<job_t> queue;
+  bool draining{false};
+  int idle_workers{0};
+  int64_t total_wait_micros{0};
+  connection_pool_stats_t stats;
+};
+
+ConnectionPool::ConnectionPool(int max_workers, int max_queue)
+    : state_(std::make_shared<state_t>(max_workers, max_queue)) {}
+
+ConnectionPool::~ConnectionPool() { Drain(milliseconds::zero()); }
+
+bool ConnectionPool::Submit(job_fn run, job_fn cancel) {
+  std::lock_guard<std::mutex> lock(state_->mu);
+  auto& s = *state_;
+  // Only queue when there's nobody idle to take it right away.
+  const auto waiting = static_cast<int>(s.queue.size()) - s.idle_workers;
+  const auto can_start = s.stats.workers < s.max_workers;
+  if (s.draining || (!can_start && waiting >= s.max_queue)) {
+    ++s.stats.busy;
+    return false;
+  }
+  s.queue.push_back({std::move(run), std::move(cancel), steady_clock::now()});
+  ++s.stats.accepted;
+  s.stats.queue_depth = static_cast<int>(s.queue.size());
+  s.stats.max_queue_depth = std::max(s.stats.max_queue_depth, s.stats.queue_depth);
+  if (s.idle_workers < static_cast<int>(s.queue.size()) && can_start) {
+    try {
+      std::thread(WorkerProc, state_).detach();
+      ++s.stats.workers;
+    } catch (const std::system_error& e) {
+      LOG(ERROR) << "ConnectionPool: Unable to start worker: " << e.what();
+      if (s.stats.workers == 0) {
+        // Nobody will ever get to it.
+        s.queue.pop_back();
+        s.stats.queue_depth = static_cast<int>(s.queue.size());
+        --s.stats.accepted;
+        ++s.stats.busy;
+        return false;
+      }
+    }
+  }
+  s.work_cv.notify_one();
+  return true;
+}
+
+void ConnectionPool::Denied() {
+  std::lock_guard<std::mutex> lock(state_->mu);
+  ++state_->stats.denied;
+}
+
+// static
+void ConnectionPool::WorkerProc(std::shared_ptr<state_t> state) {
+  auto& s = *state;
+  std::unique_lock<std::mutex> lock(s.mu);
+  while (true) {
+    ++s.idle_workers;
+    s.work_cv.wait(lock, [&] { return s.draining || !s.queue.empty(); });
+    --s.idle_workers;
+    if (s.queue.empty()) {
+      // Draining.
+      break;
+    }
+    auto job = std::move(s.queue.front());
+    s.queue.pop_front();
+    s.stats.queue_depth = static_cast<int>(s.queue.size());
+    const auto wait = duration_cast<microseconds>(steady_clock::now() - job.queued).count();
+    ++s.stats.started;
+    ++s.stats.active_workers;
+    s.total_wait_micros += wait;
+    s.stats.max_wait_micros = std::max<int64_t>(s.stats.max_wait_micros, wait);
+
+    lock.unlock();
+    try {
+      job.run();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "ConnectionPool: Handled Uncaught Exception: " << e.what();
+    }
+    // Release anything the job captured before taking the lock again.
+    job = {};
+    lock.lock();
+    --s.stats.active_workers;
+  }
+  --s.stats.workers;
+  s.exit_cv.notify_all();
+}
+
+bool ConnectionPool::Drain(milliseconds timeout) {
+  std::deque<state_t::job_t> cancelled;
+  std::unique_lock<std::mutex> lock(state_->mu);
+  auto& s = *state_;
+  s.draining = true;
+  std::swap(cancelled, s.queue);
+  s.stats.queue_depth = 0;
+  s.work_cv.notify_all();
+  lock.unlock();
+
+  for (auto& j : cancelled) {
+    if (j.cancel) {
+      j.cancel();
+    }
+  }
+
+  lock.lock();
+  return s.exit_cv.wait_for(lock, timeout, [&] { return s.stats.workers == 0; });
+}
+
+connection_pool_stats_t ConnectionPool::stats() const {
+  std::lock_guard<std::mutex> lock(state_->mu);
+  auto r = state_->stats;
+  if (r.started > 0) {
+    r.avg_wait_micros = state_->total_wait_micros / r.started;
+  }
+  return r;
+}
+
+} // namespace wwiv::wwivd
@@ -0,0 +1,96 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_WWIVD_CONNECTION_POOL_H
+#define INCLUDED_WWIVD_CONNECTION_POOL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace wwiv::wwivd {
+
+/** Counters describing the connections handled by a ConnectionPool. */
+struct connection_pool_stats_t {
+  // Connections handed to the pool.
+  int64_t accepted{0};
+  // Connections turned away by the admission check before reaching the pool.
+  int64_t denied{0};
+  // Connections turned away since all workers were busy and the queue was full.
+  int64_t busy{0};
+  // Connections picked up by a worker.
+  int64_t started{0};
+  int queue_depth{0};
+  int max_queue_depth{0};
+  int active_workers{0};
+  int workers{0};
+  // Time between a connection being handed to the pool and a worker
+  // starting on it.
+  int64_t avg_wait_micros{0};
+  int64_t max_wait_micros{0};
+};
+
+/**
+ * A bounded set of worker threads to handle accepted connections.
+ *
+ * Workers are started as needed up to max_workers and then stay around
+ * waiting for more work.  Once every worker is busy, up to max_queue
+ * connections wait for a worker before new ones are turned away.
+ */
+class ConnectionPool final {
+public:
+  typedef std::function<void()> job_fn;
+
+  ConnectionPool(int max_workers, int max_queue);
+  ~ConnectionPool();
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  /**
+   * Queues run to be executed on a worker.  If the pool is draining before
+   * run is started, then cancel is called instead.  Returns false without
+   * calling either function if the pool is full or draining, in which case
+   * the caller still owns the connection.
+   */
+  bool Submit(job_fn run, job_fn cancel);
+
+  /** Records a connection turned away by the admission check. */
+  void Denied();
+
+  /**
+   * Stops accepting work, cancels anything still queued, and waits up to
+   * timeout for running workers to finish.  Returns true if all workers
+   * have exited.
+   */
+  bool Drain(std::chrono::milliseconds timeout);
+
+  [[nodiscard]] connection_pool_stats_t stats() const;
+
+private:
+  struct state_t;
+  static void WorkerProc(std::shared_ptr<state_t> state);
+
+  // Shared with the (detached) worker threads so that a worker still
+  // running at exit never touches a destroyed pool.
+  std::shared_ptr<state_t> state_;
+};
+
+} // namespace wwiv::wwivd
+
+#endif
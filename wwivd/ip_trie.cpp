@@ -0,0 +1,133 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "wwivd/ip_trie.h"
+
+#include "core/strings.h"
+#include <algorithm>
+#include <cstring>
+
+namespace wwiv::wwivd {
+
+using namespace wwiv::core;
+using namespace wwiv::strings;
+
+// nodes_[0] is the root for IPv4 ranges and nodes_[1] for IPv6.
+static constexpr int kRootV4 = 0;
+static constexpr int kRootV6 = 1;
+// Bits of an IPv4-mapped IPv6 address before the IPv4 address.
+static constexpr int kV4MappedBits = 96;
+
+static int bit(const uint8_t* bytes, int n) noexcept {
+  return (bytes[n / 8] >> (7 - n % 8)) & 1;
+}
+
+// Clears everything after the first bits bits of addr.
+static ip_address mask(const ip_address& addr, int bits) {
+  char d[16];
+  memcpy(d, addr.bytes(), sizeof(d));
+  for (auto i = 0; i < 16; i++) {
+    const auto keep = std::clamp(bits - i * 8, 0, 8);
+    d[i] = static_cast<char>(d[i] & static_cast<uint8_t>(0xff00 >> keep));
+  }
+  return ip_address(d);
+}
+
+std::optional<ip_prefix_t> parse_ip_prefix(const std::string& s) {
+  const auto slash = s.find('/');
+  const auto addr = ip_address::from_string(s.substr(0, slash));
+  if (!addr) {
+    return std::nullopt;
+  }
+  const auto max_bits = addr->is_v4() ? 32 : 128;
+  auto bits = max_bits;
+  if (slash != std::string::npos) {
+    const auto b = s.substr(slash + 1);
+    if (b.empty() || b.find_first_not_of("0123456789") != std::string::npos) {
+      return std::nullopt;
+    }
+    bits = to_number<int>(b);
+    if (bits > max_bits) {
+      return std::nullopt;
+    }
+  }
+  if (addr->is_v4()) {
+    bits += kV4MappedBits;
+  }
+  return ip_prefix_t{mask(addr.value(), bits), bits};
+}
+
+std::string to_string(const ip_prefix_t& p) {
+  const auto max_bits = 128;
+  if (p.bits >= max_bits) {
+    return p.address.to_string();
+  }
+  const auto bits = p.address.is_v4() ? p.bits - kV4MappedBits : p.bits;
+  return StrCat(p.address.to_string(), "/", bits);
+}
+
+ip_prefix_t subnet_of(const ip_address& addr, int v4_bits, int v6_bits) {
+  const auto bits = addr.is_v4() ? kV4MappedBits + v4_bits : v6_bits;
+  return ip_prefix_t{mask(addr, bits), bits};
+}
+
+IpTrie::IpTrie() : nodes_(2) {}
+
+bool IpTrie::Insert(const ip_prefix_t& prefix) {
+  const auto* bytes = prefix.address.bytes();
+  const auto v4 = prefix.address.is_v4() && prefix.bits >= kV4MappedBits;
+  auto n = v4 ? kRootV4 : kRootV6;
+  for (auto i = v4 ? kV4MappedBits : 0; i < prefix.bits; i++) {
+    if (nodes_[n].terminal) {
+      // Already covered by a shorter range.
+      return false;
+    }
+    const auto b = bit(bytes, i);
+    if (!nodes_[n].child[b]) {
+      nodes_[n].child[b] = static_cast<int32_t>(nodes_.size());
+      nodes_.emplace_back();
+    }
+    n = nodes_[n].child[b];
+  }
+  if (nodes_[n].terminal) {
+    return false;
+  }
+  // Anything under this node is now redundant, but it's left in place since
+  // the lookup stops here.
+  nodes_[n].terminal = true;
+  ++size_;
+  return true;
+}
+
+bool IpTrie::Contains(const ip_address& addr) const noexcept {
+  const auto* bytes = addr.bytes();
+  const auto v4 = addr.is_v4();
+  auto n = v4 ? kRootV4 : kRootV6;
+  for (auto i = v4 ? kV4MappedBits : 0; i < 128; i++) {
+    if (nodes_[n].terminal) {
+      return true;
+    }
+    n = nodes_[n].child[bit(bytes, i)];
+    if (!n) {
+      return false;
+    }
+  }
+  return nodes_[n].terminal;
+}
+
+} // namespace wwiv::wwivd
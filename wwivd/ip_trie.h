@@ -0,0 +1,88 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#ifndef INCLUDED_WWIVD_IP_TRIE_H
+#define INCLUDED_WWIVD_IP_TRIE_H
+
+#include "core/ip_address.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wwiv::wwivd {
+
+/**
+ * An IPv4 or IPv6 address range.  IPv4 ranges are stored as IPv4-mapped
+ * IPv6 ranges, so an IPv4 /24 has 120 bits.
+ */
+struct ip_prefix_t {
+  core::ip_address address;
+  int bits{128};
+};
+
+/**
+ * Parses an address or a range in CIDR notation, such as "10.0.0.1",
+ * "10.0.0.0/8" or "2001:db8::/32".  A plain address is a range of one.
+ */
+std::optional<ip_prefix_t> parse_ip_prefix(const std::string& s);
+
+/** Returns the prefix in CIDR notation, or just the address for a single address. */
+std::string to_string(const ip_prefix_t& p);
+
+/**
+ * Returns the subnet containing addr, using v4_bits for IPv4 addresses and
+ * v6_bits for IPv6 ones.
+ */
+ip_prefix_t subnet_of(const core::ip_address& addr, int v4_bits, int v6_bits);
+
+/**
+ * A binary trie of IP address ranges, used to check if an address falls
+ * within any of a set of addresses and CIDR ranges.  IPv4 and IPv6 ranges
+ * are kept under separate roots, so IPv4 lookups walk at most 32 nodes.
+ * This also means IPv6 ranges shorter than 96 bits never match an IPv4
+ * address.
+ */
+class IpTrie final {
+public:
+  IpTrie();
+
+  /** Adds a range.  Returns false if it was already covered by the trie. */
+  bool Insert(const ip_prefix_t& prefix);
+
+  /** Returns true if addr falls within any range in the trie. */
+  [[nodiscard]] bool Contains(const core::ip_address& addr) const noexcept;
+
+  /** Number of ranges added. */
+  [[nodiscard]] int size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+private:
+  struct node_t {
+    // Index of the child node for a 0 or 1 bit, 0 if none.
+    int32_t child[2]{0, 0};
+    // True if a range ends at this node.
+    bool terminal{false};
+  };
+  std::vector<node_t> nodes_;
+  int size_{0};
+};
+
+} // namespace wwiv::wwivd
+
+#endif
@@ -18,19 +18,22 @@
 #include "wwivd/ips.h"
 
 #include "core/datetime.h"
+#include "core/ip_address.h"
 #include "core/jsonfile.h"
 #include "core/log.h"
 #include "core/os.h"
 #include "core/stl.h"
 #include "core/strings.h"
+#include "core/textfile.h"
 #include "sdk/config.h"
 #include "wwivd/connection_data.h"
 #include <cereal/archives/json.hpp>
 #include <cereal/types/memory.hpp>
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace wwiv::wwivd {
@@ -44,21 +47,39 @@ using namespace wwiv::stl;
 using namespace wwiv::strings;
 using namespace wwiv::os;
 
-static bool LoadLinesIntoSet(std::unordered_set<string>& s, const std::vector<std::string>& lines) {
+// How often blocked addresses are appended to badip.txt.
+static constexpr auto kBadIpFlushInterval = 10s;
+// Write them sooner if this many are waiting.
+static constexpr std::size_t kBadIpMaxPending = 64;
+// Bounds on the number of addresses and subnets AutoBlocker keeps track of.
+static constexpr std::size_t kMaxTrackedAddresses = 64 * 1024;
+static constexpr std::size_t kMaxTrackedSubnets = 16 * 1024;
+static constexpr int kSubnetBitsV4 = 24;
+static constexpr int kSubnetBitsV6 = 64;
+
+static void LoadLinesIntoTrie(IpTrie& t, const std::vector<std::string>& lines) {
   for (auto line : lines) {
     const auto space = line.find(' ');
     if (space != std::string::npos) {
       line = line.substr(0, space);
     }
-    s.emplace(StringTrim(line));
+    StringTrim(&line);
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    if (const auto p = parse_ip_prefix(line)) {
+      t.Insert(p.value());
+    } else {
+      LOG(WARNING) << "Ignoring invalid address: '" << line << "'";
+    }
   }
-  return true;
 }
 
 GoodIp::GoodIp(const std::vector<std::string>& lines) { (void)LoadLines(lines); }
 
 bool GoodIp::LoadLines(const std::vector<std::string>& lines) {
-  return LoadLinesIntoSet(ips_, lines);
+  LoadLinesIntoTrie(ips_, lines);
+  return true;
 }
 
 GoodIp::GoodIp(const std::filesystem::path& fn) {
@@ -73,66 +94,147 @@ bool GoodIp::IsAlwaysAllowed(const std::string& ip) {
   if (ips_.empty()) {
     return false;
   }
-  return ips_.find(ip) != ips_.end();
+  const auto addr = ip_address::from_string(ip);
+  return addr && ips_.Contains(addr.value());
 }
 
 BadIp::BadIp(const std::filesystem::path& fn) : fn_(fn) {
   TextFile f(fn, "r");
   if (f) {
     const auto lines = f.ReadFileIntoVector();
-    LoadLinesIntoSet(ips_, lines);
+    LoadLinesIntoTrie(ips_, lines);
   }
 }
+
+BadIp::~BadIp() { Flush(); }
+
 bool BadIp::IsBlocked(const std::string& ip) {
-  if (ips_.empty()) {
+  const auto addr = ip_address::from_string(ip);
+  if (!addr) {
     return false;
   }
-  return ips_.find(ip) != ips_.end();
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!pending_.empty() && std::chrono::steady_clock::now() - last_flush_ >= kBadIpFlushInterval) {
+    FlushLocked();
+  }
+  return ips_.Contains(addr.value());
 }
+
 bool BadIp::Block(const std::string& ip) {
-  ips_.emplace(ip);
-  TextFile appender(fn_, "at");
+  const auto p = parse_ip_prefix(ip);
+  if (!p) {
+    LOG(WARNING) << "Unable to block invalid address: " << ip;
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  ips_.Insert(p.value());
   const auto now = DateTime::now();
-  const auto written =
-      appender.WriteLine(StrCat(ip, " # AutoBlocked by wwivd on: ", now.to_string("%FT%T")));
-  return written > 0;
+  pending_.emplace_back(StrCat(ip, " # AutoBlocked by wwivd on: ", now.to_string("%FT%T")));
+  if (pending_.size() >= kBadIpMaxPending ||
+      std::chrono::steady_clock::now() - last_flush_ >= kBadIpFlushInterval) {
+    return FlushLocked();
+  }
+  return true;
+}
+
+bool BadIp::Flush() {
+  std::lock_guard<std::mutex> lock(mu_);
+  return FlushLocked();
+}
+
+bool BadIp::FlushLocked() {
+  last_flush_ = std::chrono::steady_clock::now();
+  if (pending_.empty()) {
+    return true;
+  }
+  TextFile appender(fn_, "at");
+  auto ok = true;
+  for (const auto& line : pending_) {
+    if (appender.WriteLine(line) <= 0) {
+      ok = false;
+    }
+  }
+  pending_.clear();
+  return ok;
+}
+
+RateLimiter::RateLimiter(double capacity, double refill_per_second, std::size_t max_keys)
+    : capacity_(capacity), refill_per_second_(refill_per_second),
+      max_keys_(std::max<std::size_t>(1, max_keys)) {}
+
+bool RateLimiter::Take(const std::string& key, std::chrono::steady_clock::time_point now) {
+  lru_t::iterator it;
+  if (const auto i = index_.find(key); i != std::end(index_)) {
+    it = i->second;
+    // Move it to the front of the list.
+    buckets_.splice(std::begin(buckets_), buckets_, it);
+    const auto elapsed = std::chrono::duration<double>(now - it->updated).count();
+    if (elapsed > 0) {
+      it->tokens = std::min(capacity_, it->tokens + elapsed * refill_per_second_);
+      it->updated = now;
+    }
+  } else {
+    if (buckets_.size() >= max_keys_) {
+      index_.erase(buckets_.back().key);
+      buckets_.pop_back();
+    }
+    buckets_.push_front(bucket_t{key, capacity_, now});
+    it = std::begin(buckets_);
+    index_.emplace(key, it);
+  }
+  if (it->tokens < 1.0) {
+    return false;
+  }
+  it->tokens -= 1.0;
+  return true;
+}
+
+// The old sliding window counted sessions at both ends of it, so
+// auto_bl_sessions are allowed every auto_bl_seconds + 1 seconds.
+static double refill_rate(int sessions, int seconds) {
+  return std::max(1, sessions) / static_cast<double>(std::max(0, seconds) + 1);
 }
 
 AutoBlocker::AutoBlocker(std::shared_ptr<BadIp> bip, const wwiv::sdk::wwivd_blocking_t& b)
-    : bip_(bip), b_(b) {}
+    : bip_(std::move(bip)), b_(b),
+      addresses_(std::max(1, b.auto_bl_sessions), refill_rate(b.auto_bl_sessions, b.auto_bl_seconds),
+                 kMaxTrackedAddresses),
+      subnets_(std::max(1, b.auto_bl_subnet_sessions),
+               refill_rate(b.auto_bl_subnet_sessions, b.auto_bl_seconds), kMaxTrackedSubnets) {}
 
 AutoBlocker::~AutoBlocker() = default;
 
 bool AutoBlocker::Connection(const std::string& ip) {
+  return Connection(ip, std::chrono::steady_clock::now());
+}
+
+bool AutoBlocker::Connection(const std::string& ip, std::chrono::steady_clock::time_point now) {
   VLOG(1) << "AutoBlocker::Connection: " << ip;
   if (!b_.auto_blocklist) {
     return true;
   }
-
-  const auto auto_bl_sessions = b_.auto_bl_sessions;
-  const auto auto_bl_seconds = b_.auto_bl_seconds;
-  const auto now = DateTime::now();
-  const auto oldest_in_window = now.to_time_t() - auto_bl_seconds;
-  auto& s = sessions_[ip];
-  s.emplace(now.to_time_t());
-  if (s.size() == 1) {
+  const auto addr = ip_address::from_string(ip);
+  if (!addr) {
     return true;
   }
 
-  for (auto iter = s.begin(); iter != s.end();) {
-    if (*iter < oldest_in_window) {
-      iter = s.erase(iter);
-    } else {
-      ++iter;
-    }
-  }
-
-  if (ssize(s) > auto_bl_sessions) {
-    LOG(INFO) << "Blocking since we have " << s.size() << " sessions within "
-              << auto_bl_seconds << " seconds.";
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!addresses_.Take(ip, now)) {
+    LOG(INFO) << "Blocking since we have more than " << b_.auto_bl_sessions
+              << " sessions within " << b_.auto_bl_seconds << " seconds.";
     bip_->Block(ip);
     return false;
   }
+  if (b_.auto_bl_subnet_sessions > 0) {
+    const auto subnet = to_string(subnet_of(addr.value(), kSubnetBitsV4, kSubnetBitsV6));
+    if (!subnets_.Take(subnet, now)) {
+      LOG(INFO) << "Blocking subnet " << subnet << " since we have more than "
+                << b_.auto_bl_subnet_sessions << " sessions within " << b_.auto_bl_seconds
+                << " seconds.";
+      bip_->Block(subnet);
+      return false;
+    }
+  }
   return true;
 }
 
@@ -19,12 +19,15 @@
 #define INCLUDED_WWIVD_IPS_H
 
 #include "sdk/wwivd_config.h"
-#include <ctime>
+#include "wwivd/ip_trie.h"
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
+#include <list>
 #include <memory>
-#include <set>
+#include <mutex>
+#include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace wwiv::wwivd {
@@ -37,30 +40,84 @@ public:
 
 private:
   [[nodiscard]] bool LoadLines(const std::vector<std::string>& ips);
-  std::unordered_set<std::string> ips_;
+  IpTrie ips_;
 };
 
+/**
+ * The addresses and CIDR ranges in badip.txt.  Addresses blocked at runtime
+ * are appended to the file in batches, at most once every few seconds, and
+ * anything left is written out by Flush or the destructor.
+ */
 class BadIp {
 public:
   explicit BadIp(const std::filesystem::path& fn);
+  ~BadIp();
   [[nodiscard]] bool IsBlocked(const std::string& ip);
+  /** Blocks an address or CIDR range. */
   bool Block(const std::string& ip);
+  /** Appends any blocked addresses not yet written to badip.txt. */
+  bool Flush();
 
 private:
+  bool FlushLocked();
+
   const std::filesystem::path fn_;
-  std::unordered_set<std::string> ips_;
+  std::mutex mu_;
+  IpTrie ips_;
+  // Lines not yet written to fn_.
+  std::vector<std::string> pending_;
+  std::chrono::steady_clock::time_point last_flush_{};
+};
+
+/**
+ * Token buckets for a bounded number of keys.  Each key starts with capacity
+ * tokens and gets them back at refill_per_second, and the least recently
+ * used keys are forgotten once there are more than max_keys of them.  Keys
+ * that are forgotten just start over with a full bucket.
+ */
+class RateLimiter final {
+public:
+  RateLimiter(double capacity, double refill_per_second, std::size_t max_keys);
+
+  /** Takes a token for key at time now, returning false if none were left. */
+  bool Take(const std::string& key, std::chrono::steady_clock::time_point now);
+
+  [[nodiscard]] std::size_t size() const noexcept { return index_.size(); }
+
+private:
+  struct bucket_t {
+    std::string key;
+    double tokens;
+    std::chrono::steady_clock::time_point updated;
+  };
+  typedef std::list<bucket_t> lru_t;
+
+  const double capacity_;
+  const double refill_per_second_;
+  const std::size_t max_keys_;
+  // Most recently used first.
+  lru_t buckets_;
+  std::unordered_map<std::string, lru_t::iterator> index_;
 };
 
+/**
+ * Blocks addresses that connect more than auto_bl_sessions times within
+ * auto_bl_seconds, and whole subnets (/24 for IPv4 and /64 for IPv6) that
+ * connect more than auto_bl_subnet_sessions times.
+ */
 class AutoBlocker final {
 public:
   AutoBlocker(std::shared_ptr<BadIp> bip, const wwiv::sdk::wwivd_blocking_t& b);
   ~AutoBlocker();
   bool Connection(const std::string& ip);
+  bool Connection(const std::string& ip, std::chrono::steady_clock::time_point now);
 
 private:
   std::shared_ptr<BadIp> bip_;
   sdk::wwivd_blocking_t b_;
-  std::unordered_map<std::string, std::set<time_t>> sessions_;
+  std::mutex mu_;
+  RateLimiter addresses_;
+  RateLimiter subnets_;
 };
 
 } // namespace
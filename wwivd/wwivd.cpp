@@ -30,6 +30,7 @@
 #include "core/version.h"
 #include "sdk/config.h"
 #include "wwivd/connection_data.h"
+#include "wwivd/connection_pool.h"
 #include "wwivd/nets.h"
 #include "wwivd/node_manager.h"
 #include "wwivd/wwivd_http.h"
@@ -76,6 +77,14 @@ namespace wwiv::wwivd {
 extern std::atomic<bool> need_to_exit;
 extern std::atomic<bool> need_to_reload_config;
 
+// Connections allowed to wait for a worker once all of them are busy.
+static constexpr int kMaxQueuedConnections = 32;
+// Workers beyond one per node for the matrix logon, HTTP, and connections
+// that will be told BUSY.
+static constexpr int kExtraWorkers = 16;
+// How long to wait for running connections to finish on exit.
+static constexpr auto kDrainTimeout = std::chrono::seconds(10);
+
 static bool DeleteAllSemaphores(const Config& config, int start_node, int end_node) {
   // Delete telnet/SSH node semaphore files.
   for (auto i = start_node; i <= end_node; i++) {
@@ -148,17 +157,39 @@ int Main(CommandLine& cmdline) {
     data.auto_blocker_ = std::make_shared<AutoBlocker>(data.bad_ips_, c.blocking);
   }
 
+  auto max_workers = kExtraWorkers;
+  for (const auto& n : nodes) {
+    max_workers += n.second->total_nodes();
+  }
+  const auto pool = std::make_shared<ConnectionPool>(max_workers, kMaxQueuedConnections);
+  data.pool_ = pool;
+
+  // Runs the admission check here on the accept loop and only then hands the
+  // connection to a worker.
+  auto dispatch = [&](accepted_socket_t r, void (ConnectionHandler::*fn)()) {
+    auto h = std::make_shared<ConnectionHandler>(data, r);
+    if (!h->Admit()) {
+      pool->Denied();
+      return;
+    }
+    const auto sock = r.client_socket;
+    if (!pool->Submit([h, fn] { ((*h).*fn)(); }, [sock] { closesocket(sock); })) {
+      LOG(INFO) << "Sending BUSY. No worker available to handle connection.";
+      SendBusyAndClose(sock);
+    }
+  };
   auto telnet_or_ssh_fn = [&](accepted_socket_t r) {
-    std::thread client(HandleConnection, std::make_unique<ConnectionHandler>(data, r));
-    client.detach();
+    dispatch(r, &ConnectionHandler::HandleConnection);
   };
   auto binkp_fn = [&](accepted_socket_t r) {
-    std::thread client(HandleBinkPConnection, std::make_unique<ConnectionHandler>(data, r));
-    client.detach();
+    dispatch(r, &ConnectionHandler::HandleBinkPConnection);
   };
   auto http_fn = [&](accepted_socket_t r) {
-    std::thread client(HandleHttpConnection, data, r);
-    client.detach();
+    const auto sock = r.client_socket;
+    if (!pool->Submit([data, r] { HandleHttpConnection(data, r); },
+                      [sock] { closesocket(sock); })) {
+      closesocket(sock);
+    }
   };
 
   SocketSet sockets;
@@ -184,7 +215,15 @@ int Main(CommandLine& cmdline) {
   // Do network callouts if enabled.
   do_wwivd_callouts(config, c);
 
-  if (!sockets.Run(need_to_exit)) {
+  const auto run_result = sockets.Run(need_to_exit);
+  if (!pool->Drain(kDrainTimeout)) {
+    LOG(INFO) << "Exiting with connections still running.";
+  }
+  const auto s = pool->stats();
+  LOG(INFO) << "Connections accepted: " << s.accepted << "; denied: " << s.denied
+            << "; busy: " << s.busy << "; max queue depth: " << s.max_queue_depth
+            << "; avg wait: " << s.avg_wait_micros << "us";
+  if (!run_result) {
     LOG(INFO) << "Error accepting client socket. " << errno;
     return 2;
   }
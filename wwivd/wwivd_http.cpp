@@ -38,6 +38,7 @@
 #include "core/strings.h"
 #include "sdk/config.h"
 #include "wwivd/connection_data.h"
+#include "wwivd/connection_pool.h"
 #include "wwivd/node_manager.h"
 
 namespace wwiv {
@@ -73,6 +74,33 @@ string ToJson(status_reponse_t r) {
   return ss.str();
 }
 
+struct metrics_response_t {
+  connection_pool_stats_t pool;
+
+  template <class Archive> void serialize(Archive& ar) {
+    ar(cereal::make_nvp("accepted", pool.accepted), cereal::make_nvp("denied", pool.denied),
+       cereal::make_nvp("busy", pool.busy), cereal::make_nvp("started", pool.started),
+       cereal::make_nvp("queue_depth", pool.queue_depth),
+       cereal::make_nvp("max_queue_depth", pool.max_queue_depth),
+       cereal::make_nvp("active_workers", pool.active_workers),
+       cereal::make_nvp("workers", pool.workers),
+       cereal::make_nvp("avg_wait_micros", pool.avg_wait_micros),
+       cereal::make_nvp("max_wait_micros", pool.max_wait_micros));
+  }
+};
+
+string ToJson(metrics_response_t r) {
+  std::ostringstream ss;
+  try {
+    cereal::JSONOutputArchive save(ss);
+    save(cereal::make_nvp("metrics", r));
+  }
+  catch (const cereal::RapidJSONException& e) {
+    LOG(ERROR) << e.what();
+  }
+  return ss.str();
+}
+
 class StatusHandler : public HttpHandler {
 public:
   StatusHandler(std::map<const std::string, std::shared_ptr<NodeManager>>* nodes) : nodes_(nodes) {}
@@ -99,6 +127,26 @@ private:
   std::map<const string, std::shared_ptr<NodeManager>>* nodes_;
 };
 
+class MetricsHandler : public HttpHandler {
+public:
+  explicit MetricsHandler(std::shared_ptr<ConnectionPool> pool) : pool_(std::move(pool)) {}
+
+  HttpResponse Handle(HttpMethod, const std::string&, std::vector<std::string>) override {
+    HttpResponse response(200);
+    response.headers.emplace("Content-Type: ", "text/json");
+
+    metrics_response_t r{};
+    if (pool_) {
+      r.pool = pool_->stats();
+    }
+    response.text = ToJson(r);
+    return response;
+  }
+
+private:
+  std::shared_ptr<ConnectionPool> pool_;
+};
+
 void HandleHttpConnection(ConnectionData data, accepted_socket_t r) {
   const auto sock = r.client_socket;
   const auto& b = data.c->blocking;
@@ -115,6 +163,8 @@ void HandleHttpConnection(ConnectionData data, accepted_socket_t r) {
     HttpServer h(std::make_unique<SocketConnection>(r.client_socket));
     StatusHandler status(data.nodes);
     h.add(HttpMethod::GET, "/status", &status);
+    MetricsHandler metrics(data.pool_);
+    h.add(HttpMethod::GET, "/metrics", &metrics);
     h.Run();
 
   }
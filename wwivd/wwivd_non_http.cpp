@@ -245,8 +245,16 @@ wwivd_matrix_entry_t ConnectionHandler::DoMatrixLogon(const wwivd_config_t& c) {
   return {};
 }
 
+void SendBusyAndClose(SOCKET sock) {
+  // This is a brand new connection, so the send buffer is empty and this
+  // won't block the caller.
+  static constexpr char busy[] = "BUSY\r\n";
+  send(sock, busy, sizeof(busy) - 1, 0);
+  closesocket(sock);
+}
+
 // Can throw
-ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedConnection() {
+ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedPeer() {
   const auto sock = r.client_socket;
   string remote_peer;
   const auto& b = data.c->blocking;
@@ -254,14 +262,14 @@ ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedCon
   // We fail open when we can't get the remote peer
   if (!GetRemotePeerAddress(sock, remote_peer)) {
     LOG(ERROR) << "Allowing connections we can't determine the remote peer.";
-    return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer);
+    return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer, true);
   }
 
   // Check for always allowed addresses
   if (b.use_goodip_txt && data.good_ips_) {
     if (data.good_ips_->IsAlwaysAllowed(remote_peer)) {
       LOG(INFO) << "Allowing connection for goodip.txt always-allowed peer: " << remote_peer;
-      return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer);
+      return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer, true);
     }
   }
 
@@ -274,7 +282,40 @@ ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedCon
     }
   }
 
-  // Check for country blocking if we have a DNS cc server defined.
+  return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer);
+}
+
+bool ConnectionHandler::Admit() {
+  try {
+    admission_ = CheckForBlockedPeer();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Admit: Handled Uncaught Exception: " << e.what();
+    // Let the worker try again and handle it like any other failure.
+    admission_.reset();
+    return true;
+  }
+  if (admission_->action == BlockedConnectionAction::DENY) {
+    SendBusyAndClose(r.client_socket);
+    return false;
+  }
+  return true;
+}
+
+// Can throw
+ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedConnection() {
+  if (!admission_) {
+    admission_ = CheckForBlockedPeer();
+  }
+  const auto& result = admission_.value();
+  if (result.action == BlockedConnectionAction::DENY || result.always_allowed) {
+    return result;
+  }
+
+  // Check for country blocking if we have a DNS cc server defined.  This is
+  // a DNS lookup, so it and everything after it is done here on the worker
+  // and not in Admit.
+  const auto& b = data.c->blocking;
+  const auto& remote_peer = result.remote_peer;
   if (b.use_dns_cc && !b.dns_cc_server.empty()) {
     const auto cc = get_dns_cc(remote_peer, b.dns_cc_server);
     LOG(INFO) << "Accepted connection on port: " << r.port << "; from: " << remote_peer
@@ -298,7 +339,7 @@ ConnectionHandler::BlockedConnectionResult ConnectionHandler::CheckForBlockedCon
 
   // Nothing left to check, let the connection through.
   LOG(INFO) << "Allowing connection for peer: " << remote_peer;
-  return BlockedConnectionResult(BlockedConnectionAction::ALLOW, remote_peer);
+  return result;
 }
 
 void ConnectionHandler::HandleBinkPConnection() {
@@ -434,8 +475,5 @@ void ConnectionHandler::HandleConnection() {
   }
 }
 
-void HandleConnection(std::unique_ptr<ConnectionHandler> h) { h->HandleConnection(); }
-
-void HandleBinkPConnection(std::unique_ptr<ConnectionHandler> h) { h->HandleBinkPConnection(); }
 
 } // namespace wwiv
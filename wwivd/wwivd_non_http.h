@@ -25,6 +25,7 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace wwiv::wwivd {
@@ -41,28 +42,43 @@ public:
   enum class MailerModeResult { ALLOW, DENY };
 
   struct BlockedConnectionResult {
-    BlockedConnectionResult(const BlockedConnectionAction& a, const std::string& r)
-        : action(a), remote_peer(r) {}
+    BlockedConnectionResult(const BlockedConnectionAction& a, const std::string& r,
+                            bool always_allowed = false)
+        : action(a), remote_peer(r), always_allowed(always_allowed) {}
     BlockedConnectionAction action{BlockedConnectionAction::ALLOW};
     std::string remote_peer;
+    // True if the peer is in goodip.txt, so no further checks are needed.
+    bool always_allowed{false};
   };
 
   ConnectionHandler() = delete;
   ConnectionHandler(ConnectionData d, wwiv::core::accepted_socket_t a);
 
+  /**
+   * Runs the goodip and badip checks on the calling thread, so that blocked
+   * peers are turned away from the accept loop without costing a thread.
+   * The country check and then the auto blocker run later on the worker,
+   * so a peer from a blocked country never counts towards the auto blocker.
+   * On DENY this sends BUSY, closes the socket, and returns false.
+   */
+  bool Admit();
+
   void HandleConnection();
   void HandleBinkPConnection();
 
 private:
   MailerModeResult DoMailerMode();
+  BlockedConnectionResult CheckForBlockedPeer();
   BlockedConnectionResult CheckForBlockedConnection();
   wwiv::sdk::wwivd_matrix_entry_t DoMatrixLogon(const wwiv::sdk::wwivd_config_t& c);
   ConnectionData data;
   wwiv::core::accepted_socket_t r;
+  std::optional<BlockedConnectionResult> admission_;
 };
 
-void HandleConnection(std::unique_ptr<ConnectionHandler> h);
-void HandleBinkPConnection(std::unique_ptr<ConnectionHandler> h);
+/** Best effort send of BUSY to a new connection and then closes it. */
+void SendBusyAndClose(SOCKET sock);
+
 
 } // namespace
 
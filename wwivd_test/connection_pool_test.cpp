@@ -0,0 +1,148 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "wwivd/connection_pool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std::chrono_literals;
+using namespace wwiv::wwivd;
+
+// Blocks workers until released.
+class Gate {
+public:
+  void wait() {
+    std::unique_lock<std::mutex> lock(mu_);
+    ++waiting_;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return open_; });
+  }
+  void open() {
+    std::lock_guard<std::mutex> lock(mu_);
+    open_ = true;
+    cv_.notify_all();
+  }
+  void finished() {
+    std::lock_guard<std::mutex> lock(mu_);
+    ++finished_;
+    cv_.notify_all();
+  }
+  bool wait_for_waiters(int n) {
+    std::unique_lock<std::mutex> lock(mu_);
+    return cv_.wait_for(lock, 10s, [&] { return waiting_ >= n; });
+  }
+  bool wait_for_finished(int n) {
+    std::unique_lock<std::mutex> lock(mu_);
+    return cv_.wait_for(lock, 10s, [&] { return finished_ >= n; });
+  }
+
+private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool open_{false};
+  int waiting_{0};
+  int finished_{0};
+};
+
+TEST(ConnectionPoolTest, RunsJobs) {
+  ConnectionPool pool(2, 4);
+  Gate gate;
+  gate.open();
+  std::atomic<int> count{0};
+  for (auto i = 0; i < 4; i++) {
+    EXPECT_TRUE(pool.Submit(
+        [&] {
+          ++count;
+          gate.finished();
+        },
+        nullptr));
+  }
+  ASSERT_TRUE(gate.wait_for_finished(4));
+  EXPECT_TRUE(pool.Drain(10s));
+  EXPECT_EQ(4, count.load());
+  const auto s = pool.stats();
+  EXPECT_EQ(4, s.accepted);
+  EXPECT_EQ(4, s.started);
+  EXPECT_EQ(0, s.workers);
+  EXPECT_LE(s.max_queue_depth, 4);
+}
+
+TEST(ConnectionPoolTest, BoundedWorkersAndQueue) {
+  ConnectionPool pool(2, 1);
+  Gate gate;
+  std::atomic<int> count{0};
+  auto job = [&] {
+    gate.wait();
+    ++count;
+    gate.finished();
+  };
+  EXPECT_TRUE(pool.Submit(job, nullptr));
+  EXPECT_TRUE(pool.Submit(job, nullptr));
+  ASSERT_TRUE(gate.wait_for_waiters(2));
+  EXPECT_EQ(2, pool.stats().workers);
+  EXPECT_EQ(2, pool.stats().active_workers);
+
+  // One more may wait in the queue, the next is turned away.
+  EXPECT_TRUE(pool.Submit(job, nullptr));
+  EXPECT_FALSE(pool.Submit(job, nullptr));
+  EXPECT_EQ(1, pool.stats().busy);
+  EXPECT_EQ(1, pool.stats().queue_depth);
+  EXPECT_EQ(2, pool.stats().workers);
+
+  gate.open();
+  ASSERT_TRUE(gate.wait_for_finished(3));
+  EXPECT_TRUE(pool.Drain(10s));
+  EXPECT_EQ(3, count.load());
+}
+
+TEST(ConnectionPoolTest, DrainCancelsQueued) {
+  ConnectionPool pool(1, 2);
+  Gate gate;
+  std::atomic<int> ran{0};
+  std::atomic<int> cancelled{0};
+  EXPECT_TRUE(pool.Submit(
+      [&] {
+        gate.wait();
+        ++ran;
+      },
+      [&] { ++cancelled; }));
+  ASSERT_TRUE(gate.wait_for_waiters(1));
+  EXPECT_TRUE(pool.Submit([&] { ++ran; }, [&] { ++cancelled; }));
+  EXPECT_TRUE(pool.Submit([&] { ++ran; }, [&] { ++cancelled; }));
+
+  // The running one keeps us from draining.
+  EXPECT_FALSE(pool.Drain(10ms));
+  EXPECT_EQ(2, cancelled.load());
+  EXPECT_FALSE(pool.Submit([&] { ++ran; }, nullptr));
+
+  gate.open();
+  EXPECT_TRUE(pool.Drain(10s));
+  EXPECT_EQ(1, ran.load());
+}
+
+TEST(ConnectionPoolTest, Denied) {
+  ConnectionPool pool(1, 1);
+  pool.Denied();
+  pool.Denied();
+  EXPECT_EQ(2, pool.stats().denied);
+  EXPECT_EQ(0, pool.stats().accepted);
+}
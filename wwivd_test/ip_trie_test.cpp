@@ -0,0 +1,217 @@
+/**************************************************************************/
+/*                                                                        */
+/*                          WWIV Version 5.x                              */
+/*             Copyright (C)2021, WWIV Software Services                  */
+/*                                                                        */
+/*    Licensed  under the  Apache License, Version  2.0 (the "License");  */
+/*    you may not use this  file  except in compliance with the License.  */
+/*    You may obtain a copy of the License at                             */
+/*                                                                        */
+/*                http://www.apache.org/licenses/LICENSE-2.0              */
+/*                                                                        */
+/*    Unless  required  by  applicable  law  or agreed to  in  writing,   */
+/*    software  distributed  under  the  License  is  distributed on an   */
+/*    "AS IS"  BASIS, WITHOUT  WARRANTIES  OR  CONDITIONS OF ANY  KIND,   */
+/*    either  express  or implied.  See  the  License for  the specific   */
+/*    language governing permissions and limitations under the License.   */
+/*                                                                        */
+/**************************************************************************/
+#include "gtest/gtest.h"
+
+#include "core/ip_address.h"
+#include "core/log.h"
+#include "core/strings.h"
+#include "core/textfile.h"
+#include "core_test/file_helper.h"
+#include "sdk/wwivd_config.h"
+#include "wwivd/ip_trie.h"
+#include "wwivd/ips.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using namespace wwiv::core;
+using namespace wwiv::sdk;
+using namespace wwiv::strings;
+using namespace wwiv::wwivd;
+
+static ip_address ip(const std::string& s) { return ip_address::from_string(s).value(); }
+
+TEST(IpTrieTest, ParseIpPrefix) {
+  const auto p = parse_ip_prefix("10.1.2.3/8").value();
+  EXPECT_EQ("10.0.0.0", p.address.to_string());
+  EXPECT_EQ(96 + 8, p.bits);
+  EXPECT_EQ("10.0.0.0/8", to_string(p));
+
+  EXPECT_EQ("10.1.2.3", to_string(parse_ip_prefix("10.1.2.3").value()));
+  EXPECT_EQ("2001:db8::/32", to_string(parse_ip_prefix("2001:db8:1::/32").value()));
+
+  EXPECT_FALSE(parse_ip_prefix("10.0.0.0/33").has_value());
+  EXPECT_FALSE(parse_ip_prefix("10.0.0.0/").has_value());
+  EXPECT_FALSE(parse_ip_prefix("10.0.0.0/x").has_value());
+  EXPECT_FALSE(parse_ip_prefix("example.com").has_value());
+}
+
+TEST(IpTrieTest, SubnetOf) {
+  EXPECT_EQ("10.1.2.0/24", to_string(subnet_of(ip("10.1.2.3"), 24, 64)));
+  EXPECT_EQ("2001:db8:1:2::/64", to_string(subnet_of(ip("2001:db8:1:2:3::4"), 24, 64)));
+}
+
+TEST(IpTrieTest, Contains) {
+  IpTrie t;
+  EXPECT_TRUE(t.empty());
+  EXPECT_TRUE(t.Insert(parse_ip_prefix("10.0.0.0/8").value()));
+  EXPECT_TRUE(t.Insert(parse_ip_prefix("192.168.1.1").value()));
+  EXPECT_TRUE(t.Insert(parse_ip_prefix("2001:db8::/32").value()));
+  EXPECT_EQ(3, t.size());
+
+  EXPECT_TRUE(t.Contains(ip("10.0.0.1")));
+  EXPECT_TRUE(t.Contains(ip("10.255.255.255")));
+  EXPECT_FALSE(t.Contains(ip("11.0.0.1")));
+  EXPECT_TRUE(t.Contains(ip("192.168.1.1")));
+  EXPECT_FALSE(t.Contains(ip("192.168.1.2")));
+  EXPECT_TRUE(t.Contains(ip("2001:db8:ffff::1")));
+  EXPECT_FALSE(t.Contains(ip("2001:db9::1")));
+  EXPECT_FALSE(t.Contains(ip("::1")));
+}
+
+TEST(IpTrieTest, Insert_AlreadyCovered) {
+  IpTrie t;
+  EXPECT_TRUE(t.Insert(parse_ip_prefix("10.0.0.0/8").value()));
+  EXPECT_FALSE(t.Insert(parse_ip_prefix("10.1.0.0/16").value()));
+  EXPECT_FALSE(t.Insert(parse_ip_prefix("10.0.0.0/8").value()));
+  // A wider range still goes in.
+  EXPECT_TRUE(t.Insert(parse_ip_prefix("0.0.0.0/0").value()));
+  EXPECT_TRUE(t.Contains(ip("1.2.3.4")));
+  EXPECT_FALSE(t.Contains(ip("::1")));
+}
+
+TEST(IpsTest, GoodIp_Cidr) {
+  GoodIp good(std::vector<std::string>{"10.0.0.0/8 # LAN", "# comment", "", "::1"});
+  EXPECT_TRUE(good.IsAlwaysAllowed("10.1.2.3"));
+  EXPECT_TRUE(good.IsAlwaysAllowed("::1"));
+  EXPECT_FALSE(good.IsAlwaysAllowed("11.1.2.3"));
+  EXPECT_FALSE(good.IsAlwaysAllowed("not an address"));
+}
+
+TEST(IpsTest, BadIp_BatchesWrites) {
+  FileHelper helper;
+  const auto fn = helper.CreateTempFile("badip.txt", "10.0.0.0/8\r\n");
+  {
+    BadIp bad(fn);
+    EXPECT_TRUE(bad.IsBlocked("10.1.2.3"));
+    EXPECT_TRUE(bad.Block("1.1.1.1"));
+    // The first one is written right away, the next one waits.
+    EXPECT_TRUE(bad.Block("2.2.2.0/24"));
+    EXPECT_TRUE(bad.IsBlocked("2.2.2.2"));
+    const auto contents = TextFile(fn, "rt").ReadFileIntoString();
+    EXPECT_NE(contents.find("1.1.1.1"), std::string::npos);
+    EXPECT_EQ(contents.find("2.2.2.0/24"), std::string::npos);
+  }
+  BadIp bad(fn);
+  EXPECT_TRUE(bad.IsBlocked("1.1.1.1"));
+  EXPECT_TRUE(bad.IsBlocked("2.2.2.2"));
+  EXPECT_FALSE(bad.IsBlocked("3.3.3.3"));
+}
+
+TEST(IpsTest, RateLimiter) {
+  RateLimiter r(2, 1, 100);
+  const auto now = steady_clock::now();
+  EXPECT_TRUE(r.Take("a", now));
+  EXPECT_TRUE(r.Take("a", now));
+  EXPECT_FALSE(r.Take("a", now));
+  EXPECT_TRUE(r.Take("b", now));
+  EXPECT_FALSE(r.Take("a", now + 500ms));
+  EXPECT_TRUE(r.Take("a", now + 1s));
+  EXPECT_FALSE(r.Take("a", now + 1s));
+  // Never more than the capacity.
+  EXPECT_TRUE(r.Take("a", now + 1h));
+  EXPECT_TRUE(r.Take("a", now + 1h));
+  EXPECT_FALSE(r.Take("a", now + 1h));
+}
+
+TEST(IpsTest, RateLimiter_EvictsLeastRecentlyUsed) {
+  RateLimiter r(1, 0.001, 2);
+  const auto now = steady_clock::now();
+  EXPECT_TRUE(r.Take("a", now));
+  EXPECT_TRUE(r.Take("b", now));
+  EXPECT_FALSE(r.Take("a", now));
+  EXPECT_TRUE(r.Take("c", now));
+  EXPECT_EQ(2u, r.size());
+  // b was forgotten, so it starts over.
+  EXPECT_TRUE(r.Take("b", now));
+  EXPECT_FALSE(r.Take("c", now));
+}
+
+TEST(IpsTest, AutoBlocker_Subnet) {
+  wwivd_blocking_t b{};
+  b.auto_blocklist = true;
+  b.auto_bl_seconds = 10;
+  b.auto_bl_sessions = 3;
+  b.auto_bl_subnet_sessions = 4;
+  FileHelper helper;
+  auto bip = std::make_shared<BadIp>(helper.CreateTempFile("badip.txt", ""));
+  AutoBlocker blocker(bip, b);
+  const auto now = steady_clock::now();
+  for (auto i = 1; i <= 4; i++) {
+    EXPECT_TRUE(blocker.Connection(StrCat("10.0.0.", i), now)) << i;
+  }
+  EXPECT_FALSE(blocker.Connection("10.0.0.5", now));
+  EXPECT_TRUE(bip->IsBlocked("10.0.0.200"));
+  EXPECT_FALSE(bip->IsBlocked("10.0.1.1"));
+  EXPECT_TRUE(blocker.Connection("10.0.1.1", now));
+}
+
+TEST(IpsTest, AutoBlocker_Address) {
+  wwivd_blocking_t b{};
+  b.auto_blocklist = true;
+  b.auto_bl_seconds = 10;
+  b.auto_bl_sessions = 2;
+  b.auto_bl_subnet_sessions = 0;
+  FileHelper helper;
+  auto bip = std::make_shared<BadIp>(helper.CreateTempFile("badip.txt", ""));
+  AutoBlocker blocker(bip, b);
+  const auto now = steady_clock::now();
+  EXPECT_TRUE(blocker.Connection("2001:db8::1", now));
+  EXPECT_TRUE(blocker.Connection("2001:db8::1", now + 1s));
+  // 2 sessions every 11 seconds.
+  EXPECT_TRUE(blocker.Connection("2001:db8::1", now + 6s));
+  EXPECT_FALSE(blocker.Connection("2001:db8::1", now + 7s));
+  EXPECT_TRUE(bip->IsBlocked("2001:db8::1"));
+  EXPECT_FALSE(bip->IsBlocked("2001:db8::2"));
+}
+
+// Benchmark of checking addresses against a large badip.txt.
+TEST(IpsTest, DISABLED_Benchmark_IsBlocked) {
+  constexpr auto kNumBlocked = 100000;
+  constexpr auto kNumLookups = 2000000;
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> octet(0, 255);
+  auto random_ip = [&] {
+    return StrCat(octet(gen), ".", octet(gen), ".", octet(gen), ".", octet(gen));
+  };
+  FileHelper helper;
+  std::string contents;
+  for (auto i = 0; i < kNumBlocked; i++) {
+    contents.append(i % 10 == 0 ? StrCat(random_ip(), "/24") : random_ip()).append("\n");
+  }
+  BadIp bad(helper.CreateTempFile("badip.txt", contents));
+  std::vector<std::string> ips;
+  for (auto i = 0; i < 4096; i++) {
+    ips.push_back(random_ip());
+  }
+
+  auto blocked = 0;
+  const auto start = steady_clock::now();
+  for (auto i = 0; i < kNumLookups; i++) {
+    if (bad.IsBlocked(ips[i % ips.size()])) {
+      ++blocked;
+    }
+  }
+  const auto ms = std::max<int64_t>(1, duration_cast<milliseconds>(steady_clock::now() - start).count());
+  LOG(INFO) << "IsBlocked: " << kNumLookups << " lookups in " << ms << "ms; "
+            << kNumLookups * 1000 / ms << " lookups/sec; blocked: " << blocked;
+}
@@ -188,7 +188,39 @@ public:
     return area->AddMessage(header) ? 0 : 1;
   }
 };
+class RebuildEmailIndexCommand final : public BaseEmailSubCommand {
+public:
+  RebuildEmailIndexCommand()
+      : BaseEmailSubCommand("reindex", "Rebuilds the mailbox index (EMAIL.IDX) from EMAIL.DAT.") {}
 
+  bool AddSubCommands() override { return true; }
+
+  [[nodiscard]] std::string GetUsage() const override {
+    std::ostringstream ss;
+    ss << "Usage:   reindex" << std::endl;
+    return ss.str();
+  }
+
+  [[nodiscard]] int Execute() override {
+    if (!CreateMessageApi()) {
+      std::clog << "Error Creating message api." << std::endl;
+      return 1;
+    }
+
+    auto email = api().OpenEmail();
+    if (!email) {
+      std::clog << "Unable to Open email" << std::endl;
+      return 1;
+    }
+    if (!email->RebuildIndex()) {
+      LOG(ERROR) << "Unable to rebuild the email index.";
+      return 1;
+    }
+    std::cout << "Indexed " << email->number_of_messages() << " messages in "
+              << email->number_of_email_records() << " records." << std::endl;
+    return 0;
+  }
+};
 
 bool EmailCommand::AddSubCommands() {
   if (!add(std::make_unique<EmailDumpCommand>())) {
@@ -200,6 +232,9 @@ bool EmailCommand::AddSubCommands() {
   if (!add(std::make_unique<AddEmailCommand>())) {
     return false;
   }
+  if (!add(std::make_unique<RebuildEmailIndexCommand>())) {
+    return false;
+  }
   
   return true;
 }
@@ -21,6 +21,7 @@
 #include "core/file.h"
 #include "core/log.h"
 #include "core/strings.h"
+#include "sdk/fido/fido_packet_reader.h"
 #include "sdk/fido/fido_packets.h"
 #include "sdk/fido/fido_util.h"
 #include "sdk/net/ftn_msgdupe.h"
@@ -127,16 +128,16 @@ static int dump_packet_file(const std::string& filename) {
   }
 
   auto done = false;
+  FidoPacketReader reader(f);
   packet_header_2p_t header = {};
-  auto num_header_read = f.Read(&header, sizeof(packet_header_2p_t));
-  if (num_header_read < static_cast<int>(sizeof(packet_header_2p_t))) {
+  if (!reader.ReadHeader(header)) {
     LOG(ERROR) << "Read less than packet header";
     return 1;
   }
 
   while (!done) {
     FidoPackedMessage msg;
-    auto response = read_packed_message(f, msg);
+    auto response = reader.Next(msg);
     if (response == ReadPacketResponse::END_OF_FILE) {
       return 0;
     }
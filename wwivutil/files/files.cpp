@@ -17,6 +17,7 @@
 /**************************************************************************/
 #include "wwivutil/files/files.h"
 
+#include "sdk/files/file_catalog.h"
 #include "sdk/files/files.h"
 #include "core/command_line.h"
 #include "core/log.h"
@@ -241,6 +242,45 @@ public:
   }
 };
 
+class ReindexFilesCommand final : public UtilCommand {
+public:
+  ReindexFilesCommand()
+      : UtilCommand("reindex", "Builds the catalog of files in every area used for searches.") {}
+
+  [[nodiscard]] std::string GetUsage() const override {
+    std::ostringstream ss;
+    ss << "Usage:   reindex" << endl;
+    return ss.str();
+  }
+
+  int Execute() override {
+    const auto& datadir = config()->config()->datadir();
+    auto o = ReadAreas(datadir);
+    if (!o) {
+      return 2;
+    }
+    sdk::files::FileApi api(datadir);
+    sdk::files::FileCatalog catalog(datadir);
+    for (const auto& dir : o.value()) {
+      auto area = api.Open(dir);
+      if (!area) {
+        LOG(WARNING) << "Skipping missing file area: " << dir.filename;
+        continue;
+      }
+      catalog.AddArea(dir.filename, *area);
+    }
+    if (!catalog.Save()) {
+      LOG(ERROR) << "Unable to write the file catalog: " << catalog.path();
+      return 1;
+    }
+    cout << "Indexed " << catalog.size() << " files in " << o.value().size() << " areas; "
+         << catalog.number_of_words() << " words." << endl;
+    return 0;
+  }
+
+  bool AddSubCommands() override { return true; }
+};
+
 bool FilesCommand::AddSubCommands() {
   if (!add(make_unique<AllowCommand>())) {
     return false;
@@ -260,6 +300,9 @@ bool FilesCommand::AddSubCommands() {
   if (!add(make_unique<DeleteFileCommand>())) {
     return false;
   }
+  if (!add(make_unique<ReindexFilesCommand>())) {
+    return false;
+  }
   return true;
 }
 
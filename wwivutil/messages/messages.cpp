@@ -27,6 +27,8 @@
 #include "sdk/config.h"
 #include "sdk/names.h"
 #include "sdk/msgapi/message_api_wwiv.h"
+#include "sdk/msgapi/message_area_wwiv.h"
+#include "sdk/msgapi/message_search_index.h"
 #include "sdk/msgapi/msgapi.h"
 #include "sdk/net/networks.h"
 #include "wwivutil/util.h"
@@ -349,6 +351,61 @@ public:
       clog << "Unable to move dat";
     }
 
+    // Packing moves the text of every message, so the search index needs to
+    // be rebuilt if this sub has one.
+    if (MessageSearchIndex(orig_sub_fn).exists()) {
+      unique_ptr<MessageArea> area(api().Open(sub(), -1));
+      if (auto* wa = dynamic_cast<WWIVMessageArea*>(area.get());
+          !wa || !wa->RebuildSearchIndex()) {
+        clog << "Unable to rebuild the search index." << endl;
+      }
+    }
+    return 0;
+  }
+};
+
+class ReindexMessagesCommand final : public BaseMessagesSubCommand {
+public:
+  ReindexMessagesCommand()
+      : BaseMessagesSubCommand("reindex", "Builds the full text search index for a message area.") {}
+
+  bool AddSubCommands() override { return true; }
+
+  [[nodiscard]] std::string GetUsage() const override {
+    std::ostringstream ss;
+    ss << "Usage:   reindex <base sub filename>" << endl;
+    ss << "Example: reindex general" << endl;
+    return ss.str();
+  }
+
+  int Execute() override {
+    if (remaining().empty()) {
+      clog << "Missing sub basename." << endl;
+      cout << GetUsage() << GetHelp() << endl;
+      return 2;
+    }
+
+    const auto basename(remaining().front());
+    if (!CreateMessageApiMap(basename)) {
+      clog << "Error Creating message apis." << endl;
+      return 1;
+    }
+
+    unique_ptr<MessageArea> area(api().Open(sub(), -1));
+    auto* wa = dynamic_cast<WWIVMessageArea*>(area.get());
+    if (!wa) {
+      clog << "Unable to Open message area: '" << sub().filename << "'." << endl;
+      return 1;
+    }
+    if (!wa->RebuildSearchIndex()) {
+      LOG(ERROR) << "Unable to build the search index for: " << basename;
+      return 1;
+    }
+    const auto sub_fn = FilePath(config()->config()->datadir(), StrCat(basename, ".sub"));
+    MessageSearchIndex index(sub_fn);
+    index.Load();
+    cout << "Indexed " << index.size() << " messages; " << index.number_of_words() << " words."
+         << endl;
     return 0;
   }
 };
@@ -367,6 +424,9 @@ bool MessagesCommand::AddSubCommands() {
   if (!add(make_unique<PackMessageCommand>())) {
     return false;
   }
+  if (!add(make_unique<ReindexMessagesCommand>())) {
+    return false;
+  }
   
   return true;
 }
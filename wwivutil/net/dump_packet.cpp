@@ -23,6 +23,7 @@
 #include "core/log.h"
 #include "core/strings.h"
 #include "sdk/net/net.h"
+#include "sdk/net/packet_reader.h"
 #include "sdk/net/packets.h"
 #include "wwivutil/util.h"
 #include <iomanip>
@@ -42,15 +43,15 @@ using namespace wwiv::strings;
 namespace wwiv::wwivutil {
 
 int dump_file(const std::string& filename) {
-  File f(filename);
-  if (!f.Open(File::modeBinary | File::modeReadOnly)) {
+  PacketReader reader(filename, true);
+  if (!reader.IsOpen()) {
     LOG(ERROR) << "Unable to open file: " << filename;
     return 1;
   }
 
   auto current{0};
   for (;;) {
-    auto [packet, response] = read_packet(f, true);
+    auto [packet, response] = reader.Next();
     if (response == ReadPacketResponse::END_OF_FILE) {
       return 0;
     }
@@ -83,8 +84,8 @@ int dump_file(const std::string& filename) {
     if (packet.nh.list_len > 0) {
       // read list of addresses.
       cout << "System List: ";
-      for (const auto item : packet.list) {
-        cout << item << " ";
+      for (auto i = 0; i < packet.list_size(); i++) {
+        cout << packet.list_at(i) << " ";
       }
       cout << std::endl;
     }